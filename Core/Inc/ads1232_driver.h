@@ -3,6 +3,18 @@
 
 #include "main.h"
 #include <stdint.h>
+#include <stdbool.h>
+#include "corrotina.h"
+
+// =================================================================================
+// MODO DE SIMULACAO: Defina como 1 para rodar sem o hardware ADS1232 conectado.
+// Isso evita que o cdigo trave esperando por um sinal que nunca chegar.
+// Defina como 0 para operao normal com o hardware.
+// No header porque, com a leitura fixa, o servo_controle simula a camara.
+// =================================================================================
+#ifndef ADS1232_SIMULATION_MODE
+#define ADS1232_SIMULATION_MODE 1
+#endif
 
 // --- DEFINIES PARTILHADAS PARA CALIBRAO ---
 #define NUM_CAL_POINTS 4
@@ -21,6 +33,9 @@ void ADS1232_Init(void);
 int32_t ADS1232_Read(void);
 int32_t ADS1232_Read_Median_of_3(void);
 int32_t ADS1232_Tare(void);
+void ADS1232_Tare_Iniciar(void);
+Cr_Estado_t ADS1232_Tare_Passo(void);
+bool ADS1232_Tare_Em_Andamento(void);
 void ADS1232_SetCalibrationFactor(float factor);
 float ADS1232_ConvertToGrams(int32_t raw_value);
 int32_t ADS1232_GetOffset(void);
@@ -32,33 +32,63 @@
 #include <stdio.h>
 #include <string.h>
 
-typedef enum {
-  STATE_ACTIVE,
-  STATE_STOPPED,
-  STATE_CONFIRM_WAKEUP
-} SystemState_t;
+// Retomada rpida do Stop: a stack USBX fica montada (SRAM e registradores
+// so retidos no Stop), o display  sondado em vez de esperado por tempo fixo
+// e o autodiagnstico s roda se a ltima execuo reprovou.
+// Com 0 volta ao caminho antigo (desmonta e recria a stack).
+#ifndef RETOMADA_RAPIDA_HABILITADA
+#define RETOMADA_RAPIDA_HABILITADA  1
+#endif
+
+#define RETOMADA_ALVO_MS            300u    // Do fim do Stop at a tela de confirmao
 
 /**
- * @brief Ponteiro de funo para um teste de diagnstico individual.
- * @return true em caso de sucesso, false em caso de falha.
+ * @brief IDs das tarefas do estado ativo (ndices na tabela do escalonador).
  */
-typedef bool (*DiagnosticTestFunc)(void);
+typedef enum {
+    TAREFA_TEMPORIZADOR,
+    TAREFA_DWIN_TX,
+    TAREFA_DWIN_RX,
+    TAREFA_EVENTOS,
+    TAREFA_CLI,
+    TAREFA_MEDICAO,
+    TAREFA_SERVOS,
+    TAREFA_EEPROM,
+    TAREFA_DISPLAY,
+    TAREFA_TEMP,
+    TAREFA_LOTE,
+    TAREFA_GOVERNADOR,
+    NUM_TAREFAS_ATIVAS
+} Tarefa_Id_t;
 
 /**
- * @brief Estrutura que define uma nica etapa do autodiagnstico.
+ * @brief Latncias da ltima retomada do Stop (ms desde a sada do Stop).
  */
 typedef struct {
-    const char* description;         // Descrio para o log do console (printf)
-    uint16_t    screen_id;           // ID da tela DWIN a ser exibida
-    uint32_t    display_time_ms;     // Tempo que a tela fica visvel
-    DiagnosticTestFunc execute_test; // Ponteiro para a funo de teste
-} DiagnosticStep_t;
+    uint32_t usb_ms;        // Clocks restaurados e USB reconectado
+    uint32_t display_ms;    // Display respondeu e a tela de confirmao foi enviada
+    uint32_t pior_ms;       // Pior display_ms desde o reset
+    uint32_t retomadas;
+    bool     display_respondeu;
+} App_Retomada_t;
+
+typedef enum {
+  STATE_ACTIVE,
+  STATE_STOPPED,
+  STATE_CONFIRM_WAKEUP
+} SystemState_t;
 
 /**
  * @brief Inicializa todos os mdulos da aplicao em uma sequncia controlada.
  */
 void App_Manager_Init(void);
 
+/**
+ * @brief Conduz o boot at a tela principal (boot rpido ou autodiagnstico
+ * completo, conforme BOOT_RAPIDO_HABILITADO). Chamar aps App_Manager_Init().
+ */
+void App_Manager_Iniciar_Boot(void);
+
 /**
  * @brief Executa o loop de processamento principal da aplicao (Super-loop V8.2).
  */
@@ -67,6 +97,11 @@ void App_Manager_Process(void);
 // Funes de Callback para serem chamadas pela UI/Controller
 void App_Manager_Handle_Start_Process(void);
 void App_Manager_Handle_New_Password(const char* new_password);
+
+/**
+ * @brief Dispara o autodiagnstico completo (telas de verificao) sem bloquear.
+ * @return false se j houver um diagnstico em andamento.
+ */
 bool App_Manager_Run_Self_Diagnostics(uint8_t return_tela);
 
 /**
@@ -75,10 +110,21 @@ bool App_Manager_Run_Self_Diagnostics(uint8_t return_tela);
  */
 void App_Manager_Request_Sleep(void);
 
+/**
+ * @brief Indica se a USB est operando (stack montada e PCD ligado). Durante a sequncia de Stop
+ * o loop continua rodando, mas USB_Process/CLI_TX_Pump no devem ser chamados.
+ */
+bool App_Manager_USB_Ativo(void);
+
 /**
  * @brief Confirma que o usurio deseja acordar o sistema.
  * Chamado pelo controller quando o boto de confirmao  pressionado.
  */
 void App_Manager_Confirm_Wakeup(void);
 
+/**
+ * @brief Copia as latncias medidas na ltima retomada do Stop.
+ */
+void App_Manager_Get_Retomada(App_Retomada_t* retomada_out);
+
 #endif // APP_MANAGER_H
\ No newline at end of file
@@ -3,20 +3,31 @@
 
 #include "main.h"
 #include "i2c.h"
+#include <stdbool.h>
 
 // Define a capacidade da sua bateria aqui para fcil configurao
 #define BATTERY_CAPACITY_MAH 210
 
 /**
  * @brief Inicializa o handler da bateria, o driver do BQ25622 e o mdulo SOC.
+ * Registra um temporizador peridico que atualiza o SOC e a tela de bateria.
  * @param hi2c Ponteiro para o handle I2C.
  */
 void Battery_Handler_Init(I2C_HandleTypeDef *hi2c);
 
 /**
- * @brief Processa a lgica de atualizao do SOC e da tela de bateria.
- *        Deve ser chamado continuamente no loop principal.
+ * @brief Rel o ID do BQ25622 pelo I2C (transao curta).
+ * @return true se o carregador respondeu com o ID esperado.
  */
-void Battery_Handler_Process(void);
+bool Battery_Handler_Verificar_Carregador(void);
+
+/**
+ * @brief Atualizao do SOC numa acordada peridica do Stop: s I2C, sem
+ * eventos para o display. Integra o intervalo inteiro desde a anterior.
+ * @param intervalo_ms Tempo desde a ltima atualizao.
+ * @param corrente_piso_A Consumo modelado em repouso (ver bq_soc).
+ * @return false se o carregador no foi detectado na inicializao.
+ */
+bool Battery_Handler_Atualizar_Sono(uint32_t intervalo_ms, float corrente_piso_A);
 
 #endif // BATTERY_HANDLER_H
\ No newline at end of file
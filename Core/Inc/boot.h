@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * @file        boot.h
+ * @brief       Marcas de tempo das fases do boot e opo de boot rpido.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada fase  marcada uma nica vez (a primeira chamada vale),
+ * em s desde o HAL_Init, usando o SysTick (o TIM14 ainda no existe nas
+ * primeiras fases). O tempo entre o reset e o main() no  medido.
+ * Comando BOOT do CLI.
+ *
+ * Com BOOT_RAPIDO_HABILITADO a tela principal aparece assim que a
+ * configurao est carregada e o display responde; bateria, histrico
+ * de lotes e autodiagnstico rodam depois, sem telas de verificao.
+ ******************************************************************************/
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BOOT_RAPIDO_HABILITADO
+#define BOOT_RAPIDO_HABILITADO      1
+#endif
+
+#define BOOT_SEM_MARCA              0xFFFFFFFFu
+
+typedef enum {
+    BOOT_FASE_HAL,              // HAL_Init concludo
+    BOOT_FASE_CLOCK,            // SystemClock_Config concludo
+    BOOT_FASE_PERIFERICOS,      // MX_*_Init concludos (display j alimentado)
+    BOOT_FASE_USB,              // PCD do USB inicializado
+    BOOT_FASE_CONFIG,           // Configurao validada/restaurada da EEPROM
+    BOOT_FASE_APP_INIT,         // App_Manager_Init e CLI concludos
+    BOOT_FASE_DISPLAY_PRONTO,   // Display respondeu (ou timeout)
+    BOOT_FASE_TELA_PRINCIPAL,   // Comando da tela principal enfileirado
+    BOOT_FASE_INIT_ADIADA,      // Bateria e histrico de lotes inicializados
+    BOOT_FASE_DIAGNOSTICO,      // Primeiro autodiagnstico concludo
+    NUM_BOOT_FASES
+} Boot_Fase_t;
+
+/**
+ * @brief Registra o instante da fase (s a primeira chamada por fase conta).
+ */
+void Boot_Marcar(Boot_Fase_t fase);
+
+/**
+ * @brief Instante da fase em s desde o HAL_Init, ou BOOT_SEM_MARCA.
+ */
+uint32_t Boot_Get_Marca_us(Boot_Fase_t fase);
+
+/**
+ * @brief Nome da fase para relatrios.
+ */
+const char* Boot_Get_Nome(Boot_Fase_t fase);
+
+#endif // BOOT_H
@@ -16,14 +16,24 @@ void bq_soc_coulomb_init(I2C_HandleTypeDef *hi2c, uint16_t battery_capacity_mah)
 
 /**
  * @brief Funo de atualizao do contador.
- * Deve ser chamada de dentro do loop principal (while(1)).
- * Esta funo verifica uma flag interna (setada pelo Systick) e executa
- * o clculo de integrao de corrente apenas quando necessrio (a cada 1s).
+ * Deve ser chamada a cada 1 s (temporizador peridico do battery_handler):
+ * a integrao de corrente assume esse intervalo fixo.
  *
  * @param hi2c Ponteiro para o handle I2C (para ler IBAT e CHG_STATUS).
  */
 void bq_soc_coulomb_update(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief Atualizao com intervalo explcito (acordadas peridicas do Stop).
+ * Em repouso a corrente real fica abaixo da zona morta do IBAT e seria
+ * contada como zero; descarregando, usa 'corrente_piso_A' no lugar.
+ *
+ * @param hi2c Ponteiro para o handle I2C.
+ * @param intervalo_ms Tempo desde a atualizao anterior.
+ * @param corrente_piso_A Consumo modelado em repouso (positivo, em A; 0 = sem piso).
+ */
+void bq_soc_coulomb_update_intervalo(I2C_HandleTypeDef *hi2c, uint32_t intervalo_ms, float corrente_piso_A);
+
 /**
  * @brief Retorna a porcentagem de bateria calculada mais recente.
  * @return Porcentagem (0.0f a 100.0f).
@@ -60,10 +70,4 @@ BQ25622_ChargeStatus_t bq_soc_get_last_chg_status(void);
  */
 float bq_soc_get_last_tdie(void);
 
-/**
- * @brief Callback do SysTick. Deve ser chamado a cada 1ms.
- * Coloque 'bq_soc_systick_callback();' dentro de 'HAL_SYSTICK_Callback(void)'.
- */
-void bq_soc_systick_callback(void);
-
 #endif /* INC_BQ_SOC_H_ */
\ No newline at end of file
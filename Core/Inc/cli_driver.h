@@ -73,6 +73,19 @@ void CLI_Receive_Char(uint8_t received_char);
  */
 bool CLI_Is_USB_Connected(void);
 
+/**
+ * @brief Espao livre no FIFO de TX, em bytes.
+ *
+ * til para quem envia muitos dados em partes (ex.: dump do profiler) sem
+ * perder o final quando o FIFO enche.
+ */
+uint16_t CLI_Get_TX_Livre(void);
+
+/**
+ * @brief Indica se ainda h bytes no FIFO de TX esperando o CLI_TX_Pump.
+ */
+bool CLI_TX_Pendente(void);
+
 /**
  * @brief Processa o comando pendente chamando o callback de linha.
  *
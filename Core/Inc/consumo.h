@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * @file        consumo.h
+ * @brief       Contabilidade de energia por subsistema e autonomia da bateria.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A cada leitura do carregador (1 s, battery_handler) o consumo
+ * medido na bateria (IBAT do ADC do BQ25622, em descarga e sem VBUS) 
+ * repartido entre os subsistemas ativos naquele segundo: base (MCU, sensores
+ * e lgica do display), backlight (proporcional ao nvel), servos em
+ * movimento, USB com host e medio em andamento. Cada subsistema tem uma
+ * corrente nominal que o modelo corrige por NLMS contra a medio; a soma
+ * prevista tambm cobre os segundos em que a IBAT cai na zona morta.
+ * A autonomia vem da carga restante (SoC x capacidade) sobre a mdia recente
+ * da descarga. Comando CONSUMO do CLI e tela de bateria do DWIN.
+ ******************************************************************************/
+
+#ifndef CONSUMO_H
+#define CONSUMO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CONSUMO_HABILITADO
+#define CONSUMO_HABILITADO          1
+#endif
+
+#define CONSUMO_AUTONOMIA_INDEFINIDA    UINT32_MAX  // Carregando ou sem descarga
+
+typedef enum {
+    CONSUMO_BASE,
+    CONSUMO_BACKLIGHT,
+    CONSUMO_SERVOS,
+    CONSUMO_USB,
+    CONSUMO_MEDICAO,
+    NUM_CONSUMIDORES
+} Consumo_Subsistema_t;
+
+typedef struct {
+    float corrente_mA;          // Estimada com o subsistema 100% ativo
+    float media_mA;             // Parcela mdia recente na descarga
+    float carga_mAh;            // Acumulada na bateria desde o boot/ZERAR
+    float atividade;            // ltimo estado (0..1)
+} Consumo_Subsistema_Info_t;
+
+typedef struct {
+    float    media_medida_mA;   // Descarga mdia recente (medida ou prevista)
+    float    media_prevista_mA;
+    float    erro_medio_mA;     // Mdia do |medida - prevista| nas amostras vlidas
+    float    carga_sono_mAh;    // Integrada pelas acordadas do Stop (piso modelado)
+    uint32_t amostras;          // Segundos contabilizados em descarga
+    uint32_t amostras_validas;  // Com IBAT fora da zona morta (usadas no ajuste)
+    uint32_t autonomia_min;     // CONSUMO_AUTONOMIA_INDEFINIDA se no se aplica
+    bool     em_descarga;
+} Consumo_Relatorio_t;
+
+void Consumo_Init(void);
+
+/**
+ * @brief Amostra do battery_handler logo aps a atualizao do SoC.
+ * @param intervalo_ms Tempo desde a amostra anterior.
+ */
+void Consumo_Amostrar(uint32_t intervalo_ms);
+
+/**
+ * @brief Carga de um intervalo dormido em Stop (s o piso modelado).
+ */
+void Consumo_Contabilizar_Sono(uint32_t intervalo_ms, float corrente_piso_A);
+
+void Consumo_Get_Relatorio(Consumo_Relatorio_t* relatorio_out);
+void Consumo_Get_Subsistema(Consumo_Subsistema_t subsistema, Consumo_Subsistema_Info_t* info_out);
+const char* Consumo_Get_Nome(Consumo_Subsistema_t subsistema);
+
+/**
+ * @brief Zera as cargas acumuladas e as mdias; mantm as correntes aprendidas.
+ */
+void Consumo_Zerar(void);
+
+#endif // CONSUMO_H
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * @file        corrotina.h
+ * @brief       Corrotinas sem pilha (protothreads) para fluxos com espera.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Permitem escrever uma sequncia com esperas (ligar algo,
+ * aguardar 800 ms, aguardar um evento...) de forma linear, sem HAL_Delay:
+ * a cada espera a funo retorna CR_ESPERANDO e, na prxima chamada,
+ * continua da mesma linha. O estado  s a linha de retomada, uma marca e
+ * o prazo da espera (2 + 4 + 4 bytes), ento o super-loop segue atendendo
+ * USB e display. Cr_Restante_ms() diz ao gerenciador de energia quanto
+ * tempo a corrotina ainda vai dormir.
+ *
+ * Uso:
+ *     static Cr_Estado_t Sequencia(Corrotina_t* cr)
+ *     {
+ *         CR_INICIO(cr);
+ *         Liga_Display();
+ *         CR_AGUARDAR_MS(cr, 800);
+ *         CR_AGUARDAR_ATE(cr, !DWIN_Driver_IsTxBusy());
+ *         CR_AGUARDAR_EVENTO(cr, EVT_MEDICAO_PRONTA);
+ *         CR_FIM(cr);
+ *     }
+ *
+ *     CR_INICIALIZAR(&s_cr);                        // Antes da primeira chamada
+ *     if (Sequencia(&s_cr) == CR_TERMINOU) { ... }   // Chamar at terminar
+ *
+ * Restries (consequncia do switch por trs das macros):
+ *  - variveis locais NO sobrevivem a uma espera: use static ou um contexto;
+ *  - no usar as macros de espera dentro de um switch do prprio corpo.
+ ******************************************************************************/
+
+#ifndef CORROTINA_H
+#define CORROTINA_H
+
+#include "main.h"
+#include "eventos.h"
+#include <stdint.h>
+
+typedef struct {
+    uint16_t linha;     // Ponto de retomada (0 = incio)
+    uint32_t marca;     // Tick ou sequncia de evento da espera atual
+    uint32_t espera_ms; // Prazo de CR_AGUARDAR_MS (0 = espera por condio)
+} Corrotina_t;
+
+typedef enum {
+    CR_ESPERANDO,
+    CR_TERMINOU
+} Cr_Estado_t;
+
+#define CR_SEM_PRAZO                UINT32_MAX
+
+// A espera cai de propsito no prprio case: avisa o -Wimplicit-fallthrough.
+#if defined(__has_attribute)
+#if __has_attribute(fallthrough)
+#define CR__SEGUE                   __attribute__((fallthrough))
+#endif
+#endif
+#ifndef CR__SEGUE
+#define CR__SEGUE
+#endif
+
+#define CR_INICIALIZAR(cr)          do { (cr)->linha = 0u; (cr)->espera_ms = 0u; } while (0)
+
+#define CR_INICIO(cr)               switch ((cr)->linha) { case 0u:
+
+#define CR_FIM(cr)                  } (cr)->linha = 0u; return CR_TERMINOU
+
+/** @brief Encerra a corrotina antes do fim (a prxima chamada recomea). */
+#define CR_SAIR(cr)                 do { (cr)->linha = 0u; return CR_TERMINOU; } while (0)
+
+/** @brief Retorna uma vez ao chamador e continua na prxima chamada. */
+#define CR_CEDER(cr)                do { (cr)->espera_ms = 0u; (cr)->linha = (uint16_t)__LINE__; return CR_ESPERANDO; \
+                                         case __LINE__:; } while (0)
+
+#define CR__AGUARDAR(cr, cond)      do { (cr)->linha = (uint16_t)__LINE__; CR__SEGUE; case __LINE__: \
+                                         if (!(cond)) return CR_ESPERANDO; } while (0)
+
+#define CR_AGUARDAR_ATE(cr, cond)   do { (cr)->espera_ms = 0u; CR__AGUARDAR((cr), (cond)); } while (0)
+
+#define CR_AGUARDAR_MS(cr, ms)      do { (cr)->marca = HAL_GetTick(); (cr)->espera_ms = (uint32_t)(ms); \
+                                         CR__AGUARDAR((cr), (HAL_GetTick() - (cr)->marca) >= (cr)->espera_ms); } while (0)
+
+/** @brief Espera a prxima publicao de um evento do tipo dado. */
+#define CR_AGUARDAR_EVENTO(cr, tipo) do { (cr)->marca = Eventos_Get_Sequencia(tipo); \
+                                         CR_AGUARDAR_ATE((cr), Eventos_Get_Sequencia(tipo) != (cr)->marca); } while (0)
+
+/**
+ * @brief Tempo que falta na espera CR_AGUARDAR_MS atual; CR_SEM_PRAZO se a
+ * corrotina espera uma condio (s a interrupo que a muda sabe quando).
+ */
+static inline uint32_t Cr_Restante_ms(const Corrotina_t* cr)
+{
+    if (cr->espera_ms == 0u) return CR_SEM_PRAZO;
+    uint32_t decorrido = HAL_GetTick() - cr->marca;
+    return (decorrido >= cr->espera_ms) ? 0u : (cr->espera_ms - decorrido);
+}
+
+#endif // CORROTINA_H
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * @file        diagnostico.h
+ * @brief       Autodiagnstico no bloqueante, executado em passos.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada verificao  um passo da tabela em diagnostico.c com
+ * incio, verificao peridica e timeout. O executor roda num temporizador
+ * da roda de tempo, ento o super-loop (display, USB, medio) continua
+ * atendido durante o diagnstico. Os resultados ficam em cache: uma
+ * execuo "quente" (ao acordar do Stop) no troca de tela e s repete os
+ * passos que falharam ou que dependem do tempo dormido.
+ ******************************************************************************/
+
+#ifndef DIAGNOSTICO_H
+#define DIAGNOSTICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    DIAG_PENDENTE,
+    DIAG_OK,
+    DIAG_FALHA
+} Diag_Resultado_t;
+
+/**
+ * @brief Cria o temporizador do executor. Chamar aps Temporizador_Init().
+ */
+void Diagnostico_Init(void);
+
+/**
+ * @brief Dispara uma execuo do autodiagnstico (retorna imediatamente).
+ * @param tela_retorno Tela exibida ao concluir a execuo fria.
+ * @param quente true: no troca de tela e pula os passos j aprovados.
+ * @return false se j houver uma execuo em andamento.
+ */
+bool Diagnostico_Iniciar(uint16_t tela_retorno, bool quente);
+
+/**
+ * @brief Indica se h uma execuo em andamento.
+ */
+bool Diagnostico_Em_Andamento(void);
+
+/**
+ * @brief Indica se a ltima execuo concluda passou em todos os passos crticos.
+ */
+bool Diagnostico_Aprovado(void);
+
+#endif // DIAGNOSTICO_H
@@ -51,11 +51,22 @@ void Display_Set_Serial(const uint8_t* dwin_data, uint16_t len, uint16_t receive
 /**
  * @brief Inicia a sequncia de telas para o processo de medio.
  * Esta funo  NO-BLOQUEANTE e apenas inicia a mquina de estados.
+ * @return false se j havia uma medio em andamento (nada  iniciado).
  */
-void Display_StartMeasurementSequence(void);
+bool Display_StartMeasurementSequence(void);
 
 // --- Getters/Setters para estado interno ---
 void Display_SetPrintingEnabled(bool is_enabled);
 bool Display_IsPrintingEnabled(void);
 
+/**
+ * @brief Nvel de backlight comandado ao DWIN (10 em standby, 100 ativo).
+ */
+uint8_t Display_Get_Backlight(void);
+
+/**
+ * @brief true enquanto a sequncia de medio das telas est em andamento.
+ */
+bool Display_Medicao_Em_Andamento(void);
+
 #endif // DISPLAY_HANDLER_H
\ No newline at end of file
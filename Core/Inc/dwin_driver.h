@@ -88,6 +88,12 @@ enum
 		VP_IBAT          = 0x2310,
 		VP_TEMP          = 0x2320,
 		VP_PERC          = 0x2330,
+		VP_AUTONOMIA     = 0x2340,  // Minutos (-1 carregando/indefinida)
+		VP_CONSUMO_BASE  = 0x2350,  // Parcelas por subsistema, 0,1 mA
+		VP_CONSUMO_LUZ   = 0x2360,
+		VP_CONSUMO_SERVO = 0x2370,
+		VP_CONSUMO_USB   = 0x2380,
+		VP_CONSUMO_MEDE  = 0x2390,
 		
     VP_MESSAGES      = 0x4096,
 
@@ -276,6 +282,18 @@ void DWIN_TX_Pump(void);
  */
 bool DWIN_Driver_IsTxBusy(void);
 
+/**
+ * @brief Indica se a ISR entregou um pacote que DWIN_Driver_Process() ainda
+ * nao tratou.
+ */
+bool DWIN_Driver_IsRxPending(void);
+
+/**
+ * @brief Indica se ha um quadro chegando ou ainda nao tratado: byte na
+ * USART, bytes no buffer do DMA antes do IDLE, ou pacote pendente.
+ */
+bool DWIN_Driver_IsRxBusy(void);
+
 
 /*
 ==================================================
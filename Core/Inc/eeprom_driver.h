@@ -115,4 +115,27 @@ void EEPROM_Driver_FSM_Process(void);
  */
 bool EEPROM_Driver_GetAndClearErrorFlag(void);
 
+
+/**
+ * @brief Queda de energia iminente: a pgina em curso (j enviada ou em
+ * tWR) termina, nenhuma outra comea e novas escritas assncronas so
+ * recusadas at `EEPROM_Driver_Liberar()`. A operao interrompida
+ * termina em FSM_ERROR. As funes bloqueantes continuam disponveis
+ * para a gravao do estado crtico.
+ * @return true se havia uma escrita assncrona em andamento.
+ */
+bool EEPROM_Driver_Abortar(void);
+
+
+/**
+ * @brief Volta a aceitar escritas assncronas (energia restabelecida).
+ */
+void EEPROM_Driver_Liberar(void);
+
+
+/**
+ * @brief Indica se as escritas assncronas esto bloqueadas por `EEPROM_Driver_Abortar()`.
+ */
+bool EEPROM_Driver_Is_Abortado(void);
+
 #endif // EEPROM_DRIVER_H
\ No newline at end of file
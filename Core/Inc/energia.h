@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * @file        energia.h
+ * @brief       Gerenciador de energia: escolhe o modo de baixo consumo de
+ *              cada perodo ocioso do super-loop.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A cada perodo ocioso o gerenciador prev quanto tempo falta
+ * para o prximo trabalho: a prxima tarefa peridica ou a espera da
+ * corrotina (fornecidas pelo chamador) e o prximo temporizador da roda.
+ * Em seguida consulta a tabela de restries. Cada perifrico com atividade
+ * em curso (USB, display/DMA, EEPROM, servos, medio) limita o modo mais
+ * profundo permitido. O gerenciador ento escolhe:
+ *  - SLEEP: WFI com clocks ligados; acorda no prximo SysTick ou IRQ;
+ *  - STOP:  regulador principal, clocks parados, alarme do RTC no prazo
+ *           previsto. Na volta restaura os clocks e compensa o HAL tick e
+ *           a roda de temporizao com o tempo medido pelo RTC.
+ * O Stop pode voltar com o clock reduzido (HSISYS/4), para tarefas curtas de
+ * fundo ou por deciso do governador de clock; Energia_Set_Clock troca o
+ * clock e refaz as bases de tempo de todos os perifricos que dependem dele.
+ * Com o barramento USB suspenso pelo host, o HSI48  desligado e a USB deixa
+ * de impedir o Stop (o pedido de retomada acorda o MCU pela EXTI da USB).
+ * Standby no entra na escolha: perde a SRAM e volta por reset, ento no
+ * serve como modo ocioso deste firmware.
+ ******************************************************************************/
+
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ENERGIA_SEM_PRAZO       UINT32_MAX
+#define ENERGIA_STOP_FALHOU     UINT32_MAX  // Retorno de Energia_Stop sem RTC
+
+typedef enum {
+    ENERGIA_EXECUTANDO,     // Ncleo rodando (inclui o tempo das tarefas)
+    ENERGIA_SLEEP,
+    ENERGIA_STOP,
+    NUM_NIVEIS_ENERGIA
+} Energia_Nivel_t;
+
+typedef enum {
+    ENERGIA_CLOCK_CHEIO,        // Como o SystemClock_Config: 48 MHz, HSI48 da USB
+    ENERGIA_CLOCK_REDUZIDO,     // HSISYS/4 = 12 MHz, HSI48 s com a USB ativa
+    NUM_CLOCKS_ENERGIA
+} Energia_Clock_t;
+
+/**
+ * @brief Previso, em ms, do prximo trabalho do chamador (0 = j h trabalho).
+ * Chamada com interrupes bloqueadas.
+ */
+typedef uint32_t (*Energia_Previsao_t)(void);
+
+typedef struct {
+    uint64_t tempo_us;
+    uint32_t entradas;
+} Energia_Residencia_t;
+
+typedef struct {
+    uint32_t suspensoes;
+    uint64_t tempo_suspenso_ms;
+    uint32_t retomada_max_us;   // Do aviso de retomada at a tarefa ver o HSI48 pronto
+    bool     suspenso;
+} Energia_USB_t;
+
+/**
+ * @brief Habilita a interrupo do RTC (alarme A acorda o Stop).
+ */
+void Energia_Init(RTC_HandleTypeDef* hrtc);
+
+/**
+ * @brief Dorme no modo mais profundo permitido at o prximo trabalho.
+ * @param nivel_max Limite imposto pelo estado da aplicao.
+ * @param previsao  Previso do chamador (NULL = s a roda de temporizao).
+ */
+void Energia_Ocioso(Energia_Nivel_t nivel_max, Energia_Previsao_t previsao);
+
+/**
+ * @brief Entra em Stop incondicionalmente at uma interrupo externa ou o
+ * prazo (ENERGIA_SEM_PRAZO = s externa). Se o alarme no puder ser
+ * armado, dorme sem prazo.
+ * @param clock_volta Clock com que retorna (HAL tick e TIM14 j ajustados).
+ * @return Tempo dormido em ms, medido pelo RTC; ENERGIA_STOP_FALHOU se no
+ * dormiu (RTC no inicializado).
+ */
+uint32_t Energia_Stop(uint32_t prazo_ms, Energia_Clock_t clock_volta);
+
+/**
+ * @brief Indica se o ltimo Stop terminou pelo alarme do RTC (prazo vencido)
+ * e no por uma interrupo externa.
+ */
+bool Energia_Acordou_Pelo_Alarme(void);
+
+/**
+ * @brief Troca o clock do sistema e refaz HAL tick, TIM14, baud da USART2,
+ * timing do I2C1, PWM dos servos e TIM3 do profiler para o clock novo.
+ * Chamar s com Energia_Clock_Pode_Trocar() verdadeiro.
+ */
+void Energia_Set_Clock(Energia_Clock_t clock);
+
+Energia_Clock_t Energia_Get_Clock(void);
+
+/**
+ * @brief Nenhuma transferncia em curso nos perifricos retemporizados
+ * (TX e RX do display, FSM da EEPROM, I2C1).
+ */
+bool Energia_Clock_Pode_Trocar(void);
+
+/**
+ * @brief Aviso do USBX (contexto de interrupo): o host suspendeu (true) ou
+ * retomou/desconectou (false) o barramento.
+ */
+void Energia_USB_Suspenso(bool suspenso);
+
+/**
+ * @brief Confere, em contexto de tarefa, a partida do HSI48 pedida na
+ * retomada e registra o tempo at ela.
+ * @return true enquanto o HSI48 ainda no est pronto.
+ */
+bool Energia_USB_Retomando(void);
+
+/**
+ * @brief Indica se o barramento est suspenso: CLI e logs ficam desligados.
+ */
+bool Energia_Get_USB_Suspenso(void);
+
+void Energia_Get_USB(Energia_USB_t* usb_out);
+
+void Energia_Get_Residencia(Energia_Nivel_t nivel, Energia_Residencia_t* residencia_out);
+const char* Energia_Get_Nome_Nivel(Energia_Nivel_t nivel);
+
+/**
+ * @brief Quantas vezes cada restrio impediu um Stop que a previso permitia.
+ */
+uint8_t Energia_Get_Num_Restricoes(void);
+const char* Energia_Get_Nome_Restricao(uint8_t indice);
+uint32_t Energia_Get_Bloqueios(uint8_t indice);
+
+void Energia_Zerar(void);
+
+#endif // ENERGIA_H
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * @file        escalonador.h
+ * @brief       Escalonador cooperativo de tarefas do super-loop.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Executa apenas as tarefas prontas (perodo vencido ou evento
+ * sinalizado), sempre a de maior prioridade primeiro. Uma tarefa peridica
+ * com previso s faz polling enquanto tem trabalho: parada, no limita o
+ * tempo ocioso que o gerenciador de energia usa para escolher o Stop.
+ ******************************************************************************/
+
+#ifndef ESCALONADOR_H
+#define ESCALONADOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ESCALONADOR_MAX_TAREFAS 16
+
+// Medio do tempo de cada tarefa e do loop (comando STATS do CLI).
+// Com 0, o cdigo de medio no  compilado.
+#ifndef ESCALONADOR_ESTATISTICAS
+#define ESCALONADOR_ESTATISTICAS 1
+#endif
+
+#define ESCALONADOR_HIST_FAIXAS 4   // <100 us, <1 ms, <10 ms, >=10 ms
+
+typedef void (*Tarefa_Funcao_t)(void);
+
+/**
+ * @brief Milissegundos at a tarefa ter trabalho: 0 = agora, UINT32_MAX = s
+ * depois de uma interrupo ou de outra tarefa. Tambm  chamada com
+ * interrupes bloqueadas: s consulta, no altera estado.
+ */
+typedef uint32_t (*Tarefa_Previsao_t)(void);
+
+/**
+ * @brief Descrio esttica de uma tarefa. O ndice na tabela  o ID da tarefa.
+ */
+typedef struct {
+    const char*     nome;
+    Tarefa_Funcao_t executar;
+    uint16_t        periodo_ms;     // 0 = executa apenas quando sinalizada
+    uint8_t         prioridade;     // 0 = mais alta
+    Tarefa_Previsao_t previsao;     // NULL = roda a cada perodo; seno, s com trabalho
+} Tarefa_t;
+
+/**
+ * @brief Estatstica de durao (em microssegundos).
+ */
+typedef struct {
+    uint32_t execucoes;
+    uint64_t soma_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t histograma[ESCALONADOR_HIST_FAIXAS];
+} Escalonador_Estatistica_t;
+
+/**
+ * @brief Registra a tabela de tarefas. A tabela deve permanecer vlida.
+ */
+void Escalonador_Init(const Tarefa_t* tabela, uint8_t num_tarefas);
+
+/**
+ * @brief Marca uma tarefa como pronta. Pode ser chamada de uma ISR.
+ */
+void Escalonador_Sinalizar(uint8_t id_tarefa);
+
+/**
+ * @brief Executa as tarefas prontas em ordem de prioridade.
+ * @return true se ao menos uma tarefa foi executada.
+ */
+bool Escalonador_Executar(void);
+
+/**
+ * @brief Milissegundos at alguma tarefa ficar pronta: 0 se j houver uma
+ * pronta ou sinalizada, UINT32_MAX se nenhuma tiver prazo (s sinalizadas
+ * ou com previso sem trabalho). Chamar com interrupes bloqueadas.
+ */
+uint32_t Escalonador_Get_Ocioso_ms(void);
+
+/**
+ * @brief Maior atraso observado (ms) entre o vencimento e a execuo da tarefa.
+ */
+uint32_t Escalonador_Get_Atraso_Max_ms(uint8_t id_tarefa);
+
+/**
+ * @brief Nmero de tarefas registradas e nome de cada uma.
+ */
+uint8_t Escalonador_Get_Num_Tarefas(void);
+const char* Escalonador_Get_Nome(uint8_t id_tarefa);
+
+#if ESCALONADOR_ESTATISTICAS
+/**
+ * @brief Durao das execues de uma tarefa.
+ */
+bool Escalonador_Get_Estatistica_Tarefa(uint8_t id_tarefa, Escalonador_Estatistica_t* estatistica_out);
+
+/**
+ * @brief Durao das passadas com trabalho e perodo entre passadas do loop.
+ */
+void Escalonador_Get_Estatistica_Loop(Escalonador_Estatistica_t* passada_out, Escalonador_Estatistica_t* periodo_out);
+
+/**
+ * @brief Zera todas as estatsticas (inclusive o atraso mximo).
+ */
+void Escalonador_Zerar_Estatisticas(void);
+#endif
+
+
+#endif // ESCALONADOR_H
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * @file        estimador_peso.h
+ * @brief       Estimador do peso final a partir do transiente da balana.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Ajusta, de forma incremental e em ponto fixo, um modelo
+ * autorregressivo de 2 ordem sobre as diferenas do peso. O modelo cobre
+ * tanto a acomodao exponencial quanto a oscilao amortecida da clula,
+ * e fornece o peso assinttico previsto com uma faixa de incerteza.
+ * No depende do HAL: recebe amostras igualmente espaadas em mg.
+ ******************************************************************************/
+
+#ifndef ESTIMADOR_PESO_H
+#define ESTIMADOR_PESO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Estado de uma instncia do estimador. Campos internos; use a API.
+ */
+typedef struct {
+    // Somas ponderadas (esquecimento exponencial) das equaes normais
+    int64_t s11, s12, s22, sy1, sy2;
+    int64_t var_residuo;        // Varincia do erro de predio de 1 passo (mg)
+
+    int32_t peso_anterior_mg;
+    int32_t dif_1;              // d[n]   = w[n]   - w[n-1]
+    int32_t dif_2;              // d[n-1] = w[n-1] - w[n-2]
+    int32_t a1_q16, a2_q16;     // Coeficientes do modelo em Q16
+    bool    modelo_valido;
+
+    int32_t tolerancia_mg;
+    uint16_t amostras;
+    uint8_t  amostras_convergidas;
+
+    // Resultado
+    int32_t peso_previsto_mg;
+    int32_t incerteza_mg;
+    bool    convergiu;
+} Estimador_Peso_t;
+
+/**
+ * @brief Reinicia o estimador para um novo transiente.
+ * @param tolerancia_mg Incerteza mxima aceita para declarar convergncia.
+ */
+void EstimadorPeso_Reiniciar(Estimador_Peso_t* est, int32_t tolerancia_mg);
+
+/**
+ * @brief Alimenta uma nova amostra de peso (perodo de amostragem constante).
+ */
+void EstimadorPeso_Adicionar(Estimador_Peso_t* est, int32_t peso_mg);
+
+/**
+ * @brief Indica se a previso est estvel e dentro da tolerncia.
+ */
+bool EstimadorPeso_Convergiu(const Estimador_Peso_t* est);
+
+/**
+ * @brief Peso assinttico previsto, em mg.
+ */
+int32_t EstimadorPeso_Get_Previsto_mg(const Estimador_Peso_t* est);
+
+/**
+ * @brief Meia-largura da faixa de confiana da previso, em mg.
+ */
+int32_t EstimadorPeso_Get_Incerteza_mg(const Estimador_Peso_t* est);
+
+#endif // ESTIMADOR_PESO_H
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * @file        eventos.h
+ * @brief       Fila de eventos tipados (publica/assina) em memria esttica.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Produtores publicam eventos sem conhecer quem os trata; a
+ * tarefa de eventos despacha um lote limitado por passada do escalonador,
+ * de modo que um toque no display no vira uma cadeia longa de chamadas
+ * dentro do driver. Tambm  o ponto nico de contagem dos eventos.
+ ******************************************************************************/
+
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENTOS_FILA_TAMANHO        8
+#define EVENTOS_DADOS_MAX           64  // >= DWIN_RX_BUFFER_SIZE (pacote completo do display)
+#define EVENTOS_MAX_ASSINANTES      4   // Por tipo de evento
+
+typedef enum {
+    EVT_TOQUE_DWIN,         // Pacote recebido do display (dados = pacote bruto)
+    EVT_MEDICAO_PRONTA,     // Nova Frequencia/Escala A publicada (valor = tempo de integrao em ms)
+    EVT_CONFIG_ALTERADA,    // Configurao gravada na EEPROM
+    EVT_BATERIA_ALTERADA,   // cone de bateria mudou (valor = novo cone)
+    NUM_TIPOS_EVENTO
+} Evento_Tipo_t;
+
+typedef struct {
+    Evento_Tipo_t tipo;
+    uint16_t      tamanho;                  // Bytes vlidos em dados[]
+    int32_t       valor;                    // Carga simples, dependente do tipo
+    uint8_t       dados[EVENTOS_DADOS_MAX];
+} Evento_t;
+
+typedef void (*Evento_Assinante_t)(const Evento_t* evento);
+
+typedef struct {
+    uint32_t publicados;
+    uint32_t descartados;       // Fila cheia ou dados grandes demais
+    uint32_t despachados;
+    uint32_t tempo_max_ms;      // Maior tempo gasto pelos assinantes de um evento
+} Evento_Estatistica_t;
+
+/**
+ * @brief Zera a fila e os assinantes.
+ * @param ao_publicar Chamado a cada publicao (pode ser NULL). Usado para
+ *                    sinalizar a tarefa que chama Eventos_Despachar().
+ */
+void Eventos_Init(void (*ao_publicar)(void));
+
+/**
+ * @brief Registra um assinante para um tipo de evento.
+ */
+bool Eventos_Assinar(Evento_Tipo_t tipo, Evento_Assinante_t assinante);
+
+/**
+ * @brief Enfileira um evento (copia os dados). Pode ser chamada de uma ISR.
+ * @return false se a fila estiver cheia ou os dados no couberem.
+ */
+bool Eventos_Publicar(Evento_Tipo_t tipo, int32_t valor, const uint8_t* dados, uint16_t tamanho);
+
+/**
+ * @brief Despacha at max_eventos eventos da fila (contexto principal).
+ * @return Nmero de eventos despachados.
+ */
+uint8_t Eventos_Despachar(uint8_t max_eventos);
+
+/**
+ * @brief Indica se h eventos na fila.
+ */
+bool Eventos_Ha_Pendentes(void);
+
+/**
+ * @brief Contadores de um tipo de evento.
+ */
+void Eventos_Get_Estatistica(Evento_Tipo_t tipo, Evento_Estatistica_t* estatistica_out);
+
+/**
+ * @brief Nmero de eventos do tipo aceitos na fila desde o boot (no 
+ * zerado com as estatsticas). Base de CR_AGUARDAR_EVENTO.
+ */
+uint32_t Eventos_Get_Sequencia(Evento_Tipo_t tipo);
+
+/**
+ * @brief Zera os contadores e a ocupao mxima (no mexe na fila).
+ */
+void Eventos_Zerar_Estatisticas(void);
+
+/**
+ * @brief Maior ocupao observada da fila.
+ */
+uint8_t Eventos_Get_Ocupacao_Max(void);
+
+/**
+ * @brief Nome curto do tipo de evento (para logs e CLI).
+ */
+const char* Eventos_Get_Nome(Evento_Tipo_t tipo);
+
+#endif // EVENTOS_H
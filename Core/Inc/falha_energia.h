@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * @file        falha_energia.h
+ * @brief       Antecipao de queda de energia e gravao do estado crtico.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Trs origens indicam que a alimentao vai acabar:
+ *  - POWER_GOOD baixo (entrada perdida) sem bateria capaz de sustentar;
+ *  - bateria abaixo do nvel crtico, sem carregador (status do BQ25622);
+ *  - VDDA, medida pelo VREFINT, caindo abaixo do mnimo.
+ * Na primeira deteco o mdulo interrompe o trabalho no crtico (lote em
+ * curso, novas escritas assncronas na EEPROM), deixa terminar s a pgina
+ * que j est na EEPROM e grava o estado crtico num registro de 32 bytes:
+ * uma nica escrita de pgina, alternando entre dois slots para que um corte
+ * no meio dela preserve o registro anterior. Com todas as origens normais
+ * por RESTABELECIMENTO_MS a EEPROM  liberada e a configurao  regravada.
+ ******************************************************************************/
+
+#ifndef FALHA_ENERGIA_H
+#define FALHA_ENERGIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FALHA_ENERGIA_HABILITADA
+#define FALHA_ENERGIA_HABILITADA    1
+#endif
+
+typedef enum {
+    FALHA_ORIGEM_POWER_GOOD,
+    FALHA_ORIGEM_BATERIA,
+    FALHA_ORIGEM_VDDA,
+    FALHA_ORIGEM_SIMULADA,      // Comando QUEDA SIMULAR do CLI
+    NUM_FALHA_ORIGENS
+} Falha_Origem_t;
+
+// Estado crtico gravado na emergncia (32 bytes, um slot por pgina).
+typedef struct {
+    uint32_t magica;
+    uint32_t sequencia;         // Maior = mais recente
+    uint32_t numero_amostra;    // ltimo nmero do lote
+    uint16_t soc_decimos;       // 0..1000
+    uint16_t vbat_mv;
+    uint16_t quedas;            // Emergncias registradas desde a fabricao
+    uint8_t  origens;           // Mscara de Falha_Origem_t
+    uint8_t  escrita_interrompida;
+    float    umidade;           // ltimo resultado
+    float    peso;
+    uint16_t reservado;
+    uint16_t checksum;          // Deve ser o ltimo campo
+} Falha_Energia_Registro_t;
+
+typedef struct {
+    bool     em_falha;
+    uint8_t  origens;           // Mscara atual
+    uint32_t emergencias;       // Desde o boot
+    uint32_t duracao_max_us;    // Deteco at o registro gravado
+    uint32_t ultima_duracao_us;
+    bool     ultima_gravou;
+} Falha_Energia_Status_t;
+
+/**
+ * @brief L o ltimo registro crtico e arma a EXTI do POWER_GOOD.
+ * Chamar aps EEPROM_Driver_Init().
+ */
+void Falha_Energia_Init(void);
+
+/**
+ * @brief Avalia as origens e executa a emergncia ou o restabelecimento.
+ * Chamar a cada passada do super-loop (e nas acordadas do Stop).
+ */
+void Falha_Energia_Process(void);
+
+/**
+ * @brief Borda de descida do POWER_GOOD (contexto de interrupo).
+ */
+void Falha_Energia_Sinalizar(void);
+
+/**
+ * @brief Fora uma emergncia (teste do caminho completo pelo CLI).
+ */
+void Falha_Energia_Simular(void);
+
+bool Falha_Energia_Em_Falha(void);
+void Falha_Energia_Get_Status(Falha_Energia_Status_t* status_out);
+const char* Falha_Energia_Get_Nome_Origem(Falha_Origem_t origem);
+
+/**
+ * @brief ltimo registro crtico vlido da EEPROM (do boot ou da emergncia).
+ * @return false se nenhum slot  vlido.
+ */
+bool Falha_Energia_Get_Registro(Falha_Energia_Registro_t* registro_out);
+
+#endif // FALHA_ENERGIA_H
@@ -79,6 +79,20 @@ typedef struct {
 
 #define END_OF_CONFIG_DATA    (ADDR_CONFIG_BACKUP2 + CONFIG_BLOCK_SIZE)
 
+// Histrico de amostras (lote_handler): anel de registros alinhado  pgina.
+#define HISTORICO_REGISTRO_SIZE  32
+#define HISTORICO_NUM_REGISTROS  128
+#define ADDR_HISTORICO_LOTES     (((END_OF_CONFIG_DATA + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE) * EEPROM_PAGE_SIZE)
+#define END_OF_HISTORICO         (ADDR_HISTORICO_LOTES + (HISTORICO_NUM_REGISTROS * HISTORICO_REGISTRO_SIZE))
+
+// Estado crtico da queda de energia (falha_energia.c): dois slots, um por pgina.
+#define ADDR_ESTADO_CRITICO      (((END_OF_HISTORICO + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE) * EEPROM_PAGE_SIZE)
+#define END_OF_ESTADO_CRITICO    (ADDR_ESTADO_CRITICO + 2 * EEPROM_PAGE_SIZE)
+
+// Gravao de entradas (gravacao.c): cabealho na primeira pgina, registros at o fim.
+#define ADDR_GRAVACAO            0x8000
+#define END_OF_GRAVACAO          EEPROM_TOTAL_SIZE_BYTES
+
 
 //==============================================================================
 // API Pblica do Mdulo
@@ -128,6 +142,25 @@ void Gerenciador_Config_Marcar_Como_Pendente(void);
  * @return true se h dados para salvar, false caso contrrio.
  */
 bool Gerenciador_Config_Ha_Pendencias(void);
+
+typedef enum {
+    CFG_VERIF_EM_ANDAMENTO,
+    CFG_VERIF_OK,
+    CFG_VERIF_FALHA
+} Config_Verificacao_t;
+
+/**
+ * @brief Inicia a verificao do CRC da cpia primria gravada na EEPROM.
+ */
+void Gerenciador_Config_Verificacao_Iniciar(void);
+
+/**
+ * @brief Avana a verificao lendo alguns blocos pequenos (no l a
+ * estrutura inteira de uma vez). Recomea sozinha se um salvamento usar o
+ * perifrico CRC no meio do caminho. Chamar at retornar OK ou FALHA.
+ */
+Config_Verificacao_t Gerenciador_Config_Verificacao_Passo(void);
+
 // --- Funes "Get" e "Set" (a interface para o resto da aplicao) ---
 
 void Gerenciador_Config_Get_Config_Snapshot(Config_Aplicacao_t* config_out);
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * @file        governador.h
+ * @brief       Governador de clock: reduz o ncleo quando a carga  leve.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A cada GOVERNADOR_PERIODO_MS o governador consulta a tabela de
+ * demandas (USB com host, medio/lote, EEPROM, servos, tela fora da
+ * principal, toque recente, ocupao do ncleo). Qualquer demanda sobe na
+ * hora para o clock cheio; sem nenhuma por GOVERNADOR_DESCIDA_MS, desce para
+ * o reduzido (HSISYS/4). A troca em si e a retemporizao dos perifricos
+ * ficam em energia.c. Comando CLOCK do CLI.
+ ******************************************************************************/
+
+#ifndef GOVERNADOR_H
+#define GOVERNADOR_H
+
+#include "energia.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef GOVERNADOR_HABILITADO
+#define GOVERNADOR_HABILITADO       1
+#endif
+
+#define GOVERNADOR_PERIODO_MS       10u
+#define GOVERNADOR_DESCIDA_MS       2000u
+
+typedef struct {
+    uint64_t executando_us;     // Ncleo rodando neste clock
+    uint64_t sleep_us;          // WFI neste clock
+    uint32_t entradas;
+} Governador_Residencia_t;
+
+typedef struct {
+    Energia_Clock_t clock;
+    uint8_t  demandas;              // Mscara atual
+    uint32_t trocas;
+    uint32_t adiadas;               // Troca esperou um perifrico ocupado
+    uint32_t carga_permil;          // Ocupao do ncleo no ltimo perodo
+    uint32_t carga_uAh;             // Estimada para o MCU (execuo + WFI)
+    uint32_t economia_uAh;          // Em relao a ficar sempre no cheio
+    Governador_Residencia_t residencia[NUM_CLOCKS_ENERGIA];
+} Governador_Relatorio_t;
+
+void Governador_Init(void);
+
+/**
+ * @brief Tarefa peridica do estado ativo.
+ */
+void Governador_Process(void);
+
+/**
+ * @brief Milissegundos at o Process ter deciso a tomar: 0 com alguma demanda
+ * ativa; no clock cheio, o prazo de descida; no reduzido, s quando uma
+ * demanda aparecer. A carga s  reavaliada nas passadas que acontecerem.
+ */
+uint32_t Governador_Get_Proximo_ms(void);
+
+void Governador_Get_Relatorio(Governador_Relatorio_t* relatorio_out);
+
+uint8_t Governador_Get_Num_Demandas(void);
+const char* Governador_Get_Nome_Demanda(uint8_t indice);
+
+/**
+ * @brief Quantas vezes cada demanda levou o clock de volta ao cheio.
+ */
+uint32_t Governador_Get_Subidas(uint8_t indice);
+
+void Governador_Zerar(void);
+
+#endif // GOVERNADOR_H
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * @file        gravacao.h
+ * @brief       Gravao e reproduo das entradas do equipamento.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Registra, com o instante de chegada, os pacotes do display,
+ * as linhas do CLI, as amostras do ADS1232 e os pulsos do TIM2 numa regio
+ * reservada da EEPROM (ADDR_GRAVACAO). A reproduo injeta os mesmos
+ * registros no mesmo ritmo, no lugar do hardware, para repetir um travamento
+ * de campo ou comparar verses do firmware com entradas idnticas.
+ * Comandos GRAVAR e REPRODUZIR do CLI.
+ *
+ * Formato de cada registro (fluxo de bytes, sem alinhamento):
+ *     tipo (1) | delta_ms (varint, 1..5) | carga
+ * onde a carga  tamanho (1) + bytes para DWIN/CLI e 3 bytes (LE) para
+ * ADS (amostra com sinal) e TIM2 (pulsos desde a leitura anterior).
+ ******************************************************************************/
+
+#ifndef GRAVACAO_H
+#define GRAVACAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef GRAVACAO_HABILITADA
+#define GRAVACAO_HABILITADA         0
+#endif
+
+typedef enum {
+    GRV_DWIN_RX,        // Pacote recebido do display
+    GRV_CLI_LINHA,      // Linha recebida pelo CLI (sem terminador)
+    GRV_ADS_AMOSTRA,    // Mediana de 3 do ADS1232
+    GRV_TIM2_PULSOS,    // Pulsos contados desde a leitura anterior
+    NUM_TIPOS_GRAVACAO
+} Gravacao_Tipo_t;
+
+typedef struct {
+    bool     gravando;
+    bool     reproduzindo;
+    uint32_t bytes;             // Gravados (ou restantes, na reproduo)
+    uint32_t capacidade;
+    uint32_t registros;
+    uint32_t descartados;       // Buffer ou regio cheios
+    uint32_t duracao_ms;
+} Gravacao_Status_t;
+
+#if GRAVACAO_HABILITADA
+#define GRAVACAO_BYTES(tipo, dados, tam)    Gravacao_Registrar_Bytes((tipo), (dados), (tam))
+#define GRAVACAO_ADS(amostra)               Gravacao_Registrar_Ads(amostra)
+#define GRAVACAO_PULSOS(contagem)           Gravacao_Registrar_Pulsos(contagem)
+#define GRAVACAO_REPRODUZINDO()             Gravacao_Reproduzindo()
+#else
+#define GRAVACAO_BYTES(tipo, dados, tam)    do { } while (0)
+#define GRAVACAO_ADS(amostra)               do { } while (0)
+#define GRAVACAO_PULSOS(contagem)           do { } while (0)
+#define GRAVACAO_REPRODUZINDO()             false
+#endif
+
+/**
+ * @brief Cria os temporizadores do mdulo. Chamar aps Temporizador_Init().
+ */
+void Gravacao_Init(void);
+
+/**
+ * @brief Comea uma gravao nova (invalida a anterior na EEPROM).
+ * @return false se j houver gravao ou reproduo em andamento.
+ */
+bool Gravacao_Iniciar(void);
+
+/**
+ * @brief Encerra a gravao: descarrega o buffer e grava o cabealho.
+ */
+void Gravacao_Parar(void);
+
+/**
+ * @brief Reproduz a gravao da EEPROM a partir de agora.
+ * @return false se no houver gravao vlida ou o mdulo estiver ocupado.
+ */
+bool Gravacao_Reproduzir(void);
+
+/**
+ * @brief Interrompe a reproduo.
+ */
+void Gravacao_Parar_Reproducao(void);
+
+bool Gravacao_Reproduzindo(void);
+
+/** @brief Registra um pacote (DWIN) ou linha (CLI). Contexto principal. */
+void Gravacao_Registrar_Bytes(Gravacao_Tipo_t tipo, const void* dados, uint16_t tamanho);
+
+/** @brief Registra uma amostra do ADS1232. Contexto principal. */
+void Gravacao_Registrar_Ads(int32_t amostra);
+
+/** @brief Registra uma leitura do contador do TIM2 (valor absoluto). */
+void Gravacao_Registrar_Pulsos(uint32_t contagem);
+
+/**
+ * @brief Na reproduo, entrega a prxima amostra do ADS1232 que j venceu.
+ * @return true se havia amostra nova.
+ */
+bool Gravacao_Get_Amostra_Ads(int32_t* amostra_out);
+
+/**
+ * @brief Na reproduo, contador de pulsos reconstrudo (substitui o TIM2).
+ */
+uint32_t Gravacao_Get_Pulsos(void);
+
+void Gravacao_Get_Status(Gravacao_Status_t* status_out);
+
+#endif // GRAVACAO_H
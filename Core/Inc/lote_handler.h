@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * @file        lote_handler.h
+ * @brief       Interface do Handler de Lotes (modo contnuo de medio).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Numera as amostras de forma sequencial e persistente, grava o
+ * histrico de resultados na EEPROM, envia cada resultado pela USB e mantm
+ * as estatsticas de vazo (amostras/hora) e de tempo por etapa. No modo
+ * lote, a sequncia de medio  reiniciada automaticamente ao fim de cada
+ * amostra, sem voltar  tela PRINCIPAL.
+ ******************************************************************************/
+
+#ifndef LOTE_HANDLER_H
+#define LOTE_HANDLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Etapas da sequncia de medio, usadas na estatstica de tempo.
+typedef enum {
+    LOTE_ETAPA_ENCHIMENTO,
+    LOTE_ETAPA_AJUSTE,
+    LOTE_ETAPA_RASPAGEM,
+    LOTE_ETAPA_PESO,
+    LOTE_ETAPA_TEMPERATURA,
+    LOTE_ETAPA_UMIDADE,
+    LOTE_ETAPA_RESULTADO,
+    LOTE_NUM_ETAPAS
+} LoteEtapa_t;
+
+// Registro do histrico, gravado na EEPROM (32 bytes, alinhado  pgina).
+typedef struct {
+    uint32_t numero_amostra;
+    uint8_t  dia;
+    uint8_t  mes;
+    uint8_t  ano;
+    uint8_t  hora;
+    uint8_t  minuto;
+    uint8_t  segundo;
+    uint8_t  indice_grao;
+    uint8_t  reservado;
+    float    umidade;
+    float    peso;
+    float    densidade;
+    float    temperatura;
+    uint16_t duracao_ciclo_ms;
+    uint16_t checksum;          // Deve ser o ltimo campo
+} Lote_Registro_t;
+
+/**
+ * @brief Localiza o ltimo registro do histrico para continuar a numerao.
+ * @note  Faz leituras bloqueantes da EEPROM; chamar na inicializao, aps
+ * Gerenciador_Config_Validar_e_Restaurar().
+ */
+void Lote_Init(void);
+
+/**
+ * @brief Grava na EEPROM os registros pendentes quando o barramento est livre.
+ * Deve ser chamada continuamente no loop principal.
+ */
+void Lote_Process(void);
+
+/**
+ * @brief Indica se h registros na fila ou uma gravao em curso (trabalho
+ * para Lote_Process()).
+ */
+bool Lote_Ha_Gravacao_Pendente(void);
+
+/**
+ * @brief Inicia o modo lote.
+ * @param quantidade Nmero de amostras do lote (0 = at Lote_Parar()).
+ * @return false se a medio no pde ser iniciada.
+ */
+bool Lote_Iniciar(uint16_t quantidade);
+
+/**
+ * @brief Encerra o modo lote ao fim da amostra em curso.
+ */
+void Lote_Parar(void);
+
+/**
+ * @brief Indica se a prxima amostra deve ser iniciada automaticamente.
+ */
+bool Lote_Is_Ativo(void);
+
+/**
+ * @brief Marca o incio da sequncia de medio (zera o cronmetro das etapas).
+ */
+void Lote_Sequencia_Iniciada(void);
+
+/**
+ * @brief Registra o fim de uma etapa da sequncia de medio.
+ */
+void Lote_Etapa_Concluida(LoteEtapa_t etapa);
+
+/**
+ * @brief Numera a amostra recm-medida, envia o resultado pela USB e enfileira
+ * o registro no histrico.
+ * @return Nmero atribudo  amostra.
+ */
+uint32_t Lote_Amostra_Concluida(void);
+
+/**
+ * @brief Registra uma sequncia abortada (falha de enchimento/raspagem).
+ * No modo lote, interrompe o lote.
+ */
+void Lote_Amostra_Falhou(void);
+
+/**
+ * @brief Nmero da ltima amostra concluda (contador persistente).
+ */
+uint32_t Lote_Get_Numero_Amostra(void);
+
+/**
+ * @brief L um registro do histrico (0 = mais recente).
+ * @return false se o registro no existe ou est corrompido.
+ */
+bool Lote_Get_Registro(uint16_t indice_recente, Lote_Registro_t* registro_out);
+
+/**
+ * @brief Imprime o estado do lote, amostras/hora e os tempos por etapa.
+ */
+void Lote_Imprimir_Estatisticas(void);
+
+#endif // LOTE_HANDLER_H
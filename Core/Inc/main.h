@@ -53,6 +53,7 @@ extern "C" {
 void Error_Handler(void);
 void SystemClock_Config(void);
 /* USER CODE BEGIN EFP */
+void USB_Process(void);
 
 /* USER CODE END EFP */
 
@@ -19,6 +19,7 @@ typedef struct {
     float Frequencia;
     float Escala_A;
     float Temp_Instru;
+    float Temp_Amostra;
     float Densidade;
     float Umidade;
 } DadosMedicao_t;
@@ -34,12 +35,54 @@ void Medicao_Init(void);
  */
 void Medicao_Process(void);
 
+/**
+ * @brief Milissegundos at Medicao_Process() ter trabalho: amostra do ADS1232
+ * pronta, tara ou reproduo em curso, ou fim da sub-janela de frequncia.
+ */
+uint32_t Medicao_Get_Proximo_ms(void);
+
 /**
  * @brief Obtm uma cpia da ltima medio consolidada.
  * @param[out] dados Ponteiro para a estrutura onde os dados sero copiados.
  */
 void Medicao_Get_UltimaMedicao(DadosMedicao_t* dados);
 
+/**
+ * @brief Retorna quantas leituras de peso j foram processadas.
+ * Permite detectar se h amostra nova sem comparar valores em float.
+ */
+uint32_t Medicao_Get_Contador_Peso(void);
+
+/**
+ * @brief Fixa o peso reportado em DadosMedicao_t (peso final previsto pelo
+ * estimador dos servos). As leituras da balana continuam sendo contadas,
+ * mas s voltam ao campo Peso aps Medicao_Liberar_Peso() ou uma tara.
+ */
+void Medicao_Fixar_Peso(float peso);
+
+/**
+ * @brief Volta a reportar o peso lido pela balana.
+ */
+void Medicao_Liberar_Peso(void);
+
+/**
+ * @brief Retorna quantas integraes de frequncia j foram publicadas.
+ */
+uint32_t Medicao_Get_Contador_Frequencia(void);
+
+/**
+ * @brief Durao da ltima integrao de frequncia, em ms.
+ * Menor que 1 s quando o sinal estabilizou antes do limite.
+ */
+uint32_t Medicao_Get_Tempo_Integracao_ms(void);
+
+/**
+ * @brief Descarta a integrao de frequncia em curso e comea outra agora.
+ * Chamada com a amostra no lugar: as sub-janelas da cmara enchendo no
+ * entram na mdia e o fim antecipado encurta a medio.
+ */
+void Medicao_Reiniciar_Integracao(void);
+
 // --- Funes de atualizao para valores definidos externamente ---
 
 /**
@@ -47,6 +90,11 @@ void Medicao_Get_UltimaMedicao(DadosMedicao_t* dados);
  */
 void Medicao_Set_Temp_Instru(float temp_instru);
 
+/**
+ * @brief Atualiza a temperatura da amostra (termistor no pino TEMP_CHIP).
+ */
+void Medicao_Set_Temp_Amostra(float temp_amostra);
+
 /**
  * @brief Define a densidade do gro atual (usado para clculos futuros).
  */
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * @file        memoria.h
+ * @brief       Monitor de uso de RAM: pilha, pool do USBX e dados estticos.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A pilha  pintada com um padro no boot; o pico de uso  a
+ * distncia do topo at a primeira palavra que ainda tem o padro. O pool
+ * do USBX usa as estatsticas do prprio USBX (UX_ENABLE_MEMORY_STATISTICS).
+ ******************************************************************************/
+
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEMORIA_PILHA_TAMANHO   0x800u      // Igual a Stack_Size em startup_stm32c071xx.s
+#define MEMORIA_HEAP_TAMANHO    0x200u      // Igual a Heap_Size em startup_stm32c071xx.s
+#define MEMORIA_RAM_TAMANHO     (24u * 1024u)
+
+typedef struct {
+    uint32_t pilha_usada;       // Pico desde o boot (bytes)
+    uint32_t pilha_tamanho;
+    bool     pool_ativo;        // false antes de MX_USBX_Device_Init()
+    uint32_t pool_em_uso;
+    uint32_t pool_pico;
+    uint32_t pool_tamanho;
+    uint32_t estatica;          // .data + .bss, sem pilha e heap
+    uint32_t ram_tamanho;
+} Memoria_Uso_t;
+
+/**
+ * @brief Preenche a pilha livre com o padro. Chamar no incio de main(),
+ * antes de qualquer outra funo.
+ */
+void Memoria_Pintar_Pilha(void);
+
+/**
+ * @brief Coleta o uso atual e os picos.
+ */
+void Memoria_Get_Uso(Memoria_Uso_t* uso_out);
+
+#endif // MEMORIA_H
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * @file        profiler.h
+ * @brief       Profiler estatstico por amostragem do PC (TIM3).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O Cortex-M0+ no tem DWT. O TIM3 interrompe a ~991 Hz
+ * (perodo de 1009 us, para no sincronizar com as tarefas de 1 ms) e a
+ * ISR l o PC empilhado na entrada da exceo. Cada amostra incrementa o
+ * balde da faixa de endereos da flash onde o PC estava.
+ *
+ * O dump (comando PROF DUMP) lista "endereco contagem" dos baldes no
+ * vazios; os endereos so resolvidos no PC pelo Ferramentas/simbolizar_perfil,
+ * com o arquivo .map do Keil (Image Symbol Table) ou com o .axf.
+ ******************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Desabilitado por padro: o histograma ocupa 1 KB de RAM e o TIM3 fica livre.
+#ifndef PROFILER_HABILITADO
+#define PROFILER_HABILITADO     0
+#endif
+
+#define PROFILER_BITS_BALDE     8           // 256 bytes de cdigo por balde
+#define PROFILER_FLASH_INICIO   0x08000000UL
+#define PROFILER_FLASH_TAMANHO  (128UL * 1024UL)
+#define PROFILER_NUM_BALDES     (PROFILER_FLASH_TAMANHO >> PROFILER_BITS_BALDE)
+
+#if PROFILER_HABILITADO
+
+/**
+ * @brief Configura o TIM3 como fonte de amostragem (no inicia).
+ */
+void Profiler_Init(void);
+
+/**
+ * @brief Inicia / pausa a amostragem. O histograma  mantido.
+ */
+void Profiler_Iniciar(void);
+void Profiler_Parar(void);
+
+/**
+ * @brief Zera o histograma e os contadores.
+ */
+void Profiler_Zerar(void);
+
+/**
+ * @brief Envia o histograma pelo CLI (USB CDC) em partes, sem estourar o
+ * FIFO de TX. Retorna de imediato; o envio segue por um temporizador.
+ */
+void Profiler_Dump(void);
+
+/**
+ * @brief Refaz o prescaler do TIM3 aps uma troca de clock, mantendo a
+ * amostragem a ~991 Hz. Chamar com interrupes bloqueadas.
+ * @param clock_timer_hz Clock do TIM3 (PCLK) j com a frequncia nova.
+ */
+void Profiler_Ajustar_Clock(uint32_t clock_timer_hz);
+
+bool Profiler_Ativo(void);
+uint32_t Profiler_Get_Amostras(void);
+uint32_t Profiler_Get_Fora_Flash(void);
+
+#endif // PROFILER_HABILITADO
+
+#endif // PROFILER_H
@@ -9,6 +9,7 @@ typedef struct {
     uint32_t           channel;      // Canal do timer
     uint16_t           min_pulse_us; // Pulso mnimo em microssegundos (valor calibrado para 0)
     uint16_t           max_pulse_us; // Pulso mximo em microssegundos (valor calibrado para 180)
+    uint8_t            divisor_clock; // Clock do timer dividido pelo governador (0 ou 1 = cheio)
 } Servo_t;
 
 /**
@@ -25,6 +26,14 @@ HAL_StatusTypeDef PWM_Servo_Init(Servo_t *servo);
  */
 void PWM_Servo_SetAngle(Servo_t *servo, float angle);
 
+/**
+ * @brief Mantm perodo e largura de pulso aps uma troca de clock: com o
+ * prescaler em 0 no d para compensar nele, ento ARR e CCR so divididos.
+ * @param servo Ponteiro para a estrutura do servo.
+ * @param divisor Fator em que o clock do timer foi dividido (1 = cheio).
+ */
+void PWM_Servo_Ajustar_Clock(Servo_t *servo, uint8_t divisor);
+
 /**
  * @brief Para a gerao de PWM para um servo especfico.
  * @param servo Ponteiro para a estrutura do servo.
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * @file        secao_critica.h
+ * @brief       Sees crticas com medio do tempo de interrupes bloqueadas.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Substituem o par __disable_irq()/__enable_irq(): salvam e
+ * restauram o PRIMASK (podem ser aninhadas e usadas com IRQs j bloqueadas)
+ * e, com SECAO_CRITICA_MEDIR, cronometram a seo mais externa e guardam
+ * os piores casos por local de sada (funo + linha). Comando IRQOFF do CLI.
+ *
+ * Uso:
+ *     SecaoCritica_t sc;
+ *     SECAO_CRITICA_ENTRAR(sc);
+ *     ...
+ *     SECAO_CRITICA_SAIR(sc);     // Em cada caminho de sada
+ *
+ * O tempo vem do TIM14 (Temporizador_Get_us); sees acima de ~2 ms
+ * so subestimadas, pois o estouro do TIM14 no  atendido nesse tempo.
+ ******************************************************************************/
+
+#ifndef SECAO_CRITICA_H
+#define SECAO_CRITICA_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SECAO_CRITICA_MEDIR
+#define SECAO_CRITICA_MEDIR         1
+#endif
+
+#define SECAO_CRITICA_MAX_LOCAIS    8
+
+#if SECAO_CRITICA_MEDIR
+
+#include "temporizador.h"
+
+typedef struct {
+    uint32_t primask;
+    uint32_t inicio_us;
+} SecaoCritica_t;
+
+typedef struct {
+    const char* funcao;
+    uint16_t    linha;
+    uint32_t    contagem;
+    uint32_t    max_us;
+    uint64_t    soma_us;
+} SecaoCritica_Local_t;
+
+/**
+ * @brief Registra a durao de uma seo (chamada com IRQs bloqueadas).
+ */
+void SecaoCritica_Registrar(const char* funcao, uint16_t linha, uint32_t duracao_us);
+
+/**
+ * @brief Copia os piores locais, do maior para o menor tempo mximo.
+ * @return Nmero de locais copiados.
+ */
+uint8_t SecaoCritica_Get_Piores(SecaoCritica_Local_t* locais_out, uint8_t max_locais);
+
+void SecaoCritica_Zerar(void);
+
+static inline void SecaoCritica_Entrar(SecaoCritica_t* sc)
+{
+    sc->primask = __get_PRIMASK();
+    __disable_irq();
+    sc->inicio_us = Temporizador_Get_us();
+}
+
+static inline void SecaoCritica_Sair(SecaoCritica_t* sc, const char* funcao, uint16_t linha)
+{
+    if (sc->primask == 0u)  // S a seo mais externa  medida
+    {
+        SecaoCritica_Registrar(funcao, linha, Temporizador_Get_us() - sc->inicio_us);
+    }
+    __set_PRIMASK(sc->primask);
+}
+
+#define SECAO_CRITICA_ENTRAR(sc)    SecaoCritica_Entrar(&(sc))
+#define SECAO_CRITICA_SAIR(sc)      SecaoCritica_Sair(&(sc), __func__, (uint16_t)__LINE__)
+
+#else
+
+typedef struct {
+    uint32_t primask;
+} SecaoCritica_t;
+
+#define SECAO_CRITICA_ENTRAR(sc)    do { (sc).primask = __get_PRIMASK(); __disable_irq(); } while (0)
+#define SECAO_CRITICA_SAIR(sc)      __set_PRIMASK((sc).primask)
+
+#endif // SECAO_CRITICA_MEDIR
+
+#endif // SECAO_CRITICA_H
@@ -2,14 +2,47 @@
 #define SERVO_CONTROLE_H
 
 #include "main.h"
+#include <stdbool.h>
 
 typedef enum {
     SERVO_STEP_FUNNEL,
     SERVO_STEP_SCRAPER,
     SERVO_STEP_IDLE,
-    SERVO_STEP_FINISHED 
+    SERVO_STEP_FINISHED,
+    SERVO_STEP_SETTLE
 } ServoStep_t;
 
+/**
+ * @brief Resultado da ltima sequncia. Valores a partir de
+ * SERVO_FALHA_SEM_LEITURA_PESO indicam falha (ver Servos_Status_Is_Falha).
+ */
+typedef enum {
+    SERVO_STATUS_OCIOSO,
+    SERVO_STATUS_EM_CURSO,
+    SERVO_STATUS_CONCLUIDO,
+    SERVO_FALHA_SEM_LEITURA_PESO,       // Balana parou de entregar amostras
+    SERVO_FALHA_SEM_FLUXO,              // Funil aberto e o peso no subiu
+    SERVO_FALHA_ENCHIMENTO_INCOMPLETO,  // Timeout antes de atingir o peso mnimo
+    SERVO_FALHA_PESO_EXCESSIVO,         // Peso acima do limite do gro
+    SERVO_FALHA_RASPAGEM_SEM_QUEDA,     // Raspador no retirou o excesso
+    SERVO_FALHA_ABORTADO
+} ServoStatus_t;
+
+/**
+ * @brief Dados do ltimo ciclo de enchimento/raspagem.
+ */
+typedef struct {
+    float    peso_inicial_g;
+    float    peso_enchimento_g;
+    float    peso_final_g;          // Previsto pelo estimador quando peso_previsto = true
+    float    incerteza_final_g;     // Meia-largura da faixa de confiana da previso
+    bool     peso_previsto;
+    uint32_t tempo_enchimento_ms;
+    uint32_t tempo_raspagem_ms;
+    uint32_t tempo_total_ms;
+    bool     semente_miuda;
+} Servo_Ciclo_Info_t;
+
 
 /**
  * @brief Inicializa o mdulo de controle dos servos.
@@ -23,14 +56,44 @@ void Servos_Init(void);
 void Servos_Process(void);
 
 /**
- * @brief Inicia a sequncia de movimento dos servos.
+ * @brief Inicia a sequncia de enchimento e raspagem usando os limites do gro ativo.
  */
 void Servos_Start_Sequence(void);
 
 /**
- * @brief Decrementa os temporizadores internos de controle dos servos.
- * Esta funo DEVE ser chamada a cada 1ms por uma interrupo de timer (ex: SysTick).
+ * @brief Interrompe a sequncia em curso e leva os servos  posio segura.
+ */
+void Servos_Abort(void);
+
+/**
+ * @brief Reescala o PWM dos dois servos aps uma troca de clock (energia.c).
+ * @param divisor Fator em que o clock dos timers foi dividido (1 = cheio).
+ */
+void Servos_Ajustar_Clock(uint8_t divisor);
+
+/**
+ * @brief Retorna o passo atual da sequncia (SERVO_STEP_IDLE se parada).
+ */
+ServoStep_t Servos_Get_Step(void);
+
+/**
+ * @brief Retorna o status/resultado da sequncia atual ou da ltima executada.
+ */
+ServoStatus_t Servos_Get_Status(void);
+
+/**
+ * @brief Indica se o status corresponde a uma falha.
+ */
+bool Servos_Status_Is_Falha(ServoStatus_t status);
+
+/**
+ * @brief Texto curto do status, para log e VP_MESSAGES.
+ */
+const char* Servos_Get_Status_Str(ServoStatus_t status);
+
+/**
+ * @brief Obtm os pesos e tempos do ltimo ciclo.
  */
-void Servos_Tick_ms(void);
+void Servos_Get_Ultimo_Ciclo(Servo_Ciclo_Info_t* info_out);
 
 #endif // SERVO_CONTROLE_H
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * @file        sono.h
+ * @brief       Acordadas peridicas de fundo durante o Stop.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Enquanto o equipamento dorme (display e USB desligados), o RTC
+ * acorda o MCU a cada SONO_INTERVALO_MS para um conjunto mnimo de tarefas:
+ * leitura do carregador (ADC do BQ25622 pelo I2C), atualizao do SoC com o
+ * intervalo dormido e um registro num log circular em RAM. Tudo roda no
+ * clock reduzido e volta ao Stop sem tocar na USB nem no display. S o toque
+ * encerra o sono; outras interrupes (DRDY do ADS, alarmes intermedirios
+ * do RTC) voltam a dormir pelo restante do intervalo.
+ * O relatrio d o ciclo de trabalho e a carga estimada pelo modelo de
+ * correntes (comando SONO do CLI).
+ ******************************************************************************/
+
+#ifndef SONO_H
+#define SONO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SONO_FUNDO_HABILITADO
+#define SONO_FUNDO_HABILITADO       1
+#endif
+
+#define SONO_INTERVALO_MS           (5u * 60u * 1000u)
+#define SONO_LOG_TAMANHO            16u
+
+typedef struct {
+    uint32_t instante_s;        // Desde o incio do sono
+    uint16_t vbat_mv;
+    int16_t  ibat_ma;           // Filtrada pela zona morta (0 em repouso)
+    uint16_t soc_decimos;       // 0..1000
+    uint16_t acordada_us;       // Durao desta acordada (saturada)
+} Sono_Registro_t;
+
+typedef struct {
+    uint32_t sonos;             // Entradas na sequncia de sono
+    uint32_t acordadas;         // Acordadas com tarefas de fundo
+    uint32_t intermediarias;    // Alarmes de prazo mximo do RTC e outras IRQs
+    uint64_t dormido_ms;
+    uint64_t acordado_us;       // Tarefas e reentradas em Stop, clock reduzido
+    uint32_t acordada_max_us;
+    uint32_t carga_uAh;         // Estimada: correntes modeladas x tempos
+    uint16_t soc_inicio_decimos;    // Do ltimo sono
+    uint16_t soc_fim_decimos;
+} Sono_Relatorio_t;
+
+/**
+ * @brief Dorme em Stop at o toque, executando as tarefas de fundo a cada
+ * SONO_INTERVALO_MS. Retorna com o clock cheio e o SoC atualizado.
+ * Bloqueante: chamada pela sequncia de Stop do app_manager.
+ */
+void Sono_Dormir(void);
+
+/**
+ * @brief Aviso da EXTI do toque (contexto de interrupo).
+ */
+void Sono_Sinalizar_Toque(void);
+
+void Sono_Get_Relatorio(Sono_Relatorio_t* relatorio_out);
+
+/**
+ * @brief Copia os registros do log, do mais antigo ao mais recente.
+ * @return Quantidade copiada (at 'max').
+ */
+uint8_t Sono_Get_Log(Sono_Registro_t* registros_out, uint8_t max);
+
+void Sono_Zerar(void);
+
+#endif // SONO_H
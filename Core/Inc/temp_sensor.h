@@ -2,12 +2,47 @@
 #define TEMP_SENSOR_H
 
 #include "main.h"
+#include <stdbool.h>
 
 /**
- * @brief L a temperatura do sensor interno do STM32.
+ * @brief Calibra o ADC e dispara a primeira sequncia de converso via DMA.
+ */
+void TempSensor_Init(void);
+
+/**
+ * @brief Converte o ltimo resultado do DMA e redispara o ADC periodicamente.
+ * Deve ser chamada no super-loop; nunca bloqueia.
+ */
+void TempSensor_Process(void);
+
+/**
+ * @brief Milissegundos at TempSensor_Process() ter trabalho (resultado do DMA
+ * ou prximo disparo). Pode ser chamada com interrupes bloqueadas.
+ */
+uint32_t TempSensor_Get_Proximo_ms(void);
+
+/**
+ * @brief L a temperatura do sensor interno do STM32 (ltimo valor convertido).
  *
  * @return float O valor da temperatura em graus Celsius.
  */
 float TempSensor_GetTemperature(void);
 
-#endif // TEMP_SENSOR_H
\ No newline at end of file
+/**
+ * @brief Retorna a temperatura da amostra (termistor no pino TEMP_CHIP).
+ *
+ * @return float ltimo valor vlido em graus Celsius.
+ */
+float TempSensor_Get_Temp_Amostra(void);
+
+/**
+ * @brief Indica se a ltima leitura do termistor da amostra est na faixa da tabela.
+ */
+bool TempSensor_Temp_Amostra_Valida(void);
+
+/**
+ * @brief Retorna a tenso VDDA medida pelo VREFINT, em mV.
+ */
+uint16_t TempSensor_Get_VDDA_mV(void);
+
+#endif // TEMP_SENSOR_H
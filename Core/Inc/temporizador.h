@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * @file        temporizador.h
+ * @brief       Roda de temporizao (hashed timer wheel) acionada pelo TIM14.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Temporizadores one-shot e peridicos com resoluo de 1 ms.
+ * A ISR do TIM14 apenas avana a roda e marca os expirados; os callbacks
+ * rodam no contexto principal, em Temporizador_Process().
+ ******************************************************************************/
+
+#ifndef TEMPORIZADOR_H
+#define TEMPORIZADOR_H
+
+#include "main.h"
+#include <stdbool.h>
+
+#define TEMPORIZADOR_MAX        16
+#define TEMPORIZADOR_INVALIDO   0xFF
+
+typedef uint8_t Temporizador_Id_t;
+typedef void (*Temporizador_Callback_t)(void);
+
+/**
+ * @brief Inicia o TIM14 (base de 1 ms) e zera a roda.
+ * @param htim Timer configurado para estourar a cada 1 ms.
+ * @param ao_expirar Chamado na ISR quando algum temporizador expira (pode ser NULL).
+ *                   Usado para acordar a tarefa que chama Temporizador_Process().
+ */
+void Temporizador_Init(TIM_HandleTypeDef* htim, void (*ao_expirar)(void));
+
+/**
+ * @brief Reserva um temporizador. No o inicia.
+ * @return ID do temporizador ou TEMPORIZADOR_INVALIDO se no houver espao.
+ */
+Temporizador_Id_t Temporizador_Criar(Temporizador_Callback_t callback, bool periodico);
+
+/**
+ * @brief (Re)inicia o temporizador. Nos peridicos, o atraso  tambm o perodo.
+ */
+bool Temporizador_Iniciar(Temporizador_Id_t id, uint32_t atraso_ms);
+
+/**
+ * @brief Para o temporizador e descarta uma expirao ainda no despachada.
+ */
+void Temporizador_Parar(Temporizador_Id_t id);
+
+/**
+ * @brief Executa os callbacks dos temporizadores expirados (contexto principal).
+ */
+void Temporizador_Process(void);
+
+/**
+ * @brief Indica se h callbacks expirados aguardando Temporizador_Process().
+ */
+bool Temporizador_Ha_Pendentes(void);
+
+/**
+ * @brief Tempo livre em microssegundos (milissegundos da roda + contador do
+ * TIM14). Pode ser chamada com interrupes bloqueadas. Estoura a cada ~71 min;
+ * use apenas diferenas.
+ */
+uint32_t Temporizador_Get_us(void);
+
+/**
+ * @brief Milissegundos at o prximo vencimento (0 se houver expirados
+ * pendentes, UINT32_MAX se nenhum estiver na roda). Chamar com interrupes
+ * bloqueadas para a resposta valer at o WFI.
+ */
+uint32_t Temporizador_Get_Proximo_ms(void);
+
+/**
+ * @brief Compensa 'ms' em que o TIM14 ficou parado (modo Stop): avana o
+ * relgio da roda e marca como expirados os que venceram nesse intervalo.
+ * Custo proporcional ao nmero de temporizadores, no ao tempo.
+ */
+void Temporizador_Avancar(uint32_t ms);
+
+/**
+ * @brief Refaz o prescaler do TIM14 para manter a base de 1 us aps uma
+ * troca de clock. Vale na hora: o contador  recarregado com a mesma
+ * contagem, sem gerar estouro. Chamar com interrupes bloqueadas.
+ * @param clock_timer_hz Clock do TIM14 (PCLK) j com a frequncia nova.
+ */
+void Temporizador_Ajustar_Clock(uint32_t clock_timer_hz);
+
+/**
+ * @brief Avana a roda em 1 ms. Chamada pela ISR do TIM14.
+ */
+void Temporizador_Tick_ISR(void);
+
+#endif // TEMPORIZADOR_H
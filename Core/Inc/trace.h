@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * @file        trace.h
+ * @brief       Rastro binrio de eventos em RAM (ISRs e tarefas).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada registro tem 8 bytes (tempo em us, ID, argumento) e 
+ * gravado num anel com poucas instrues, em ISR ou no loop. O anel pode
+ * ser congelado por um gatilho e enviado pelo CLI (TRACE DUMP) em texto
+ * compacto; o Ferramentas/trace_para_chrome converte a captura no JSON do
+ * Chrome/Perfetto (chrome://tracing, ui.perfetto.dev).
+ ******************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Desabilitado por padro: o anel ocupa 2 KB de RAM.
+#ifndef TRACE_HABILITADO
+#define TRACE_HABILITADO        0
+#endif
+
+#define TRACE_NUM_REGISTROS     256     // Potncia de 2
+
+typedef enum {
+    TRC_TAREFA_INICIO,      // arg = ID da tarefa do escalonador
+    TRC_TAREFA_FIM,         // arg = ID da tarefa do escalonador
+    TRC_EVENTO_PUBLICADO,   // arg = Evento_Tipo_t
+    TRC_EVENTO_DESPACHADO,  // arg = Evento_Tipo_t
+    TRC_ISR_EXTI,
+    TRC_ISR_USB,
+    TRC_ISR_DMA_UART_RX,
+    TRC_ISR_DMA_UART_TX_ADC,
+    TRC_ISR_I2C,
+    TRC_ISR_UART,
+    TRC_MARCA,              // Uso livre durante depurao
+    NUM_TRACE_IDS
+} Trace_Id_t;
+
+#if TRACE_HABILITADO
+
+#define TRACE(id, arg)  Trace_Registrar((uint16_t)(id), (uint16_t)(arg))
+
+/**
+ * @brief Grava um registro no anel (seguro em ISR). Ignorado se congelado.
+ */
+void Trace_Registrar(uint16_t id, uint16_t arg);
+
+/**
+ * @brief Congela o anel na hora de um registro com o ID dado, depois de
+ * gravar mais pos_gatilho registros (0 = congela no prprio registro).
+ */
+void Trace_Armar_Gatilho(Trace_Id_t id, uint16_t pos_gatilho);
+
+void Trace_Congelar(void);
+
+/**
+ * @brief Volta a gravar (desarma o gatilho; o contedo  mantido).
+ */
+void Trace_Liberar(void);
+
+bool Trace_Congelado(void);
+uint32_t Trace_Get_Total(void);
+
+/**
+ * @brief Congela o anel e envia-o pelo CLI (nomes e registros em hex), em
+ * partes, pelo temporizador.
+ */
+void Trace_Dump(void);
+
+/**
+ * @brief Cria o temporizador do dump. Chamar depois de Temporizador_Init().
+ */
+void Trace_Init(void);
+
+#else
+
+#define TRACE(id, arg)  ((void)0)
+
+#endif // TRACE_HABILITADO
+
+#endif // TRACE_H
@@ -4,13 +4,6 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
-// =================================================================================
-// MODO DE SIMULACAO: Defina como 1 para rodar sem o hardware ADS1232 conectado.
-// Isso evita que o cdigo trave esperando por um sinal que nunca chegar.
-// Defina como 0 para operao normal com o hardware.
-// =================================================================================
-#define ADS1232_SIMULATION_MODE 1
-
 
 static int32_t cal_zero_adc = 0;
 volatile bool g_ads_data_ready = false;
@@ -24,12 +17,14 @@ CalPoint_t cal_points[NUM_CAL_POINTS] = {
 
 static int32_t adc_offset = 0;
 
+#if ADS1232_SIMULATION_MODE == 0
 static void sort_three(int32_t *a, int32_t *b, int32_t *c) {
     int32_t temp;
     if (*a > *b) { temp = *a; *a = *b; *b = temp; }
     if (*b > *c) { temp = *b; *b = *c; *c = temp; }
     if (*a > *b) { temp = *a; *a = *b; *b = temp; }
 }
+#endif
 
 void Drv_ADS1232_DRDY_Callback(void)
 {
@@ -91,35 +86,84 @@ int32_t ADS1232_Read_Median_of_3(void) {
     #endif
 }
 
-int32_t ADS1232_Tare(void) {
+// Tara cooperativa: mesma mdia de 32 medianas com teste de estabilidade,
+// mas cada espera pelo DRDY ou pelo intervalo devolve o controle ao loop.
+#define TARA_AMOSTRAS           32
+#define TARA_TENTATIVAS         10
+#define TARA_LIMIAR_ESTAVEL     300
+#define TARA_INTERVALO_MS       10u
+#define TARA_DRDY_TIMEOUT_MS    500u    // Sem DRDY: ADS ausente, desiste mantendo o offset
+
+static Corrotina_t s_cr_tara;
+static bool s_tara_ativa = false;
+#if ADS1232_SIMULATION_MODE == 0
+static struct {
+    uint8_t  tentativa;
+    uint8_t  amostra;
+    uint8_t  leitura;
+    int32_t  leituras[3];
+    int64_t  soma;
+    int32_t  min_val;
+    int32_t  max_val;
+    uint32_t inicio_ms;
+} s_tara;
+#endif
+
+void ADS1232_Tare_Iniciar(void) {
+    CR_INICIALIZAR(&s_cr_tara);
+    s_tara_ativa = true;
+}
+
+bool ADS1232_Tare_Em_Andamento(void) {
+    return s_tara_ativa;
+}
+
+Cr_Estado_t ADS1232_Tare_Passo(void) {
+    Corrotina_t* cr = &s_cr_tara;
+    if (!s_tara_ativa) return CR_TERMINOU;
+
+    CR_INICIO(cr);
     #if ADS1232_SIMULATION_MODE == 1
-        // Em modo de simulao, define um offset fixo e retorna sucesso.
-        printf("ADS1232: Tare em modo de simulacao.\r\n");
-        adc_offset = 235469; // Valor de exemplo
-        return adc_offset;
+    printf("ADS1232: Tare em modo de simulacao.\r\n");
+    adc_offset = 235469; // Valor de exemplo
     #else
-    const int num_samples = 32;
-    const int32_t stability_threshold = 300;
-    int max_retries = 10;
-
-    for (int retry = 0; retry < max_retries; retry++) {
-        int64_t sum = 0;
-        int32_t min_val = 0x7FFFFFFF, max_val = 0x80000000;
-        for (int i = 0; i < num_samples; i++) {
-            // Esta chamada trava se o hardware no estiver presente.
-            int32_t sample = ADS1232_Read_Median_of_3();
-            sum += sample;
-            if (sample < min_val) min_val = sample;
-            if (sample > max_val) max_val = sample;
-            HAL_Delay(10);
+    for (s_tara.tentativa = 0; s_tara.tentativa < TARA_TENTATIVAS; s_tara.tentativa++) {
+        s_tara.soma = 0;
+        s_tara.min_val = 0x7FFFFFFF;
+        s_tara.max_val = (int32_t)0x80000000;
+        for (s_tara.amostra = 0; s_tara.amostra < TARA_AMOSTRAS; s_tara.amostra++) {
+            for (s_tara.leitura = 0; s_tara.leitura < 3; s_tara.leitura++) {
+                s_tara.inicio_ms = HAL_GetTick();
+                CR_AGUARDAR_ATE(cr, g_ads_data_ready || (HAL_GetTick() - s_tara.inicio_ms) >= TARA_DRDY_TIMEOUT_MS);
+                if (!g_ads_data_ready) {
+                    printf("ADS1232: Tare sem DRDY, offset mantido.\r\n");
+                    s_tara_ativa = false;
+                    CR_SAIR(cr);
+                }
+                s_tara.leituras[s_tara.leitura] = ADS1232_Read();
+                g_ads_data_ready = false;
+            }
+            sort_three(&s_tara.leituras[0], &s_tara.leituras[1], &s_tara.leituras[2]);
+            s_tara.soma += s_tara.leituras[1];
+            if (s_tara.leituras[1] < s_tara.min_val) s_tara.min_val = s_tara.leituras[1];
+            if (s_tara.leituras[1] > s_tara.max_val) s_tara.max_val = s_tara.leituras[1];
+            CR_AGUARDAR_MS(cr, TARA_INTERVALO_MS);
         }
-        if ((max_val - min_val) < stability_threshold) {
-            adc_offset = (int32_t)(sum / num_samples);
-            return adc_offset;
+        if ((s_tara.max_val - s_tara.min_val) < TARA_LIMIAR_ESTAVEL) {
+            adc_offset = (int32_t)(s_tara.soma / TARA_AMOSTRAS);
+            break;
         }
     }
-    return adc_offset;
     #endif
+    s_tara_ativa = false;
+    CR_FIM(cr);
+}
+
+// Verso bloqueante, mantida para chamadores que precisam do offset na hora.
+int32_t ADS1232_Tare(void) {
+    ADS1232_Tare_Iniciar();
+    while (ADS1232_Tare_Passo() == CR_ESPERANDO) {}
+    return adc_offset;
 }
 
 float ADS1232_ConvertToGrams(int32_t raw_value)
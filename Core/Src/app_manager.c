@@ -16,6 +16,20 @@
 #include "usb.h"             // Para a funo MX_USB_PCD_Init e o handle
 #include "app_usbx_device.h"
 #include "battery_handler.h" 
+#include "lote_handler.h"
+#include "escalonador.h"
+#include "temporizador.h"
+#include "eventos.h"
+#include "profiler.h"
+#include "trace.h"
+#include "diagnostico.h"
+#include "boot.h"
+#include "corrotina.h"
+#include "gravacao.h"
+#include "energia.h"
+#include "sono.h"
+#include "falha_energia.h"
+#include "governador.h"
 
 extern PCD_HandleTypeDef hpcd_USB_DRD_FS;
 //================================================================================
@@ -24,77 +38,172 @@ extern PCD_HandleTypeDef hpcd_USB_DRD_FS;
 
 static SystemState_t s_current_state = STATE_ACTIVE;
 static volatile bool s_go_to_sleep_request = false;
+static volatile uint32_t s_sleep_request_tick = 0;
+static Corrotina_t s_cr_sono;           // Sequncia desligar -> Stop -> religar
+static volatile bool s_usb_ativo = true;  // false enquanto a USB est parada ou desmontada
 static volatile bool s_wakeup_confirmed = false;
+static uint32_t s_retomada_inicio = 0;
+static App_Retomada_t s_retomada;
 
 // --- Variveis para o modo de confirmao de "acordar" ---
 static uint32_t s_confirm_start_tick = 0;
 static uint32_t s_countdown_last_tick = 0;
 
+// Eventos despachados por passada do loop (o resto fica para a prxima)
+static const uint8_t EVENTOS_POR_PASSADA = 4;
+
+// Debounce de software do boto de desligar (o loop continua rodando)
+static const uint32_t SLEEP_DEBOUNCE_MS = 500;
+
+#if RETOMADA_RAPIDA_HABILITADA
+// --- Retomada rpida do Stop ---
+static const uint32_t RETOMADA_ESCALONAMENTO_MS  = 20;    // Entre HAB_TOUCH e a alimentao do display
+static const uint32_t RETOMADA_SONDA_DISPLAY_MS  = 10;
+static const uint32_t RETOMADA_DISPLAY_TIMEOUT_MS = 2000; // Segue sem resposta (display com defeito)
+static uint32_t s_rx_pacotes_retomada = 0;
+#endif
+
+#if BOOT_RAPIDO_HABILITADO || RETOMADA_RAPIDA_HABILITADA
+// Leitura do registrador PIC_NOW: qualquer resposta indica display pronto.
+static const uint8_t DWIN_LER_PIC_NOW[] = {0x5A, 0xA5, 0x04, 0x83, 0x00, 0x14, 0x01};
+#endif
+
+#if BOOT_RAPIDO_HABILITADO
+// --- Boot rpido ---
+static const uint32_t BOOT_SONDA_DISPLAY_MS   = 50;    // Intervalo entre leituras de PIC_NOW
+static const uint32_t BOOT_DISPLAY_TIMEOUT_MS = 3000;  // Desde o reset; segue sem resposta
+static const uint32_t BOOT_ADIAMENTO_MS       = 50;    // Folga para a troca de tela sair pela UART
+static Temporizador_Id_t s_tmr_sonda_display;
+static Temporizador_Id_t s_tmr_init_adiada;
+static uint32_t s_rx_pacotes_boot = 0;
+#endif
+
 //================================================================================
 // Prottipos de Funes Privadas
 //================================================================================
 
-static void Task_Handle_High_Frequency_Polling(void);
-static void EnterStopMode(void);
-static void HandleWakeUpSequence(void);
-static bool Test_DisplayInfo(void);
-static bool Test_Servos(void);
-static bool Test_Capacimetro(void);
-static bool Test_Balanca(void);
-static bool Test_Termometro(void);
-static bool Test_EEPROM(void);
-static bool Test_RTC(void);
+static Cr_Estado_t Sequencia_Stop(Corrotina_t* cr);
+static void Entrar_Estado_Parado(void);
+static uint32_t Previsao_Sono(void);
+static void Sinalizar_Temporizadores(void);
+static void Sinalizar_Eventos(void);
+static void Despachar_Eventos(void);
+static void Processar_USB(void);
+static uint32_t Previsao_Dwin_Tx(void);
+static uint32_t Previsao_Dwin_Rx(void);
+static uint32_t Previsao_Cli(void);
+static uint32_t Previsao_Servos(void);
+static uint32_t Previsao_Eeprom(void);
+static uint32_t Previsao_Display(void);
+static uint32_t Previsao_Lote(void);
+static void Publicar_Toque_Dwin(const uint8_t* data, uint16_t len);
+static void Tratar_Toque_Dwin(const Evento_t* evento);
+static void Init_Adiada(void);
+#if BOOT_RAPIDO_HABILITADO
+static void Sondar_Display(void);
+#endif
 
 //================================================================================
 // Implementao das Funes Pblicas
 //================================================================================
 
-static const DiagnosticStep_t s_diagnostic_steps[] = {
-    {"Exibindo Logo e Versoes...",  LOGO,                3000, Test_DisplayInfo},
-    {"Verificando Servos...",       BOOT_CHECK_SERVOS,   1200, Test_Servos},
-    {"Verificando Medidor Freq...", BOOT_CHECK_CAPACI,   1200, Test_Capacimetro},
-    {"Verificando Balanca...",      BOOT_BALANCE,        1000, Test_Balanca},
-    {"Verificando Termometro...",   BOOT_THERMOMETER,    1000, Test_Termometro},
-    {"Verificando Memoria EEPROM...", BOOT_MEMORY,       1100, Test_EEPROM},
-    {"Verificando RTC...",          BOOT_CLOCK,          1100, Test_RTC},
+// Tarefas do estado ativo. Perodo de 1 ms = polling a cada tick do SysTick,
+// mas s enquanto a previso da tarefa indicar trabalho; parado, o polling
+// no limita o ocioso e o ncleo pode ir para o Stop.
+static const Tarefa_t s_tarefas_ativas[NUM_TAREFAS_ATIVAS] = {
+    [TAREFA_TEMPORIZADOR] = {"TIMERS", Temporizador_Process,     0,  0, NULL},
+    [TAREFA_DWIN_TX]  = {"DWIN_TX",  DWIN_TX_Pump,               1,  0, Previsao_Dwin_Tx},
+    [TAREFA_DWIN_RX]  = {"DWIN_RX",  DWIN_Driver_Process,        1,  0, Previsao_Dwin_Rx},
+    [TAREFA_EVENTOS]  = {"EVENTOS",  Despachar_Eventos,          0,  1, NULL},
+    [TAREFA_CLI]      = {"CLI",      Processar_USB,              1,  1, Previsao_Cli},
+    [TAREFA_MEDICAO]  = {"MEDICAO",  Medicao_Process,            1,  1, Medicao_Get_Proximo_ms},
+    [TAREFA_SERVOS]   = {"SERVOS",   Servos_Process,             5,  1, Previsao_Servos},
+    [TAREFA_EEPROM]   = {"EEPROM",   Gerenciador_Config_Run_FSM, 1,  2, Previsao_Eeprom},
+    [TAREFA_DISPLAY]  = {"DISPLAY",  DisplayHandler_Process,     10, 2, Previsao_Display},
+    [TAREFA_TEMP]     = {"TEMP",     TempSensor_Process,         10, 3, TempSensor_Get_Proximo_ms},
+    [TAREFA_LOTE]     = {"LOTE",     Lote_Process,               10, 3, Previsao_Lote},
+    [TAREFA_GOVERNADOR] = {"GOVERNADOR", Governador_Process, GOVERNADOR_PERIODO_MS, 3, Governador_Get_Proximo_ms},
 };
-static const size_t NUM_DIAGNOSTIC_STEPS = sizeof(s_diagnostic_steps) / sizeof(s_diagnostic_steps[0]);
 
 
 void App_Manager_Init(void) {
-    DWIN_Driver_Init(&huart2, Controller_DwinCallback);
+    Temporizador_Init(&htim14, Sinalizar_Temporizadores);
+    Eventos_Init(Sinalizar_Eventos);
+    Energia_Init(&hrtc);
+    Diagnostico_Init();
+#if GRAVACAO_HABILITADA
+    Gravacao_Init();
+#endif
+#if PROFILER_HABILITADO
+    Profiler_Init();
+#endif
+#if TRACE_HABILITADO
+    Trace_Init();
+#endif
+    Eventos_Assinar(EVT_TOQUE_DWIN, Tratar_Toque_Dwin);
+    DWIN_Driver_Init(&huart2, Publicar_Toque_Dwin);
     EEPROM_Driver_Init(&hi2c1);
     Gerenciador_Config_Init(&hcrc);
     RTC_Driver_Init(&hrtc);
     Medicao_Init();
+    TempSensor_Init();
     DisplayHandler_Init();
     Servos_Init();
     Frequency_Init();
     ADS1232_Init();
-		Battery_Handler_Init(&hi2c1);
     Gerenciador_Config_Validar_e_Restaurar();
+    Falha_Energia_Init();
+    Governador_Init();
+    Boot_Marcar(BOOT_FASE_CONFIG);
+#if !BOOT_RAPIDO_HABILITADO
+    Init_Adiada();
+#endif
     Medicao_Set_Densidade(71.0);
     Medicao_Set_Umidade(25.73);
+    Escalonador_Init(s_tarefas_ativas, NUM_TAREFAS_ATIVAS);
+}
+
+void App_Manager_Iniciar_Boot(void) {
+#if BOOT_RAPIDO_HABILITADO
+    // O display foi alimentado no MX_GPIO_Init e inicializa em paralelo com
+    // os sensores; a tela principal sai assim que ele responder.
+    s_rx_pacotes_boot = DWIN_Driver_GetRxPacketCounter();
+    s_tmr_init_adiada = Temporizador_Criar(Init_Adiada, false);
+    s_tmr_sonda_display = Temporizador_Criar(Sondar_Display, true);
+    Temporizador_Iniciar(s_tmr_sonda_display, BOOT_SONDA_DISPLAY_MS);
+#else
+    App_Manager_Run_Self_Diagnostics(PRINCIPAL);
+#endif
 }
 
 void App_Manager_Process(void) {
 
+    // Antes de qualquer estado: a EXTI do POWER_GOOD acorda o WFI/Stop e a
+    // emergncia precisa rodar na mesma passada.
+    Falha_Energia_Process();
+
     switch (s_current_state) {
         case STATE_ACTIVE:
-						Battery_Handler_Process(); 
-            Task_Handle_High_Frequency_Polling();
-            Medicao_Process();
-            DisplayHandler_Process();
-            if (s_go_to_sleep_request) {
+            if (!Escalonador_Executar()) {
+                Energia_Ocioso(ENERGIA_STOP, Escalonador_Get_Ocioso_ms);
+            }
+            if (s_go_to_sleep_request && (HAL_GetTick() - s_sleep_request_tick) >= SLEEP_DEBOUNCE_MS) {
                 s_go_to_sleep_request = false;
-                s_current_state = STATE_STOPPED;
+                Entrar_Estado_Parado();
             }
             break;
 
         case STATE_STOPPED:
-            EnterStopMode();
-            HandleWakeUpSequence();
-            s_current_state = STATE_CONFIRM_WAKEUP;
+            // As esperas da sequncia devolvem o controle: o display continua atendido.
+            if (Sequencia_Stop(&s_cr_sono) == CR_TERMINOU) {
+                s_current_state = STATE_CONFIRM_WAKEUP;
+            }
+            Processar_USB();
+            DWIN_TX_Pump();
+            DWIN_Driver_Process();
+            if (s_current_state == STATE_STOPPED) {
+                Energia_Ocioso(ENERGIA_STOP, Previsao_Sono);
+            }
             break;
 
         case STATE_CONFIRM_WAKEUP:
@@ -102,14 +211,24 @@ void App_Manager_Process(void) {
                 s_wakeup_confirmed = false;
                 s_current_state = STATE_ACTIVE;
                 printf("Confirmado! Retornando ao modo ativo.\r\n");
-                App_Manager_Run_Self_Diagnostics(PRINCIPAL);
+                // Volta direto  tela principal; s os passos que dependem
+                // do tempo dormido (ou que falharam) rodam em segundo plano.
+                Controller_SetScreen(PRINCIPAL);
+#if RETOMADA_RAPIDA_HABILITADA
+                // Retomada quente: nada foi reinicializado, s repete se reprovou.
+                if (!Diagnostico_Aprovado()) {
+                    Diagnostico_Iniciar(PRINCIPAL, true);
+                }
+#else
+                Diagnostico_Iniciar(PRINCIPAL, true);
+#endif
                 break;
             }
 
             // Lgica de timeout para a tela de confirmao
             if (HAL_GetTick() - s_confirm_start_tick > 5000) {
                 printf("Timeout! Voltando para o modo Stop.\r\n");
-                s_current_state = STATE_STOPPED;
+                Entrar_Estado_Parado();
                 break;
             }
 
@@ -120,52 +239,38 @@ void App_Manager_Process(void) {
                 uint32_t remaining_seconds = (elapsed_ms > 5000) ? 0 : (5 - (elapsed_ms / 1000));
                 DWIN_Driver_WriteInt(VP_REGRESSIVA, remaining_seconds);
             }
+            Processar_USB();
 						DWIN_TX_Pump();
             DWIN_Driver_Process();
+            Eventos_Despachar(EVENTOS_POR_PASSADA);
+            // Display ligado esperando o toque: s WFI, acorda a cada SysTick.
+            Energia_Ocioso(ENERGIA_SLEEP, NULL);
             break;
     }
 }
 
 void App_Manager_Request_Sleep(void) {
-    HAL_Delay(500); // Debounce de software para o boto de desligar
+    s_sleep_request_tick = HAL_GetTick();
     s_go_to_sleep_request = true;
 }
 
+bool App_Manager_USB_Ativo(void) {
+    return s_usb_ativo;
+}
+
 void App_Manager_Confirm_Wakeup(void) {
     s_wakeup_confirmed = true;
 }
 
-bool App_Manager_Run_Self_Diagnostics(uint8_t return_tela) {
-    printf("\r\n>>> INICIANDO AUTODIAGNOSTICO <<<\r\n");
-
-    for (size_t i = 0; i < NUM_DIAGNOSTIC_STEPS; i++)
-    {
-        const DiagnosticStep_t* step = &s_diagnostic_steps[i];
-
-        printf("Diagnostico: %s\r\n", step->description);
-        Controller_SetScreen(step->screen_id);
-        DWIN_TX_Pump(); // Garante que o comando seja enviado
-        
-        // Espera o tempo de exibio da tela
-        HAL_Delay(step->display_time_ms);
-
-        // Executa a funo de teste associada ao passo
-        if (step->execute_test != NULL)
-        {
-            if (!step->execute_test())
-            {
-                // A funo de teste j imprimiu a falha e mostrou a tela de erro
-                printf(">>> AUTODIAGNOSTICO FALHOU! <<<\r\n");
-                return false; // Interrompe em caso de falha
-            }
-        }
+void App_Manager_Get_Retomada(App_Retomada_t* retomada_out) {
+    if (retomada_out != NULL) {
+        *retomada_out = s_retomada;
     }
+}
 
-    printf(">>> AUTODIAGNOSTICO COMPLETO <<<\r\n\r\n");
-    Controller_SetScreen(return_tela);
-    DWIN_TX_Pump();
-    
-    return true;
+bool App_Manager_Run_Self_Diagnostics(uint8_t return_tela) {
+    // Execuo fria: percorre todas as telas de verificao sem bloquear o loop.
+    return Diagnostico_Iniciar(return_tela, false);
 }
 
 //================================================================================
@@ -173,22 +278,168 @@ bool App_Manager_Run_Self_Diagnostics(uint8_t return_tela) {
 //================================================================================
 
 /**
- * @brief Agrupa as chamadas de polling de I/O de alta frequncia.
+ * @brief Chamado na ISR do TIM14 quando um temporizador expira.
+ */
+static void Sinalizar_Temporizadores(void) {
+    Escalonador_Sinalizar(TAREFA_TEMPORIZADOR);
+}
+
+/**
+ * @brief Chamado a cada evento publicado; acorda a tarefa de eventos.
+ */
+static void Sinalizar_Eventos(void) {
+    Escalonador_Sinalizar(TAREFA_EVENTOS);
+}
+
+/**
+ * @brief Despacha um lote limitado de eventos. Se sobrar algo na fila, a
+ * tarefa se sinaliza de novo e continua na prxima passada do loop.
+ */
+static void Despachar_Eventos(void) {
+    Eventos_Despachar(EVENTOS_POR_PASSADA);
+    if (Eventos_Ha_Pendentes()) {
+        Escalonador_Sinalizar(TAREFA_EVENTOS);
+    }
+}
+
+/**
+ * @brief Tarefa da CLI: stack do USBX, recepo das linhas (o comando roda
+ * dentro de CLI_Receive_Char) e envio do FIFO de sada. Fora do estado
+ * ativo  chamada direto pelo lao de cada estado.
+ */
+static void Processar_USB(void) {
+    // A retomada do barramento religou o HSI48 na ISR: confere aqui at partir.
+    if (Energia_USB_Retomando()) {
+        Escalonador_Sinalizar(TAREFA_CLI);
+    }
+    if (!s_usb_ativo) {
+        return;
+    }
+    USB_Process();
+    CLI_TX_Pump();
+    // Com sada na fila, roda de novo na prxima passada em vez de esperar 1 ms.
+    if (CLI_TX_Pendente()) {
+        Escalonador_Sinalizar(TAREFA_CLI);
+    }
+}
+
+// --- Previses das tarefas ---
+// 0 com trabalho, UINT32_MAX parada: o trabalho volta por uma interrupo ou
+// por outra tarefa, e o loop reavalia as previses ao acordar.
+
+static uint32_t Previsao_Dwin_Tx(void) {
+    return DWIN_Driver_IsTxBusy() ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Dwin_Rx(void) {
+    return DWIN_Driver_IsRxPending() ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Cli(void) {
+    // A recepo chega pela IRQ da USB, que sinaliza a tarefa.
+    return (s_usb_ativo && CLI_TX_Pendente()) ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Servos(void) {
+    const ServoStep_t passo = Servos_Get_Step();
+    return (passo != SERVO_STEP_IDLE && passo != SERVO_STEP_FINISHED) ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Eeprom(void) {
+    return (EEPROM_Driver_IsBusy() || Gerenciador_Config_Ha_Pendencias()) ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Display(void) {
+    return Display_Medicao_Em_Andamento() ? 0 : UINT32_MAX;
+}
+
+static uint32_t Previsao_Lote(void) {
+    return Lote_Ha_Gravacao_Pendente() ? 0 : UINT32_MAX;
+}
+
+/**
+ * @brief Callback de RX do driver DWIN: s enfileira o pacote recebido.
  */
-static void Task_Handle_High_Frequency_Polling(void) {
-    DWIN_TX_Pump();
-		CLI_Process();
-    DWIN_Driver_Process();
-		Gerenciador_Config_Run_FSM();
-    Servos_Process();
+static void Publicar_Toque_Dwin(const uint8_t* data, uint16_t len) {
+    // Na reproduo os pacotes vm da gravao; toques reais misturariam as entradas.
+    if (GRAVACAO_REPRODUZINDO()) return;
+    GRAVACAO_BYTES(GRV_DWIN_RX, data, len);
+    if (!Eventos_Publicar(EVT_TOQUE_DWIN, 0, data, len)) {
+        printf("EVENTOS: fila cheia, pacote DWIN descartado\r\n");
+    }
 }
 
 /**
- * @brief Executa a sequncia para colocar o MCU em modo de baixo consumo.
+ * @brief Assinante de EVT_TOQUE_DWIN: entrega o pacote ao controller.
  */
-static void EnterStopMode(void) {
-		
-		// 1. Desconecta a stack do host de forma limpa
+static void Tratar_Toque_Dwin(const Evento_t* evento) {
+    Controller_DwinCallback(evento->dados, evento->tamanho);
+}
+
+/**
+ * @brief Inicializaes que no so necessrias para mostrar a tela principal.
+ * No boot rpido roda logo aps a troca de tela e dispara o autodiagnstico
+ * sem telas de verificao.
+ */
+static void Init_Adiada(void) {
+    Battery_Handler_Init(&hi2c1);
+    Lote_Init();
+    Boot_Marcar(BOOT_FASE_INIT_ADIADA);
+#if BOOT_RAPIDO_HABILITADO
+    Diagnostico_Iniciar(PRINCIPAL, true);
+#endif
+}
+
+#if BOOT_RAPIDO_HABILITADO
+/**
+ * @brief Pergunta a tela atual (registrador PIC_NOW) at o display responder.
+ * Qualquer pacote recebido indica que o display j aceita comandos.
+ */
+static void Sondar_Display(void) {
+    if (DWIN_Driver_GetRxPacketCounter() == s_rx_pacotes_boot && HAL_GetTick() < BOOT_DISPLAY_TIMEOUT_MS) {
+        DWIN_Driver_WriteRawBytes(DWIN_LER_PIC_NOW, sizeof(DWIN_LER_PIC_NOW));
+        return;
+    }
+
+    Temporizador_Parar(s_tmr_sonda_display);
+    Boot_Marcar(BOOT_FASE_DISPLAY_PRONTO);
+    Controller_SetScreen(PRINCIPAL);
+    Boot_Marcar(BOOT_FASE_TELA_PRINCIPAL);
+    Temporizador_Iniciar(s_tmr_init_adiada, BOOT_ADIAMENTO_MS);
+}
+#endif
+
+static void Entrar_Estado_Parado(void) {
+    CR_INICIALIZAR(&s_cr_sono);
+    s_current_state = STATE_STOPPED;
+}
+
+/**
+ * @brief Previso para o gerenciador de energia durante a sequncia de Stop:
+ * as esperas por tempo permitem Stop; as por condio, s um WFI.
+ */
+static uint32_t Previsao_Sono(void) {
+    const uint32_t restante = Cr_Restante_ms(&s_cr_sono);
+    return (restante == CR_SEM_PRAZO) ? 1u : restante;
+}
+
+/**
+ * @brief Desliga USB e display, entra em Stop e, ao acordar pelo toque,
+ * religa o necessrio e mostra a tela de confirmao.
+ * Corrotina: cada espera retorna ao loop em vez de chamar HAL_Delay.
+ */
+static Cr_Estado_t Sequencia_Stop(Corrotina_t* cr) {
+    CR_INICIO(cr);
+
+#if RETOMADA_RAPIDA_HABILITADA
+    // 1. Avisa o host e solta o pull-up do D+. A stack, as classes e o memory
+    //    pool continuam montados: SRAM e registradores da USB so retidos no Stop.
+    s_usb_ativo = false;
+    ux_device_stack_disconnect();
+    HAL_PCD_Stop(&hpcd_USB_DRD_FS);
+#else
+    // 1. Desconecta a stack do host de forma limpa
+    s_usb_ativo = false;
     ux_device_stack_disconnect();
 
     // 2. Desinicializa a stack de dispositivo USBX (libera classes e endpoints)
@@ -199,117 +450,78 @@ static void EnterStopMode(void) {
 
     // 4. Desliga o hardware da perifrica USB
     HAL_PCD_DeInit(&hpcd_USB_DRD_FS);
-    HAL_Delay(100);
+#endif
+    CR_AGUARDAR_MS(cr, 100);
 
     HAL_GPIO_WritePin(DISPLAY_PWR_CTRL_GPIO_Port, DISPLAY_PWR_CTRL_Pin, GPIO_PIN_SET);
-    HAL_Delay(800);
+    CR_AGUARDAR_MS(cr, 800);
     HAL_GPIO_WritePin(HAB_TOUCH_GPIO_Port, HAB_TOUCH_Pin, GPIO_PIN_SET);
-    HAL_Delay(800);
+    CR_AGUARDAR_MS(cr, 800);
 
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WUF1);
-    HAL_PWR_EnterSTOPMode(PWR_MAINREGULATOR_ON, PWR_STOPENTRY_WFI);
-}
-
-/**
- * @brief Executa a sequncia de hardware e software aps o MCU acordar.
- */
-static void HandleWakeUpSequence(void) {
-    // O cdigo continua daqui quando a interrupo de toque (EXTI) acorda o MCU
-    SystemClock_Config();
-		
-		HAL_Delay(20);
-		MX_USBX_Device_Init();
-		
-		
-    // 2. Reinicializa o hardware da perifrica USB (PCD).
+    Sono_Dormir();
+
+    // O cdigo continua daqui quando a interrupo de toque (EXTI) acorda o MCU.
+    // Sono_Dormir j restaurou os clocks e compensou o tick com o tempo dormido;
+    // as acordadas de fundo (SoC, log) aconteceram l dentro.
+    s_retomada_inicio = HAL_GetTick();
+#if RETOMADA_RAPIDA_HABILITADA
+    HAL_PCD_Start(&hpcd_USB_DRD_FS);        // Religa o pull-up; o host reenumera
+    s_usb_ativo = true;
+    s_retomada.usb_ms = HAL_GetTick() - s_retomada_inicio;
+#else
+    CR_AGUARDAR_MS(cr, 20);
+    MX_USBX_Device_Init();
+
+    // Reinicializa o hardware da perifrica USB (PCD).
     MX_USB_PCD_Init();
+    s_usb_ativo = true;
+    s_retomada.usb_ms = HAL_GetTick() - s_retomada_inicio;
+#endif
     // Reinicializa perifricos que perdem configurao no modo Stop
     MX_USART2_UART_Init();
-    DWIN_Driver_Init(&huart2, Controller_DwinCallback);
+    DWIN_Driver_Init(&huart2, Publicar_Toque_Dwin);
 
     printf("\r\n>>> TOQUE DETECTADO! Entrando em modo de confirmacao... <<<\r\n");
 
+#if RETOMADA_RAPIDA_HABILITADA
+    // Religa o display e segue assim que ele responder, sem tempo fixo.
+    HAL_GPIO_WritePin(HAB_TOUCH_GPIO_Port, HAB_TOUCH_Pin, GPIO_PIN_RESET);
+    CR_AGUARDAR_MS(cr, RETOMADA_ESCALONAMENTO_MS);
+    HAL_GPIO_WritePin(DISPLAY_PWR_CTRL_GPIO_Port, DISPLAY_PWR_CTRL_Pin, GPIO_PIN_RESET);
+
+    s_rx_pacotes_retomada = DWIN_Driver_GetRxPacketCounter();
+    while (DWIN_Driver_GetRxPacketCounter() == s_rx_pacotes_retomada &&
+           (HAL_GetTick() - s_retomada_inicio) < RETOMADA_DISPLAY_TIMEOUT_MS) {
+        DWIN_Driver_WriteRawBytes(DWIN_LER_PIC_NOW, sizeof(DWIN_LER_PIC_NOW));
+        CR_AGUARDAR_MS(cr, RETOMADA_SONDA_DISPLAY_MS);
+    }
+    s_retomada.display_respondeu = (DWIN_Driver_GetRxPacketCounter() != s_rx_pacotes_retomada);
+#else
     HAL_GPIO_WritePin(HAB_TOUCH_GPIO_Port, HAB_TOUCH_Pin, GPIO_PIN_RESET);
-    HAL_Delay(800);
+    CR_AGUARDAR_MS(cr, 800);
     HAL_GPIO_WritePin(DISPLAY_PWR_CTRL_GPIO_Port, DISPLAY_PWR_CTRL_Pin, GPIO_PIN_RESET);
-    HAL_Delay(800);
+    CR_AGUARDAR_MS(cr, 800);
+    s_retomada.display_respondeu = true;
+#endif
 
     Controller_SetScreen(TELA_CONFIRM_WAKEUP);
 
     // Garante que o comando para mudar de tela seja enviado
-    while (DWIN_Driver_IsTxBusy()) {
-        DWIN_TX_Pump();
+    CR_AGUARDAR_ATE(cr, !DWIN_Driver_IsTxBusy());
+
+    s_retomada.display_ms = HAL_GetTick() - s_retomada_inicio;
+    if (s_retomada.display_ms > s_retomada.pior_ms) {
+        s_retomada.pior_ms = s_retomada.display_ms;
     }
+    s_retomada.retomadas++;
+    printf("Retomada: USB %lu ms, display %lu ms (alvo %u ms)%s\r\n",
+           (unsigned long)s_retomada.usb_ms, (unsigned long)s_retomada.display_ms,
+           RETOMADA_ALVO_MS, s_retomada.display_respondeu ? "" : ", display sem resposta");
 
     s_confirm_start_tick = HAL_GetTick();
     s_countdown_last_tick = s_confirm_start_tick;
     s_wakeup_confirmed = false;
-}
-
-// --- Implementao das Funes de Teste Individuais ---
-
-/** @brief Mostra as informaes de verso no display. Sempre retorna sucesso. */
-static bool Test_DisplayInfo(void)
-{
-    char nr_serial_buffer[17];
-    Gerenciador_Config_Get_Serial(nr_serial_buffer, sizeof(nr_serial_buffer));
-    
-    DWIN_Driver_WriteString(VP_HARDWARE, HARDWARE, strlen(HARDWARE));
-    DWIN_Driver_WriteString(VP_FIRMWARE, FIRMWARE, strlen(FIRMWARE));
-    DWIN_Driver_WriteString(VP_FIRM_IHM, FIRM_IHM, strlen(FIRM_IHM));
-    DWIN_Driver_WriteString(VP_SERIAL, nr_serial_buffer, strlen(nr_serial_buffer));
-    
-    // Espera a transmisso terminar para no sobrecarregar o buffer do DWIN
-    while (DWIN_Driver_IsTxBusy())
-    {
-        DWIN_TX_Pump();
-    }
-    return true;
-}
-
-/** @brief Lgica de teste para os servos (atualmente apenas visual). */
-static bool Test_Servos(void) {
-    // Se houvesse uma forma de verificar o feedback dos servos, a lgica estaria aqui.
-    // Como  um teste visual, simplesmente retornamos sucesso.
-    return true;
-}
-
-/** @brief Lgica de teste para o capacmetro (atualmente apenas visual). */
-static bool Test_Capacimetro(void) {
-    // Poderia ler a frequncia e verificar se est dentro de uma faixa esperada.
-    return true;
-}
-
-/** @brief Executa a tara da balana como forma de teste. */
-static bool Test_Balanca(void) {
-    ADS1232_Tare(); // A prpria tara  um bom teste funcional.
-    // Para um teste mais robusto, poderamos verificar se o valor aps a tara  prximo de zero.
-    return true;
-}
-
-/** @brief L a temperatura inicial e a armazena. */
-static bool Test_Termometro(void) {
-    float temp_inicial = TempSensor_GetTemperature(); 
-    Medicao_Set_Temp_Instru(temp_inicial); // Usa o handler correto para armazenar o dado
 
-    // Um teste real poderia verificar se a temperatura est em uma faixa plausvel (ex: > 0 e < 100)
-    return true;
+    CR_FIM(cr);
 }
-
-/** @brief Verifica se a comunicao com a memria EEPROM est ativa. */
-static bool Test_EEPROM(void) {
-    if (!EEPROM_Driver_IsReady()) {
-
-        Controller_SetScreen(MSG_ERROR); // Tela de erro genrica
-        DWIN_TX_Pump();
-        return false;
-    }
-
-    return true;
-}
-
-/** @brief Lgica de teste para o RTC (atualmente apenas visual). */
-static bool Test_RTC(void) {
-    // O RTC j foi inicializado. Um teste real poderia ler a data/hora e verificar se so vlidas.
-    return true;
-}
\ No newline at end of file
@@ -4,16 +4,24 @@
 #include "dwin_driver.h"
 #include "controller.h" // Para saber a tela atual
 #include "cli_driver.h" // Para logs de debug
+#include "temporizador.h"
+#include "eventos.h"
+#include "consumo.h"
 #include <stdio.h>
 
 // --- Variveis Estticas ---
 static I2C_HandleTypeDef *s_hi2c = NULL;
-static uint32_t s_last_update_tick = 0;
-static const uint32_t SCREEN_UPDATE_INTERVAL_MS = 1000; // Atualiza o display a cada 1 segundo
+static const uint32_t SCREEN_UPDATE_INTERVAL_MS = 1000; // Atualiza o SOC e o display a cada 1 segundo
 static int16_t s_last_icon_id = -1;
 
+// Parcelas de consumo na tela de bateria, na ordem de Consumo_Subsistema_t
+static const uint16_t VP_CONSUMO[NUM_CONSUMIDORES] = {
+    VP_CONSUMO_BASE, VP_CONSUMO_LUZ, VP_CONSUMO_SERVO, VP_CONSUMO_USB, VP_CONSUMO_MEDE
+};
+
 // --- Prottipos de Funes Privadas ---
 static void update_battery_screen_data(void);
+static void Battery_Handler_Atualizar(void);
 static int16_t get_icon_id_from_status(void); 
 
 /**
@@ -24,6 +32,8 @@ void Battery_Handler_Init(I2C_HandleTypeDef *hi2c)
     s_hi2c = hi2c;
     uint8_t device_id = 0;
 
+    Consumo_Init();
+
     // 1. Valida comunicao com o chip
     if (bq25622_validate_comm(s_hi2c, &device_id) != HAL_OK || device_id != 0x0A) {
         CLI_Printf("BATERIA: FALHA na comunicacao com BQ25622!\r\n");
@@ -48,38 +58,55 @@ void Battery_Handler_Init(I2C_HandleTypeDef *hi2c)
     bq_soc_coulomb_init(s_hi2c, BATTERY_CAPACITY_MAH);
     CLI_Printf("BATERIA: Handler inicializado para %dmAh. SoC inicial: %.1f%%\r\n", 
                BATTERY_CAPACITY_MAH, bq_soc_get_percentage());
+
+    // 5. Atualizao peridica pela roda de temporizao (substitui o contador no SysTick)
+    Temporizador_Id_t id = Temporizador_Criar(Battery_Handler_Atualizar, true);
+    Temporizador_Iniciar(id, SCREEN_UPDATE_INTERVAL_MS);
+}
+
+bool Battery_Handler_Verificar_Carregador(void)
+{
+    if (s_hi2c == NULL) return false;
+
+    uint8_t device_id = 0;
+    return (bq25622_validate_comm(s_hi2c, &device_id) == HAL_OK && device_id == 0x0A);
+}
+
+bool Battery_Handler_Atualizar_Sono(uint32_t intervalo_ms, float corrente_piso_A)
+{
+    if (s_hi2c == NULL) return false;
+
+    bq_soc_coulomb_update_intervalo(s_hi2c, intervalo_ms, corrente_piso_A);
+    Consumo_Contabilizar_Sono(intervalo_ms, corrente_piso_A);
+    return true;
 }
 
 /**
- * @brief Funo de processamento chamada no loop principal.
+ * @brief Callback do temporizador peridico (contexto principal, a cada 1 s).
  */
-void Battery_Handler_Process(void)
+static void Battery_Handler_Atualizar(void)
 {
     if (s_hi2c == NULL) return;
 
-    // Atualiza o clculo do SOC (sempre)
     bq_soc_coulomb_update(s_hi2c);
+    Consumo_Amostrar(SCREEN_UPDATE_INTERVAL_MS);
 
-    // Lgica de atualizao do display (a cada 1 segundo)
-    if (HAL_GetTick() - s_last_update_tick >= SCREEN_UPDATE_INTERVAL_MS)
-    {
-        s_last_update_tick = HAL_GetTick();
-
-        // **AQUI EST A NOVA LGICA VISUAL**
-        int16_t current_icon_id = get_icon_id_from_status();
+    // **AQUI EST A NOVA LGICA VISUAL**
+    int16_t current_icon_id = get_icon_id_from_status();
 
-        // Otimizao: s envia o comando para o display se o cone mudou.
-        if (current_icon_id != s_last_icon_id)
+    // Otimizao: s avisa o display se o cone mudou.
+    if (current_icon_id != s_last_icon_id)
+    {
+        if (Eventos_Publicar(EVT_BATERIA_ALTERADA, current_icon_id, NULL, 0))
         {
-            DWIN_Driver_WriteInt(VP_ICON_BAT, current_icon_id);
             s_last_icon_id = current_icon_id;
         }
+    }
 
-        // Se a tela de monitor detalhado estiver aberta, atualiza os dados dela tambm.
-        if (Controller_GetCurrentScreen() == TELA_BATERIA)
-        {
-            update_battery_screen_data();
-        }
+    // Se a tela de monitor detalhado estiver aberta, atualiza os dados dela tambm.
+    if (Controller_GetCurrentScreen() == TELA_BATERIA)
+    {
+        update_battery_screen_data();
     }
 }
 
@@ -117,14 +144,12 @@ static int16_t get_icon_id_from_status(void)
  */
 static void update_battery_screen_data(void)
 {
-		char buffer[20];
     // Obtm os ltimos valores cacheados pelo bq_soc
     float vbus = bq_soc_get_last_vbus();
     float vbat = bq_soc_get_last_vbat();
     float ibat = bq_soc_get_last_ibat();
     float tdie = bq_soc_get_last_tdie();
 		float perc = bq_soc_get_percentage();
-    BQ25622_ChargeStatus_t status = bq_soc_get_last_chg_status();
 
     // Converte para inteiros para enviar ao DWIN (formato com 2 casas decimais)
     int16_t vbus_dwin = (int16_t)(vbus * 1000.0f); // Ex: 5.12V -> 512
@@ -139,4 +164,16 @@ static void update_battery_screen_data(void)
     DWIN_Driver_WriteInt32(VP_IBAT, ibat_dwin);
     DWIN_Driver_WriteInt32(VP_TEMP, tdie_dwin);
 		DWIN_Driver_WriteInt32(VP_PERC, perc_dwin);
+
+    // Autonomia e de onde vem o consumo (mdias recentes do modelo)
+    Consumo_Relatorio_t consumo;
+    Consumo_Get_Relatorio(&consumo);
+    DWIN_Driver_WriteInt32(VP_AUTONOMIA, (consumo.autonomia_min == CONSUMO_AUTONOMIA_INDEFINIDA) ? -1 : (int32_t)consumo.autonomia_min);
+
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        Consumo_Subsistema_Info_t info;
+        Consumo_Get_Subsistema((Consumo_Subsistema_t)i, &info);
+        DWIN_Driver_WriteInt32(VP_CONSUMO[i], (int32_t)(info.media_mA * 10.0f));
+    }
 }
\ No newline at end of file
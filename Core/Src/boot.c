@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * @file        boot.c
+ * @brief       Marcas de tempo das fases do boot.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O tempo  o tick do HAL (ms) mais a frao do perodo do
+ * SysTick j decorrida, o que d resoluo de s sem outro timer.
+ ******************************************************************************/
+
+#include "boot.h"
+#include "main.h"
+#include <stdio.h>
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint32_t s_marcas_us[NUM_BOOT_FASES];
+static bool     s_marcada[NUM_BOOT_FASES];      // Zerado pelo startup, antes de main()
+
+static const char* const s_nomes_fase[NUM_BOOT_FASES] = {
+    [BOOT_FASE_HAL]            = "HAL",
+    [BOOT_FASE_CLOCK]          = "CLOCK",
+    [BOOT_FASE_PERIFERICOS]    = "PERIFERICOS",
+    [BOOT_FASE_USB]            = "USB",
+    [BOOT_FASE_CONFIG]         = "CONFIG",
+    [BOOT_FASE_APP_INIT]       = "APP_INIT",
+    [BOOT_FASE_DISPLAY_PRONTO] = "DISPLAY_PRONTO",
+    [BOOT_FASE_TELA_PRINCIPAL] = "TELA_PRINCIPAL",
+    [BOOT_FASE_INIT_ADIADA]    = "INIT_ADIADA",
+    [BOOT_FASE_DIAGNOSTICO]    = "DIAGNOSTICO",
+};
+
+//==============================================================================
+// Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Tempo desde o HAL_Init em s (tick do HAL + contagem do SysTick).
+ */
+static uint32_t Boot_Get_us(void)
+{
+    uint32_t ms;
+    uint32_t valor;
+    do {
+        ms = HAL_GetTick();
+        valor = SysTick->VAL;
+    } while (ms != HAL_GetTick());     // Releitura se o tick virou no meio
+
+    const uint32_t carga = SysTick->LOAD + 1u;
+    return ms * 1000u + ((carga - 1u - valor) * 1000u) / carga;
+}
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Boot_Marcar(Boot_Fase_t fase)
+{
+    if (fase >= NUM_BOOT_FASES || s_marcada[fase]) return;
+
+    s_marcas_us[fase] = Boot_Get_us();
+    s_marcada[fase] = true;
+
+    if (fase == BOOT_FASE_TELA_PRINCIPAL)
+    {
+        printf("BOOT: tela principal em %lu ms.\r\n", (unsigned long)(s_marcas_us[fase] / 1000u));
+    }
+}
+
+uint32_t Boot_Get_Marca_us(Boot_Fase_t fase)
+{
+    return (fase < NUM_BOOT_FASES && s_marcada[fase]) ? s_marcas_us[fase] : BOOT_SEM_MARCA;
+}
+
+const char* Boot_Get_Nome(Boot_Fase_t fase)
+{
+    return (fase < NUM_BOOT_FASES) ? s_nomes_fase[fase] : "?";
+}
@@ -1,6 +1,7 @@
 #include "bq_soc.h"
 #include "bq25622_driver.h" // Precisamos das funes do BQ
 #include <stddef.h>
+#include <stdbool.h>
 #include <math.h>
 
 /*
@@ -54,13 +55,11 @@ static float bq_soc_estimate_percentage_from_voltage(float vbat_V) {
  */
 
 #define UPDATE_INTERVAL_MS 1000
-static const float UPDATE_INTERVAL_HOURS = (float)UPDATE_INTERVAL_MS / 3600000.0f; // (1000ms / (3600 s/h * 1000 ms/s))
+static const float MS_POR_HORA = 3600000.0f;
 static const float CURRENT_DEADBAND_A = 0.008f;
 
 // Variveis de estado globais (estticas)
 static float g_total_capacity_mAh = 210.0f; // Valor padro, ser sobrescrito na inicializao.
-static volatile uint32_t g_systick_counter = 0;
-static volatile uint8_t  g_update_soc_flag = 0;
 static float g_capacidade_atual_mAh = 0.0f;
 
 static float g_last_vbat = 0.0f;
@@ -69,17 +68,6 @@ static float g_last_ibat = 0.0f;
 static BQ25622_ChargeStatus_t g_last_chg_status = CHG_STAT_NOT_CHARGING;
 static float g_last_tdie = 0.0f;
 
-/**
- * @brief Callback do SysTick (chamado a cada 1ms por padro no HAL)
- */
-void bq_soc_systick_callback(void) {
-    g_systick_counter++;
-    if (g_systick_counter >= UPDATE_INTERVAL_MS) {
-        g_systick_counter = 0;
-        g_update_soc_flag = 1; // Sinaliza o loop principal para atualizar
-    }
-}
-
 /**
  * @brief Inicializa o contador.
  */
@@ -101,19 +89,21 @@ void bq_soc_coulomb_init(I2C_HandleTypeDef *hi2c, uint16_t battery_capacity_mah)
     bq25622_read_vbus(hi2c, &g_last_vbus);
     bq25622_read_charge_status(hi2c, &g_last_chg_status);
     bq25622_read_die_temp(hi2c, &g_last_tdie);
-
-    g_systick_counter = 0;
-    g_update_soc_flag = 0;
 }
 
 /**
- * @brief Atualiza a contagem de Coulomb (deve ser chamada no loop principal)
+ * @brief Atualiza a contagem de Coulomb. Deve ser chamada a cada
+ * UPDATE_INTERVAL_MS (o battery_handler usa um temporizador peridico).
  */
 void bq_soc_coulomb_update(I2C_HandleTypeDef *hi2c) {
-    if (!g_update_soc_flag) {
-        return;
-    }
-    g_update_soc_flag = 0;
+    bq_soc_coulomb_update_intervalo(hi2c, UPDATE_INTERVAL_MS, 0.0f);
+}
+
+/**
+ * @brief Contagem de Coulomb sobre 'intervalo_ms'. Sem carregador e com a
+ * corrente dentro da zona morta, integra o piso informado pelo chamador.
+ */
+void bq_soc_coulomb_update_intervalo(I2C_HandleTypeDef *hi2c, uint32_t intervalo_ms, float corrente_piso_A) {
 
     // 3. --- LEITURAS ---
     float vbus_now, vbat_now, ibat_now_raw; // Renomeado para 'raw' para clareza
@@ -135,6 +125,13 @@ void bq_soc_coulomb_update(I2C_HandleTypeDef *hi2c) {
         ibat_now = 0.0f;
     }
 
+    const bool sem_carregador = (vbus_now <= 4.5f);
+    float ibat_integrada = ibat_now;
+    if (ibat_integrada == 0.0f && sem_carregador)
+    {
+        ibat_integrada = -corrente_piso_A; // Descarga: IBAT negativa
+    }
+
     // 4. --- LGICA DE CLCULO ---
     if (vbus_now > 4.5f && status_now == CHG_STAT_NOT_CHARGING && vbat_now > 4.15f)
     {
@@ -143,9 +140,9 @@ void bq_soc_coulomb_update(I2C_HandleTypeDef *hi2c) {
     }
     else
     {
-        // Usa a corrente j filtrada ('ibat_now') para o clculo
-        float ibat_mA = ibat_now * 1000.0f;
-        float delta_mAh = ibat_mA * UPDATE_INTERVAL_HOURS;
+        // Usa a corrente j filtrada (ou o piso em repouso) para o clculo
+        float ibat_mA = ibat_integrada * 1000.0f;
+        float delta_mAh = ibat_mA * ((float)intervalo_ms / MS_POR_HORA);
         g_capacidade_atual_mAh += delta_mAh;
     }
 
@@ -19,6 +19,23 @@
 #include "medicao_handler.h"
 #include "temp_sensor.h"
 #include "relato.h"
+#include "lote_handler.h"
+#include "escalonador.h"
+#include "eventos.h"
+#include "profiler.h"
+#include "trace.h"
+#include "memoria.h"
+#include "secao_critica.h"
+#include "boot.h"
+#include "app_manager.h"
+#include "energia.h"
+#include "sono.h"
+#include "falha_energia.h"
+#include "governador.h"
+#include "consumo.h"
+#include "battery_handler.h"
+#include "bq_soc.h"
+#include "gravacao.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -48,6 +65,20 @@ static void Cmd_GetPeso (char* args);
 static void Cmd_GetTemp (char* args);
 static void Cmd_GetFreq (char* args);
 static void Cmd_Service (char* args);
+static void Cmd_Lote    (char* args);
+static void Cmd_Stats   (char* args);
+static void Cmd_Prof    (char* args);
+static void Cmd_Trace   (char* args);
+static void Cmd_Mem     (char* args);
+static void Cmd_IrqOff  (char* args);
+static void Cmd_Boot    (char* args);
+static void Cmd_Gravar  (char* args);
+static void Cmd_Reproduzir(char* args);
+static void Cmd_Energia (char* args);
+static void Cmd_Sono    (char* args);
+static void Cmd_Queda   (char* args);
+static void Cmd_Clock   (char* args);
+static void Cmd_Consumo (char* args);
 
 /* -------------------- Subcomandos DWIN -------------------- */
 
@@ -65,6 +96,13 @@ static void Handle_Dwin_RAW   (char* sub_args);
 
 static uint8_t hex_char_to_value(char c);
 
+/* -------------------- Subcomandos LOTE -------------------- */
+
+static void Handle_Lote_INICIAR (char* sub_args);
+static void Handle_Lote_PARAR   (char* sub_args);
+static void Handle_Lote_STATUS  (char* sub_args);
+static void Handle_Lote_HIST    (char* sub_args);
+
 /* ============================================================================
  *  TABELAS
  * ========================================================================== */
@@ -81,6 +119,20 @@ static const cli_command_t s_command_table[] = {
     { "FREQ",     Cmd_GetFreq  },
     { "SERVICE",  Cmd_Service  },
     { "WHO_AM_I", Cmd_WhoAmI   },
+    { "LOTE",     Cmd_Lote     },
+    { "STATS",    Cmd_Stats    },
+    { "PROF",     Cmd_Prof     },
+    { "TRACE",    Cmd_Trace    },
+    { "MEM",      Cmd_Mem      },
+    { "IRQOFF",   Cmd_IrqOff   },
+    { "BOOT",     Cmd_Boot     },
+    { "GRAVAR",   Cmd_Gravar   },
+    { "REPRODUZIR", Cmd_Reproduzir },
+    { "ENERGIA",  Cmd_Energia  },
+    { "SONO",     Cmd_Sono     },
+    { "QUEDA",    Cmd_Queda    },
+    { "CLOCK",    Cmd_Clock    },
+    { "CONSUMO",  Cmd_Consumo  },
 };
 
 static const size_t NUM_COMMANDS =
@@ -96,6 +148,16 @@ static const dwin_subcommand_t s_dwin_table[] = {
 static const size_t NUM_DWIN_SUBCOMMANDS =
     sizeof(s_dwin_table) / sizeof(s_dwin_table[0]);
 
+static const dwin_subcommand_t s_lote_table[] = {
+    { "INICIAR", Handle_Lote_INICIAR },
+    { "PARAR",   Handle_Lote_PARAR   },
+    { "STATUS",  Handle_Lote_STATUS  },
+    { "HIST",    Handle_Lote_HIST    },
+};
+
+static const size_t NUM_LOTE_SUBCOMMANDS =
+    sizeof(s_lote_table) / sizeof(s_lote_table[0]);
+
 /* ============================================================================
  *  TEXTO DE AJUDA
  * ========================================================================== */
@@ -114,6 +176,27 @@ static const char HELP_TEXT[] =
     "| PESO                     | Mostra a leitura atual da balanca.            |\r\n"
     "| TEMP                     | Mostra a leitura do sensor de temperatura.    |\r\n"
     "| FREQ                     | Mostra a ultima leitura de frequencia.        |\r\n"
+    "| LOTE INICIAR [n]         | Inicia lote de n amostras (0 = continuo).     |\r\n"
+    "| LOTE PARAR               | Encerra o lote apos a amostra atual.          |\r\n"
+    "| LOTE STATUS              | Vazao (amostras/hora) e tempo por etapa.      |\r\n"
+    "| LOTE HIST [n]            | Lista as ultimas n amostras do historico.     |\r\n"
+    "| STATS [RESET]            | Tempo por tarefa/loop (us) e fila de eventos. |\r\n"
+    "| PROF INICIAR|PARAR|ZERAR | Profiler por amostragem do PC (TIM3).         |\r\n"
+    "| PROF DUMP                | Histograma de enderecos (resolver com .map).  |\r\n"
+    "| TRACE CONGELAR|LIBERAR   | Congela / retoma o rastro de eventos.         |\r\n"
+    "| TRACE GATILHO <id> [n]   | Congela n registros apos o evento <id>.       |\r\n"
+    "| TRACE DUMP               | Envia o rastro (ver trace_para_chrome no PC). |\r\n"
+    "| MEM                      | Pico de pilha, pool USBX e RAM estatica.      |\r\n"
+    "| IRQOFF [RESET]           | Piores secoes com IRQ bloqueada (us).         |\r\n"
+    "| BOOT                     | Tempo de cada fase do boot (ms).              |\r\n"
+    "| GRAVAR INICIAR|PARAR     | Grava entradas (DWIN/CLI/ADS/TIM2) na EEPROM. |\r\n"
+    "| GRAVAR STATUS            | Registros, bytes e descartes da gravacao.     |\r\n"
+    "| REPRODUZIR [PARAR]       | Reinjeta a gravacao no mesmo ritmo.           |\r\n"
+    "| ENERGIA [ZERAR]          | Tempo em cada modo (Sleep/Stop) e bloqueios.  |\r\n"
+    "| SONO [ZERAR]             | Acordadas de fundo no Stop: ciclo e carga.    |\r\n"
+    "| QUEDA [SIMULAR]          | Queda de energia: origens e estado critico.   |\r\n"
+    "| CLOCK [ZERAR]            | Clock do nucleo: residencia e demandas.       |\r\n"
+    "| CONSUMO [ZERAR]          | Consumo por subsistema e autonomia.           |\r\n"
     "============================================================================\r\n";
 
 /* ============================================================================
@@ -134,6 +217,8 @@ static void CLI_LineHandler(const char* line) {
         return;
     }
 
+    GRAVACAO_BYTES(GRV_CLI_LINHA, line, (uint16_t)strlen(line));
+
     // Copia para um buffer mutvel, pois vamos tokenizar
     char buffer[128];
     strncpy(buffer, line, sizeof(buffer) - 1u);
@@ -261,6 +346,12 @@ static void Cmd_GetTemp(char* args) {
     (void)args;
     const float temperatura = TempSensor_GetTemperature();
     CLI_Printf("Temperatura interna do MCU: %.2f C\r\n", temperatura);
+    if (TempSensor_Temp_Amostra_Valida()) {
+        CLI_Printf("Temperatura da amostra: %.2f C\r\n", TempSensor_Get_Temp_Amostra());
+    } else {
+        CLI_Puts("Temperatura da amostra: sensor fora da faixa\r\n");
+    }
+    CLI_Printf("VDDA: %u mV\r\n", (unsigned)TempSensor_Get_VDDA_mV());
 }
 
 static void Cmd_GetFreq(char* args) {
@@ -268,8 +359,462 @@ static void Cmd_GetFreq(char* args) {
     DadosMedicao_t dados;
     Medicao_Get_UltimaMedicao(&dados);
     CLI_Puts("Dados de Frequencia:\r\n");
-    CLI_Printf("  Pulsos (1s): %.1f\r\n", dados.Frequencia);
+    CLI_Printf("  Frequencia: %.1f Hz\r\n", dados.Frequencia);
     CLI_Printf("  Escala A: %.2f\r\n", dados.Escala_A);
+    CLI_Printf("  Integracao: %lu ms\r\n", (unsigned long)Medicao_Get_Tempo_Integracao_ms());
+}
+
+/* ============================================================================
+ *  COMANDO STATS
+ * ========================================================================== */
+
+#if ESCALONADOR_ESTATISTICAS
+static void Imprimir_Estatistica(const char* nome, const Escalonador_Estatistica_t* e, uint32_t atraso_max_ms) {
+    const uint32_t media_us = (e->execucoes > 0u) ? (uint32_t)(e->soma_us / e->execucoes) : 0u;
+    CLI_Printf("%-8s %8lu %6lu %6lu %7lu %4lu | %6lu %6lu %5lu %4lu\r\n",
+               nome,
+               (unsigned long)e->execucoes,
+               (unsigned long)e->min_us,
+               (unsigned long)media_us,
+               (unsigned long)e->max_us,
+               (unsigned long)atraso_max_ms,
+               (unsigned long)e->histograma[0],
+               (unsigned long)e->histograma[1],
+               (unsigned long)e->histograma[2],
+               (unsigned long)e->histograma[3]);
+}
+#endif
+
+static void Cmd_Stats(char* args) {
+#if ESCALONADOR_ESTATISTICAS
+    if (args && strcasecmp(args, "RESET") == 0) {
+        Escalonador_Zerar_Estatisticas();
+        Eventos_Zerar_Estatisticas();
+        CLI_Puts("Estatisticas zeradas.");
+        return;
+    }
+
+    Escalonador_Estatistica_t estatistica;
+    Escalonador_Estatistica_t periodo;
+
+    CLI_Puts("TAREFA       EXEC MIN_us MED_us  MAX_us ATRS |  <100u   <1ms <10ms >=10\r\n");
+    for (uint8_t id = 0; id < Escalonador_Get_Num_Tarefas(); id++) {
+        if (Escalonador_Get_Estatistica_Tarefa(id, &estatistica)) {
+            Imprimir_Estatistica(Escalonador_Get_Nome(id), &estatistica, Escalonador_Get_Atraso_Max_ms(id));
+        }
+    }
+
+    Escalonador_Get_Estatistica_Loop(&estatistica, &periodo);
+    Imprimir_Estatistica("PASSADA", &estatistica, 0u);
+    Imprimir_Estatistica("PERIODO", &periodo, 0u);
+
+    CLI_Printf("EVENTO            PUBL  DESC  DESP MAX_ms (fila max %u/%u)\r\n",
+               (unsigned)Eventos_Get_Ocupacao_Max(), (unsigned)EVENTOS_FILA_TAMANHO);
+    for (uint8_t tipo = 0; tipo < NUM_TIPOS_EVENTO; tipo++) {
+        Evento_Estatistica_t ev;
+        Eventos_Get_Estatistica((Evento_Tipo_t)tipo, &ev);
+        CLI_Printf("%-16s %5lu %5lu %5lu %6lu\r\n",
+                   Eventos_Get_Nome((Evento_Tipo_t)tipo),
+                   (unsigned long)ev.publicados,
+                   (unsigned long)ev.descartados,
+                   (unsigned long)ev.despachados,
+                   (unsigned long)ev.tempo_max_ms);
+    }
+#else
+    (void)args;
+    CLI_Puts("Estatisticas desabilitadas (ESCALONADOR_ESTATISTICAS = 0).");
+#endif
+}
+
+/* ============================================================================
+ *  COMANDO PROF
+ * ========================================================================== */
+
+static void Cmd_Prof(char* args) {
+#if PROFILER_HABILITADO
+    if (!args) {
+        CLI_Printf("Profiler %s. Amostras: %lu (fora da flash: %lu)",
+                   Profiler_Ativo() ? "ativo" : "parado",
+                   (unsigned long)Profiler_Get_Amostras(),
+                   (unsigned long)Profiler_Get_Fora_Flash());
+    } else if (strcasecmp(args, "INICIAR") == 0) {
+        Profiler_Iniciar();
+        CLI_Puts("Profiler iniciado.");
+    } else if (strcasecmp(args, "PARAR") == 0) {
+        Profiler_Parar();
+        CLI_Puts("Profiler parado.");
+    } else if (strcasecmp(args, "ZERAR") == 0) {
+        Profiler_Zerar();
+        CLI_Puts("Histograma zerado.");
+    } else if (strcasecmp(args, "DUMP") == 0) {
+        Profiler_Dump();
+    } else {
+        CLI_Puts("Uso: PROF [INICIAR|PARAR|ZERAR|DUMP]");
+    }
+#else
+    (void)args;
+    CLI_Puts("Profiler desabilitado (PROFILER_HABILITADO = 0).");
+#endif
+}
+
+/* ============================================================================
+ *  COMANDO TRACE
+ * ========================================================================== */
+
+static void Cmd_Trace(char* args) {
+#if TRACE_HABILITADO
+    if (!args) {
+        CLI_Printf("Trace %s. Registros gravados: %lu (anel de %u)",
+                   Trace_Congelado() ? "congelado" : "gravando",
+                   (unsigned long)Trace_Get_Total(), (unsigned)TRACE_NUM_REGISTROS);
+    } else if (strcasecmp(args, "CONGELAR") == 0) {
+        Trace_Congelar();
+        CLI_Puts("Trace congelado.");
+    } else if (strcasecmp(args, "LIBERAR") == 0) {
+        Trace_Liberar();
+        CLI_Puts("Trace gravando.");
+    } else if (strncasecmp(args, "GATILHO", 7) == 0) {
+        unsigned id = 0u;
+        unsigned pos = 0u;
+        if (sscanf(args + 7, "%u %u", &id, &pos) >= 1 && id < NUM_TRACE_IDS) {
+            Trace_Armar_Gatilho((Trace_Id_t)id, (uint16_t)pos);
+            CLI_Printf("Gatilho armado: id %u, mais %u registros.", id, pos);
+        } else {
+            CLI_Printf("Uso: TRACE GATILHO <id 0-%u> [registros apos]", (unsigned)(NUM_TRACE_IDS - 1));
+        }
+    } else if (strcasecmp(args, "DUMP") == 0) {
+        Trace_Dump();
+    } else {
+        CLI_Puts("Uso: TRACE [CONGELAR|LIBERAR|GATILHO <id> [n]|DUMP]");
+    }
+#else
+    (void)args;
+    CLI_Puts("Trace desabilitado (TRACE_HABILITADO = 0).");
+#endif
+}
+
+/* ============================================================================
+ *  COMANDO MEM
+ * ========================================================================== */
+
+static void Cmd_Mem(char* args) {
+    (void)args;
+    Memoria_Uso_t uso;
+    Memoria_Get_Uso(&uso);
+
+    CLI_Printf("Pilha:        pico %5lu de %5lu B\r\n",
+               (unsigned long)uso.pilha_usada, (unsigned long)uso.pilha_tamanho);
+    if (uso.pool_ativo) {
+        CLI_Printf("Pool USBX:    uso %5lu, pico %5lu de %5lu B\r\n",
+                   (unsigned long)uso.pool_em_uso, (unsigned long)uso.pool_pico,
+                   (unsigned long)uso.pool_tamanho);
+    } else {
+        CLI_Puts("Pool USBX:    nao inicializado\r\n");
+    }
+    CLI_Printf("Estatica:     %5lu B (.data + .bss, com o pool USBX)\r\n", (unsigned long)uso.estatica);
+    CLI_Printf("Pilha + heap: %5lu B\r\n", (unsigned long)(MEMORIA_PILHA_TAMANHO + MEMORIA_HEAP_TAMANHO));
+    CLI_Printf("RAM livre:    %5ld de %5lu B\r\n",
+               (long)uso.ram_tamanho - (long)(uso.estatica + MEMORIA_PILHA_TAMANHO + MEMORIA_HEAP_TAMANHO),
+               (unsigned long)uso.ram_tamanho);
+}
+
+/* ============================================================================
+ *  COMANDO IRQOFF
+ * ========================================================================== */
+
+static void Cmd_IrqOff(char* args) {
+#if SECAO_CRITICA_MEDIR
+    if (args && strcasecmp(args, "RESET") == 0) {
+        SecaoCritica_Zerar();
+        CLI_Puts("Medicoes zeradas.");
+        return;
+    }
+
+    SecaoCritica_Local_t locais[SECAO_CRITICA_MAX_LOCAIS];
+    const uint8_t n = SecaoCritica_Get_Piores(locais, SECAO_CRITICA_MAX_LOCAIS);
+
+    CLI_Puts("LOCAL                          LINHA     VEZES  MAX_us  MED_us\r\n");
+    for (uint8_t i = 0; i < n; i++) {
+        const uint32_t media_us = (locais[i].contagem > 0u) ? (uint32_t)(locais[i].soma_us / locais[i].contagem) : 0u;
+        CLI_Printf("%-30.30s %5u %9lu %7lu %7lu\r\n",
+                   locais[i].funcao,
+                   (unsigned)locais[i].linha,
+                   (unsigned long)locais[i].contagem,
+                   (unsigned long)locais[i].max_us,
+                   (unsigned long)media_us);
+    }
+    if (n == 0u) {
+        CLI_Puts("Nenhuma secao medida ainda.\r\n");
+    }
+#else
+    (void)args;
+    CLI_Puts("Medicao desabilitada (SECAO_CRITICA_MEDIR = 0).");
+#endif
+}
+
+/* ============================================================================
+ *  COMANDO BOOT
+ * ========================================================================== */
+
+static void Cmd_Boot(char* args) {
+    (void)args;
+    uint32_t anterior_us = 0;
+
+    CLI_Puts("FASE               T_ms    DELTA_ms\r\n");
+    for (uint8_t i = 0; i < NUM_BOOT_FASES; i++) {
+        const uint32_t marca_us = Boot_Get_Marca_us((Boot_Fase_t)i);
+        if (marca_us == BOOT_SEM_MARCA) {
+            CLI_Printf("%-16s       -           -\r\n", Boot_Get_Nome((Boot_Fase_t)i));
+            continue;
+        }
+        CLI_Printf("%-16s %6lu.%01lu %9lu.%01lu\r\n", Boot_Get_Nome((Boot_Fase_t)i),
+                   (unsigned long)(marca_us / 1000u), (unsigned long)((marca_us % 1000u) / 100u),
+                   (unsigned long)((marca_us - anterior_us) / 1000u),
+                   (unsigned long)(((marca_us - anterior_us) % 1000u) / 100u));
+        anterior_us = marca_us;
+    }
+    CLI_Printf("Boot rapido: %s\r\n", BOOT_RAPIDO_HABILITADO ? "habilitado" : "desabilitado");
+
+    App_Retomada_t retomada;
+    App_Manager_Get_Retomada(&retomada);
+    if (retomada.retomadas == 0u) {
+        CLI_Printf("Retomada do Stop (%s): nenhuma ainda.\r\n",
+                   RETOMADA_RAPIDA_HABILITADA ? "rapida" : "completa");
+        return;
+    }
+    CLI_Printf("Retomada do Stop (%s): USB %lu ms, display %lu ms, pior %lu ms, alvo %u ms%s\r\n",
+               RETOMADA_RAPIDA_HABILITADA ? "rapida" : "completa",
+               (unsigned long)retomada.usb_ms, (unsigned long)retomada.display_ms,
+               (unsigned long)retomada.pior_ms, RETOMADA_ALVO_MS,
+               retomada.display_respondeu ? "" : " (display sem resposta)");
+}
+
+/* ============================================================================
+ *  COMANDO ENERGIA
+ * ========================================================================== */
+
+static void Cmd_Energia(char* args) {
+    if (args && strcasecmp(args, "ZERAR") == 0) {
+        Energia_Zerar();
+        CLI_Puts("Residencias zeradas.");
+        return;
+    }
+
+    Energia_Residencia_t residencia[NUM_NIVEIS_ENERGIA];
+    uint64_t total_us = 0;
+    for (uint8_t i = 0; i < NUM_NIVEIS_ENERGIA; i++) {
+        Energia_Get_Residencia((Energia_Nivel_t)i, &residencia[i]);
+        total_us += residencia[i].tempo_us;
+    }
+
+    CLI_Puts("MODO          TEMPO_ms      %   ENTRADAS\r\n");
+    for (uint8_t i = 0; i < NUM_NIVEIS_ENERGIA; i++) {
+        const uint32_t permil = (total_us > 0u) ? (uint32_t)((residencia[i].tempo_us * 1000u) / total_us) : 0u;
+        CLI_Printf("%-10s %11lu %4lu.%01lu %10lu\r\n", Energia_Get_Nome_Nivel((Energia_Nivel_t)i),
+                   (unsigned long)(residencia[i].tempo_us / 1000u),
+                   (unsigned long)(permil / 10u), (unsigned long)(permil % 10u),
+                   (unsigned long)residencia[i].entradas);
+    }
+
+    CLI_Puts("Stop impedido por:");
+    for (uint8_t i = 0; i < Energia_Get_Num_Restricoes(); i++) {
+        CLI_Printf(" %s=%lu", Energia_Get_Nome_Restricao(i), (unsigned long)Energia_Get_Bloqueios(i));
+    }
+
+    Energia_USB_t usb;
+    Energia_Get_USB(&usb);
+    CLI_Printf("\r\nUSB suspenso: %lu vezes, %lu ms, pior retomada do HSI48 %lu us",
+               (unsigned long)usb.suspensoes, (unsigned long)usb.tempo_suspenso_ms,
+               (unsigned long)usb.retomada_max_us);
+}
+
+/* ============================================================================
+ *  COMANDO SONO
+ * ========================================================================== */
+
+static void Cmd_Sono(char* args) {
+    if (args && strcasecmp(args, "ZERAR") == 0) {
+        Sono_Zerar();
+        CLI_Puts("Relatorio de sono zerado.");
+        return;
+    }
+
+    Sono_Relatorio_t rel;
+    Sono_Get_Relatorio(&rel);
+    const uint64_t total_us = rel.dormido_ms * 1000u + rel.acordado_us;
+    const uint32_t ppm = (total_us > 0u) ? (uint32_t)((rel.acordado_us * 1000000u) / total_us) : 0u;
+
+    CLI_Printf("Sonos: %lu, acordadas de fundo: %lu (a cada %lu s), intermediarias: %lu\r\n",
+               (unsigned long)rel.sonos, (unsigned long)rel.acordadas,
+               (unsigned long)(SONO_INTERVALO_MS / 1000u), (unsigned long)rel.intermediarias);
+    CLI_Printf("Dormido %lu s, acordado %lu ms (pior %lu us), ciclo de trabalho %lu ppm\r\n",
+               (unsigned long)(rel.dormido_ms / 1000u), (unsigned long)(rel.acordado_us / 1000u),
+               (unsigned long)rel.acordada_max_us, (unsigned long)ppm);
+    CLI_Printf("Carga estimada: %lu uAh. SoC no ultimo sono: %u.%u%% -> %u.%u%%\r\n",
+               (unsigned long)rel.carga_uAh,
+               rel.soc_inicio_decimos / 10u, rel.soc_inicio_decimos % 10u,
+               rel.soc_fim_decimos / 10u, rel.soc_fim_decimos % 10u);
+
+    Sono_Registro_t log[SONO_LOG_TAMANHO];
+    const uint8_t n = Sono_Get_Log(log, SONO_LOG_TAMANHO);
+    CLI_Puts("  INSTANTE_s  VBAT_mV  IBAT_mA   SOC_%  ACORDADA_us\r\n");
+    for (uint8_t i = 0; i < n; i++) {
+        CLI_Printf("%12lu %8u %8d %5u.%u %12u\r\n", (unsigned long)log[i].instante_s,
+                   log[i].vbat_mv, log[i].ibat_ma,
+                   log[i].soc_decimos / 10u, log[i].soc_decimos % 10u, log[i].acordada_us);
+    }
+}
+
+/* ============================================================================
+ *  COMANDO QUEDA
+ * ========================================================================== */
+
+static void Cmd_Queda(char* args) {
+    if (args && strcasecmp(args, "SIMULAR") == 0) {
+        Falha_Energia_Simular();
+        CLI_Puts("Emergencia simulada na proxima passada.");
+        return;
+    }
+
+    Falha_Energia_Status_t status;
+    Falha_Energia_Get_Status(&status);
+    CLI_Printf("Estado: %s. Emergencias desde o boot: %lu, ultima %lu us (%s), pior %lu us\r\n",
+               status.em_falha ? "EM FALHA (EEPROM bloqueada)" : "normal",
+               (unsigned long)status.emergencias, (unsigned long)status.ultima_duracao_us,
+               status.ultima_gravou ? "gravou" : "sem registro",
+               (unsigned long)status.duracao_max_us);
+
+    CLI_Puts("Origens ativas:");
+    for (uint8_t i = 0; i < NUM_FALHA_ORIGENS; i++) {
+        if (status.origens & (1u << i)) CLI_Printf(" %s", Falha_Energia_Get_Nome_Origem((Falha_Origem_t)i));
+    }
+    if (status.origens == 0u) CLI_Puts(" nenhuma");
+
+    Falha_Energia_Registro_t reg;
+    if (!Falha_Energia_Get_Registro(&reg)) {
+        CLI_Puts("\r\nNenhum estado critico gravado.");
+        return;
+    }
+    CLI_Printf("\r\nUltimo registro: queda #%u, seq %lu, SoC %u.%u%%, VBAT %u mV, amostra %lu,\r\n",
+               reg.quedas, (unsigned long)reg.sequencia, reg.soc_decimos / 10u, reg.soc_decimos % 10u,
+               reg.vbat_mv, (unsigned long)reg.numero_amostra);
+    CLI_Printf("  umidade %.2f%%, peso %.2f g, origens 0x%02X, escrita %s",
+               reg.umidade, reg.peso, reg.origens, reg.escrita_interrompida ? "interrompida" : "ociosa");
+}
+
+/* ============================================================================
+ *  COMANDO CLOCK
+ * ========================================================================== */
+
+static void Cmd_Clock(char* args) {
+    if (args && strcasecmp(args, "ZERAR") == 0) {
+        Governador_Zerar();
+        CLI_Puts("Relatorio do governador zerado.");
+        return;
+    }
+
+    static const char* const nomes_clock[NUM_CLOCKS_ENERGIA] = {"48 MHz", "12 MHz"};
+    Governador_Relatorio_t rel;
+    Governador_Get_Relatorio(&rel);
+
+    CLI_Printf("Clock %s%s. Trocas: %lu, adiadas: %lu, carga do nucleo %lu.%lu%%\r\n",
+               nomes_clock[rel.clock], GOVERNADOR_HABILITADO ? "" : " (governador desabilitado)",
+               (unsigned long)rel.trocas, (unsigned long)rel.adiadas,
+               (unsigned long)(rel.carga_permil / 10u), (unsigned long)(rel.carga_permil % 10u));
+    CLI_Puts("  CLOCK    ENTRADAS  EXECUTANDO_ms  SLEEP_ms\r\n");
+    for (uint8_t c = 0; c < NUM_CLOCKS_ENERGIA; c++) {
+        CLI_Printf("  %-7s %9lu %14lu %9lu\r\n", nomes_clock[c], (unsigned long)rel.residencia[c].entradas,
+                   (unsigned long)(rel.residencia[c].executando_us / 1000u),
+                   (unsigned long)(rel.residencia[c].sleep_us / 1000u));
+    }
+
+    CLI_Puts("Subidas por demanda:");
+    for (uint8_t i = 0; i < Governador_Get_Num_Demandas(); i++) {
+        CLI_Printf(" %s=%lu%s", Governador_Get_Nome_Demanda(i), (unsigned long)Governador_Get_Subidas(i),
+                   (rel.demandas & (1u << i)) ? "*" : "");
+    }
+    CLI_Printf("\r\nCarga estimada do MCU: %lu uAh, economia frente a 48 MHz fixo: %lu uAh",
+               (unsigned long)rel.carga_uAh, (unsigned long)rel.economia_uAh);
+}
+
+/* ============================================================================
+ *  COMANDO CONSUMO
+ * ========================================================================== */
+
+static void Cmd_Consumo(char* args) {
+    if (args && strcasecmp(args, "ZERAR") == 0) {
+        Consumo_Zerar();
+        CLI_Puts("Contabilidade de consumo zerada (correntes aprendidas mantidas).");
+        return;
+    }
+
+    Consumo_Relatorio_t rel;
+    Consumo_Get_Relatorio(&rel);
+    if (!rel.em_descarga) {
+        CLI_Puts("VBUS presente: sem descarga, autonomia nao se aplica.\r\n");
+    } else if (rel.autonomia_min == CONSUMO_AUTONOMIA_INDEFINIDA) {
+        CLI_Puts("Autonomia: indefinida (descarga media abaixo de 0,5 mA).\r\n");
+    } else {
+        CLI_Printf("Autonomia: %luh%02lu (%.1f%% de %u mAh)\r\n",
+                   (unsigned long)(rel.autonomia_min / 60u), (unsigned long)(rel.autonomia_min % 60u),
+                   bq_soc_get_percentage(), BATTERY_CAPACITY_MAH);
+    }
+    CLI_Printf("Descarga media %.1f mA (modelo %.1f mA, erro medio %.1f mA). Amostras %lu, validas %lu\r\n",
+               rel.media_medida_mA, rel.media_prevista_mA, rel.erro_medio_mA,
+               (unsigned long)rel.amostras, (unsigned long)rel.amostras_validas);
+
+    CLI_Puts("  SUBSISTEMA  ATIVO  CORRENTE_mA  MEDIA_mA  PARCELA_%  CARGA_mAh\r\n");
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++) {
+        Consumo_Subsistema_Info_t info;
+        Consumo_Get_Subsistema((Consumo_Subsistema_t)i, &info);
+        const float parcela = (rel.media_medida_mA > 0.0f) ? info.media_mA * 100.0f / rel.media_medida_mA : 0.0f;
+        CLI_Printf("  %-10s %5.0f%% %12.1f %9.1f %10.1f %10.3f\r\n", Consumo_Get_Nome((Consumo_Subsistema_t)i),
+                   info.atividade * 100.0f, info.corrente_mA, info.media_mA, parcela, info.carga_mAh);
+    }
+    CLI_Printf("  %-10s %36s %10.3f", "SONO", "", rel.carga_sono_mAh);
+}
+
+/* ============================================================================
+ *  COMANDOS GRAVAR / REPRODUZIR
+ * ========================================================================== */
+
+static void Cmd_Gravar(char* args) {
+#if GRAVACAO_HABILITADA
+    if (!args || strcasecmp(args, "STATUS") == 0) {
+        Gravacao_Status_t status;
+        Gravacao_Get_Status(&status);
+        CLI_Printf("Gravacao %s. %lu registros, %lu/%lu bytes, %lu descartados, %lu ms.",
+                   status.gravando ? "ativa" : (status.reproduzindo ? "em reproducao" : "parada"),
+                   (unsigned long)status.registros, (unsigned long)status.bytes,
+                   (unsigned long)status.capacidade, (unsigned long)status.descartados,
+                   (unsigned long)status.duracao_ms);
+    } else if (strcasecmp(args, "INICIAR") == 0) {
+        CLI_Puts(Gravacao_Iniciar() ? "Gravacao iniciada." : "Gravacao ou reproducao ja em andamento.");
+    } else if (strcasecmp(args, "PARAR") == 0) {
+        Gravacao_Parar();
+        CLI_Puts("Encerrando gravacao (aguarde o resumo).");
+    } else {
+        CLI_Puts("Uso: GRAVAR [INICIAR|PARAR|STATUS]");
+    }
+#else
+    (void)args;
+    CLI_Puts("Gravacao desabilitada (GRAVACAO_HABILITADA = 0).");
+#endif
+}
+
+static void Cmd_Reproduzir(char* args) {
+#if GRAVACAO_HABILITADA
+    if (!args) {
+        CLI_Puts(Gravacao_Reproduzir() ? "Reproducao iniciada." : "Sem gravacao valida ou modulo ocupado.");
+    } else if (strcasecmp(args, "PARAR") == 0) {
+        Gravacao_Parar_Reproducao();
+    } else {
+        CLI_Puts("Uso: REPRODUZIR [PARAR]");
+    }
+#else
+    (void)args;
+    CLI_Puts("Gravacao desabilitada (GRAVACAO_HABILITADA = 0).");
+#endif
 }
 
 /* ============================================================================
@@ -413,4 +958,85 @@ static void Handle_Dwin_RAW(char* sub_args) {
     }
 
     DWIN_Driver_WriteRawBytes(raw_buffer, (uint16_t)byte_count);
-}
\ No newline at end of file
+}
+
+/* ============================================================================
+ *  COMANDO LOTE E SUBCOMANDOS
+ * ========================================================================== */
+
+static void Cmd_Lote(char* args) {
+    if (!args) {
+        CLI_Puts("Uso: LOTE <INICIAR|PARAR|STATUS|HIST> ... (veja HELP)");
+        return;
+    }
+
+    char* sub_cmd  = args;
+    char* sub_args = strchr(sub_cmd, ' ');
+    if (sub_args) {
+        *sub_args++ = '\0';
+        while (isspace((unsigned char)*sub_args)) {
+            sub_args++;
+        }
+        if (*sub_args == '\0') {
+            sub_args = NULL;
+        }
+    }
+
+    for (size_t i = 0; i < NUM_LOTE_SUBCOMMANDS; i++) {
+        if (strcasecmp(sub_cmd, s_lote_table[i].name) == 0) {
+            s_lote_table[i].handler(sub_args);
+            return;
+        }
+    }
+
+    CLI_Printf("Subcomando LOTE desconhecido: \"%s\"", sub_cmd);
+}
+
+static void Handle_Lote_INICIAR(char* sub_args) {
+    const uint16_t quantidade = sub_args ? (uint16_t)atoi(sub_args) : 0u;
+
+    if (Lote_Is_Ativo()) {
+        CLI_Puts("Lote ja em andamento. Use LOTE PARAR.");
+        return;
+    }
+    if (Lote_Iniciar(quantidade)) {
+        CLI_Printf("Lote iniciado (%u amostras).", quantidade);
+    } else {
+        CLI_Puts("Medicao em andamento; lote nao iniciado.");
+    }
+}
+
+static void Handle_Lote_PARAR(char* sub_args) {
+    (void)sub_args;
+    if (!Lote_Is_Ativo()) {
+        CLI_Puts("Nenhum lote em andamento.");
+        return;
+    }
+    Lote_Parar();
+    CLI_Puts("Lote encerrado; a amostra atual sera concluida.");
+}
+
+static void Handle_Lote_STATUS(char* sub_args) {
+    (void)sub_args;
+    Lote_Imprimir_Estatisticas();
+}
+
+static void Handle_Lote_HIST(char* sub_args) {
+    // Limitado pelo FIFO de TX do CLI (~60 bytes por linha).
+    uint16_t quantidade = sub_args ? (uint16_t)atoi(sub_args) : 10u;
+    if (quantidade == 0u || quantidade > 20u) {
+        quantidade = 20u;
+    }
+
+    CLI_Puts("Numero   Data     Hora     Grao  Umidade   Peso(g)  Ciclo(ms)\r\n");
+    for (uint16_t i = 0; i < quantidade; i++) {
+        Lote_Registro_t reg;
+        if (!Lote_Get_Registro(i, &reg)) {
+            break;
+        }
+        CLI_Printf("%6lu   %02u/%02u/%02u %02u:%02u:%02u %4u  %7.2f  %8.1f  %9u\r\n",
+                   (unsigned long)reg.numero_amostra, reg.dia, reg.mes, reg.ano,
+                   reg.hora, reg.minuto, reg.segundo, reg.indice_grao,
+                   reg.umidade, reg.peso, reg.duracao_ciclo_ms);
+    }
+}
@@ -14,6 +14,7 @@
 #include "cli_driver.h"
 
 #include "ux_device_cdc_acm.h"
+#include "energia.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -61,7 +62,18 @@ void CLI_Init(cli_line_callback_t line_cb) {
 }
 
 bool CLI_Is_USB_Connected(void) {
-     return (cdc_acm != NULL);
+     // Com o barramento suspenso o host no l: os produtores descartam a sada.
+     return (cdc_acm != NULL) && !Energia_Get_USB_Suspenso();
+}
+
+uint16_t CLI_Get_TX_Livre(void) {
+    const uint16_t ocupado =
+        (uint16_t)((s_cli_tx_head + CLI_TX_FIFO_SIZE - s_cli_tx_tail) % CLI_TX_FIFO_SIZE);
+    return (uint16_t)(CLI_TX_FIFO_SIZE - 1u - ocupado);
+}
+
+bool CLI_TX_Pendente(void) {
+    return s_cli_tx_head != s_cli_tx_tail;
 }
 
 void CLI_Puts(const char* str) {
@@ -88,7 +100,7 @@ void CLI_Puts(const char* str) {
 }
 
 void CLI_Printf(const char* format, ...) {
-    if (!format) {
+    if (!format || !CLI_Is_USB_Connected()) {
         return;
     }
 
@@ -0,0 +1,231 @@
+/*******************************************************************************
+ * @file        consumo.c
+ * @brief       Contabilidade de energia por subsistema e autonomia da bateria.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Modelo linear: IBAT = soma(corrente_i x atividade_i). As
+ * correntes nominais partem de medies de bancada da placa e so corrigidas
+ * por NLMS nas amostras vlidas. Como base e lgica do display esto sempre
+ * ligadas juntas no estado ativo, ficam num termo s. A parcela de cada
+ * subsistema  a prevista reescalada para somar a corrente medida.
+ ******************************************************************************/
+
+#include "consumo.h"
+#include "battery_handler.h"
+#include "bq_soc.h"
+#include "cli_driver.h"
+#include "display_handler.h"
+#include "lote_handler.h"
+#include "servo_controle.h"
+#include <string.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+typedef struct {
+    const char* nome;
+    float       nominal_mA;
+    float       (*atividade)(void);     // 0..1 no ltimo intervalo
+} Consumidor_t;
+
+static const float MS_POR_HORA      = 3600000.0f;
+static const float VBUS_PRESENTE_V  = 4.5f;         // Mesmo limiar do cone de carga
+static const float PASSO_NLMS       = 0.05f;
+static const float LIMITE_NOMINAL   = 4.0f;         // Corrente aprendida <= 4x a nominal
+static const float JANELA_MEDIA_MS  = 300000.0f;    // Mdia da autonomia: ~5 min
+static const float DESCARGA_MIN_MA  = 0.5f;
+
+//==============================================================================
+// Atividade dos Subsistemas
+//==============================================================================
+
+static float Atividade_Base(void)
+{
+    return 1.0f;
+}
+
+static float Atividade_Backlight(void)
+{
+    return (float)Display_Get_Backlight() / 100.0f;
+}
+
+static float Atividade_Servos(void)
+{
+    const ServoStep_t passo = Servos_Get_Step();
+    return (passo != SERVO_STEP_IDLE && passo != SERVO_STEP_FINISHED) ? 1.0f : 0.0f;
+}
+
+static float Atividade_Usb(void)
+{
+    return CLI_Is_USB_Connected() ? 1.0f : 0.0f;
+}
+
+static float Atividade_Medicao(void)
+{
+    return (Lote_Is_Ativo() || Display_Medicao_Em_Andamento()) ? 1.0f : 0.0f;
+}
+
+static const Consumidor_t s_consumidores[NUM_CONSUMIDORES] = {
+    [CONSUMO_BASE]      = {"BASE",      15.0f,  Atividade_Base},
+    [CONSUMO_BACKLIGHT] = {"BACKLIGHT", 45.0f,  Atividade_Backlight},
+    [CONSUMO_SERVOS]    = {"SERVOS",    180.0f, Atividade_Servos},
+    [CONSUMO_USB]       = {"USB",       3.0f,   Atividade_Usb},
+    [CONSUMO_MEDICAO]   = {"MEDICAO",   10.0f,  Atividade_Medicao},
+};
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static Consumo_Subsistema_Info_t s_info[NUM_CONSUMIDORES];
+static Consumo_Relatorio_t s_rel;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Ajustar_Modelo(const float atividade[], float medida_mA, float prevista_mA);
+static uint32_t Calcular_Autonomia_min(void);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Consumo_Init(void)
+{
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        s_info[i].corrente_mA = s_consumidores[i].nominal_mA;
+    }
+    Consumo_Zerar();
+}
+
+void Consumo_Amostrar(uint32_t intervalo_ms)
+{
+    if (!CONSUMO_HABILITADO) return;
+
+    float atividade[NUM_CONSUMIDORES];
+    float prevista_mA = 0.0f;
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        atividade[i] = s_consumidores[i].atividade();
+        s_info[i].atividade = atividade[i];
+        prevista_mA += s_info[i].corrente_mA * atividade[i];
+    }
+
+    // Com VBUS o sistema  alimentado pelo carregador e a IBAT  a de carga.
+    s_rel.em_descarga = (bq_soc_get_last_vbus() <= VBUS_PRESENTE_V);
+    if (!s_rel.em_descarga)
+    {
+        s_rel.autonomia_min = CONSUMO_AUTONOMIA_INDEFINIDA;
+        return;
+    }
+
+    // Descarga  IBAT negativa; a zona morta do bq_soc devolve 0 abaixo de 8 mA.
+    const float ibat_A = bq_soc_get_last_ibat();
+    const bool valida = (ibat_A < 0.0f);
+    const float medida_mA = valida ? -ibat_A * 1000.0f : prevista_mA;
+
+    if (valida)
+    {
+        Ajustar_Modelo(atividade, medida_mA, prevista_mA);
+        s_rel.amostras_validas++;
+    }
+    s_rel.amostras++;
+
+    // A primeira amostra semeia as mdias; depois, janela de ~5 min.
+    float alfa = (float)intervalo_ms / JANELA_MEDIA_MS;
+    if (alfa > 1.0f || s_rel.amostras == 1u) alfa = 1.0f;
+
+    // Reparte a medida na proporo do modelo j ajustado.
+    float ajustada_mA = 0.0f;
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        ajustada_mA += s_info[i].corrente_mA * atividade[i];
+    }
+    const float escala = (ajustada_mA > 0.0f) ? medida_mA / ajustada_mA : 0.0f;
+    const float horas = (float)intervalo_ms / MS_POR_HORA;
+
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        const float parcela_mA = s_info[i].corrente_mA * atividade[i] * escala;
+        s_info[i].media_mA += alfa * (parcela_mA - s_info[i].media_mA);
+        s_info[i].carga_mAh += parcela_mA * horas;
+    }
+    s_rel.media_medida_mA += alfa * (medida_mA - s_rel.media_medida_mA);
+    s_rel.media_prevista_mA += alfa * (prevista_mA - s_rel.media_prevista_mA);
+    s_rel.autonomia_min = Calcular_Autonomia_min();
+}
+
+void Consumo_Contabilizar_Sono(uint32_t intervalo_ms, float corrente_piso_A)
+{
+    if (!CONSUMO_HABILITADO) return;
+
+    s_rel.carga_sono_mAh += corrente_piso_A * 1000.0f * ((float)intervalo_ms / MS_POR_HORA);
+}
+
+void Consumo_Get_Relatorio(Consumo_Relatorio_t* relatorio_out)
+{
+    if (relatorio_out != NULL) *relatorio_out = s_rel;
+}
+
+void Consumo_Get_Subsistema(Consumo_Subsistema_t subsistema, Consumo_Subsistema_Info_t* info_out)
+{
+    if (info_out == NULL || subsistema >= NUM_CONSUMIDORES) return;
+    *info_out = s_info[subsistema];
+}
+
+const char* Consumo_Get_Nome(Consumo_Subsistema_t subsistema)
+{
+    return (subsistema < NUM_CONSUMIDORES) ? s_consumidores[subsistema].nome : "?";
+}
+
+void Consumo_Zerar(void)
+{
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        s_info[i].media_mA = 0.0f;
+        s_info[i].carga_mAh = 0.0f;
+    }
+    memset(&s_rel, 0, sizeof(s_rel));
+    s_rel.autonomia_min = CONSUMO_AUTONOMIA_INDEFINIDA;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Passo NLMS: distribui o erro entre os subsistemas ativos na
+ * proporo da atividade, limitando cada corrente a [0, 4x nominal].
+ */
+static void Ajustar_Modelo(const float atividade[], float medida_mA, float prevista_mA)
+{
+    const float erro_mA = medida_mA - prevista_mA;
+    float norma = 0.0f;
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        norma += atividade[i] * atividade[i];
+    }
+
+    for (uint8_t i = 0; i < NUM_CONSUMIDORES; i++)
+    {
+        float corrente = s_info[i].corrente_mA + PASSO_NLMS * erro_mA * atividade[i] / norma;
+        const float limite = s_consumidores[i].nominal_mA * LIMITE_NOMINAL;
+        if (corrente < 0.0f) corrente = 0.0f;
+        if (corrente > limite) corrente = limite;
+        s_info[i].corrente_mA = corrente;
+    }
+
+    const float erro_abs = (erro_mA < 0.0f) ? -erro_mA : erro_mA;
+    s_rel.erro_medio_mA += PASSO_NLMS * (erro_abs - s_rel.erro_medio_mA);
+}
+
+static uint32_t Calcular_Autonomia_min(void)
+{
+    if (s_rel.media_medida_mA < DESCARGA_MIN_MA) return CONSUMO_AUTONOMIA_INDEFINIDA;
+
+    const float restante_mAh = bq_soc_get_percentage() / 100.0f * (float)BATTERY_CAPACITY_MAH;
+    return (uint32_t)(restante_mAh / s_rel.media_medida_mA * 60.0f);
+}
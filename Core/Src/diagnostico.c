@@ -0,0 +1,465 @@
+/*******************************************************************************
+ * @file        diagnostico.c
+ * @brief       Autodiagnstico no bloqueante, executado em passos.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O executor roda a cada DIAG_PERIODO_MS. Um passo termina
+ * quando a verificao deixa de estar pendente e a tela do passo j ficou
+ * visvel pelo tempo mnimo (s na execuo fria). Verificao pendente
+ * alm de timeout_ms conta como falha. Falha em passo crtico mostra a
+ * tela de erro e interrompe a execuo; as demais so s registradas.
+ ******************************************************************************/
+
+#include "diagnostico.h"
+#include "main.h"
+#include "rtc.h"
+#include "tim.h"
+#include "temporizador.h"
+#include "controller.h"
+#include "dwin_driver.h"
+#include "eeprom_driver.h"
+#include "ads1232_driver.h"
+#include "rtc_driver.h"
+#include "temp_sensor.h"
+#include "medicao_handler.h"
+#include "battery_handler.h"
+#include "gerenciador_configuracoes.h"
+#include "boot.h"
+#include "corrotina.h"
+#include <stdio.h>
+#include <string.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+#define DIAG_SEM_TELA           0xFFFFu     // Passo sem tela prpria
+
+typedef struct {
+    const char*      descricao;             // Para o log do console
+    uint16_t         tela;                  // Tela DWIN da execuo fria (ou DIAG_SEM_TELA)
+    uint16_t         tempo_tela_ms;         // Tempo mnimo de exibio da tela
+    uint16_t         timeout_ms;            // Limite para a verificao sair de PENDENTE
+    bool             critico;               // Falha interrompe o diagnstico
+    bool             repetir_ao_acordar;    // Refaz mesmo aprovado (depende do tempo dormido)
+    void             (*iniciar)(void);      // Opcional; dispara o teste
+    Diag_Resultado_t (*verificar)(void);    // Chamado a cada perodo at sair de PENDENTE
+} Diag_Passo_t;
+
+static const uint32_t DIAG_PERIODO_MS = 20;
+
+// --- Limites de plausibilidade ---
+static const float    FREQ_MIN_HZ        = 100000.0f;
+static const float    FREQ_MAX_HZ        = 3000000.0f;
+static const int32_t  ADS_OFFSET_MAX     = 0x7F0000;   // Perto do fundo de escala (24 bits)
+static const uint16_t VDDA_MIN_MV        = 2700;
+static const uint16_t VDDA_MAX_MV        = 3600;
+static const float    TEMP_MCU_MIN_C     = -20.0f;
+static const float    TEMP_MCU_MAX_C     = 85.0f;
+static const uint32_t OSC_JANELA_MS      = 1000;       // Janela de comparao HSI x LSI
+static const uint32_t OSC_TOLERANCIA_PPM = 80000;      // LSI: tolerncia larga de fbrica
+static const uint16_t SERVO_PULSO_MAX_US = 2500;
+
+//==============================================================================
+// Prottipos das Verificaes
+//==============================================================================
+
+static void             Iniciar_DisplayInfo(void);
+static Diag_Resultado_t Verificar_DisplayInfo(void);
+static Diag_Resultado_t Verificar_Servos(void);
+static void             Iniciar_Capacimetro(void);
+static Diag_Resultado_t Verificar_Capacimetro(void);
+static void             Iniciar_Balanca(void);
+static Cr_Estado_t      Balanca_Corrotina(Corrotina_t* cr);
+static Diag_Resultado_t Verificar_Balanca(void);
+static Diag_Resultado_t Verificar_Termometro(void);
+static Diag_Resultado_t Verificar_EEPROM(void);
+static void             Iniciar_Config_CRC(void);
+static Diag_Resultado_t Verificar_Config_CRC(void);
+static Diag_Resultado_t Verificar_RTC(void);
+static void             Iniciar_Osciladores(void);
+static Diag_Resultado_t Verificar_Osciladores(void);
+static Diag_Resultado_t Verificar_Carregador(void);
+
+//==============================================================================
+// Tabela de Passos
+//==============================================================================
+
+static const Diag_Passo_t s_passos[] = {
+    // descricao                    tela               tela_ms timeout crit.  acordar iniciar               verificar
+    {"Logo e Versoes",              LOGO,              3000,   500,    false, false,  Iniciar_DisplayInfo,  Verificar_DisplayInfo},
+    {"Servos",                      BOOT_CHECK_SERVOS, 1200,   100,    false, false,  NULL,                 Verificar_Servos},
+    {"Medidor Freq",                BOOT_CHECK_CAPACI, 1200,   1500,   false, false,  Iniciar_Capacimetro,  Verificar_Capacimetro},
+    {"Balanca",                     BOOT_BALANCE,      1000,   12000,  false, false,  Iniciar_Balanca,      Verificar_Balanca},
+    {"Termometro",                  BOOT_THERMOMETER,  1000,   500,    false, true,   NULL,                 Verificar_Termometro},
+    {"Memoria EEPROM",              BOOT_MEMORY,       1100,   300,    true,  false,  NULL,                 Verificar_EEPROM},
+    {"CRC da Configuracao",         DIAG_SEM_TELA,     0,      2000,   false, false,  Iniciar_Config_CRC,   Verificar_Config_CRC},
+    {"RTC",                         BOOT_CLOCK,        1100,   100,    false, true,   NULL,                 Verificar_RTC},
+    {"Osciladores (HSI x LSI)",     DIAG_SEM_TELA,     0,      1500,   false, true,   Iniciar_Osciladores,  Verificar_Osciladores},
+    {"Carregador BQ25622",          DIAG_SEM_TELA,     0,      100,    false, false,  NULL,                 Verificar_Carregador},
+};
+#define NUM_PASSOS  (sizeof(s_passos) / sizeof(s_passos[0]))
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static Temporizador_Id_t s_temporizador;
+static bool     s_ativo = false;
+static bool     s_quente = false;
+static bool     s_aprovado_geral = false;
+static uint16_t s_tela_retorno = 0;
+static uint8_t  s_passo = 0;
+static uint32_t s_inicio_passo = 0;
+static Diag_Resultado_t s_resultado = DIAG_PENDENTE;
+static bool     s_aprovado[NUM_PASSOS];                 // Cache entre execues
+
+// Estado das verificaes com mais de uma etapa
+static uint32_t s_ref_contador = 0;
+static Corrotina_t s_cr_passo;
+static uint32_t s_osc_tick_inicio = 0;
+static uint32_t s_osc_rtc_inicio_ms = 0;
+
+//==============================================================================
+// Prottipos do Executor
+//==============================================================================
+
+static void Diagnostico_Executar(void);
+static void Iniciar_Passo(uint8_t indice);
+static void Concluir(bool aprovado);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Diagnostico_Init(void)
+{
+    s_temporizador = Temporizador_Criar(Diagnostico_Executar, true);
+    memset(s_aprovado, 0, sizeof(s_aprovado));
+}
+
+bool Diagnostico_Iniciar(uint16_t tela_retorno, bool quente)
+{
+    if (s_ativo) return false;
+
+    s_ativo = true;
+    s_quente = quente;
+    s_aprovado_geral = true;
+    s_tela_retorno = tela_retorno;
+    printf("\r\n>>> INICIANDO AUTODIAGNOSTICO%s <<<\r\n", quente ? " (RAPIDO)" : "");
+
+    Temporizador_Iniciar(s_temporizador, DIAG_PERIODO_MS);
+    Iniciar_Passo(0);
+    return true;
+}
+
+bool Diagnostico_Em_Andamento(void) { return s_ativo; }
+
+bool Diagnostico_Aprovado(void) { return s_aprovado_geral; }
+
+//==============================================================================
+// Executor
+//==============================================================================
+
+/**
+ * @brief Comea o passo 'indice' ou o prximo que precise rodar.
+ * Na execuo quente pula os passos aprovados que no dependem do sono.
+ */
+static void Iniciar_Passo(uint8_t indice)
+{
+    while (indice < NUM_PASSOS && s_quente && s_aprovado[indice] && !s_passos[indice].repetir_ao_acordar)
+    {
+        indice++;
+    }
+
+    if (indice >= NUM_PASSOS)
+    {
+        Concluir(true);
+        return;
+    }
+
+    const Diag_Passo_t* passo = &s_passos[indice];
+    s_passo = indice;
+    s_inicio_passo = HAL_GetTick();
+    s_resultado = DIAG_PENDENTE;
+
+    if (!s_quente && passo->tela != DIAG_SEM_TELA)
+    {
+        Controller_SetScreen(passo->tela);
+    }
+    if (passo->iniciar != NULL)
+    {
+        passo->iniciar();
+    }
+}
+
+/**
+ * @brief Callback do temporizador: avana o passo atual, nunca espera.
+ */
+static void Diagnostico_Executar(void)
+{
+    if (!s_ativo) return;
+
+    const Diag_Passo_t* passo = &s_passos[s_passo];
+    uint32_t decorrido = HAL_GetTick() - s_inicio_passo;
+
+    if (s_resultado == DIAG_PENDENTE)
+    {
+        s_resultado = passo->verificar();
+        if (s_resultado == DIAG_PENDENTE)
+        {
+            if (decorrido < passo->timeout_ms) return;
+            printf("Diagnostico: %s - TIMEOUT\r\n", passo->descricao);
+            s_resultado = DIAG_FALHA;
+        }
+    }
+
+    // A tela do passo fica visvel pelo tempo mnimo na execuo fria.
+    if (!s_quente && passo->tela != DIAG_SEM_TELA && decorrido < passo->tempo_tela_ms) return;
+
+    s_aprovado[s_passo] = (s_resultado == DIAG_OK);
+    printf("Diagnostico: %s - %s\r\n", passo->descricao, (s_resultado == DIAG_OK) ? "OK" : "FALHA");
+
+    if (s_resultado != DIAG_OK)
+    {
+        s_aprovado_geral = s_aprovado_geral && !passo->critico;
+        if (passo->critico)
+        {
+            Controller_SetScreen(MSG_ERROR);
+            Concluir(false);
+            return;
+        }
+    }
+
+    Iniciar_Passo((uint8_t)(s_passo + 1));
+}
+
+static void Concluir(bool completo)
+{
+    Temporizador_Parar(s_temporizador);
+    s_ativo = false;
+
+    if (!completo)
+    {
+        printf(">>> AUTODIAGNOSTICO FALHOU! <<<\r\n");
+        return;
+    }
+
+    printf(">>> AUTODIAGNOSTICO COMPLETO <<<\r\n\r\n");
+    if (!s_quente)
+    {
+        Controller_SetScreen(s_tela_retorno);
+        Boot_Marcar(BOOT_FASE_TELA_PRINCIPAL);
+    }
+    Boot_Marcar(BOOT_FASE_DIAGNOSTICO);
+}
+
+//==============================================================================
+// Verificaes
+//==============================================================================
+
+/** @brief Envia as verses para o display; conclui quando a fila de TX esvazia. */
+static void Iniciar_DisplayInfo(void)
+{
+    char nr_serial_buffer[17];
+    Gerenciador_Config_Get_Serial(nr_serial_buffer, sizeof(nr_serial_buffer));
+
+    DWIN_Driver_WriteString(VP_HARDWARE, HARDWARE, strlen(HARDWARE));
+    DWIN_Driver_WriteString(VP_FIRMWARE, FIRMWARE, strlen(FIRMWARE));
+    DWIN_Driver_WriteString(VP_FIRM_IHM, FIRM_IHM, strlen(FIRM_IHM));
+    DWIN_Driver_WriteString(VP_SERIAL, nr_serial_buffer, strlen(nr_serial_buffer));
+}
+
+static Diag_Resultado_t Verificar_DisplayInfo(void)
+{
+    return DWIN_Driver_IsTxBusy() ? DIAG_PENDENTE : DIAG_OK;
+}
+
+/** @brief PWM dos dois servos ligado (timer e canal) e pulso dentro da faixa. */
+static bool Servo_PWM_Ativo(const TIM_TypeDef* tim)
+{
+    return ((tim->CR1 & TIM_CR1_CEN) != 0u) &&
+           ((tim->CCER & TIM_CCER_CC1E) != 0u) &&
+           (tim->CCR1 <= SERVO_PULSO_MAX_US);
+}
+
+static Diag_Resultado_t Verificar_Servos(void)
+{
+    return (Servo_PWM_Ativo(htim16.Instance) && Servo_PWM_Ativo(htim17.Instance)) ? DIAG_OK : DIAG_FALHA;
+}
+
+/** @brief Espera uma integrao nova e confere se a frequncia  plausvel. */
+static void Iniciar_Capacimetro(void)
+{
+    s_ref_contador = Medicao_Get_Contador_Frequencia();
+}
+
+static Diag_Resultado_t Verificar_Capacimetro(void)
+{
+    if (Medicao_Get_Contador_Frequencia() == s_ref_contador) return DIAG_PENDENTE;
+
+    DadosMedicao_t medicao;
+    Medicao_Get_UltimaMedicao(&medicao);
+    if (medicao.Frequencia < FREQ_MIN_HZ || medicao.Frequencia > FREQ_MAX_HZ)
+    {
+        printf("FREQ: %.0f Hz fora da faixa.\r\n", medicao.Frequencia);
+        return DIAG_FALHA;
+    }
+    return DIAG_OK;
+}
+
+/**
+ * @brief Tara a balana e confere se o ADS1232 continua entregando amostras
+ * (DRDY vivo) com um offset longe do fundo de escala.
+ */
+static void Iniciar_Balanca(void)
+{
+    ADS1232_Tare_Iniciar();
+    CR_INICIALIZAR(&s_cr_passo);
+}
+
+static Cr_Estado_t Balanca_Corrotina(Corrotina_t* cr)
+{
+    CR_INICIO(cr);
+    CR_AGUARDAR_ATE(cr, ADS1232_Tare_Passo() == CR_TERMINOU);
+    s_ref_contador = Medicao_Get_Contador_Peso();
+    CR_AGUARDAR_ATE(cr, Medicao_Get_Contador_Peso() != s_ref_contador);
+    CR_FIM(cr);
+}
+
+static Diag_Resultado_t Verificar_Balanca(void)
+{
+    if (Balanca_Corrotina(&s_cr_passo) == CR_ESPERANDO) return DIAG_PENDENTE;
+
+    int32_t offset = ADS1232_GetOffset();
+    if (offset > ADS_OFFSET_MAX || offset < -ADS_OFFSET_MAX)
+    {
+        printf("BALANCA: Offset %ld saturado.\r\n", (long)offset);
+        return DIAG_FALHA;
+    }
+    return DIAG_OK;
+}
+
+/** @brief VDDA e temperatura do MCU plausveis; registra a temperatura inicial. */
+static Diag_Resultado_t Verificar_Termometro(void)
+{
+    TempSensor_Process();
+    uint16_t vdda_mv = TempSensor_Get_VDDA_mV();
+    if (vdda_mv == 0) return DIAG_PENDENTE;    // Primeira sequncia do ADC ainda no concluda
+
+    float temp_mcu = TempSensor_GetTemperature();
+    Medicao_Set_Temp_Instru(temp_mcu);
+
+    if (!TempSensor_Temp_Amostra_Valida())
+    {
+        printf("TEMP: Termistor da amostra fora da faixa (aberto/curto?).\r\n");
+    }
+
+    if (vdda_mv < VDDA_MIN_MV || vdda_mv > VDDA_MAX_MV ||
+        temp_mcu < TEMP_MCU_MIN_C || temp_mcu > TEMP_MCU_MAX_C)
+    {
+        printf("TEMP: VDDA %u mV / MCU %.1f C fora da faixa.\r\n", vdda_mv, temp_mcu);
+        return DIAG_FALHA;
+    }
+    return DIAG_OK;
+}
+
+/** @brief EEPROM responde no barramento I2C. */
+static Diag_Resultado_t Verificar_EEPROM(void)
+{
+    return EEPROM_Driver_IsReady() ? DIAG_OK : DIAG_FALHA;
+}
+
+/**
+ * @brief Rel a cpia primria da configurao em blocos e confere o CRC.
+ * Em caso de falha a configurao  marcada como pendente, e o salvamento
+ * regrava a cpia primria a partir do cache (que veio de uma cpia vlida).
+ */
+static void Iniciar_Config_CRC(void)
+{
+    Gerenciador_Config_Verificacao_Iniciar();
+}
+
+static Diag_Resultado_t Verificar_Config_CRC(void)
+{
+    switch (Gerenciador_Config_Verificacao_Passo())
+    {
+        case CFG_VERIF_EM_ANDAMENTO: return DIAG_PENDENTE;
+        case CFG_VERIF_OK:           return DIAG_OK;
+        default:
+            printf("EEPROM: CRC da copia primaria invalido, regravando.\r\n");
+            Gerenciador_Config_Marcar_Como_Pendente();
+            return DIAG_FALHA;
+    }
+}
+
+/** @brief Calendrio inicializado e data/hora dentro das faixas vlidas. */
+static Diag_Resultado_t Verificar_RTC(void)
+{
+    if (!__HAL_RTC_IS_CALENDAR_INITIALIZED(&hrtc)) return DIAG_FALHA;
+
+    uint8_t dia, mes, ano, horas, minutos, segundos;
+    char dia_semana[4];
+    if (!RTC_Driver_GetTime(&horas, &minutos, &segundos) ||
+        !RTC_Driver_GetDate(&dia, &mes, &ano, dia_semana))
+    {
+        return DIAG_FALHA;
+    }
+
+    bool valido = (dia >= 1 && dia <= 31) && (mes >= 1 && mes <= 12) && (ano <= 99) &&
+                  (horas < 24) && (minutos < 60) && (segundos < 60);
+    return valido ? DIAG_OK : DIAG_FALHA;
+}
+
+/**
+ * @brief L o RTC em ms do dia (inclui os sub-segundos, que contam para baixo).
+ */
+static uint32_t RTC_Get_ms_Do_Dia(void)
+{
+    RTC_TimeTypeDef hora = {0};
+    RTC_DateTypeDef data = {0};
+    HAL_RTC_GetTime(&hrtc, &hora, RTC_FORMAT_BIN);
+    HAL_RTC_GetDate(&hrtc, &data, RTC_FORMAT_BIN);    // Destrava os registradores sombra
+
+    uint32_t segundos = (uint32_t)hora.Hours * 3600u + (uint32_t)hora.Minutes * 60u + hora.Seconds;
+    uint32_t fracao_ms = ((hora.SecondFraction - hora.SubSeconds) * 1000u) / (hora.SecondFraction + 1u);
+    return segundos * 1000u + fracao_ms;
+}
+
+/**
+ * @brief Compara o tick do sistema (HSI) com o RTC (LSI) numa janela de
+ * OSC_JANELA_MS. Um oscilador parado ou muito fora de frequncia aparece
+ * como diferena acima da tolerncia.
+ */
+static void Iniciar_Osciladores(void)
+{
+    s_osc_tick_inicio = HAL_GetTick();
+    s_osc_rtc_inicio_ms = RTC_Get_ms_Do_Dia();
+}
+
+static Diag_Resultado_t Verificar_Osciladores(void)
+{
+    uint32_t tick_ms = HAL_GetTick() - s_osc_tick_inicio;
+    if (tick_ms < OSC_JANELA_MS) return DIAG_PENDENTE;
+
+    uint32_t rtc_fim_ms = RTC_Get_ms_Do_Dia();
+    uint32_t rtc_ms = (rtc_fim_ms >= s_osc_rtc_inicio_ms)
+                    ? (rtc_fim_ms - s_osc_rtc_inicio_ms)
+                    : (rtc_fim_ms + 86400000u - s_osc_rtc_inicio_ms);  // Virada do dia
+    if (rtc_ms == 0) return DIAG_FALHA;
+
+    uint32_t diferenca = (tick_ms > rtc_ms) ? (tick_ms - rtc_ms) : (rtc_ms - tick_ms);
+    uint32_t erro_ppm = (uint32_t)(((uint64_t)diferenca * 1000000u) / rtc_ms);
+    if (erro_ppm > OSC_TOLERANCIA_PPM)
+    {
+        printf("OSC: tick %lu ms x RTC %lu ms.\r\n", (unsigned long)tick_ms, (unsigned long)rtc_ms);
+        return DIAG_FALHA;
+    }
+    return DIAG_OK;
+}
+
+/** @brief O BQ25622 responde com o ID esperado. */
+static Diag_Resultado_t Verificar_Carregador(void)
+{
+    return Battery_Handler_Verificar_Carregador() ? DIAG_OK : DIAG_FALHA;
+}
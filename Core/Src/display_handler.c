@@ -8,6 +8,10 @@
 
 #include "display_handler.h"
 #include "dwin_parser.h" 
+#include "servo_controle.h"
+#include "lote_handler.h"
+#include "temporizador.h"
+#include "eventos.h"
 
 //================================================================================
 // Definies, Enums e Variveis Estticas
@@ -30,27 +34,33 @@ typedef enum {
 
 static MedeState_t s_mede_state = MEDE_STATE_IDLE;
 static uint32_t s_mede_last_tick = 0;
-static const uint32_t MEDE_INTERVAL_MS = 1000;
+static const uint32_t MEDE_INTERVAL_MS = 1000;         // Resultado fora do lote
+static const uint32_t MEDE_TELA_MIN_MS = 300;          // Peso e temperatura: leituras j prontas
+static const uint32_t MEDE_UMIDADE_TIMEOUT_MS = 2000;  // Integrao no publicou (limite  1 s)
+static const uint32_t MEDE_RESULTADO_LOTE_MS = 3000; // Resultado visvel enquanto a prxima amostra enche
+static uint32_t s_contador_freq_amostra = 0;           // Integraes publicadas antes da amostra
 
 // --- FSM de Atualizao do Monitor ---
-static uint32_t s_monitor_last_tick = 0;
 static const uint32_t MONITOR_UPDATE_INTERVAL_MS = 1000;
 static uint8_t s_temp_update_counter = 0;
 static const uint8_t TEMP_UPDATE_PERIOD_SECONDS = 5;
 
 // --- Atualizao do Relgio ---
-static uint32_t s_clock_last_tick = 0;
 static const uint32_t CLOCK_UPDATE_INTERVAL_MS = 1000;
 
 // --- Estado do Mdulo ---
 static bool s_printing_enabled = true;
+static uint8_t s_backlight_pct = 100;
 
 //================================================================================
 // Prottipos de Funes Privadas
 //================================================================================
 static void UpdateMonitorScreen(void);
 static void UpdateClockOnMainScreen(void);
+static void AtualizarIconeBateria(const Evento_t* evento);
 static void ProcessMeasurementSequenceFSM(void);
+static void AcompanharSequenciaServos(void);
+static void MudarEstadoMedicao(MedeState_t novo_estado);
 
 
 //================================================================================
@@ -60,23 +70,31 @@ static void ProcessMeasurementSequenceFSM(void);
 void DisplayHandler_Init(void) {
     s_mede_state = MEDE_STATE_IDLE;
     s_printing_enabled = true;
+
+    // Monitor e relgio so peridicos: rodam pelo temporizador, no por polling.
+    Temporizador_Iniciar(Temporizador_Criar(UpdateMonitorScreen, true), MONITOR_UPDATE_INTERVAL_MS);
+    Temporizador_Iniciar(Temporizador_Criar(UpdateClockOnMainScreen, true), CLOCK_UPDATE_INTERVAL_MS);
+
+    Eventos_Assinar(EVT_BATERIA_ALTERADA, AtualizarIconeBateria);
 }
 
 void DisplayHandler_Process(void) {
 
 	ProcessMeasurementSequenceFSM();
-	UpdateMonitorScreen();
-	UpdateClockOnMainScreen();
 }
 
 
-void Display_StartMeasurementSequence(void) {
-    if (s_mede_state == MEDE_STATE_IDLE) {
-        printf("DISPLAY: Iniciando sequencia de medicao...\r\n");
-        s_mede_state = MEDE_STATE_ENCHE_CAMARA;
-        s_mede_last_tick = HAL_GetTick();
-        Controller_SetScreen(MEDE_ENCHE_CAMARA);
+bool Display_StartMeasurementSequence(void) {
+    if (s_mede_state != MEDE_STATE_IDLE) {
+        return false;
     }
+    printf("DISPLAY: Iniciando sequencia de medicao...\r\n");
+    s_mede_state = MEDE_STATE_ENCHE_CAMARA;
+    s_mede_last_tick = HAL_GetTick();
+    Controller_SetScreen(MEDE_ENCHE_CAMARA);
+    Lote_Sequencia_Iniciada();
+    Servos_Start_Sequence();
+    return true;
 }
 
 void Display_OFF(uint16_t received_value)
@@ -85,11 +103,13 @@ void Display_OFF(uint16_t received_value)
 	{
 		Controller_SetScreen(SYSTEM_STANDBY);
 		DWIN_Driver_WriteRawBytes(CMD_AJUSTAR_BACKLIGHT_10, sizeof(CMD_AJUSTAR_BACKLIGHT_10));
+		s_backlight_pct = 10;
 	}
 	else
 	{
 		Controller_SetScreen(PRINCIPAL);
 		DWIN_Driver_WriteRawBytes(CMD_AJUSTAR_BACKLIGHT_100, sizeof(CMD_AJUSTAR_BACKLIGHT_100));
+		s_backlight_pct = 100;
 	}
 }
 
@@ -206,6 +226,7 @@ void Display_SetCompany(const uint8_t* dwin_data, uint16_t len, uint16_t receive
 
 void Display_Adj_Capa(uint16_t received_value)
 {
+    (void)received_value;
     DWIN_Driver_WriteString(VP_MESSAGES, "AdjustFrequency: 3000.0KHz+/-2.0", strlen("AdjustFrequency: 3000.0KHz+/-2.0"));
     Controller_SetScreen(TELA_ADJUST_CAPA);
 }
@@ -274,6 +295,14 @@ bool Display_IsPrintingEnabled(void) {
     return s_printing_enabled;
 }
 
+uint8_t Display_Get_Backlight(void) {
+    return s_backlight_pct;
+}
+
+bool Display_Medicao_Em_Andamento(void) {
+    return s_mede_state != MEDE_STATE_IDLE;
+}
+
 
 /**
  * @brief Mquina de estados NO-BLOQUEANTE para a sequncia de medio.
@@ -284,38 +313,57 @@ static void ProcessMeasurementSequenceFSM(void) {
         return;
     }
 
-    if (HAL_GetTick() - s_mede_last_tick < MEDE_INTERVAL_MS) {
+    // Enchimento e raspagem avanam pelo peso (servo_controle), no pelo relgio.
+    if (s_mede_state == MEDE_STATE_ENCHE_CAMARA ||
+        s_mede_state == MEDE_STATE_AJUSTANDO ||
+        s_mede_state == MEDE_STATE_RASPA_CAMARA) {
+        AcompanharSequenciaServos();
         return;
     }
+
+    const uint32_t decorrido = HAL_GetTick() - s_mede_last_tick;
+    if (s_mede_state == MEDE_STATE_UMIDADE) {
+        // A umidade sai quando a integrao iniciada com a amostra no lugar
+        // termina: o fim antecipado pela Escala A encurta a medio.
+        if (Medicao_Get_Contador_Frequencia() == s_contador_freq_amostra &&
+            decorrido < MEDE_UMIDADE_TIMEOUT_MS) {
+            return;
+        }
+    } else {
+        uint32_t intervalo = (s_mede_state == MEDE_STATE_MOSTRA_RESULTADO)
+                             ? (Lote_Is_Ativo() ? MEDE_RESULTADO_LOTE_MS : MEDE_INTERVAL_MS)
+                             : MEDE_TELA_MIN_MS;
+        if (decorrido < intervalo) {
+            return;
+        }
+    }
     s_mede_last_tick = HAL_GetTick();
 
     switch (s_mede_state) {
-        case MEDE_STATE_ENCHE_CAMARA:
-            s_mede_state = MEDE_STATE_AJUSTANDO;
-            Controller_SetScreen(MEDE_AJUSTANDO);
-            break;
-        case MEDE_STATE_AJUSTANDO:
-            s_mede_state = MEDE_STATE_RASPA_CAMARA;
-            Controller_SetScreen(MEDE_RASPA_CAMARA);
-            break;
-        case MEDE_STATE_RASPA_CAMARA:
-            s_mede_state = MEDE_STATE_PESO_AMOSTRA;
-            Controller_SetScreen(MEDE_PESO_AMOSTRA);
-            break;
         case MEDE_STATE_PESO_AMOSTRA:
-            s_mede_state = MEDE_STATE_TEMP_SAMPLE;
+            MudarEstadoMedicao(MEDE_STATE_TEMP_SAMPLE);
             Controller_SetScreen(MEDE_TEMP_SAMPLE);
             break;
         case MEDE_STATE_TEMP_SAMPLE:
-            s_mede_state = MEDE_STATE_UMIDADE;
+            MudarEstadoMedicao(MEDE_STATE_UMIDADE);
             Controller_SetScreen(MEDE_UMIDADE);
             break;
         case MEDE_STATE_UMIDADE:
-            s_mede_state = MEDE_STATE_MOSTRA_RESULTADO;
+            MudarEstadoMedicao(MEDE_STATE_MOSTRA_RESULTADO);
+            Lote_Amostra_Concluida();
             Display_ProcessPrintEvent(0x0000); // 0x0000 para "mostrar resultado na tela"
+            if (Lote_Is_Ativo()) {
+                // Prepara a prxima amostra enquanto o resultado est na tela.
+                Servos_Start_Sequence();
+            }
             break;
         case MEDE_STATE_MOSTRA_RESULTADO:
-            s_mede_state = MEDE_STATE_IDLE;
+            if (Lote_Is_Ativo()) {
+                MudarEstadoMedicao(MEDE_STATE_ENCHE_CAMARA);
+                Controller_SetScreen(MEDE_ENCHE_CAMARA);
+                break;
+            }
+            MudarEstadoMedicao(MEDE_STATE_IDLE);
             printf("DISPLAY: Sequencia de medicao finalizada.\r\n");
             break;
         default:
@@ -325,15 +373,72 @@ static void ProcessMeasurementSequenceFSM(void) {
 }
 
 /**
- * @brief Lgica movida de app_manager.c (Task_Update_Display_FSM).
- * Atualiza os VPs da tela de Monitor/Ajuste a cada 1 segundo.
+ * @brief Espelha o passo dos servos nas telas de enchimento/ajuste/raspagem.
+ * Em caso de falha, informa o motivo em VP_MESSAGES e volta  tela principal.
  */
-static void UpdateMonitorScreen(void) {
-    if (HAL_GetTick() - s_monitor_last_tick < MONITOR_UPDATE_INTERVAL_MS) {
+static void AcompanharSequenciaServos(void) {
+    ServoStatus_t status = Servos_Get_Status();
+
+    if (Servos_Status_Is_Falha(status)) {
+        const char* motivo = Servos_Get_Status_Str(status);
+        printf("DISPLAY: Sequencia de medicao abortada: %s\r\n", motivo);
+        DWIN_Driver_WriteString(VP_MESSAGES, motivo, strlen(motivo));
+        s_mede_state = MEDE_STATE_IDLE;
+        Controller_SetScreen(PRINCIPAL);
+        Lote_Amostra_Falhou();
         return;
     }
-    s_monitor_last_tick = HAL_GetTick();
 
+    MedeState_t novo_estado = s_mede_state;
+    uint16_t nova_tela = 0;
+
+    switch (Servos_Get_Step()) {
+        case SERVO_STEP_FUNNEL:
+            break;
+        case SERVO_STEP_SETTLE:
+            novo_estado = MEDE_STATE_AJUSTANDO;
+            nova_tela = MEDE_AJUSTANDO;
+            break;
+        case SERVO_STEP_SCRAPER:
+            novo_estado = MEDE_STATE_RASPA_CAMARA;
+            nova_tela = MEDE_RASPA_CAMARA;
+            break;
+        case SERVO_STEP_FINISHED:
+            novo_estado = MEDE_STATE_PESO_AMOSTRA;
+            nova_tela = MEDE_PESO_AMOSTRA;
+            if (s_mede_state != MEDE_STATE_PESO_AMOSTRA) {
+                // Amostra no lugar: a frequncia passa a ser integrada sobre ela.
+                Medicao_Reiniciar_Integracao();
+                s_contador_freq_amostra = Medicao_Get_Contador_Frequencia();
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (novo_estado != s_mede_state) {
+        MudarEstadoMedicao(novo_estado);
+        s_mede_last_tick = HAL_GetTick();
+        Controller_SetScreen(nova_tela);
+    }
+}
+
+/**
+ * @brief Troca o estado da sequncia e contabiliza o tempo da etapa que terminou.
+ */
+static void MudarEstadoMedicao(MedeState_t novo_estado) {
+    if (s_mede_state >= MEDE_STATE_ENCHE_CAMARA && s_mede_state <= MEDE_STATE_MOSTRA_RESULTADO) {
+        // As etapas do lote seguem a mesma ordem dos estados da medio.
+        Lote_Etapa_Concluida((LoteEtapa_t)(s_mede_state - MEDE_STATE_ENCHE_CAMARA));
+    }
+    s_mede_state = novo_estado;
+}
+
+/**
+ * @brief Lgica movida de app_manager.c (Task_Update_Display_FSM).
+ * Atualiza os VPs da tela de Monitor/Ajuste (temporizador de 1 segundo).
+ */
+static void UpdateMonitorScreen(void) {
     uint16_t tela_atual = Controller_GetCurrentScreen();
     if (tela_atual != TELA_MONITOR_SYSTEM && tela_atual != TELA_ADJUST_CAPA) { 
         s_temp_update_counter = 0;
@@ -361,18 +466,24 @@ static void UpdateMonitorScreen(void) {
         
         int16_t temperatura_para_dwin = (int16_t)(temp_mcu * 10.0f);
         DWIN_Driver_WriteInt(TEMP_INSTRU, temperatura_para_dwin);
+
+        int16_t temp_amostra_para_dwin = (int16_t)(dados_atuais.Temp_Amostra * 10.0f);
+        DWIN_Driver_WriteInt(TEMP_SAMPLE, temp_amostra_para_dwin);
     }
 }
 
+/**
+ * @brief Assinante de EVT_BATERIA_ALTERADA: atualiza o cone de bateria.
+ */
+static void AtualizarIconeBateria(const Evento_t* evento) {
+    DWIN_Driver_WriteInt(VP_ICON_BAT, (int16_t)evento->valor);
+}
+
 /**
  * @brief Lgica movida de app_manager.c (Task_Update_Clock).
- * Atualiza o relgio na tela principal a cada segundo.
+ * Atualiza o relgio na tela principal (temporizador de 1 segundo).
  */
 static void UpdateClockOnMainScreen(void) {
-    if (HAL_GetTick() - s_clock_last_tick < CLOCK_UPDATE_INTERVAL_MS) {
-        return;
-    }
-    s_clock_last_tick = HAL_GetTick();
 		
 		switch (Controller_GetCurrentScreen())
 		{
@@ -383,8 +494,6 @@ static void UpdateClockOnMainScreen(void) {
 				case TELA_ABOUT_SYSTEM:
 				case TELA_ADJUST_TIME:
 				{
-						char time_buf[9];
-						char date_buf[9];
 						uint8_t h, m, s, d, mo, y;
 						char weekday_dummy[4];
 						
@@ -16,6 +16,7 @@
  */
  
 #include "dwin_driver.h"
+#include "secao_critica.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -75,7 +76,8 @@ static bool DWIN_TX_Queue_Send_Bytes(const uint8_t* data, uint16_t size)
 
     // --- Incio da Seo Crtica ---
     // Garantir que o clculo de espao e a insero no FIFO no sejam interrompidos.
-    __disable_irq();
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
 
     uint16_t free_space;
     if (s_tx_fifo_head >= s_tx_fifo_tail)
@@ -89,19 +91,19 @@ static bool DWIN_TX_Queue_Send_Bytes(const uint8_t* data, uint16_t size)
 
     if (size > free_space)
     {
-        __enable_irq(); // Reabilitar as IRQs!
+        SECAO_CRITICA_SAIR(sc); // Reabilitar as IRQs!
         DWIN_LOG("ERRO: FIFO de TX cheio!\r\n");
         return false;
     }
 
-    // Copia os dados para o FIFO
-    for (uint16_t i = 0u; i < size; i++)
-    {
-        s_tx_fifo[s_tx_fifo_head] = data[i];
-        s_tx_fifo_head = (uint16_t)((s_tx_fifo_head + 1u) % DWIN_TX_FIFO_SIZE);
-    }
+    // Copia os dados para o FIFO em at dois blocos (antes e depois da volta)
+    uint16_t ate_o_fim = (uint16_t)(DWIN_TX_FIFO_SIZE - s_tx_fifo_head);
+    uint16_t primeiro = (size < ate_o_fim) ? size : ate_o_fim;
+    memcpy(&s_tx_fifo[s_tx_fifo_head], data, primeiro);
+    memcpy(&s_tx_fifo[0], &data[primeiro], (size_t)(size - primeiro));
+    s_tx_fifo_head = (uint16_t)((s_tx_fifo_head + size) % DWIN_TX_FIFO_SIZE);
 
-    __enable_irq();
+    SECAO_CRITICA_SAIR(sc);
     // --- Fim da Seo Crtica ---
 
     return true;
@@ -137,21 +139,20 @@ void DWIN_Driver_Process(void)
 
     uint8_t local_buffer[DWIN_RX_BUFFER_SIZE];
     uint16_t local_len;
-    uint32_t packet_id;
 
     // --- Incio da Seo Crtica ---
     // Copia os dados recebidos (sinalizados pela ISR) para um buffer local
     // para processamento. Isso libera o buffer de DMA rapidamente.
-    __disable_irq();
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
     
     local_len = s_received_len;
-    packet_id = s_rx_event_counter;
     memcpy(local_buffer, s_rx_dma_buffer, local_len);
     
     s_rx_pending_data = false; // Marca que processamos o pacote
     s_received_len = 0u;
     
-    __enable_irq();
+    SECAO_CRITICA_SAIR(sc);
     // --- Fim da Seo Crtica ---
 
     DWIN_Start_Listening(); // Reinicia a escuta de DMA para no perder pacote.
@@ -187,17 +188,18 @@ void DWIN_TX_Pump(void)
 {
     // --- Incio da Seo Crtica ---
     // Verificar se o DMA est ocupado E se h dados no FIFO.
-    __disable_irq();
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
     
     if (s_dma_tx_busy || (s_tx_fifo_head == s_tx_fifo_tail))
     {
-        __enable_irq(); // Ou o DMA est ocupado, ou o FIFO est vazio, retorna
+        SECAO_CRITICA_SAIR(sc); // Ou o DMA est ocupado, ou o FIFO est vazio, retorna
         return;
     }
     
     s_dma_tx_busy = true; //Tem dados + DMA livre
     
-    __enable_irq();
+    SECAO_CRITICA_SAIR(sc);
     // --- Fim da Seo Crtica ---
 
     //Prepara o buffer de DMA
@@ -223,6 +225,22 @@ bool DWIN_Driver_IsTxBusy(void)
     return (s_dma_tx_busy || (s_tx_fifo_head != s_tx_fifo_tail));
 }
 
+bool DWIN_Driver_IsRxPending(void)
+{
+    return s_rx_pending_data;
+}
+
+bool DWIN_Driver_IsRxBusy(void)
+{
+    if (s_huart == NULL || s_huart->hdmarx == NULL)
+    {
+        return false;
+    }
+    return s_rx_pending_data ||
+           (__HAL_DMA_GET_COUNTER(s_huart->hdmarx) != DWIN_RX_BUFFER_SIZE) ||
+           (__HAL_UART_GET_FLAG(s_huart, UART_FLAG_BUSY) != RESET);
+}
+
 bool DWIN_Driver_SetScreen(uint16_t screen_id)
 {
     uint8_t cmd_buffer[] = {
@@ -68,6 +68,7 @@ static struct {
     uint16_t            bytes_remaining;  
     uint32_t            delay_start_tick; 
     bool                error_flag;       
+    volatile bool       abortado;              // Queda de energia: no inicia pginas novas.
 } s_fsm;
 
 
@@ -95,6 +96,13 @@ static void EEPROM_Driver_ResetPeripheral(void) {
     HAL_I2C_DeInit(s_fsm.i2c_handle);
     HAL_Delay(5);
     HAL_I2C_Init(s_fsm.i2c_handle);
+
+    // Uma escrita IT em andamento foi descartada com o perifrico e nunca
+    // chegar ao TxCplt: encerra como erro para o dono repetir.
+    if (s_fsm.state == FSM_WAIT_I2C_IT) {
+        s_fsm.error_flag = true;
+        s_fsm.state = FSM_ERROR;
+    }
 }
 
 
@@ -214,7 +222,7 @@ bool EEPROM_Driver_IsBusy(void) {
 
 // Inicia uma operao de escrita assncrona.
 bool EEPROM_Driver_Write_Async_Start(uint16_t addr, const uint8_t *data, uint16_t size) {
-    if (EEPROM_Driver_IsBusy() || data == NULL || size == 0) {
+    if (EEPROM_Driver_IsBusy() || s_fsm.abortado || data == NULL || size == 0) {
         return false;
     }
 
@@ -236,6 +244,13 @@ void EEPROM_Driver_FSM_Process(void) {
                 break;
             }
 
+            // Abortada: as pginas j escritas ficam, o restante no comea.
+            if (s_fsm.abortado) {
+                s_fsm.error_flag = true;
+                s_fsm.state = FSM_ERROR;
+                break;
+            }
+
             uint16_t chunk_size = EEPROM_PAGE_SIZE - (s_fsm.current_addr % EEPROM_PAGE_SIZE);
 
             // Limita o chunk ao total de dados restantes
@@ -283,6 +298,22 @@ bool EEPROM_Driver_GetAndClearErrorFlag(void) {
     return false;
 }
 
+/**
+ * @brief Bloqueia novas pginas; a que est no barramento ou em tWR termina.
+ */
+bool EEPROM_Driver_Abortar(void) {
+    s_fsm.abortado = true;
+    return EEPROM_Driver_IsBusy();
+}
+
+void EEPROM_Driver_Liberar(void) {
+    s_fsm.abortado = false;
+}
+
+bool EEPROM_Driver_Is_Abortado(void) {
+    return s_fsm.abortado;
+}
+
 /*
 ==================================================
   CALLBACKS DO HAL I2C (Contexto de ISR)
@@ -0,0 +1,522 @@
+/*******************************************************************************
+ * @file        energia.c
+ * @brief       Gerenciador de energia (Sleep/Stop por tempo ocioso previsto).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O alarme A do RTC compara s segundos e subsegundos (1/256 s),
+ * ento o prazo de um Stop fica limitado a STOP_PRAZO_MAX_MS e  arredondado
+ * para baixo: acordar um pouco antes custa s um WFI a mais. O tempo dormido
+ *  medido pelo prprio RTC, porque SysTick e TIM14 ficam parados no Stop.
+ ******************************************************************************/
+
+#include "energia.h"
+#include "temporizador.h"
+#include "app_manager.h"
+#include "eeprom_driver.h"
+#include "gerenciador_configuracoes.h"
+#include "servo_controle.h"
+#include "lote_handler.h"
+#include "ads1232_driver.h"
+#include "dwin_driver.h"
+#include "profiler.h"
+#include "usart.h"
+#include "i2c.h"
+#include "secao_critica.h"
+#include <string.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+typedef struct {
+    const char*     nome;
+    Energia_Nivel_t (*nivel_max)(void);    // Modo mais profundo permitido agora
+} Energia_Restricao_t;
+
+// Stop s compensa acima disto: religar HSI/HSI48 e refazer o clock cheio
+// custa algumas dezenas de microssegundos, e o alarme tem resoluo de ~4 ms.
+static const uint32_t STOP_PREVISAO_MIN_MS = 10;
+static const uint32_t STOP_PRAZO_MAX_MS    = 30000;  // Alarme no compara minutos
+static const uint32_t HSI48_ESPERA_MAX     = 10000;  // Iteraes; parte em ~2,5 us
+
+// Por clock: divisor do HSISYS e timing do I2C1 a 100 kHz. O do reduzido mantm
+// os tempos do CubeMX (0x10805D88 a 48 MHz) com PRESC 0 e contagens pela metade.
+static const uint8_t  DIVISOR_CLOCK[NUM_CLOCKS_ENERGIA]    = {1u, 4u};
+static const uint32_t I2C1_TIMING_CLOCK[NUM_CLOCKS_ENERGIA] = {0x10805D88u, 0x00402F44u};
+
+static Energia_USB_t s_usb;
+static uint32_t s_inicio_suspensao_ms = 0;
+static volatile bool s_usb_retomando = false;   // HSI48 religado, ainda no visto pronto
+static uint32_t s_inicio_retomada_us = 0;
+
+//==============================================================================
+// Restries
+//==============================================================================
+
+static Energia_Nivel_t Restricao_Usb(void)
+{
+    // A stack precisa do HSI48 e responder ao host dentro do tempo do barramento.
+    // Suspensa, s precisa da EXTI de wakeup, que funciona em Stop.
+    return (App_Manager_USB_Ativo() && !s_usb.suspenso) ? ENERGIA_SLEEP : ENERGIA_STOP;
+}
+
+static Energia_Nivel_t Restricao_Display(void)
+{
+    // Com o display ligado um pacote pode chegar a qualquer momento, e a USART2
+    // no recebe em Stop. DMA de transmisso tambm precisa do clock.
+    const bool display_ligado = (HAL_GPIO_ReadPin(DISPLAY_PWR_CTRL_GPIO_Port, DISPLAY_PWR_CTRL_Pin) == GPIO_PIN_RESET);
+    return (display_ligado || DWIN_Driver_IsTxBusy()) ? ENERGIA_SLEEP : ENERGIA_STOP;
+}
+
+static Energia_Nivel_t Restricao_Eeprom(void)
+{
+    return (EEPROM_Driver_IsBusy() || Gerenciador_Config_Ha_Pendencias()) ? ENERGIA_SLEEP : ENERGIA_STOP;
+}
+
+static Energia_Nivel_t Restricao_Servos(void)
+{
+    // PWM do TIM16/17 para em Stop: servo em movimento perderia a posio.
+    const ServoStep_t passo = Servos_Get_Step();
+    return (passo != SERVO_STEP_IDLE && passo != SERVO_STEP_FINISHED) ? ENERGIA_SLEEP : ENERGIA_STOP;
+}
+
+static Energia_Nivel_t Restricao_Medicao(void)
+{
+    // TIM2 no conta pulsos em Stop; a tara depende do DRDY com timeout.
+    return (Lote_Is_Ativo() || ADS1232_Tare_Em_Andamento()) ? ENERGIA_SLEEP : ENERGIA_STOP;
+}
+
+static const Energia_Restricao_t s_restricoes[] = {
+    {"USB",     Restricao_Usb},
+    {"DISPLAY", Restricao_Display},
+    {"EEPROM",  Restricao_Eeprom},
+    {"SERVOS",  Restricao_Servos},
+    {"MEDICAO", Restricao_Medicao},
+};
+
+#define NUM_RESTRICOES  (sizeof(s_restricoes) / sizeof(s_restricoes[0]))
+
+static const char* const NOMES_NIVEIS[NUM_NIVEIS_ENERGIA] = {
+    [ENERGIA_EXECUTANDO] = "EXECUTANDO",
+    [ENERGIA_SLEEP]      = "SLEEP",
+    [ENERGIA_STOP]       = "STOP",
+};
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static RTC_HandleTypeDef* s_hrtc = NULL;
+static Energia_Residencia_t s_residencia[NUM_NIVEIS_ENERGIA];
+static uint32_t s_bloqueios[NUM_RESTRICOES];
+static uint32_t s_ultima_saida_us = 0;
+static Energia_Clock_t s_clock = ENERGIA_CLOCK_CHEIO;
+static bool s_acordou_alarme = false;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static Energia_Nivel_t Escolher_Nivel(Energia_Nivel_t nivel_max, uint32_t previsao_ms);
+static void Contabilizar_Execucao(void);
+static uint32_t Rtc_Subticks(uint32_t* por_segundo_out);
+static bool Armar_Alarme(uint32_t prazo_ms);
+static uint32_t Dormir_Stop(uint32_t prazo_ms, Energia_Previsao_t previsao, bool reverificar, Energia_Clock_t clock_volta);
+static void Aplicar_Clock(Energia_Clock_t clock);
+static void Retemporizar_Perifericos(Energia_Clock_t clock);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Energia_Init(RTC_HandleTypeDef* hrtc)
+{
+    s_hrtc = hrtc;
+    Energia_Zerar();
+
+    // O alarme chega pela linha 19 da EXTI (direta, sempre habilitada).
+    HAL_NVIC_SetPriority(RTC_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(RTC_IRQn);
+}
+
+void Energia_Ocioso(Energia_Nivel_t nivel_max, Energia_Previsao_t previsao)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    uint32_t previsao_ms = (previsao != NULL) ? previsao() : ENERGIA_SEM_PRAZO;
+    const uint32_t proximo_tmr = Temporizador_Get_Proximo_ms();
+    if (proximo_tmr < previsao_ms) previsao_ms = proximo_tmr;
+
+    if (previsao_ms == 0)
+    {
+        SECAO_CRITICA_SAIR(sc);
+        return;
+    }
+
+    const Energia_Nivel_t nivel = Escolher_Nivel(nivel_max, previsao_ms);
+    if (nivel == ENERGIA_STOP)
+    {
+        // O alarme espera o RTC com timeout pelo HAL tick: arma fora da seo
+        // e confere a previso de novo antes do WFI.
+        SECAO_CRITICA_SAIR(sc);
+        Dormir_Stop(previsao_ms, previsao, true, s_clock);
+        return;
+    }
+
+    // Com PRIMASK ativo, uma interrupo pendente ainda acorda o WFI, mas s 
+    // atendida ao restaurar o PRIMASK: no h janela para perder um evento.
+    Contabilizar_Execucao();
+    const uint32_t inicio_us = s_ultima_saida_us;
+    __WFI();
+    s_ultima_saida_us = Temporizador_Get_us();
+    s_residencia[ENERGIA_SLEEP].tempo_us += (uint32_t)(s_ultima_saida_us - inicio_us);
+    s_residencia[ENERGIA_SLEEP].entradas++;
+    __set_PRIMASK(sc.primask);      // Sem SECAO_CRITICA_SAIR: o tempo em WFI no  IRQ bloqueada
+}
+
+uint32_t Energia_Stop(uint32_t prazo_ms, Energia_Clock_t clock_volta)
+{
+    if (s_hrtc == NULL) return ENERGIA_STOP_FALHOU;
+    return Dormir_Stop(prazo_ms, NULL, false, clock_volta);
+}
+
+bool Energia_Acordou_Pelo_Alarme(void) { return s_acordou_alarme; }
+
+Energia_Clock_t Energia_Get_Clock(void) { return s_clock; }
+
+bool Energia_Clock_Pode_Trocar(void)
+{
+    // A USART2  desabilitada para trocar o BRR: um quadro chegando se perderia.
+    return !DWIN_Driver_IsTxBusy() && !DWIN_Driver_IsRxBusy() && !EEPROM_Driver_IsBusy() &&
+           (hi2c1.State == HAL_I2C_STATE_READY);
+}
+
+void Energia_Set_Clock(Energia_Clock_t clock)
+{
+    if (clock == s_clock)
+    {
+        return;
+    }
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    Aplicar_Clock(clock);
+    SECAO_CRITICA_SAIR(sc);
+}
+
+void Energia_USB_Suspenso(bool suspenso)
+{
+    if (suspenso == s_usb.suspenso)
+    {
+        return;
+    }
+
+    if (suspenso)
+    {
+        // A clula j foi posta em baixo consumo pelo HAL (SUSPEN/SUSPRDY).
+        s_usb.suspenso = true;
+        s_usb.suspensoes++;
+        s_inicio_suspensao_ms = HAL_GetTick();
+        s_usb_retomando = false;
+        __HAL_USB_WAKEUP_EXTI_ENABLE_IT();
+        __HAL_RCC_HSI48_DISABLE();
+        return;
+    }
+
+    // Retomada: o host d 10 ms aps o fim do sinal de resume. A partida do
+    // HSI48 no  esperada aqui (ISR): a tarefa da USB a confere.
+    s_inicio_retomada_us = Temporizador_Get_us();
+    s_usb_retomando = true;
+    __HAL_RCC_HSI48_ENABLE();
+
+    s_usb.tempo_suspenso_ms += HAL_GetTick() - s_inicio_suspensao_ms;
+    s_usb.suspenso = false;
+}
+
+bool Energia_USB_Retomando(void)
+{
+    if (!s_usb_retomando)
+    {
+        return false;
+    }
+    if (READ_BIT(RCC->CR, RCC_CR_HSIUSB48RDY) == 0U)
+    {
+        return true;
+    }
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    if (s_usb_retomando)
+    {
+        const uint32_t retomada_us = Temporizador_Get_us() - s_inicio_retomada_us;
+        if (retomada_us > s_usb.retomada_max_us) s_usb.retomada_max_us = retomada_us;
+        s_usb_retomando = false;
+    }
+    SECAO_CRITICA_SAIR(sc);
+    return false;
+}
+
+bool Energia_Get_USB_Suspenso(void) { return s_usb.suspenso; }
+
+void Energia_Get_USB(Energia_USB_t* usb_out)
+{
+    if (usb_out == NULL) return;
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    *usb_out = s_usb;
+    if (s_usb.suspenso) usb_out->tempo_suspenso_ms += HAL_GetTick() - s_inicio_suspensao_ms;
+    SECAO_CRITICA_SAIR(sc);
+}
+
+void Energia_Get_Residencia(Energia_Nivel_t nivel, Energia_Residencia_t* residencia_out)
+{
+    if (nivel >= NUM_NIVEIS_ENERGIA || residencia_out == NULL) return;
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    if (nivel == ENERGIA_EXECUTANDO) Contabilizar_Execucao();
+    *residencia_out = s_residencia[nivel];
+    SECAO_CRITICA_SAIR(sc);
+}
+
+const char* Energia_Get_Nome_Nivel(Energia_Nivel_t nivel)
+{
+    return (nivel < NUM_NIVEIS_ENERGIA) ? NOMES_NIVEIS[nivel] : "?";
+}
+
+uint8_t Energia_Get_Num_Restricoes(void) { return (uint8_t)NUM_RESTRICOES; }
+
+const char* Energia_Get_Nome_Restricao(uint8_t indice)
+{
+    return (indice < NUM_RESTRICOES) ? s_restricoes[indice].nome : "?";
+}
+
+uint32_t Energia_Get_Bloqueios(uint8_t indice)
+{
+    return (indice < NUM_RESTRICOES) ? s_bloqueios[indice] : 0;
+}
+
+void Energia_Zerar(void)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    memset(s_residencia, 0, sizeof(s_residencia));
+    memset(s_bloqueios, 0, sizeof(s_bloqueios));
+    s_usb.suspensoes = 0;
+    s_usb.tempo_suspenso_ms = 0;
+    s_usb.retomada_max_us = 0;
+    s_inicio_suspensao_ms = HAL_GetTick();
+    s_ultima_saida_us = Temporizador_Get_us();
+    SECAO_CRITICA_SAIR(sc);
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Modo mais profundo que o estado da aplicao, a previso e todas as
+ * restries permitem. Conta qual restrio impediu um Stop vivel.
+ */
+static Energia_Nivel_t Escolher_Nivel(Energia_Nivel_t nivel_max, uint32_t previsao_ms)
+{
+    if (nivel_max < ENERGIA_STOP || previsao_ms < STOP_PREVISAO_MIN_MS || s_hrtc == NULL)
+    {
+        return ENERGIA_SLEEP;
+    }
+
+    for (uint8_t i = 0; i < NUM_RESTRICOES; i++)
+    {
+        if (s_restricoes[i].nivel_max() < ENERGIA_STOP)
+        {
+            s_bloqueios[i]++;
+            return ENERGIA_SLEEP;
+        }
+    }
+    return ENERGIA_STOP;
+}
+
+/** @brief Soma ao tempo executando o intervalo desde a ltima sada de um modo. */
+static void Contabilizar_Execucao(void)
+{
+    const uint32_t agora_us = Temporizador_Get_us();
+    s_residencia[ENERGIA_EXECUTANDO].tempo_us += (uint32_t)(agora_us - s_ultima_saida_us);
+    s_ultima_saida_us = agora_us;
+}
+
+/**
+ * @brief Instante do dia em subsegundos do RTC (1/(PREDIV_S+1) s).
+ * O SSR conta para baixo; a leitura da data destrava os registradores sombra.
+ */
+static uint32_t Rtc_Subticks(uint32_t* por_segundo_out)
+{
+    RTC_TimeTypeDef hora;
+    RTC_DateTypeDef data;
+    HAL_RTC_GetTime(s_hrtc, &hora, RTC_FORMAT_BIN);
+    HAL_RTC_GetDate(s_hrtc, &data, RTC_FORMAT_BIN);
+
+    const uint32_t por_segundo = hora.SecondFraction + 1u;
+    if (por_segundo_out != NULL) *por_segundo_out = por_segundo;
+
+    const uint32_t segundos = (uint32_t)hora.Hours * 3600u + (uint32_t)hora.Minutes * 60u + hora.Seconds;
+    return segundos * por_segundo + (hora.SecondFraction - hora.SubSeconds);
+}
+
+/**
+ * @brief Arma o alarme A para 'prazo_ms'  frente (arredondado para baixo,
+ * no mnimo um subsegundo), comparando s segundos e subsegundos.
+ */
+static bool Armar_Alarme(uint32_t prazo_ms)
+{
+    if (prazo_ms > STOP_PRAZO_MAX_MS) prazo_ms = STOP_PRAZO_MAX_MS;
+
+    uint32_t por_segundo;
+    const uint32_t agora = Rtc_Subticks(&por_segundo);
+    uint32_t prazo = (prazo_ms * por_segundo) / 1000u;
+    if (prazo == 0) prazo = 1;
+
+    const uint32_t no_minuto = (agora + prazo) % (60u * por_segundo);
+
+    RTC_AlarmTypeDef alarme = {0};
+    alarme.AlarmTime.Seconds    = (uint8_t)(no_minuto / por_segundo);
+    alarme.AlarmTime.SubSeconds = (por_segundo - 1u) - (no_minuto % por_segundo);
+    alarme.AlarmMask            = RTC_ALARMMASK_DATEWEEKDAY | RTC_ALARMMASK_HOURS | RTC_ALARMMASK_MINUTES;
+    alarme.AlarmSubSecondMask   = RTC_ALARMSUBSECONDMASK_NONE;
+    alarme.AlarmDateWeekDaySel  = RTC_ALARMDATEWEEKDAYSEL_DATE;
+    alarme.AlarmDateWeekDay     = 1;
+    alarme.Alarm                = RTC_ALARM_A;
+
+    return HAL_RTC_SetAlarm_IT(s_hrtc, &alarme, RTC_FORMAT_BIN) == HAL_OK;
+}
+
+/**
+ * @brief Stop at o alarme ou uma interrupo. Com 'reverificar', desiste se
+ * algum trabalho surgiu enquanto o alarme era armado.
+ */
+static uint32_t Dormir_Stop(uint32_t prazo_ms, Energia_Previsao_t previsao, bool reverificar, Energia_Clock_t clock_volta)
+{
+    s_acordou_alarme = false;
+    if (s_hrtc == NULL)
+    {
+        return 0;
+    }
+
+    bool com_alarme = (prazo_ms != ENERGIA_SEM_PRAZO);
+    if (com_alarme && !Armar_Alarme(prazo_ms))
+    {
+        // No ocioso, desiste e o loop tenta de novo. No Stop incondicional,
+        // voltar sem dormir faria o chamador girar: dorme sem prazo.
+        if (reverificar) return 0;
+        com_alarme = false;
+    }
+
+    uint32_t por_segundo;
+    const uint32_t antes = Rtc_Subticks(&por_segundo);
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    if (reverificar && (Temporizador_Get_Proximo_ms() == 0 || (previsao != NULL && previsao() == 0)))
+    {
+        SECAO_CRITICA_SAIR(sc);
+        if (com_alarme) HAL_RTC_DeactivateAlarm(s_hrtc, RTC_ALARM_A);
+        return 0;
+    }
+    Contabilizar_Execucao();
+    HAL_SuspendTick();
+    HAL_PWR_EnterSTOPMode(PWR_MAINREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    // Acordou (alarme, toque, DRDY...): HSISYS sobe com o divisor de reset.
+    // A flag do alarme  lida antes de a ISR do RTC limp-la.
+    s_acordou_alarme = com_alarme && (__HAL_RTC_ALARM_GET_FLAG(s_hrtc, RTC_FLAG_ALRAF) != 0U);
+    Aplicar_Clock(clock_volta);
+    HAL_ResumeTick();
+    __set_PRIMASK(sc.primask);      // Como no Sleep: o tempo em Stop no entra no IRQOFF
+
+    if (com_alarme)
+    {
+        HAL_RTC_DeactivateAlarm(s_hrtc, RTC_ALARM_A);
+    }
+    HAL_RTC_WaitForSynchro(s_hrtc);   // Registradores sombra ficam velhos no Stop
+
+    const uint32_t subticks_dia = 86400u * por_segundo;
+    const uint32_t depois = Rtc_Subticks(NULL);
+    const uint32_t dormido_ms = (uint32_t)(((uint64_t)((depois + subticks_dia - antes) % subticks_dia) * 1000u) / por_segundo);
+
+    // O tempo do HAL e da roda parou junto com os clocks: compensa.
+    SECAO_CRITICA_ENTRAR(sc);
+    uwTick += dormido_ms;
+    SECAO_CRITICA_SAIR(sc);
+    Temporizador_Avancar(dormido_ms);
+
+    s_ultima_saida_us = Temporizador_Get_us();
+    s_residencia[ENERGIA_STOP].tempo_us += (uint64_t)dormido_ms * 1000u;
+    s_residencia[ENERGIA_STOP].entradas++;
+    return dormido_ms;
+}
+
+/**
+ * @brief Configura o clock pedido e refaz as bases de tempo que dependem dele.
+ * Chamar com interrupes bloqueadas. S registradores: os HAL_RCC_*Config
+ * esperam com timeout no HAL tick, que aqui no anda (seo crtica ou volta
+ * do Stop). O HSI j  o SYSCLK e o CRS fica configurado desde o boot.
+ */
+static void Aplicar_Clock(Energia_Clock_t clock)
+{
+    if (clock == ENERGIA_CLOCK_REDUZIDO)
+    {
+        __HAL_RCC_HSI_CONFIG(RCC_HSI_DIV4);
+    }
+    else
+    {
+        __HAL_FLASH_SET_LATENCY(FLASH_LATENCY_1);       // Antes de subir a frequncia
+        __HAL_RCC_HSI_CONFIG(RCC_HSI_DIV1);
+    }
+
+    // No cheio o HSI48 fica ligado como no boot; no reduzido, s com a USB
+    // ativa (mesmo sem host, para atender um reset do barramento). A espera 
+    // por contagem, no pelo tick: um HSI48 que no parte no trava o ncleo.
+    if (!s_usb.suspenso && (clock == ENERGIA_CLOCK_CHEIO || App_Manager_USB_Ativo()))
+    {
+        __HAL_RCC_HSI48_ENABLE();
+        for (uint32_t i = 0; i < HSI48_ESPERA_MAX && READ_BIT(RCC->CR, RCC_CR_HSIUSB48RDY) == 0U; i++)
+        {
+        }
+    }
+    else
+    {
+        __HAL_RCC_HSI48_DISABLE();
+    }
+    SystemCoreClockUpdate();
+    HAL_InitTick(uwTickPrio);
+    Temporizador_Ajustar_Clock(HAL_RCC_GetPCLK1Freq());
+
+    // Depois de um Stop os registradores dos perifricos continuam no clock anterior.
+    if (clock != s_clock)
+    {
+        Retemporizar_Perifericos(clock);
+    }
+    s_clock = clock;
+}
+
+/**
+ * @brief USART2 e I2C1 s aceitam BRR/TIMINGR desabilitados: UE/PE caem por
+ * alguns ciclos. O DMA de recepo do display continua armado.
+ */
+static void Retemporizar_Perifericos(Energia_Clock_t clock)
+{
+    const uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+
+    CLEAR_BIT(huart2.Instance->CR1, USART_CR1_UE);
+    huart2.Instance->BRR = UART_DIV_SAMPLING16(pclk, huart2.Init.BaudRate, huart2.Init.ClockPrescaler);
+    SET_BIT(huart2.Instance->CR1, USART_CR1_UE);
+
+    __HAL_I2C_DISABLE(&hi2c1);
+    hi2c1.Instance->TIMINGR = I2C1_TIMING_CLOCK[clock];
+    hi2c1.Init.Timing = I2C1_TIMING_CLOCK[clock];
+    __HAL_I2C_ENABLE(&hi2c1);
+
+    Servos_Ajustar_Clock(DIVISOR_CLOCK[clock]);
+#if PROFILER_HABILITADO
+    Profiler_Ajustar_Clock(pclk);
+#endif
+}
@@ -0,0 +1,291 @@
+/*******************************************************************************
+ * @file        escalonador.c
+ * @brief       Escalonador cooperativo de tarefas do super-loop.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada passada escolhe a tarefa pronta de maior prioridade,
+ * executa-a e recomea a busca, de modo que uma tarefa prioritria que
+ * ficou pronta nunca espera mais que a tarefa em curso. O nmero de
+ * execues por passada  limitado ao nmero de tarefas, para que um
+ * evento sinalizado continuamente no prenda o loop.
+ * Com ESCALONADOR_ESTATISTICAS, cada execuo  cronometrada pelo tempo
+ * livre do TIM14 (resoluo de 1 us).
+ ******************************************************************************/
+
+#include "escalonador.h"
+#include "main.h"
+#include <stddef.h>
+#include <string.h>
+#include "trace.h"
+#include "secao_critica.h"
+#if ESCALONADOR_ESTATISTICAS
+#include "temporizador.h"
+#endif
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+typedef struct {
+    uint32_t ultimo_tick;
+    uint32_t atraso_max_ms;
+} Estado_Tarefa_t;
+
+static const Tarefa_t* s_tabela = NULL;
+static uint8_t s_num_tarefas = 0;
+static Estado_Tarefa_t s_estado[ESCALONADOR_MAX_TAREFAS];
+static volatile uint32_t s_sinalizadas = 0;   // Bit n = tarefa n sinalizada
+
+#if ESCALONADOR_ESTATISTICAS
+static const uint32_t LIMITES_HIST_US[ESCALONADOR_HIST_FAIXAS - 1] = {100, 1000, 10000};
+
+static Escalonador_Estatistica_t s_estat_tarefas[ESCALONADOR_MAX_TAREFAS];
+static Escalonador_Estatistica_t s_estat_passada;
+static Escalonador_Estatistica_t s_estat_periodo;
+static uint32_t s_inicio_passada_anterior_us = 0;
+static bool s_passada_anterior_valida = false;
+#endif
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static bool Tarefa_Pronta(uint8_t id, uint32_t agora);
+static int16_t Buscar_Proxima_Pronta(uint32_t agora);
+#if ESCALONADOR_ESTATISTICAS
+static void Registrar_Duracao(Escalonador_Estatistica_t* estatistica, uint32_t duracao_us);
+#endif
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Escalonador_Init(const Tarefa_t* tabela, uint8_t num_tarefas)
+{
+    s_tabela = tabela;
+    s_num_tarefas = (num_tarefas > ESCALONADOR_MAX_TAREFAS) ? ESCALONADOR_MAX_TAREFAS : num_tarefas;
+
+    uint32_t agora = HAL_GetTick();
+    for (uint8_t i = 0; i < s_num_tarefas; i++)
+    {
+        s_estado[i].ultimo_tick = agora;
+        s_estado[i].atraso_max_ms = 0;
+    }
+    // Sinalizaes da tabela anterior no valem para a nova.
+    s_sinalizadas = 0;
+
+#if ESCALONADOR_ESTATISTICAS
+    Escalonador_Zerar_Estatisticas();
+#endif
+}
+
+void Escalonador_Sinalizar(uint8_t id_tarefa)
+{
+    if (id_tarefa < ESCALONADOR_MAX_TAREFAS)
+    {
+        // Tambm chamada de ISRs (expirao do TIM14): restaura o PRIMASK do chamador.
+        SecaoCritica_t sc;
+        SECAO_CRITICA_ENTRAR(sc);
+        s_sinalizadas |= (1UL << id_tarefa);
+        SECAO_CRITICA_SAIR(sc);
+    }
+}
+
+bool Escalonador_Executar(void)
+{
+    bool executou = false;
+
+#if ESCALONADOR_ESTATISTICAS
+    uint32_t inicio_passada_us = Temporizador_Get_us();
+    if (s_passada_anterior_valida)
+    {
+        Registrar_Duracao(&s_estat_periodo, inicio_passada_us - s_inicio_passada_anterior_us);
+    }
+    s_inicio_passada_anterior_us = inicio_passada_us;
+    s_passada_anterior_valida = true;
+#endif
+
+    for (uint8_t execucoes = 0; execucoes < s_num_tarefas; execucoes++)
+    {
+        uint32_t agora = HAL_GetTick();
+        int16_t id = Buscar_Proxima_Pronta(agora);
+        if (id < 0)
+        {
+            break;
+        }
+
+        const Tarefa_t* tarefa = &s_tabela[id];
+        Estado_Tarefa_t* estado = &s_estado[id];
+
+        SecaoCritica_t sc;
+        SECAO_CRITICA_ENTRAR(sc);
+        s_sinalizadas &= ~(1UL << id);
+        SECAO_CRITICA_SAIR(sc);
+
+        if (tarefa->periodo_ms > 0 && tarefa->previsao != NULL)
+        {
+            // Polling retomado pelo trabalho: o tempo parado no  atraso.
+            if (agora - estado->ultimo_tick >= tarefa->periodo_ms) estado->ultimo_tick = agora;
+        }
+        else if (tarefa->periodo_ms > 0)
+        {
+            uint32_t decorrido = agora - estado->ultimo_tick;
+            if (decorrido >= tarefa->periodo_ms)
+            {
+                uint32_t atraso = decorrido - tarefa->periodo_ms;
+                if (atraso > estado->atraso_max_ms) estado->atraso_max_ms = atraso;
+
+                // Mantm a cadncia; se perdeu mais de um perodo, realinha.
+                estado->ultimo_tick = (atraso < tarefa->periodo_ms) ? (estado->ultimo_tick + tarefa->periodo_ms) : agora;
+            }
+        }
+
+        TRACE(TRC_TAREFA_INICIO, id);
+#if ESCALONADOR_ESTATISTICAS
+        uint32_t inicio_us = Temporizador_Get_us();
+        tarefa->executar();
+        Registrar_Duracao(&s_estat_tarefas[id], Temporizador_Get_us() - inicio_us);
+#else
+        tarefa->executar();
+#endif
+        TRACE(TRC_TAREFA_FIM, id);
+        executou = true;
+    }
+
+#if ESCALONADOR_ESTATISTICAS
+    if (executou)
+    {
+        Registrar_Duracao(&s_estat_passada, Temporizador_Get_us() - inicio_passada_us);
+    }
+#endif
+
+    return executou;
+}
+
+uint32_t Escalonador_Get_Ocioso_ms(void)
+{
+    if (s_sinalizadas != 0)
+    {
+        return 0;
+    }
+
+    uint32_t agora = HAL_GetTick();
+    uint32_t ocioso = UINT32_MAX;
+    for (uint8_t i = 0; i < s_num_tarefas; i++)
+    {
+        uint16_t periodo = s_tabela[i].periodo_ms;
+        if (periodo == 0)
+        {
+            continue;
+        }
+        uint32_t decorrido = agora - s_estado[i].ultimo_tick;
+        uint32_t restante = (decorrido >= periodo) ? 0 : (periodo - decorrido);
+        if (s_tabela[i].previsao != NULL)
+        {
+            uint32_t trabalho = s_tabela[i].previsao();
+            if (trabalho > restante) restante = trabalho;
+        }
+        if (restante == 0)
+        {
+            return 0;
+        }
+        if (restante < ocioso) ocioso = restante;
+    }
+    return ocioso;
+}
+
+uint32_t Escalonador_Get_Atraso_Max_ms(uint8_t id_tarefa)
+{
+    return (id_tarefa < s_num_tarefas) ? s_estado[id_tarefa].atraso_max_ms : 0;
+}
+
+uint8_t Escalonador_Get_Num_Tarefas(void)
+{
+    return s_num_tarefas;
+}
+
+const char* Escalonador_Get_Nome(uint8_t id_tarefa)
+{
+    return (id_tarefa < s_num_tarefas) ? s_tabela[id_tarefa].nome : "?";
+}
+
+#if ESCALONADOR_ESTATISTICAS
+bool Escalonador_Get_Estatistica_Tarefa(uint8_t id_tarefa, Escalonador_Estatistica_t* estatistica_out)
+{
+    if (id_tarefa >= s_num_tarefas || estatistica_out == NULL)
+    {
+        return false;
+    }
+    *estatistica_out = s_estat_tarefas[id_tarefa];
+    return true;
+}
+
+void Escalonador_Get_Estatistica_Loop(Escalonador_Estatistica_t* passada_out, Escalonador_Estatistica_t* periodo_out)
+{
+    if (passada_out != NULL) *passada_out = s_estat_passada;
+    if (periodo_out != NULL) *periodo_out = s_estat_periodo;
+}
+
+void Escalonador_Zerar_Estatisticas(void)
+{
+    memset(s_estat_tarefas, 0, sizeof(s_estat_tarefas));
+    memset(&s_estat_passada, 0, sizeof(s_estat_passada));
+    memset(&s_estat_periodo, 0, sizeof(s_estat_periodo));
+    s_passada_anterior_valida = false;
+
+    for (uint8_t i = 0; i < s_num_tarefas; i++)
+    {
+        s_estado[i].atraso_max_ms = 0;
+    }
+}
+#endif
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static bool Tarefa_Pronta(uint8_t id, uint32_t agora)
+{
+    if (s_sinalizadas & (1UL << id))
+    {
+        return true;
+    }
+    const Tarefa_t* tarefa = &s_tabela[id];
+    return (tarefa->periodo_ms > 0) && (agora - s_estado[id].ultimo_tick >= tarefa->periodo_ms) &&
+           (tarefa->previsao == NULL || tarefa->previsao() == 0);
+}
+
+/**
+ * @brief ndice da tarefa pronta de maior prioridade; empate fica com a
+ * que aparece antes na tabela. Retorna -1 se nenhuma estiver pronta.
+ */
+static int16_t Buscar_Proxima_Pronta(uint32_t agora)
+{
+    int16_t escolhida = -1;
+    for (uint8_t i = 0; i < s_num_tarefas; i++)
+    {
+        if (Tarefa_Pronta(i, agora) &&
+            (escolhida < 0 || s_tabela[i].prioridade < s_tabela[escolhida].prioridade))
+        {
+            escolhida = (int16_t)i;
+        }
+    }
+    return escolhida;
+}
+
+#if ESCALONADOR_ESTATISTICAS
+static void Registrar_Duracao(Escalonador_Estatistica_t* estatistica, uint32_t duracao_us)
+{
+    if (estatistica->execucoes == 0 || duracao_us < estatistica->min_us) estatistica->min_us = duracao_us;
+    if (duracao_us > estatistica->max_us) estatistica->max_us = duracao_us;
+    estatistica->execucoes++;
+    estatistica->soma_us += duracao_us;
+
+    uint8_t faixa = 0;
+    while (faixa < (ESCALONADOR_HIST_FAIXAS - 1) && duracao_us >= LIMITES_HIST_US[faixa])
+    {
+        faixa++;
+    }
+    estatistica->histograma[faixa]++;
+}
+#endif
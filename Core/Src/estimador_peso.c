@@ -0,0 +1,227 @@
+/*******************************************************************************
+ * @file        estimador_peso.c
+ * @brief       Estimador do peso final a partir do transiente da balana.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Modelo: d[n+1] = a1*d[n] + a2*d[n-1], com d = diferena entre
+ * amostras de peso consecutivas. Razes reais do a acomodao exponencial,
+ * razes complexas a oscilao amortecida. Somando a srie das diferenas
+ * futuras obtm-se o peso assinttico em forma fechada:
+ *
+ *     W = w[n] + ((a1 + a2)*d[n] + a2*d[n-1]) / (1 - a1 - a2)
+ *
+ * Os coeficientes saem de mnimos quadrados com esquecimento exponencial
+ * (sistema 2x2 resolvido por Cramer). Todo o clculo  inteiro: pesos em mg,
+ * coeficientes em Q16 e acumuladores em 64 bits.
+ ******************************************************************************/
+
+#include "estimador_peso.h"
+#include <string.h>
+
+//==============================================================================
+// Configurao
+//==============================================================================
+
+#define Q16_UM                  65536
+#define ESQUECIMENTO_SHIFT      3       // lambda = 1 - 1/8: memria de ~8 amostras
+#define NORMALIZA_BITS          22      // Somas reduzidas a < 2^22 antes dos produtos
+#define DEN_MINIMO_Q16          (Q16_UM / 64) // Limita o ganho DC do modelo a 64x
+#define AMOSTRAS_MINIMAS        6       // Amostras antes de confiar no modelo
+#define AMOSTRAS_CONVERGENCIA   3       // Previses consecutivas dentro da tolerncia
+#define FATOR_CONFIANCA         2       // Faixa = 2 sigma
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Atualizar_Modelo(Estimador_Peso_t* est);
+static void Atualizar_Previsao(Estimador_Peso_t* est, int32_t peso_mg);
+static uint32_t Raiz_Quadrada_u64(uint64_t valor);
+static int64_t Abs64(int64_t valor);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void EstimadorPeso_Reiniciar(Estimador_Peso_t* est, int32_t tolerancia_mg)
+{
+    memset(est, 0, sizeof(Estimador_Peso_t));
+    est->tolerancia_mg = tolerancia_mg;
+}
+
+void EstimadorPeso_Adicionar(Estimador_Peso_t* est, int32_t peso_mg)
+{
+    if (est->amostras == 0)
+    {
+        est->peso_anterior_mg = peso_mg;
+        est->peso_previsto_mg = peso_mg;
+        est->amostras = 1;
+        return;
+    }
+
+    int32_t dif = peso_mg - est->peso_anterior_mg;
+    est->peso_anterior_mg = peso_mg;
+
+    if (est->amostras >= 3)
+    {
+        // Erro de predio de 1 passo com o modelo anterior (antes de incorporar a amostra)
+        if (est->modelo_valido)
+        {
+            int64_t previsto = ((int64_t)est->a1_q16 * est->dif_1 + (int64_t)est->a2_q16 * est->dif_2) / Q16_UM;
+            int64_t erro = (int64_t)dif - previsto;
+            est->var_residuo += ((erro * erro) - est->var_residuo) >> ESQUECIMENTO_SHIFT;
+        }
+
+        // Atualiza as equaes normais com o par (regressor, alvo) = ([d[n], d[n-1]], d[n+1])
+        est->s11 += (int64_t)est->dif_1 * est->dif_1 - (est->s11 >> ESQUECIMENTO_SHIFT);
+        est->s12 += (int64_t)est->dif_1 * est->dif_2 - (est->s12 >> ESQUECIMENTO_SHIFT);
+        est->s22 += (int64_t)est->dif_2 * est->dif_2 - (est->s22 >> ESQUECIMENTO_SHIFT);
+        est->sy1 += (int64_t)dif * est->dif_1 - (est->sy1 >> ESQUECIMENTO_SHIFT);
+        est->sy2 += (int64_t)dif * est->dif_2 - (est->sy2 >> ESQUECIMENTO_SHIFT);
+    }
+
+    est->dif_2 = est->dif_1;
+    est->dif_1 = dif;
+    if (est->amostras < 0xFFFF) est->amostras++;
+
+    Atualizar_Modelo(est);
+    Atualizar_Previsao(est, peso_mg);
+}
+
+bool EstimadorPeso_Convergiu(const Estimador_Peso_t* est)
+{
+    return est->convergiu;
+}
+
+int32_t EstimadorPeso_Get_Previsto_mg(const Estimador_Peso_t* est)
+{
+    return est->peso_previsto_mg;
+}
+
+int32_t EstimadorPeso_Get_Incerteza_mg(const Estimador_Peso_t* est)
+{
+    return est->incerteza_mg;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Resolve o sistema 2x2 das equaes normais por Cramer.
+ * As somas so reduzidas para < 2^NORMALIZA_BITS para que os produtos
+ * (e o deslocamento para Q16) caibam em 64 bits.
+ */
+static void Atualizar_Modelo(Estimador_Peso_t* est)
+{
+    int64_t maior = Abs64(est->s11);
+    if (Abs64(est->s22) > maior) maior = Abs64(est->s22);
+    if (Abs64(est->sy1) > maior) maior = Abs64(est->sy1);
+    if (Abs64(est->sy2) > maior) maior = Abs64(est->sy2);
+
+    uint8_t shift = 0;
+    while ((maior >> shift) >= ((int64_t)1 << NORMALIZA_BITS))
+    {
+        shift++;
+    }
+
+    int64_t s11 = est->s11 >> shift;
+    int64_t s12 = est->s12 >> shift;
+    int64_t s22 = est->s22 >> shift;
+    int64_t sy1 = est->sy1 >> shift;
+    int64_t sy2 = est->sy2 >> shift;
+
+    int64_t det = s11 * s22 - s12 * s12;
+    if (det <= 0)
+    {
+        est->modelo_valido = false;
+        return;
+    }
+
+    int64_t a1 = ((sy1 * s22 - sy2 * s12) * Q16_UM) / det;
+    int64_t a2 = ((sy2 * s11 - sy1 * s12) * Q16_UM) / det;
+
+    // Condies de Jury: polos dentro do crculo unitrio, com margem no ganho DC.
+    bool estavel = (Q16_UM - a1 - a2 >= DEN_MINIMO_Q16) &&
+                   (Q16_UM + a1 - a2 > 0) &&
+                   (Abs64(a2) < Q16_UM);
+
+    est->modelo_valido = estavel;
+    if (estavel)
+    {
+        est->a1_q16 = (int32_t)a1;
+        est->a2_q16 = (int32_t)a2;
+    }
+}
+
+/**
+ * @brief Calcula o peso assinttico e a faixa de confiana.
+ * Sem modelo vlido, a previso  a prpria amostra e a faixa  a ltima variao.
+ */
+static void Atualizar_Previsao(Estimador_Peso_t* est, int32_t peso_mg)
+{
+    int32_t previsto = peso_mg;
+    int64_t incerteza = Abs64(est->dif_1);
+
+    if (est->dif_1 == 0 && est->dif_2 == 0)
+    {
+        incerteza = 0; // Sinal parado: nada a extrapolar
+    }
+    else if (est->modelo_valido)
+    {
+        int64_t den = (int64_t)Q16_UM - est->a1_q16 - est->a2_q16;
+        int64_t num = (int64_t)(est->a1_q16 + est->a2_q16) * est->dif_1 + (int64_t)est->a2_q16 * est->dif_2;
+        previsto = peso_mg + (int32_t)(num / den);
+
+        // O rudo de 1 passo  amplificado pelo ganho DC 1/(1 - a1 - a2).
+        int64_t sigma = (int64_t)Raiz_Quadrada_u64((uint64_t)est->var_residuo);
+        incerteza = (FATOR_CONFIANCA * sigma * Q16_UM) / den;
+        incerteza += Abs64((int64_t)previsto - est->peso_previsto_mg);
+    }
+
+    est->peso_previsto_mg = previsto;
+    est->incerteza_mg = (incerteza > INT32_MAX) ? INT32_MAX : (int32_t)incerteza;
+
+    if (est->amostras >= AMOSTRAS_MINIMAS && est->incerteza_mg <= est->tolerancia_mg)
+    {
+        if (est->amostras_convergidas < 0xFF) est->amostras_convergidas++;
+    }
+    else
+    {
+        est->amostras_convergidas = 0;
+    }
+    est->convergiu = (est->amostras_convergidas >= AMOSTRAS_CONVERGENCIA);
+}
+
+/**
+ * @brief Raiz quadrada inteira (mtodo bit a bit), sem diviso.
+ */
+static uint32_t Raiz_Quadrada_u64(uint64_t valor)
+{
+    uint64_t resultado = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > valor)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (valor >= resultado + bit)
+        {
+            valor -= resultado + bit;
+            resultado = (resultado >> 1) + bit;
+        }
+        else
+        {
+            resultado >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)resultado;
+}
+
+static int64_t Abs64(int64_t valor)
+{
+    return (valor < 0) ? -valor : valor;
+}
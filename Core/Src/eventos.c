@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * @file        eventos.c
+ * @brief       Fila de eventos tipados (publica/assina) em memria esttica.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Fila circular de EVENTOS_FILA_TAMANHO posies. Publicar s
+ * copia o evento para a fila (seo crtica curta); os assinantes rodam
+ * em Eventos_Despachar(), fora de qualquer driver ou ISR.
+ ******************************************************************************/
+
+#include "eventos.h"
+#include "main.h"
+#include "trace.h"
+#include "secao_critica.h"
+#include <string.h>
+#include <stddef.h>
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static Evento_t s_fila[EVENTOS_FILA_TAMANHO];
+static volatile uint8_t s_inicio = 0;
+static volatile uint8_t s_contagem = 0;
+static uint8_t s_ocupacao_max = 0;
+
+static Evento_Assinante_t s_assinantes[NUM_TIPOS_EVENTO][EVENTOS_MAX_ASSINANTES];
+static Evento_Estatistica_t s_estatisticas[NUM_TIPOS_EVENTO];
+static volatile uint32_t s_sequencia[NUM_TIPOS_EVENTO];
+static void (*s_ao_publicar)(void) = NULL;
+
+static const char* const s_nomes_evento[NUM_TIPOS_EVENTO] = {
+    [EVT_TOQUE_DWIN]       = "TOQUE_DWIN",
+    [EVT_MEDICAO_PRONTA]   = "MEDICAO_PRONTA",
+    [EVT_CONFIG_ALTERADA]  = "CONFIG_ALTERADA",
+    [EVT_BATERIA_ALTERADA] = "BATERIA_ALTERADA",
+};
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Eventos_Init(void (*ao_publicar)(void))
+{
+    s_ao_publicar = ao_publicar;
+    s_inicio = 0;
+    s_contagem = 0;
+    s_ocupacao_max = 0;
+    memset(s_assinantes, 0, sizeof(s_assinantes));
+    memset(s_estatisticas, 0, sizeof(s_estatisticas));
+}
+
+bool Eventos_Assinar(Evento_Tipo_t tipo, Evento_Assinante_t assinante)
+{
+    if (tipo >= NUM_TIPOS_EVENTO || assinante == NULL)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < EVENTOS_MAX_ASSINANTES; i++)
+    {
+        if (s_assinantes[tipo][i] == NULL)
+        {
+            s_assinantes[tipo][i] = assinante;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Eventos_Publicar(Evento_Tipo_t tipo, int32_t valor, const uint8_t* dados, uint16_t tamanho)
+{
+    if (tipo >= NUM_TIPOS_EVENTO)
+    {
+        return false;
+    }
+
+    bool aceito = false;
+
+    TRACE(TRC_EVENTO_PUBLICADO, tipo);
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    s_estatisticas[tipo].publicados++;
+    if (s_contagem < EVENTOS_FILA_TAMANHO && tamanho <= EVENTOS_DADOS_MAX)
+    {
+        Evento_t* evento = &s_fila[(s_inicio + s_contagem) % EVENTOS_FILA_TAMANHO];
+        evento->tipo = tipo;
+        evento->valor = valor;
+        evento->tamanho = tamanho;
+        if (dados != NULL && tamanho > 0)
+        {
+            memcpy(evento->dados, dados, tamanho);
+        }
+        s_contagem++;
+        s_sequencia[tipo]++;
+        if (s_contagem > s_ocupacao_max) s_ocupacao_max = s_contagem;
+        aceito = true;
+    }
+    else
+    {
+        s_estatisticas[tipo].descartados++;
+    }
+    SECAO_CRITICA_SAIR(sc);
+
+    if (aceito && s_ao_publicar != NULL)
+    {
+        s_ao_publicar();
+    }
+    return aceito;
+}
+
+uint8_t Eventos_Despachar(uint8_t max_eventos)
+{
+    uint8_t despachados = 0;
+
+    while (despachados < max_eventos && s_contagem > 0)
+    {
+        // O evento  processado direto na fila; a posio s  liberada depois,
+        // ento uma publicao feita pelo assinante no sobrescreve o evento.
+        const Evento_t* evento = &s_fila[s_inicio];
+        Evento_Tipo_t tipo = evento->tipo;
+        TRACE(TRC_EVENTO_DESPACHADO, tipo);
+
+        uint32_t inicio = HAL_GetTick();
+        for (uint8_t i = 0; i < EVENTOS_MAX_ASSINANTES && s_assinantes[tipo][i] != NULL; i++)
+        {
+            s_assinantes[tipo][i](evento);
+        }
+        uint32_t duracao = HAL_GetTick() - inicio;
+
+        s_estatisticas[tipo].despachados++;
+        if (duracao > s_estatisticas[tipo].tempo_max_ms) s_estatisticas[tipo].tempo_max_ms = duracao;
+
+        SecaoCritica_t sc;
+        SECAO_CRITICA_ENTRAR(sc);
+        s_inicio = (uint8_t)((s_inicio + 1) % EVENTOS_FILA_TAMANHO);
+        s_contagem--;
+        SECAO_CRITICA_SAIR(sc);
+
+        despachados++;
+    }
+    return despachados;
+}
+
+bool Eventos_Ha_Pendentes(void)
+{
+    return (s_contagem > 0);
+}
+
+void Eventos_Get_Estatistica(Evento_Tipo_t tipo, Evento_Estatistica_t* estatistica_out)
+{
+    if (tipo < NUM_TIPOS_EVENTO && estatistica_out != NULL)
+    {
+        SecaoCritica_t sc;
+        SECAO_CRITICA_ENTRAR(sc);
+        *estatistica_out = s_estatisticas[tipo];
+        SECAO_CRITICA_SAIR(sc);
+    }
+}
+
+uint32_t Eventos_Get_Sequencia(Evento_Tipo_t tipo)
+{
+    return (tipo < NUM_TIPOS_EVENTO) ? s_sequencia[tipo] : 0u;
+}
+
+void Eventos_Zerar_Estatisticas(void)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    memset(s_estatisticas, 0, sizeof(s_estatisticas));
+    s_ocupacao_max = s_contagem;
+    SECAO_CRITICA_SAIR(sc);
+}
+
+uint8_t Eventos_Get_Ocupacao_Max(void)
+{
+    return s_ocupacao_max;
+}
+
+const char* Eventos_Get_Nome(Evento_Tipo_t tipo)
+{
+    return (tipo < NUM_TIPOS_EVENTO) ? s_nomes_evento[tipo] : "?";
+}
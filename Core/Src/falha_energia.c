@@ -0,0 +1,301 @@
+/*******************************************************************************
+ * @file        falha_energia.c
+ * @brief       Antecipao de queda de energia e gravao do estado crtico.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A emergncia roda no contexto principal: a EXTI do POWER_GOOD
+ * s acorda o MCU (de WFI ou Stop) e marca a borda. O pior caso at o
+ * registro gravado  uma pgina de 128 bytes em curso (~12 ms de I2C + tWR)
+ * mais a escrita do registro (~3 ms + tWR), dentro do tempo que os
+ * capacitores de entrada seguram o regulador.
+ ******************************************************************************/
+
+#include "falha_energia.h"
+#include "main.h"
+#include "eeprom_driver.h"
+#include "gerenciador_configuracoes.h"
+#include "lote_handler.h"
+#include "medicao_handler.h"
+#include "bq_soc.h"
+#include "temp_sensor.h"
+#include "temporizador.h"
+#include <stdio.h>
+#include <stddef.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+_Static_assert(sizeof(Falha_Energia_Registro_t) == 32, "Registro critico deve ter 32 bytes");
+_Static_assert(END_OF_HISTORICO <= ADDR_ESTADO_CRITICO, "Estado critico sobrepoe o historico de lotes");
+_Static_assert(END_OF_ESTADO_CRITICO <= ADDR_GRAVACAO, "Estado critico sobrepoe a regiao de gravacao");
+
+typedef struct {
+    const char* nome;
+    bool        (*ativa)(void);
+} Falha_Origem_Def_t;
+
+static const uint32_t REGISTRO_MAGICA      = 0x51454441u;   // "QEDA"
+static const float    VBAT_SUSTENTA_V      = 3.50f;         // Segura o sistema sem entrada
+static const float    VBAT_CRITICA_V       = 3.30f;
+static const float    VBUS_PRESENTE_V      = 4.5f;
+static const uint16_t VDDA_MIN_MV          = 3000;
+static const uint32_t RESTABELECIMENTO_MS  = 2000;
+static const uint32_t ESPERA_PAGINA_MAX_MS = 30;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static volatile bool s_borda_power_good = false;
+static volatile bool s_simulada = false;
+static Falha_Energia_Status_t s_status;
+static Falha_Energia_Registro_t s_registro;
+static bool s_registro_valido = false;
+static uint32_t s_tick_normal = 0;
+
+//==============================================================================
+// Origens
+//==============================================================================
+
+static bool Origem_Vdda(void)
+{
+    // VDDA calculada a partir do VREFINT a cada converso do temp_sensor.
+    const uint16_t vdda_mv = TempSensor_Get_VDDA_mV();
+    return (vdda_mv != 0u) && (vdda_mv < VDDA_MIN_MV);
+}
+
+static bool Origem_Power_Good(void)
+{
+    // Borda vista pela EXTI conta mesmo que o pino j tenha voltado (glitch).
+    const bool perdido = s_borda_power_good ||
+                         (HAL_GPIO_ReadPin(POWER_GOOD_GPIO_Port, POWER_GOOD_Pin) == GPIO_PIN_RESET);
+    s_borda_power_good = false;
+
+    // Sem entrada o BQ25622 passa para a bateria; s  queda se ela no segurar.
+    // Sem leitura vlida (0 V: carregador ainda no lido no boot, ou sem resposta)
+    // quem decide  a VDDA medida pelo VREFINT.
+    const float vbat = bq_soc_get_last_vbat();
+    if (vbat <= 0.0f)
+    {
+        return perdido && Origem_Vdda();
+    }
+    return perdido && (vbat < VBAT_SUSTENTA_V);
+}
+
+static bool Origem_Bateria(void)
+{
+    const float vbat = bq_soc_get_last_vbat();
+    return (vbat > 0.0f) && (vbat < VBAT_CRITICA_V) && (bq_soc_get_last_vbus() <= VBUS_PRESENTE_V);
+}
+
+static bool Origem_Simulada(void)
+{
+    const bool simulada = s_simulada;
+    s_simulada = false;
+    return simulada;
+}
+
+static const Falha_Origem_Def_t s_origens[NUM_FALHA_ORIGENS] = {
+    [FALHA_ORIGEM_POWER_GOOD] = {"POWER_GOOD", Origem_Power_Good},
+    [FALHA_ORIGEM_BATERIA]    = {"BATERIA",    Origem_Bateria},
+    [FALHA_ORIGEM_VDDA]       = {"VDDA",       Origem_Vdda},
+    [FALHA_ORIGEM_SIMULADA]   = {"SIMULADA",   Origem_Simulada},
+};
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Emergencia(uint8_t origens);
+static void Restabelecer(void);
+static bool Ler_Slot(uint8_t slot, Falha_Energia_Registro_t* registro_out);
+static uint16_t Endereco_Slot(uint32_t sequencia);
+static uint16_t Calcular_Checksum(const Falha_Energia_Registro_t* registro);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Falha_Energia_Init(void)
+{
+    Falha_Energia_Registro_t slots[2];
+    const bool valido0 = Ler_Slot(0, &slots[0]);
+    const bool valido1 = Ler_Slot(1, &slots[1]);
+
+    if (valido0 || valido1)
+    {
+        const uint8_t mais_recente = (valido0 && (!valido1 || slots[0].sequencia > slots[1].sequencia)) ? 0u : 1u;
+        s_registro = slots[mais_recente];
+        s_registro_valido = true;
+        printf("QUEDA: ultima emergencia #%u, SoC %u.%u%%, VBAT %u mV, amostra %lu\r\n",
+               s_registro.quedas, s_registro.soc_decimos / 10u, s_registro.soc_decimos % 10u,
+               s_registro.vbat_mv, (unsigned long)s_registro.numero_amostra);
+    }
+
+#if FALHA_ENERGIA_HABILITADA
+    // O CubeMX configura o pino como entrada simples: aqui ganha a EXTI (linha 3),
+    // que acorda o MCU de WFI ou Stop na perda da entrada.
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin  = POWER_GOOD_Pin;
+    gpio.Mode = GPIO_MODE_IT_FALLING;
+    gpio.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(POWER_GOOD_GPIO_Port, &gpio);
+    HAL_NVIC_SetPriority(EXTI2_3_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(EXTI2_3_IRQn);
+#endif
+    s_tick_normal = HAL_GetTick();
+}
+
+void Falha_Energia_Process(void)
+{
+#if FALHA_ENERGIA_HABILITADA
+    uint8_t origens = 0;
+    for (uint8_t i = 0; i < NUM_FALHA_ORIGENS; i++)
+    {
+        if (s_origens[i].ativa()) origens |= (uint8_t)(1u << i);
+    }
+    s_status.origens = origens;
+
+    if (origens != 0u)
+    {
+        s_tick_normal = HAL_GetTick();
+        if (!s_status.em_falha)
+        {
+            Emergencia(origens);
+        }
+        return;
+    }
+
+    if (s_status.em_falha && (HAL_GetTick() - s_tick_normal) >= RESTABELECIMENTO_MS)
+    {
+        Restabelecer();
+    }
+#endif
+}
+
+void Falha_Energia_Sinalizar(void)
+{
+    s_borda_power_good = true;
+}
+
+void Falha_Energia_Simular(void)
+{
+    s_simulada = true;
+}
+
+bool Falha_Energia_Em_Falha(void) { return s_status.em_falha; }
+
+void Falha_Energia_Get_Status(Falha_Energia_Status_t* status_out)
+{
+    if (status_out == NULL) return;
+    *status_out = s_status;
+}
+
+const char* Falha_Energia_Get_Nome_Origem(Falha_Origem_t origem)
+{
+    return (origem < NUM_FALHA_ORIGENS) ? s_origens[origem].nome : "?";
+}
+
+bool Falha_Energia_Get_Registro(Falha_Energia_Registro_t* registro_out)
+{
+    if (registro_out == NULL || !s_registro_valido) return false;
+    *registro_out = s_registro;
+    return true;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Interrompe o no crtico, espera a pgina em curso e grava o registro.
+ */
+static void Emergencia(uint8_t origens)
+{
+    const uint32_t inicio_us = Temporizador_Get_us();
+    s_status.em_falha = true;
+    s_status.emergencias++;
+
+    // Trabalho no crtico: o lote para e nenhuma escrita nova comea. Uma cpia
+    // da configurao interrompida  recuperada pelas outras duas no boot.
+    Lote_Parar();
+    const bool interrompida = EEPROM_Driver_Abortar();
+    const uint32_t inicio_ms = HAL_GetTick();
+    while (EEPROM_Driver_IsBusy() && (HAL_GetTick() - inicio_ms) < ESPERA_PAGINA_MAX_MS)
+    {
+        EEPROM_Driver_FSM_Process();
+    }
+
+    DadosMedicao_t medicao;
+    Medicao_Get_UltimaMedicao(&medicao);
+
+    Falha_Energia_Registro_t registro = {0};
+    registro.magica               = REGISTRO_MAGICA;
+    registro.sequencia            = s_registro_valido ? (s_registro.sequencia + 1u) : 1u;
+    registro.numero_amostra       = Lote_Get_Numero_Amostra();
+    registro.soc_decimos          = (uint16_t)(bq_soc_get_percentage() * 10.0f);
+    registro.vbat_mv              = (uint16_t)(bq_soc_get_last_vbat() * 1000.0f);
+    registro.quedas               = s_registro_valido ? (uint16_t)(s_registro.quedas + 1u) : 1u;
+    registro.origens              = origens;
+    registro.escrita_interrompida = interrompida ? 1u : 0u;
+    registro.umidade              = medicao.Umidade;
+    registro.peso                 = medicao.Peso;
+    registro.checksum             = Calcular_Checksum(&registro);
+
+    // Uma pgina s, no slot oposto ao do registro anterior.
+    s_status.ultima_gravou = EEPROM_Driver_Write_Blocking(Endereco_Slot(registro.sequencia),
+                                                          (const uint8_t*)&registro, sizeof(registro));
+    if (s_status.ultima_gravou)
+    {
+        s_registro = registro;
+        s_registro_valido = true;
+    }
+
+    s_status.ultima_duracao_us = Temporizador_Get_us() - inicio_us;
+    if (s_status.ultima_duracao_us > s_status.duracao_max_us) s_status.duracao_max_us = s_status.ultima_duracao_us;
+
+    printf("QUEDA: emergencia (origens 0x%02X), escrita %s, registro %s em %lu us\r\n",
+           origens, interrompida ? "interrompida" : "ociosa",
+           s_status.ultima_gravou ? "gravado" : "FALHOU", (unsigned long)s_status.ultima_duracao_us);
+}
+
+/**
+ * @brief Energia normal por RESTABELECIMENTO_MS: libera a EEPROM. Um salvamento
+ * interrompido continua pendente e regrava as trs cpias.
+ */
+static void Restabelecer(void)
+{
+    s_status.em_falha = false;
+    EEPROM_Driver_Liberar();
+    printf("QUEDA: energia restabelecida%s\r\n",
+           Gerenciador_Config_Ha_Pendencias() ? ", regravando configuracao" : "");
+}
+
+static bool Ler_Slot(uint8_t slot, Falha_Energia_Registro_t* registro_out)
+{
+    const uint16_t addr = (uint16_t)(ADDR_ESTADO_CRITICO + (uint32_t)slot * EEPROM_PAGE_SIZE);
+    return EEPROM_Driver_Read_Blocking(addr, (uint8_t*)registro_out, sizeof(Falha_Energia_Registro_t)) &&
+           registro_out->magica == REGISTRO_MAGICA &&
+           registro_out->checksum == Calcular_Checksum(registro_out);
+}
+
+static uint16_t Endereco_Slot(uint32_t sequencia)
+{
+    return (uint16_t)(ADDR_ESTADO_CRITICO + (sequencia % 2u) * EEPROM_PAGE_SIZE);
+}
+
+/**
+ * @brief Fletcher-16 sobre o registro, exceto o prprio campo de checksum.
+ */
+static uint16_t Calcular_Checksum(const Falha_Energia_Registro_t* registro)
+{
+    const uint8_t* dados = (const uint8_t*)registro;
+    uint16_t soma1 = 0;
+    uint16_t soma2 = 0;
+    for (size_t i = 0; i < offsetof(Falha_Energia_Registro_t, checksum); i++) {
+        soma1 = (uint16_t)((soma1 + dados[i]) % 255u);
+        soma2 = (uint16_t)((soma2 + soma1) % 255u);
+    }
+    return (uint16_t)((soma2 << 8) | soma1);
+}
@@ -11,6 +11,7 @@
 #include "gerenciador_configuracoes.h"
 #include "eeprom_driver.h"
 #include "GXXX_Equacoes.h"
+#include "eventos.h"
 #include "retarget.h"
 #include <string.h>
 #include <stdio.h>
@@ -44,12 +45,72 @@ typedef enum {
 static GerenciadorFsmState_t s_mgr_state = MGR_FSM_IDLE;
 static volatile bool s_mgr_error_flag = false;
 
+// --- Verificao incremental do CRC na EEPROM ---
+#define VERIF_BLOCO_BYTES       64u
+static const uint8_t VERIF_BLOCOS_POR_PASSO = 4;
+static uint32_t s_crc_usos = 0;            // Incrementado a cada uso do CRC fora da verificao
+static uint32_t s_verif_crc_usos = 0;
+static uint32_t s_verif_offset = 0;
+static bool s_verif_ativa = false;
+
 // --- Prottipos Privados ---
 static void Recalcular_E_Atualizar_CRC_Cache(void);
 static bool Tentar_Carregar_De_Endereco(uint16_t address, Config_Aplicacao_t* config);
 
 // --- Inicializao e Status ---
 
+void Gerenciador_Config_Verificacao_Iniciar(void)
+{
+    s_verif_offset = 0;
+    s_verif_crc_usos = s_crc_usos;
+    s_verif_ativa = true;
+}
+
+Config_Verificacao_t Gerenciador_Config_Verificacao_Passo(void)
+{
+    if (!s_verif_ativa || s_crc_handle == NULL) return CFG_VERIF_FALHA;
+
+    // EEPROM ocupada com um salvamento: tenta no prximo passo.
+    if (s_mgr_state != MGR_FSM_IDLE || EEPROM_Driver_IsBusy()) return CFG_VERIF_EM_ANDAMENTO;
+
+    // Algum recalculou um CRC: o acumulador do perifrico foi perdido.
+    if (s_crc_usos != s_verif_crc_usos)
+    {
+        Gerenciador_Config_Verificacao_Iniciar();
+    }
+
+    const uint32_t tamanho_dados_crc = offsetof(Config_Aplicacao_t, crc);
+    uint32_t bloco[VERIF_BLOCO_BYTES / 4];
+    uint32_t crc_parcial = 0;
+
+    for (uint8_t i = 0; i < VERIF_BLOCOS_POR_PASSO && s_verif_offset < tamanho_dados_crc; i++)
+    {
+        uint32_t restante = tamanho_dados_crc - s_verif_offset;
+        uint16_t tamanho = (restante < VERIF_BLOCO_BYTES) ? (uint16_t)restante : (uint16_t)VERIF_BLOCO_BYTES;
+
+        if (!EEPROM_Driver_Read_Blocking((uint16_t)(ADDR_CONFIG_PRIMARY + s_verif_offset), (uint8_t*)bloco, tamanho))
+        {
+            s_verif_ativa = false;
+            return CFG_VERIF_FALHA;
+        }
+
+        crc_parcial = (s_verif_offset == 0)
+                    ? HAL_CRC_Calculate(s_crc_handle, bloco, tamanho / 4u)
+                    : HAL_CRC_Accumulate(s_crc_handle, bloco, tamanho / 4u);
+        s_verif_offset += tamanho;
+    }
+
+    if (s_verif_offset < tamanho_dados_crc) return CFG_VERIF_EM_ANDAMENTO;
+
+    uint32_t crc_armazenado = 0;
+    s_verif_ativa = false;
+    if (!EEPROM_Driver_Read_Blocking((uint16_t)(ADDR_CONFIG_PRIMARY + tamanho_dados_crc), (uint8_t*)&crc_armazenado, sizeof(crc_armazenado)))
+    {
+        return CFG_VERIF_FALHA;
+    }
+    return (crc_parcial == crc_armazenado) ? CFG_VERIF_OK : CFG_VERIF_FALHA;
+}
+
 void Gerenciador_Config_Init(CRC_HandleTypeDef* hcrc) {
     s_crc_handle = hcrc;
     s_config_dirty = false;
@@ -103,6 +164,7 @@ bool Gerenciador_Config_Salvar_Agora(void) {
     if (success) {
         printf("Salvamento sincrono completo com sucesso.\r\n");
         s_config_dirty = false;
+        Eventos_Publicar(EVT_CONFIG_ALTERADA, 0, NULL, 0);
     }
     
     return success;
@@ -117,6 +179,19 @@ void Gerenciador_Config_Run_FSM(void)
 {
     // 1. Sempre processa o driver de baixo nvel
     EEPROM_Driver_FSM_Process();
+
+    // Queda de energia: a cpia interrompida pode ter ficado pela metade, mas
+    // as outras duas esto ntegras (antigas ou novas) e a validao do boot
+    // escolhe uma delas. A pendncia fica marcada: depois de liberada, a EEPROM
+    // recebe as trs cpias de novo.
+    if (EEPROM_Driver_Is_Abortado()) {
+        if (s_mgr_state != MGR_FSM_IDLE && !EEPROM_Driver_IsBusy()) {
+            EEPROM_Driver_GetAndClearErrorFlag();
+            printf("FSM Gerenciador: Salvamento interrompido por queda de energia.\r\n");
+            s_mgr_state = MGR_FSM_IDLE;
+        }
+        return;
+    }
     
     // 2. Verifica se o driver de baixo nvel est ocupado
     if (EEPROM_Driver_IsBusy()) {
@@ -206,6 +281,7 @@ void Gerenciador_Config_Run_FSM(void)
             printf("FSM Gerenciador: Salvamento assincrono concluido.\r\n");
             s_config_dirty = false; // Limpa a flag, sinalizando para o display_handler
             s_mgr_state = MGR_FSM_IDLE;
+            Eventos_Publicar(EVT_CONFIG_ALTERADA, 0, NULL, 0);
             break;
 
         case MGR_FSM_ERROR:
@@ -271,7 +347,7 @@ void Carregar_Configuracao_Padrao(void)
     {
         strncpy(s_config_cache.graos[i].nome, Produto[i].Nome[0], MAX_NOME_GRAO_LEN);
         s_config_cache.graos[i].nome[MAX_NOME_GRAO_LEN] = '\0';
-        strncpy(s_config_cache.graos[i].validade, "22/06/2028", MAX_VALIDADE_LEN);
+        snprintf(s_config_cache.graos[i].validade, sizeof(s_config_cache.graos[i].validade), "%s", "22/06/2028");
         s_config_cache.graos[i].validade[MAX_VALIDADE_LEN] = '\0';
         s_config_cache.graos[i].id_curva = Produto[i].Nr_Equa;
         s_config_cache.graos[i].umidade_min = Produto[i].Um_Min;
@@ -432,6 +508,7 @@ static void Recalcular_E_Atualizar_CRC_Cache(void)
     // O clculo do CRC  feito sobre todos os dados da struct EXCETO o prprio campo do CRC
     uint32_t tamanho_dados_crc = offsetof(Config_Aplicacao_t, crc);
     uint32_t novo_crc = HAL_CRC_Calculate(s_crc_handle, (uint32_t*)&s_config_cache, tamanho_dados_crc / 4);
+    s_crc_usos++;
     s_config_cache.crc = novo_crc;
 }
 
@@ -447,6 +524,7 @@ static bool Tentar_Carregar_De_Endereco(uint16_t address, Config_Aplicacao_t* co
     uint32_t crc_armazenado = config_out->crc;
     uint32_t tamanho_dados_crc = offsetof(Config_Aplicacao_t, crc);
     uint32_t crc_calculado = HAL_CRC_Calculate(s_crc_handle, (uint32_t*)config_out, tamanho_dados_crc / 4);
+    s_crc_usos++;
 
     if(crc_calculado == crc_armazenado)
     {
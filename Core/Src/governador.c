@@ -0,0 +1,290 @@
+/*******************************************************************************
+ * @file        governador.c
+ * @brief       Governador de clock por demanda e carga.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A ocupao vem da residncia do gerenciador de energia: tempo
+ * executando sobre o tempo total do perodo, filtrada. No cheio a carga
+ * prevista para o reduzido  4x maior; acima de CARGA_MAX_PERMIL o ncleo
+ * ficaria saturado e a descida  impedida. As correntes do modelo so as
+ * tpicas do datasheet do STM32C071 (s o MCU, sem perifricos externos).
+ ******************************************************************************/
+
+#include "governador.h"
+#include "app_manager.h"
+#include "cli_driver.h"
+#include "controller.h"
+#include "dwin_driver.h"
+#include "eeprom_driver.h"
+#include "gerenciador_configuracoes.h"
+#include "lote_handler.h"
+#include "ads1232_driver.h"
+#include "servo_controle.h"
+#include "main.h"
+#include <string.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+typedef struct {
+    const char* nome;
+    bool        (*ativa)(void);
+} Governador_Demanda_t;
+
+static const uint32_t GANHO_CLOCK       = 4;       // Cheio / reduzido
+static const uint32_t CARGA_MAX_PERMIL  = 600;
+static const uint32_t TOQUE_OCIOSO_MS   = 3000;
+
+// Corrente do MCU (uA) executando e em WFI, por clock.
+static const uint32_t CORRENTE_RUN_UA[NUM_CLOCKS_ENERGIA]   = {4400u, 1300u};
+static const uint32_t CORRENTE_SLEEP_UA[NUM_CLOCKS_ENERGIA] = {1200u,  400u};
+static const uint64_t UA_MS_POR_UAH = 3600000u;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static Governador_Relatorio_t s_rel;
+static uint32_t s_tick_demanda = 0;
+static uint32_t s_tick_toque = 0;
+static uint32_t s_rx_pacotes = 0;
+static uint64_t s_ultimo_exec_us = 0;
+static uint64_t s_ultimo_sleep_us = 0;
+static uint64_t s_ultimo_stop_us = 0;
+static uint64_t s_carga_ua_ms = 0;
+static int64_t  s_economia_ua_ms = 0;
+
+//==============================================================================
+// Demandas
+//==============================================================================
+
+static bool Demanda_Usb(void)
+{
+    // Host presente e barramento ativo: trfego do CLI a qualquer momento.
+    return CLI_Is_USB_Connected();
+}
+
+static bool Demanda_Medicao(void)
+{
+    return Lote_Is_Ativo() || ADS1232_Tare_Em_Andamento();
+}
+
+static bool Demanda_Eeprom(void)
+{
+    return EEPROM_Driver_IsBusy() || Gerenciador_Config_Ha_Pendencias();
+}
+
+static bool Demanda_Servos(void)
+{
+    const ServoStep_t passo = Servos_Get_Step();
+    return (passo != SERVO_STEP_IDLE && passo != SERVO_STEP_FINISHED);
+}
+
+static bool Demanda_Tela(void)
+{
+    return Controller_GetCurrentScreen() != PRINCIPAL;
+}
+
+static bool Demanda_Toque(void)
+{
+    // Sem efeito colateral: tambm vale na previso. O Process registra o toque.
+    return (DWIN_Driver_GetRxPacketCounter() != s_rx_pacotes) ||
+           (HAL_GetTick() - s_tick_toque) < TOQUE_OCIOSO_MS;
+}
+
+static bool Demanda_Carga(void)
+{
+    const uint32_t prevista = (s_rel.clock == ENERGIA_CLOCK_CHEIO) ? s_rel.carga_permil * GANHO_CLOCK : s_rel.carga_permil;
+    return prevista > CARGA_MAX_PERMIL;
+}
+
+static const Governador_Demanda_t s_demandas[] = {
+    {"USB",     Demanda_Usb},
+    {"MEDICAO", Demanda_Medicao},
+    {"EEPROM",  Demanda_Eeprom},
+    {"SERVOS",  Demanda_Servos},
+    {"TELA",    Demanda_Tela},
+    {"TOQUE",   Demanda_Toque},
+    {"CARGA",   Demanda_Carga},
+};
+
+#define NUM_DEMANDAS  (sizeof(s_demandas) / sizeof(s_demandas[0]))
+
+static uint32_t s_subidas[NUM_DEMANDAS];
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Contabilizar_Periodo(void);
+static void Trocar(Energia_Clock_t clock);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Governador_Init(void)
+{
+    s_rx_pacotes = DWIN_Driver_GetRxPacketCounter();
+    s_tick_toque = HAL_GetTick();
+    Governador_Zerar();
+}
+
+void Governador_Process(void)
+{
+    Contabilizar_Periodo();
+
+    const uint32_t pacotes = DWIN_Driver_GetRxPacketCounter();
+    if (pacotes != s_rx_pacotes)
+    {
+        s_rx_pacotes = pacotes;
+        s_tick_toque = HAL_GetTick();
+    }
+
+    uint8_t demandas = 0;
+    for (uint8_t i = 0; i < NUM_DEMANDAS; i++)
+    {
+        if (s_demandas[i].ativa()) demandas |= (uint8_t)(1u << i);
+    }
+    s_rel.demandas = demandas;
+
+    // Desabilitado: s mede (residncia e demandas) e fica no clock cheio.
+    if (!GOVERNADOR_HABILITADO) return;
+
+    if (demandas != 0u)
+    {
+        s_tick_demanda = HAL_GetTick();
+        if (s_rel.clock == ENERGIA_CLOCK_REDUZIDO)
+        {
+            for (uint8_t i = 0; i < NUM_DEMANDAS; i++)
+            {
+                if (demandas & (1u << i)) s_subidas[i]++;
+            }
+            Trocar(ENERGIA_CLOCK_CHEIO);
+        }
+        return;
+    }
+
+    if (s_rel.clock == ENERGIA_CLOCK_CHEIO && (HAL_GetTick() - s_tick_demanda) >= GOVERNADOR_DESCIDA_MS)
+    {
+        Trocar(ENERGIA_CLOCK_REDUZIDO);
+    }
+}
+
+uint32_t Governador_Get_Proximo_ms(void)
+{
+    if (!GOVERNADOR_HABILITADO) return UINT32_MAX;
+
+    for (uint8_t i = 0; i < NUM_DEMANDAS; i++)
+    {
+        if (s_demandas[i].ativa()) return 0;
+    }
+    if (Energia_Get_Clock() != ENERGIA_CLOCK_CHEIO) return UINT32_MAX;
+
+    const uint32_t decorrido = HAL_GetTick() - s_tick_demanda;
+    return (decorrido >= GOVERNADOR_DESCIDA_MS) ? 0 : (GOVERNADOR_DESCIDA_MS - decorrido);
+}
+
+void Governador_Get_Relatorio(Governador_Relatorio_t* relatorio_out)
+{
+    if (relatorio_out == NULL) return;
+
+    *relatorio_out = s_rel;
+    relatorio_out->carga_uAh = (uint32_t)(s_carga_ua_ms / UA_MS_POR_UAH);
+    relatorio_out->economia_uAh = (s_economia_ua_ms > 0) ? (uint32_t)((uint64_t)s_economia_ua_ms / UA_MS_POR_UAH) : 0u;
+}
+
+uint8_t Governador_Get_Num_Demandas(void) { return (uint8_t)NUM_DEMANDAS; }
+
+const char* Governador_Get_Nome_Demanda(uint8_t indice)
+{
+    return (indice < NUM_DEMANDAS) ? s_demandas[indice].nome : "?";
+}
+
+uint32_t Governador_Get_Subidas(uint8_t indice)
+{
+    return (indice < NUM_DEMANDAS) ? s_subidas[indice] : 0;
+}
+
+void Governador_Zerar(void)
+{
+    const Energia_Clock_t clock = Energia_Get_Clock();
+    memset(&s_rel, 0, sizeof(s_rel));
+    memset(s_subidas, 0, sizeof(s_subidas));
+    s_rel.clock = clock;
+    s_carga_ua_ms = 0;
+    s_economia_ua_ms = 0;
+    s_tick_demanda = HAL_GetTick();
+
+    Energia_Residencia_t res;
+    Energia_Get_Residencia(ENERGIA_EXECUTANDO, &res);
+    s_ultimo_exec_us = res.tempo_us;
+    Energia_Get_Residencia(ENERGIA_SLEEP, &res);
+    s_ultimo_sleep_us = res.tempo_us;
+    Energia_Get_Residencia(ENERGIA_STOP, &res);
+    s_ultimo_stop_us = res.tempo_us;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Atribui ao clock atual o tempo executando e em WFI desde a ltima
+ * passada e atualiza a carga filtrada e as estimativas de carga eltrica.
+ * O clock s muda aqui (ou fora do estado ativo, que zera a base no retorno).
+ */
+static void Contabilizar_Periodo(void)
+{
+    Energia_Residencia_t exec, sleep, stop;
+    Energia_Get_Residencia(ENERGIA_EXECUTANDO, &exec);
+    Energia_Get_Residencia(ENERGIA_SLEEP, &sleep);
+    Energia_Get_Residencia(ENERGIA_STOP, &stop);
+
+    const uint64_t d_exec  = exec.tempo_us  - s_ultimo_exec_us;
+    const uint64_t d_sleep = sleep.tempo_us - s_ultimo_sleep_us;
+    const uint64_t d_stop  = stop.tempo_us  - s_ultimo_stop_us;
+    s_ultimo_exec_us  = exec.tempo_us;
+    s_ultimo_sleep_us = sleep.tempo_us;
+    s_ultimo_stop_us  = stop.tempo_us;
+
+    // O clock pode ter mudado fora do governador (sequncia de Stop): o perodo
+    // fica com o clock real no fim dele.
+    const Energia_Clock_t clock = Energia_Get_Clock();
+    s_rel.clock = clock;
+
+    const uint64_t total = d_exec + d_sleep + d_stop;
+    if (total == 0u) return;
+
+    const uint32_t carga = (uint32_t)((d_exec * 1000u) / total);
+    s_rel.carga_permil = (s_rel.carga_permil * 3u + carga) / 4u;
+
+    s_rel.residencia[clock].executando_us += d_exec;
+    s_rel.residencia[clock].sleep_us      += d_sleep;
+
+    const uint64_t real = (d_exec * CORRENTE_RUN_UA[clock] + d_sleep * CORRENTE_SLEEP_UA[clock]) / 1000u;
+    s_carga_ua_ms += real;
+
+    if (clock == ENERGIA_CLOCK_REDUZIDO)
+    {
+        // O mesmo trabalho no cheio: 1/4 do tempo executando, o resto em WFI.
+        const uint64_t exec_cheio = d_exec / GANHO_CLOCK;
+        const uint64_t cheio = (exec_cheio * CORRENTE_RUN_UA[ENERGIA_CLOCK_CHEIO] +
+                                (d_exec - exec_cheio + d_sleep) * CORRENTE_SLEEP_UA[ENERGIA_CLOCK_CHEIO]) / 1000u;
+        s_economia_ua_ms += (int64_t)cheio - (int64_t)real;
+    }
+}
+
+static void Trocar(Energia_Clock_t clock)
+{
+    if (!Energia_Clock_Pode_Trocar())
+    {
+        s_rel.adiadas++;    // Tenta de novo na prxima passada
+        return;
+    }
+    Energia_Set_Clock(clock);
+    s_rel.clock = clock;
+    s_rel.trocas++;
+    s_rel.residencia[clock].entradas++;
+}
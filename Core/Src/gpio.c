@@ -57,7 +57,7 @@ void MX_GPIO_Init(void)
   HAL_GPIO_WritePin(AD_SCLK_BAL_GPIO_Port, AD_SCLK_BAL_Pin, GPIO_PIN_RESET);
 
   /*Configure GPIO pin Output Level */
-  HAL_GPIO_WritePin(GPIOB, AD_PDWN_BAL_Pin|PESO_TEMP_Pin|TEMP_CHIP_Pin|HAB_TOUCH_Pin, GPIO_PIN_RESET);
+  HAL_GPIO_WritePin(GPIOB, AD_PDWN_BAL_Pin|PESO_TEMP_Pin|HAB_TOUCH_Pin, GPIO_PIN_RESET);
 
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(GPIOD, POWER_SEL_Pin|CHIP_DISABLE_Pin, GPIO_PIN_RESET);
@@ -82,8 +82,8 @@ void MX_GPIO_Init(void)
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(AD_DOUT_BAL_GPIO_Port, &GPIO_InitStruct);
 
-  /*Configure GPIO pins : AD_PDWN_BAL_Pin PESO_TEMP_Pin TEMP_CHIP_Pin HAB_TOUCH_Pin */
-  GPIO_InitStruct.Pin = AD_PDWN_BAL_Pin|PESO_TEMP_Pin|TEMP_CHIP_Pin|HAB_TOUCH_Pin;
+  /*Configure GPIO pins : AD_PDWN_BAL_Pin PESO_TEMP_Pin HAB_TOUCH_Pin */
+  GPIO_InitStruct.Pin = AD_PDWN_BAL_Pin|PESO_TEMP_Pin|HAB_TOUCH_Pin;
   GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
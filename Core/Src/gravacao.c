@@ -0,0 +1,488 @@
+/*******************************************************************************
+ * @file        gravacao.c
+ * @brief       Gravao e reproduo das entradas do equipamento.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Gravao: os registros entram num par de pginas em RAM; a
+ * corrotina do gravador escreve cada pgina cheia na EEPROM pela FSM
+ * assncrona, cedendo a vez  configurao e ao histrico de lotes. Ao
+ * parar, descarrega a pgina parcial e s ento grava o cabealho (que
+ * foi invalidado no incio), de modo que uma gravao interrompida por
+ * falta de energia nunca  reproduzida.
+ *
+ * Reproduo: um temporizador de 1 ms l os registros (leitura bloqueante
+ * de uma pgina por vez, s com a EEPROM livre) e os despacha quando o
+ * tempo acumulado vence. Pacotes do display voltam pela fila de eventos,
+ * linhas pelo driver do CLI; ADS e TIM2 substituem o hardware na medio.
+ ******************************************************************************/
+
+#include "gravacao.h"
+
+#if GRAVACAO_HABILITADA
+
+#include "main.h"
+#include "eeprom_driver.h"
+#include "gerenciador_configuracoes.h"
+#include "temporizador.h"
+#include "corrotina.h"
+#include "eventos.h"
+#include "cli_driver.h"
+#include "pcb_frequency.h"
+#include <string.h>
+#include <stdio.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+#define GRAVACAO_MAGICA         0x31565247u                     // "GRV1"
+#define ADDR_GRAVACAO_DADOS     (ADDR_GRAVACAO + EEPROM_PAGE_SIZE)
+#define GRAVACAO_CAPACIDADE     ((uint32_t)(END_OF_GRAVACAO - ADDR_GRAVACAO_DADOS))
+#define REGISTRO_DADOS_MAX      128u                            // Linha do CLI / pacote DWIN
+#define REGISTRO_MAX_BYTES      (1u + 5u + 1u + REGISTRO_DADOS_MAX)
+
+_Static_assert(END_OF_HISTORICO <= ADDR_GRAVACAO, "Regiao de gravacao sobrepoe o historico de lotes");
+_Static_assert((ADDR_GRAVACAO % EEPROM_PAGE_SIZE) == 0, "Regiao de gravacao deve ser alinhada a pagina");
+
+typedef struct {
+    uint32_t magica;        // 0 enquanto a gravao no foi fechada
+    uint32_t tamanho;       // Bytes de registros
+    uint32_t registros;
+    uint32_t duracao_ms;
+    uint32_t descartados;
+} Gravacao_Cabecalho_t;
+
+typedef struct {
+    Gravacao_Tipo_t tipo;
+    uint32_t        tempo_ms;   // Desde o incio da gravao
+    uint16_t        tamanho;
+    uint8_t         dados[REGISTRO_DADOS_MAX];
+} Gravacao_Registro_t;
+
+static const uint32_t GRAVADOR_PERIODO_MS  = 5;
+static const uint32_t REPRODUCAO_PERIODO_MS = 1;
+static const uint8_t  REPRODUCAO_POR_TICK  = 4;   // Limita rajadas (fila de eventos tem 8 posies)
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+// Gravao: enche uma pgina enquanto a outra vai para a EEPROM.
+// Reproduo: s_paginas[0]  o buffer de leitura.
+static uint8_t s_paginas[2][EEPROM_PAGE_SIZE];
+static Gravacao_Cabecalho_t s_cabecalho;
+static Temporizador_Id_t s_tmr_gravador;
+static Temporizador_Id_t s_tmr_reproducao;
+static uint32_t s_tick_inicio = 0;
+
+// --- Gravao ---
+static Corrotina_t s_cr_gravador;
+static bool     s_gravando = false;
+static bool     s_parando = false;
+static uint8_t  s_pag_atual = 0;
+static uint16_t s_pag_ocupacao = 0;
+static int8_t   s_pag_pronta = -1;            // Pgina aguardando a EEPROM (-1 = nenhuma)
+static uint16_t s_pag_pronta_tamanho = 0;
+static uint32_t s_addr_escrita = 0;
+static uint32_t s_tick_anterior = 0;
+static uint32_t s_ultima_contagem = 0;
+
+// --- Reproduo ---
+static bool     s_reproduzindo = false;
+static uint32_t s_r_addr = 0;
+static uint32_t s_r_restantes = 0;
+static uint16_t s_r_pos = 0;
+static uint16_t s_r_validos = 0;
+static Gravacao_Registro_t s_proximo;
+static bool     s_proximo_valido = false;
+static bool     s_ads_pendente = false;
+static int32_t  s_ads_amostra = 0;
+static uint32_t s_pulsos = 0;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Gravar_Registro(Gravacao_Tipo_t tipo, const uint8_t* carga, uint16_t tamanho);
+static Cr_Estado_t Gravador(Corrotina_t* cr);
+static void Gravador_Tick(void);
+static bool EEPROM_Livre(void);
+static void Reproducao_Tick(void);
+static bool Ler_Byte(uint8_t* byte_out);
+static bool Ler_Registro(Gravacao_Registro_t* registro);
+static void Despachar(const Gravacao_Registro_t* registro);
+static void Encerrar_Reproducao(const char* motivo);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Gravacao_Init(void)
+{
+    s_tmr_gravador = Temporizador_Criar(Gravador_Tick, true);
+    s_tmr_reproducao = Temporizador_Criar(Reproducao_Tick, true);
+}
+
+bool Gravacao_Iniciar(void)
+{
+    if (s_gravando || s_reproduzindo) return false;
+
+    memset(&s_cabecalho, 0, sizeof(s_cabecalho));
+    s_pag_atual = 0;
+    s_pag_ocupacao = 0;
+    s_pag_pronta = -1;
+    s_addr_escrita = ADDR_GRAVACAO_DADOS;
+    s_tick_inicio = HAL_GetTick();
+    s_tick_anterior = s_tick_inicio;
+    s_ultima_contagem = Frequency_Get_Pulse_Count();
+    s_parando = false;
+    s_gravando = true;
+
+    CR_INICIALIZAR(&s_cr_gravador);
+    Temporizador_Iniciar(s_tmr_gravador, GRAVADOR_PERIODO_MS);
+    return true;
+}
+
+void Gravacao_Parar(void)
+{
+    if (s_gravando) s_parando = true;
+}
+
+bool Gravacao_Reproduzir(void)
+{
+    if (s_gravando || s_reproduzindo || EEPROM_Driver_IsBusy()) return false;
+
+    Gravacao_Cabecalho_t cabecalho;
+    if (!EEPROM_Driver_Read_Blocking(ADDR_GRAVACAO, (uint8_t*)&cabecalho, sizeof(cabecalho)) ||
+        cabecalho.magica != GRAVACAO_MAGICA || cabecalho.tamanho > GRAVACAO_CAPACIDADE)
+    {
+        return false;
+    }
+
+    s_cabecalho = cabecalho;
+    s_r_addr = ADDR_GRAVACAO_DADOS;
+    s_r_restantes = cabecalho.tamanho;
+    s_r_pos = 0;
+    s_r_validos = 0;
+    s_proximo.tempo_ms = 0;
+    s_proximo_valido = false;
+    s_ads_pendente = false;
+    s_pulsos = Frequency_Get_Pulse_Count();   // Continua de onde o TIM2 estava: a medio s usa diferenas
+    s_tick_inicio = HAL_GetTick();
+    s_reproduzindo = true;
+
+    Temporizador_Iniciar(s_tmr_reproducao, REPRODUCAO_PERIODO_MS);
+    return true;
+}
+
+void Gravacao_Parar_Reproducao(void)
+{
+    if (s_reproduzindo) Encerrar_Reproducao("interrompida");
+}
+
+bool Gravacao_Reproduzindo(void) { return s_reproduzindo; }
+
+void Gravacao_Registrar_Bytes(Gravacao_Tipo_t tipo, const void* dados, uint16_t tamanho)
+{
+    if (!s_gravando || dados == NULL) return;
+    if (tamanho > REGISTRO_DADOS_MAX)
+    {
+        s_cabecalho.descartados++;
+        return;
+    }
+
+    uint8_t carga[1u + REGISTRO_DADOS_MAX];
+    carga[0] = (uint8_t)tamanho;
+    memcpy(&carga[1], dados, tamanho);
+    Gravar_Registro(tipo, carga, (uint16_t)(tamanho + 1u));
+}
+
+void Gravacao_Registrar_Ads(int32_t amostra)
+{
+    if (!s_gravando) return;
+
+    const uint8_t carga[3] = { (uint8_t)amostra, (uint8_t)(amostra >> 8), (uint8_t)(amostra >> 16) };
+    Gravar_Registro(GRV_ADS_AMOSTRA, carga, sizeof(carga));
+}
+
+void Gravacao_Registrar_Pulsos(uint32_t contagem)
+{
+    if (!s_gravando) return;
+
+    uint32_t pulsos = contagem - s_ultima_contagem;
+    s_ultima_contagem = contagem;
+    if (pulsos > 0xFFFFFFu) pulsos = 0xFFFFFFu;   // > 160 ms a 100 MHz: no ocorre na medio
+
+    const uint8_t carga[3] = { (uint8_t)pulsos, (uint8_t)(pulsos >> 8), (uint8_t)(pulsos >> 16) };
+    Gravar_Registro(GRV_TIM2_PULSOS, carga, sizeof(carga));
+}
+
+bool Gravacao_Get_Amostra_Ads(int32_t* amostra_out)
+{
+    if (!s_ads_pendente || amostra_out == NULL) return false;
+
+    s_ads_pendente = false;
+    *amostra_out = s_ads_amostra;
+    return true;
+}
+
+uint32_t Gravacao_Get_Pulsos(void) { return s_pulsos; }
+
+void Gravacao_Get_Status(Gravacao_Status_t* status_out)
+{
+    if (status_out == NULL) return;
+
+    status_out->gravando     = s_gravando;
+    status_out->reproduzindo = s_reproduzindo;
+    status_out->bytes        = s_reproduzindo ? s_r_restantes : s_cabecalho.tamanho;
+    status_out->capacidade   = GRAVACAO_CAPACIDADE;
+    status_out->registros    = s_cabecalho.registros;
+    status_out->descartados  = s_cabecalho.descartados;
+    status_out->duracao_ms   = (s_gravando || s_reproduzindo) ? (HAL_GetTick() - s_tick_inicio) : s_cabecalho.duracao_ms;
+}
+
+//==============================================================================
+// Gravao
+//==============================================================================
+
+/**
+ * @brief Codifica o registro e copia para as pginas em RAM. Descarta o
+ * registro inteiro se no couber (nunca grava registro pela metade).
+ */
+static void Gravar_Registro(Gravacao_Tipo_t tipo, const uint8_t* carga, uint16_t tamanho)
+{
+    if (s_parando) return;
+
+    uint8_t registro[REGISTRO_MAX_BYTES];
+    uint16_t n = 0;
+    const uint32_t agora = HAL_GetTick();
+    uint32_t delta = agora - s_tick_anterior;
+
+    registro[n++] = (uint8_t)tipo;
+    do {
+        uint8_t byte = (uint8_t)(delta & 0x7Fu);
+        delta >>= 7;
+        registro[n++] = (delta != 0u) ? (uint8_t)(byte | 0x80u) : byte;
+    } while (delta != 0u);
+    memcpy(&registro[n], carga, tamanho);
+    n = (uint16_t)(n + tamanho);
+
+    if (s_cabecalho.tamanho + n > GRAVACAO_CAPACIDADE)
+    {
+        s_cabecalho.descartados++;
+        printf("GRAVACAO: regiao cheia, encerrando.\r\n");
+        Gravacao_Parar();
+        return;
+    }
+
+    const uint16_t livre = (uint16_t)((EEPROM_PAGE_SIZE - s_pag_ocupacao) + ((s_pag_pronta < 0) ? EEPROM_PAGE_SIZE : 0));
+    if (n > livre)
+    {
+        s_cabecalho.descartados++;   // EEPROM ainda gravando a pgina anterior
+        return;
+    }
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        s_paginas[s_pag_atual][s_pag_ocupacao++] = registro[i];
+        if (s_pag_ocupacao == EEPROM_PAGE_SIZE)
+        {
+            s_pag_pronta = (int8_t)s_pag_atual;
+            s_pag_pronta_tamanho = EEPROM_PAGE_SIZE;
+            s_pag_atual ^= 1u;
+            s_pag_ocupacao = 0;
+        }
+    }
+
+    s_tick_anterior = agora;
+    s_cabecalho.tamanho += n;
+    s_cabecalho.registros++;
+}
+
+/** @brief Configurao e histrico de lotes tm prioridade sobre a gravao. */
+static bool EEPROM_Livre(void)
+{
+    return !EEPROM_Driver_IsBusy() && !Gerenciador_Config_Ha_Pendencias();
+}
+
+static Cr_Estado_t Gravador(Corrotina_t* cr)
+{
+    static const Gravacao_Cabecalho_t s_cabecalho_invalido = {0};
+
+    CR_INICIO(cr);
+
+    // A regio de dados vai ser sobrescrita: invalida a gravao anterior.
+    CR_AGUARDAR_ATE(cr, EEPROM_Livre() &&
+                        EEPROM_Driver_Write_Async_Start(ADDR_GRAVACAO, (const uint8_t*)&s_cabecalho_invalido, sizeof(s_cabecalho_invalido)));
+    CR_AGUARDAR_ATE(cr, !EEPROM_Driver_IsBusy());
+
+    for (;;)
+    {
+        CR_AGUARDAR_ATE(cr, s_pag_pronta >= 0 || s_parando);
+        if (s_pag_pronta < 0)
+        {
+            if (s_pag_ocupacao == 0) break;
+            s_pag_pronta = (int8_t)s_pag_atual;          // ltima pgina, parcial
+            s_pag_pronta_tamanho = s_pag_ocupacao;
+            s_pag_ocupacao = 0;
+        }
+
+        CR_AGUARDAR_ATE(cr, EEPROM_Livre() &&
+                            EEPROM_Driver_Write_Async_Start((uint16_t)s_addr_escrita, s_paginas[s_pag_pronta], s_pag_pronta_tamanho));
+        CR_AGUARDAR_ATE(cr, !EEPROM_Driver_IsBusy());
+        s_addr_escrita += EEPROM_PAGE_SIZE;
+        s_pag_pronta = -1;
+    }
+
+    s_cabecalho.magica = GRAVACAO_MAGICA;
+    s_cabecalho.duracao_ms = s_tick_anterior - s_tick_inicio;
+    CR_AGUARDAR_ATE(cr, EEPROM_Livre() &&
+                        EEPROM_Driver_Write_Async_Start(ADDR_GRAVACAO, (const uint8_t*)&s_cabecalho, sizeof(s_cabecalho)));
+    CR_AGUARDAR_ATE(cr, !EEPROM_Driver_IsBusy());
+
+    CR_FIM(cr);
+}
+
+static void Gravador_Tick(void)
+{
+    if (Gravador(&s_cr_gravador) == CR_TERMINOU)
+    {
+        Temporizador_Parar(s_tmr_gravador);
+        s_gravando = false;
+        s_parando = false;
+        printf("GRAVACAO: %lu registros, %lu bytes, %lu ms, %lu descartados.\r\n",
+               (unsigned long)s_cabecalho.registros, (unsigned long)s_cabecalho.tamanho,
+               (unsigned long)s_cabecalho.duracao_ms, (unsigned long)s_cabecalho.descartados);
+    }
+}
+
+//==============================================================================
+// Reproduo
+//==============================================================================
+
+static void Reproducao_Tick(void)
+{
+    const uint32_t decorrido = HAL_GetTick() - s_tick_inicio;
+
+    for (uint8_t i = 0; i < REPRODUCAO_POR_TICK; i++)
+    {
+        if (!s_proximo_valido)
+        {
+            if (s_r_restantes == 0)
+            {
+                Encerrar_Reproducao("concluida");
+                return;
+            }
+            if (EEPROM_Driver_IsBusy()) return;   // Escrita de outro mdulo no barramento
+            if (!Ler_Registro(&s_proximo))
+            {
+                Encerrar_Reproducao("registro invalido");
+                return;
+            }
+            s_proximo_valido = true;
+        }
+
+        if (s_proximo.tempo_ms > decorrido) return;
+
+        Despachar(&s_proximo);
+        s_proximo_valido = false;
+    }
+}
+
+static bool Ler_Byte(uint8_t* byte_out)
+{
+    if (s_r_restantes == 0) return false;
+
+    if (s_r_pos >= s_r_validos)
+    {
+        const uint16_t n = (s_r_restantes < EEPROM_PAGE_SIZE) ? (uint16_t)s_r_restantes : (uint16_t)EEPROM_PAGE_SIZE;
+        if (!EEPROM_Driver_Read_Blocking((uint16_t)s_r_addr, s_paginas[0], n)) return false;
+        s_r_addr += n;
+        s_r_pos = 0;
+        s_r_validos = n;
+    }
+
+    *byte_out = s_paginas[0][s_r_pos++];
+    s_r_restantes--;
+    return true;
+}
+
+static bool Ler_Registro(Gravacao_Registro_t* registro)
+{
+    uint8_t tipo;
+    uint8_t byte;
+    uint32_t delta = 0;
+    uint8_t deslocamento = 0;
+
+    if (!Ler_Byte(&tipo) || tipo >= NUM_TIPOS_GRAVACAO) return false;
+
+    do {
+        if (deslocamento > 28u || !Ler_Byte(&byte)) return false;
+        delta |= (uint32_t)(byte & 0x7Fu) << deslocamento;
+        deslocamento = (uint8_t)(deslocamento + 7u);
+    } while ((byte & 0x80u) != 0u);
+
+    registro->tipo = (Gravacao_Tipo_t)tipo;
+    registro->tempo_ms += delta;
+
+    if (tipo == GRV_DWIN_RX || tipo == GRV_CLI_LINHA)
+    {
+        if (!Ler_Byte(&byte) || byte > REGISTRO_DADOS_MAX) return false;
+        registro->tamanho = byte;
+    }
+    else
+    {
+        registro->tamanho = 3;
+    }
+
+    for (uint16_t i = 0; i < registro->tamanho; i++)
+    {
+        if (!Ler_Byte(&registro->dados[i])) return false;
+    }
+    return true;
+}
+
+static void Despachar(const Gravacao_Registro_t* registro)
+{
+    const uint32_t valor24 = (uint32_t)registro->dados[0] |
+                             ((uint32_t)registro->dados[1] << 8) |
+                             ((uint32_t)registro->dados[2] << 16);
+
+    switch (registro->tipo)
+    {
+        case GRV_DWIN_RX:
+            Eventos_Publicar(EVT_TOQUE_DWIN, 0, registro->dados, registro->tamanho);
+            break;
+
+        case GRV_CLI_LINHA:
+            for (uint16_t i = 0; i < registro->tamanho; i++)
+            {
+                CLI_Receive_Char(registro->dados[i]);
+            }
+            CLI_Receive_Char('\r');
+            break;
+
+        case GRV_ADS_AMOSTRA:
+            // Estende o sinal dos 24 bits
+            s_ads_amostra = (int32_t)((valor24 & 0x800000u) ? (valor24 | 0xFF000000u) : valor24);
+            s_ads_pendente = true;
+            break;
+
+        case GRV_TIM2_PULSOS:
+            s_pulsos += valor24;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void Encerrar_Reproducao(const char* motivo)
+{
+    Temporizador_Parar(s_tmr_reproducao);
+    s_reproduzindo = false;
+    s_ads_pendente = false;
+    printf("REPRODUCAO: %s.\r\n", motivo);
+}
+
+#endif // GRAVACAO_HABILITADA
@@ -0,0 +1,348 @@
+/*******************************************************************************
+ * @file        lote_handler.c
+ * @brief       Implementao do Handler de Lotes (modo contnuo de medio).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O histrico  um anel de registros de 32 bytes na EEPROM, logo
+ * aps as trs cpias da configurao. O nmero da amostra define o slot, e
+ * o maior nmero vlido encontrado no boot continua a numerao. A gravao
+ * usa a FSM assncrona do eeprom_driver e s comea quando o gerenciador de
+ * configuraes no tem salvamento pendente.
+ ******************************************************************************/
+
+#include "lote_handler.h"
+#include "display_handler.h"
+#include "medicao_handler.h"
+#include "gerenciador_configuracoes.h"
+#include "eeprom_driver.h"
+#include "rtc_driver.h"
+#include "cli_driver.h"
+#include "main.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+//================================================================================
+// Definies e Variveis Estticas
+//================================================================================
+
+#define LOTE_FILA_TAMANHO       4
+#define LOTE_REGISTROS_POR_PAG  (EEPROM_PAGE_SIZE / HISTORICO_REGISTRO_SIZE)
+
+_Static_assert(sizeof(Lote_Registro_t) == HISTORICO_REGISTRO_SIZE, "Registro do historico deve ter HISTORICO_REGISTRO_SIZE bytes");
+_Static_assert((EEPROM_PAGE_SIZE % HISTORICO_REGISTRO_SIZE) == 0, "Registros do historico nao podem cruzar paginas");
+
+typedef struct {
+    uint32_t ultimo_ms;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t soma_ms;
+    uint32_t contagem;
+} Lote_Estat_Etapa_t;
+
+static const char* const s_nomes_etapas[LOTE_NUM_ETAPAS] = {
+    "Enchimento", "Ajuste", "Raspagem", "Peso", "Temperatura", "Umidade", "Resultado"
+};
+
+// --- Numerao e histrico ---
+static uint32_t s_numero_amostra = 0;
+static Lote_Registro_t s_fila[LOTE_FILA_TAMANHO];
+static uint8_t s_fila_inicio = 0;
+static uint8_t s_fila_contagem = 0;
+static bool s_gravando = false;
+
+// --- Estado do lote ---
+static bool     s_lote_ativo = false;
+static uint16_t s_lote_quantidade = 0;
+static uint16_t s_lote_concluidas = 0;
+static uint16_t s_lote_falhas = 0;
+static uint32_t s_lote_tick_inicio = 0;
+static uint32_t s_lote_tick_ultima = 0;
+
+// --- Tempos ---
+static uint32_t s_tick_inicio_sequencia = 0;
+static uint32_t s_tick_marca_etapa = 0;
+static Lote_Estat_Etapa_t s_etapas[LOTE_NUM_ETAPAS];
+static Lote_Estat_Etapa_t s_ciclo;
+
+//================================================================================
+// Prottipos de Funes Privadas
+//================================================================================
+
+static uint16_t Calcular_Checksum(const Lote_Registro_t* registro);
+static uint16_t Endereco_Do_Numero(uint32_t numero);
+static void Acumular_Tempo(Lote_Estat_Etapa_t* estat, uint32_t duracao_ms);
+static void Reiniciar_Estatisticas(void);
+static void Imprimir_Resumo_Lote(void);
+
+//================================================================================
+// Implementao das Funes Pblicas
+//================================================================================
+
+void Lote_Init(void)
+{
+    uint8_t pagina[EEPROM_PAGE_SIZE];
+
+    s_numero_amostra = 0;
+    s_fila_inicio = 0;
+    s_fila_contagem = 0;
+    s_gravando = false;
+    s_lote_ativo = false;
+    Reiniciar_Estatisticas();
+
+    for (uint16_t addr = ADDR_HISTORICO_LOTES; addr < END_OF_HISTORICO; addr += EEPROM_PAGE_SIZE)
+    {
+        if (!EEPROM_Driver_Read_Blocking(addr, pagina, sizeof(pagina))) {
+            printf("LOTE: Falha ao ler historico (0x%04X).\r\n", addr);
+            return;
+        }
+        for (uint8_t i = 0; i < LOTE_REGISTROS_POR_PAG; i++)
+        {
+            const Lote_Registro_t* registro = (const Lote_Registro_t*)&pagina[i * HISTORICO_REGISTRO_SIZE];
+            if (registro->numero_amostra != 0xFFFFFFFFu &&
+                registro->checksum == Calcular_Checksum(registro) &&
+                registro->numero_amostra > s_numero_amostra)
+            {
+                s_numero_amostra = registro->numero_amostra;
+            }
+        }
+    }
+    printf("LOTE: Historico carregado. Ultima amostra: %lu\r\n", (unsigned long)s_numero_amostra);
+}
+
+void Lote_Process(void)
+{
+    if (s_gravando)
+    {
+        if (EEPROM_Driver_IsBusy()) {
+            return;
+        }
+        s_gravando = false;
+        s_fila_inicio = (uint8_t)((s_fila_inicio + 1) % LOTE_FILA_TAMANHO);
+        s_fila_contagem--;
+    }
+
+    if (s_fila_contagem == 0 || EEPROM_Driver_IsBusy() || Gerenciador_Config_Ha_Pendencias()) {
+        return;
+    }
+
+    const Lote_Registro_t* registro = &s_fila[s_fila_inicio];
+    if (EEPROM_Driver_Write_Async_Start(Endereco_Do_Numero(registro->numero_amostra),
+                                        (const uint8_t*)registro, sizeof(Lote_Registro_t)))
+    {
+        s_gravando = true;
+    }
+}
+
+bool Lote_Ha_Gravacao_Pendente(void)
+{
+    return s_gravando || (s_fila_contagem > 0);
+}
+
+bool Lote_Iniciar(uint16_t quantidade)
+{
+    // Com uma medio em curso o lote no  armado: a primeira amostra seria dela.
+    if (!Display_StartMeasurementSequence()) {
+        return false;
+    }
+
+    s_lote_quantidade = quantidade;
+    s_lote_concluidas = 0;
+    s_lote_falhas = 0;
+    s_lote_tick_inicio = HAL_GetTick();
+    s_lote_tick_ultima = s_lote_tick_inicio;
+    s_lote_ativo = true;
+    Reiniciar_Estatisticas();
+
+    printf("LOTE: Iniciado (%u amostras%s).\r\n", quantidade, (quantidade == 0) ? ", continuo" : "");
+    printf("LOTE;numero;produto;umidade;peso;densidade;temperatura;data;hora;ciclo_ms\r\n");
+    return true;
+}
+
+void Lote_Parar(void)
+{
+    if (s_lote_ativo) {
+        s_lote_ativo = false;
+        Imprimir_Resumo_Lote();
+    }
+}
+
+bool Lote_Is_Ativo(void)
+{
+    return s_lote_ativo;
+}
+
+void Lote_Sequencia_Iniciada(void)
+{
+    s_tick_inicio_sequencia = HAL_GetTick();
+    s_tick_marca_etapa = s_tick_inicio_sequencia;
+}
+
+void Lote_Etapa_Concluida(LoteEtapa_t etapa)
+{
+    if (etapa >= LOTE_NUM_ETAPAS) return;
+
+    uint32_t agora = HAL_GetTick();
+    Acumular_Tempo(&s_etapas[etapa], agora - s_tick_marca_etapa);
+    s_tick_marca_etapa = agora;
+}
+
+uint32_t Lote_Amostra_Concluida(void)
+{
+    uint32_t agora = HAL_GetTick();
+    uint32_t duracao_ms = agora - s_tick_inicio_sequencia;
+    // No lote, o enchimento da prxima amostra comea agora.
+    s_tick_inicio_sequencia = agora;
+    Acumular_Tempo(&s_ciclo, duracao_ms);
+
+    DadosMedicao_t dados;
+    Medicao_Get_UltimaMedicao(&dados);
+
+    Lote_Registro_t registro;
+    memset(&registro, 0, sizeof(registro));
+    char weekday_dummy[4];
+    RTC_Driver_GetDate(&registro.dia, &registro.mes, &registro.ano, weekday_dummy);
+    RTC_Driver_GetTime(&registro.hora, &registro.minuto, &registro.segundo);
+    Gerenciador_Config_Get_Grao_Ativo(&registro.indice_grao);
+
+    registro.numero_amostra   = ++s_numero_amostra;
+    registro.umidade          = dados.Umidade;
+    registro.peso             = dados.Peso;
+    registro.densidade        = dados.Densidade;
+    registro.temperatura      = dados.Temp_Amostra;
+    registro.duracao_ciclo_ms = (duracao_ms > 0xFFFFu) ? 0xFFFFu : (uint16_t)duracao_ms;
+    registro.checksum         = Calcular_Checksum(&registro);
+
+    if (s_fila_contagem < LOTE_FILA_TAMANHO) {
+        uint8_t fim = (uint8_t)((s_fila_inicio + s_fila_contagem) % LOTE_FILA_TAMANHO);
+        s_fila[fim] = registro;
+        s_fila_contagem++;
+    } else {
+        printf("LOTE: Fila do historico cheia, amostra %lu nao gravada.\r\n", (unsigned long)registro.numero_amostra);
+    }
+
+    Config_Grao_t grao;
+    Gerenciador_Config_Get_Dados_Grao(registro.indice_grao, &grao);
+    printf("LOTE;%lu;%s;%.2f;%.1f;%.1f;%.1f;%02u/%02u/%02u;%02u:%02u:%02u;%lu\r\n",
+           (unsigned long)registro.numero_amostra, grao.nome,
+           registro.umidade, registro.peso, registro.densidade, registro.temperatura,
+           registro.dia, registro.mes, registro.ano,
+           registro.hora, registro.minuto, registro.segundo,
+           (unsigned long)duracao_ms);
+
+    if (s_lote_ativo) {
+        s_lote_concluidas++;
+        s_lote_tick_ultima = agora;
+        if (s_lote_quantidade != 0 && s_lote_concluidas >= s_lote_quantidade) {
+            Lote_Parar();
+        }
+    }
+    return registro.numero_amostra;
+}
+
+void Lote_Amostra_Falhou(void)
+{
+    if (s_lote_ativo) {
+        s_lote_falhas++;
+        printf("LOTE: Amostra falhou, lote interrompido.\r\n");
+        Lote_Parar();
+    }
+}
+
+uint32_t Lote_Get_Numero_Amostra(void)
+{
+    return s_numero_amostra;
+}
+
+bool Lote_Get_Registro(uint16_t indice_recente, Lote_Registro_t* registro_out)
+{
+    if (registro_out == NULL || indice_recente >= HISTORICO_NUM_REGISTROS ||
+        indice_recente >= s_numero_amostra) {
+        return false;
+    }
+    uint32_t numero = s_numero_amostra - indice_recente;
+
+    // Registros recentes podem ainda estar na fila aguardando a EEPROM.
+    for (uint8_t i = 0; i < s_fila_contagem; i++) {
+        const Lote_Registro_t* pendente = &s_fila[(s_fila_inicio + i) % LOTE_FILA_TAMANHO];
+        if (pendente->numero_amostra == numero) {
+            *registro_out = *pendente;
+            return true;
+        }
+    }
+
+    if (!EEPROM_Driver_Read_Blocking(Endereco_Do_Numero(numero), (uint8_t*)registro_out, sizeof(Lote_Registro_t))) {
+        return false;
+    }
+    return (registro_out->numero_amostra == numero &&
+            registro_out->checksum == Calcular_Checksum(registro_out));
+}
+
+void Lote_Imprimir_Estatisticas(void)
+{
+    uint32_t decorrido_ms = (s_lote_ativo ? HAL_GetTick() : s_lote_tick_ultima) - s_lote_tick_inicio;
+    float amostras_hora = (decorrido_ms > 0) ? (s_lote_concluidas * 3600000.0f / (float)decorrido_ms) : 0.0f;
+
+    CLI_Printf("Lote: %s | Amostras: %u/%u | Falhas: %u | Ultima amostra: %lu\r\n",
+               s_lote_ativo ? "ATIVO" : "parado", s_lote_concluidas, s_lote_quantidade,
+               s_lote_falhas, (unsigned long)s_numero_amostra);
+    CLI_Printf("Vazao: %.1f amostras/hora\r\n", amostras_hora);
+    CLI_Printf("%-12s %8s %8s %8s %8s\r\n", "Etapa", "ult(ms)", "min", "med", "max");
+    for (uint8_t i = 0; i < LOTE_NUM_ETAPAS; i++) {
+        const Lote_Estat_Etapa_t* e = &s_etapas[i];
+        CLI_Printf("%-12s %8lu %8lu %8lu %8lu\r\n", s_nomes_etapas[i],
+                   (unsigned long)e->ultimo_ms, (unsigned long)(e->contagem ? e->min_ms : 0),
+                   (unsigned long)(e->contagem ? e->soma_ms / e->contagem : 0), (unsigned long)e->max_ms);
+    }
+    CLI_Printf("%-12s %8lu %8lu %8lu %8lu\r\n", "Ciclo",
+               (unsigned long)s_ciclo.ultimo_ms, (unsigned long)(s_ciclo.contagem ? s_ciclo.min_ms : 0),
+               (unsigned long)(s_ciclo.contagem ? s_ciclo.soma_ms / s_ciclo.contagem : 0), (unsigned long)s_ciclo.max_ms);
+}
+
+//================================================================================
+// Implementao das Funes Privadas
+//================================================================================
+
+/**
+ * @brief Fletcher-16 sobre o registro, exceto o prprio campo de checksum.
+ */
+static uint16_t Calcular_Checksum(const Lote_Registro_t* registro)
+{
+    const uint8_t* dados = (const uint8_t*)registro;
+    uint16_t soma1 = 0;
+    uint16_t soma2 = 0;
+    for (size_t i = 0; i < offsetof(Lote_Registro_t, checksum); i++) {
+        soma1 = (uint16_t)((soma1 + dados[i]) % 255u);
+        soma2 = (uint16_t)((soma2 + soma1) % 255u);
+    }
+    return (uint16_t)((soma2 << 8) | soma1);
+}
+
+static uint16_t Endereco_Do_Numero(uint32_t numero)
+{
+    return (uint16_t)(ADDR_HISTORICO_LOTES + ((numero - 1u) % HISTORICO_NUM_REGISTROS) * HISTORICO_REGISTRO_SIZE);
+}
+
+static void Acumular_Tempo(Lote_Estat_Etapa_t* estat, uint32_t duracao_ms)
+{
+    estat->ultimo_ms = duracao_ms;
+    if (estat->contagem == 0 || duracao_ms < estat->min_ms) estat->min_ms = duracao_ms;
+    if (duracao_ms > estat->max_ms) estat->max_ms = duracao_ms;
+    estat->soma_ms += duracao_ms;
+    estat->contagem++;
+}
+
+static void Reiniciar_Estatisticas(void)
+{
+    memset(s_etapas, 0, sizeof(s_etapas));
+    memset(&s_ciclo, 0, sizeof(s_ciclo));
+}
+
+static void Imprimir_Resumo_Lote(void)
+{
+    uint32_t decorrido_ms = s_lote_tick_ultima - s_lote_tick_inicio;
+    float amostras_hora = (decorrido_ms > 0) ? (s_lote_concluidas * 3600000.0f / (float)decorrido_ms) : 0.0f;
+    printf("LOTE: Encerrado. %u amostras, %u falhas, %.1f amostras/hora, ciclo medio %lu ms.\r\n",
+           s_lote_concluidas, s_lote_falhas, amostras_hora,
+           (unsigned long)(s_ciclo.contagem ? s_ciclo.soma_ms / s_ciclo.contagem : 0));
+}
@@ -34,6 +34,8 @@
 #include "app_manager.h"
 #include "cli_driver.h"
 #include "cli_controller.h"
+#include "memoria.h"
+#include "boot.h"
 #include <stdio.h>
 #include <string.h>
 /* USER CODE END Includes */
@@ -58,7 +60,6 @@
 /* USER CODE BEGIN PV */
 uint8_t usb_rx_buffer[64];
 uint8_t usb_tx_buffer[128]; 
-void USB_Process(void);
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -80,7 +81,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+	Memoria_Pintar_Pilha();
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -89,6 +90,7 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
+	Boot_Marcar(BOOT_FASE_HAL);
 
   /* USER CODE END Init */
 
@@ -96,6 +98,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+	Boot_Marcar(BOOT_FASE_CLOCK);
 	
   /* USER CODE END SysInit */
 
@@ -113,10 +116,13 @@ int main(void)
   MX_TIM16_Init();
   MX_TIM17_Init();
   /* USER CODE BEGIN 2 */
+	Boot_Marcar(BOOT_FASE_PERIFERICOS);
 	MX_USB_PCD_Init();
+	Boot_Marcar(BOOT_FASE_USB);
 	App_Manager_Init();
 	CLI_Controller_Init();
-	App_Manager_Run_Self_Diagnostics(PRINCIPAL);
+	Boot_Marcar(BOOT_FASE_APP_INIT);
+	App_Manager_Iniciar_Boot();
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -127,11 +133,7 @@ int main(void)
 
     /* USER CODE BEGIN 3 */
 		
-		//USB
-    USB_Process();
-		CLI_TX_Pump();
-
-		//Sistema
+		//Sistema (a USB e a CLI rodam como tarefa do escalonador)
 		App_Manager_Process();
 
 	}
@@ -148,7 +150,7 @@ void USB_Process(void)
 
     if (bytes_received > 0)
     {
-      for (int i = 0; i < bytes_received; i++)
+      for (uint32_t i = 0; i < bytes_received; i++)
       {
         CLI_Receive_Char(usb_rx_buffer[i]);
       }
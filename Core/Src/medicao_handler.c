@@ -9,6 +9,9 @@
 #include "ads1232_driver.h"
 #include "pcb_frequency.h"
 #include "gerenciador_configuracoes.h"
+#include "GXXX_Equacoes.h"
+#include "eventos.h"
+#include "gravacao.h"
 #include "main.h" 
 #include <string.h>
 #include <math.h>
@@ -21,9 +24,36 @@
 static DadosMedicao_t s_dados_medicao_atuais;
 extern volatile bool g_ads_data_ready;
 
-// Controle de tempo para atualizao de frequncia.
-static uint32_t s_freq_last_tick = 0;
-static const uint32_t FREQ_UPDATE_INTERVAL_MS = 1000;
+// Incrementado a cada nova leitura da balana (usado pelo controle dos servos).
+static uint32_t s_contador_peso = 0;
+// Peso da amostra fixado pela previso dos servos; a leitura viva fica guardada.
+static bool  s_peso_fixado = false;
+static float s_peso_vivo = 0.0f;
+// Incrementado a cada integrao de frequncia publicada (usado pelo autodiagnstico).
+static uint32_t s_contador_frequencia = 0;
+
+// Integrao da frequncia em sub-janelas: encerra assim que o erro padro
+// da Escala A fica abaixo do necessrio para as casas decimais exibidas.
+static const uint32_t FREQ_SUBJANELA_MS     = 100;
+static const uint8_t  FREQ_SUBJANELAS_MIN   = 3;
+static const uint8_t  FREQ_SUBJANELAS_MAX   = 10;    // 1 s: tempo de integrao original
+static const float    COEF_FREQ_ESCALA_A    = -0.00014955f;
+static const float    OFFSET_ESCALA_A       = 396.85f;
+static const float    FRACAO_RESOLUCAO_ALVO = 0.25f; // Erro padro alvo = 1/4 do ltimo dgito
+static const float    SENSIBILIDADE_PADRAO  = 0.3f;  // dU/dA para curvas sem coeficientes
+
+typedef struct {
+    uint32_t tick_inicio;
+    uint32_t contagem_inicio;
+    uint32_t tick_anterior;
+    uint32_t contagem_anterior;
+    uint8_t  subjanelas;
+    float    media_hz;      // Mdia (Welford) das taxas de cada sub-janela
+    float    m2;            // Soma dos quadrados dos desvios (Welford)
+} Integracao_Freq_t;
+
+static Integracao_Freq_t s_integracao;
+static uint32_t s_tempo_integracao_ms = 0;
 
 //================================================================================
 // Prottipos de Funes Privadas (Lgica Interna)
@@ -31,7 +61,9 @@ static const uint32_t FREQ_UPDATE_INTERVAL_MS = 1000;
 
 static void HandleScaleData(void);
 static void UpdateFrequencyData(void);
-static float CalculateEscalaA(uint32_t frequencia_hz);
+static float CalculateEscalaA(float frequencia_hz);
+static float CalcularErroAlvoEscalaA(float escala_a);
+static void ReiniciarIntegracao(uint32_t agora, uint32_t contagem);
 
 //================================================================================
 // Implementao das Funes Pblicas
@@ -39,6 +71,7 @@ static float CalculateEscalaA(uint32_t frequencia_hz);
 
 void Medicao_Init(void) {
     memset(&s_dados_medicao_atuais, 0, sizeof(DadosMedicao_t));
+    ReiniciarIntegracao(HAL_GetTick(), Frequency_Get_Pulse_Count());
 }
 
 void Medicao_Process(void) {
@@ -46,13 +79,50 @@ void Medicao_Process(void) {
     UpdateFrequencyData();
 }
 
+uint32_t Medicao_Get_Proximo_ms(void) {
+    if (g_ads_data_ready || ADS1232_Tare_Em_Andamento()) return 0;
+#if GRAVACAO_HABILITADA
+    if (Gravacao_Reproduzindo()) return 0;
+#endif
+    uint32_t dt_ms = HAL_GetTick() - s_integracao.tick_anterior;
+    return (dt_ms >= FREQ_SUBJANELA_MS) ? 0 : (FREQ_SUBJANELA_MS - dt_ms);
+}
+
 void Medicao_Get_UltimaMedicao(DadosMedicao_t* dados_out) {
     if (dados_out != NULL) {
         memcpy(dados_out, &s_dados_medicao_atuais, sizeof(DadosMedicao_t));
     }
 }
 
+uint32_t Medicao_Get_Contador_Peso(void) { return s_contador_peso; }
+
+void Medicao_Fixar_Peso(float peso) {
+    s_dados_medicao_atuais.Peso = peso;
+    s_peso_fixado = true;
+}
+
+void Medicao_Liberar_Peso(void) {
+    if (s_peso_fixado) {
+        s_peso_fixado = false;
+        s_dados_medicao_atuais.Peso = s_peso_vivo;
+    }
+}
+
+uint32_t Medicao_Get_Contador_Frequencia(void) { return s_contador_frequencia; }
+
+uint32_t Medicao_Get_Tempo_Integracao_ms(void) { return s_tempo_integracao_ms; }
+
+void Medicao_Reiniciar_Integracao(void) {
+#if GRAVACAO_HABILITADA
+    uint32_t contagem = Gravacao_Reproduzindo() ? Gravacao_Get_Pulsos() : Frequency_Get_Pulse_Count();
+#else
+    uint32_t contagem = Frequency_Get_Pulse_Count();
+#endif
+    ReiniciarIntegracao(HAL_GetTick(), contagem);
+}
+
 void Medicao_Set_Temp_Instru(float temp_instru) { s_dados_medicao_atuais.Temp_Instru = temp_instru; }
+void Medicao_Set_Temp_Amostra(float temp_amostra) { s_dados_medicao_atuais.Temp_Amostra = temp_amostra; }
 void Medicao_Set_Densidade(float densidade)   { s_dados_medicao_atuais.Densidade = densidade; }
 void Medicao_Set_Umidade(float umidade)       { s_dados_medicao_atuais.Umidade = umidade; }
 
@@ -65,36 +135,129 @@ void Medicao_Set_Umidade(float umidade)       { s_dados_medicao_atuais.Umidade =
  * Verifica se um novo dado da balana est pronto e o processa.
  */
 static void HandleScaleData(void) {
+    // Durante a tara o DRDY  consumido pela corrotina do driver.
+    if (ADS1232_Tare_Em_Andamento()) {
+        s_peso_fixado = false;      // O zero mudou: o peso previsto no vale mais
+        return;
+    }
+
+#if GRAVACAO_HABILITADA
+    if (Gravacao_Reproduzindo()) {
+        g_ads_data_ready = false;   // Amostras reais so descartadas
+        int32_t leitura_gravada;
+        if (Gravacao_Get_Amostra_Ads(&leitura_gravada)) {
+            s_peso_vivo = ADS1232_ConvertToGrams(leitura_gravada);
+            if (!s_peso_fixado) s_dados_medicao_atuais.Peso = s_peso_vivo;
+            s_contador_peso++;
+        }
+        return;
+    }
+#endif
+
     if (g_ads_data_ready) {
         g_ads_data_ready = false;
         int32_t leitura_adc_mediana = ADS1232_Read_Median_of_3();
-        float gramas = ADS1232_ConvertToGrams(leitura_adc_mediana);
-        s_dados_medicao_atuais.Peso = gramas;
+        GRAVACAO_ADS(leitura_adc_mediana);
+        s_peso_vivo = ADS1232_ConvertToGrams(leitura_adc_mediana);
+        if (!s_peso_fixado) s_dados_medicao_atuais.Peso = s_peso_vivo;
+        s_contador_peso++;
     }
 }
 
 /**
  * @brief Lgica movida de app_manager.c (Task_Update_Frequency).
- * Atualiza a leitura de frequncia e o clculo da Escala A a cada 1 segundo.
+ * A cada sub-janela acumula a taxa de pulsos; publica Frequencia/Escala A
+ * quando o erro padro da mdia atinge o alvo ou aps FREQ_SUBJANELAS_MAX.
+ * O contador do TIM2 corre livre (32 bits) e  lido por diferena, ento
+ * nenhum pulso se perde entre uma integrao e a seguinte.
  */
 static void UpdateFrequencyData(void) {
-    if (HAL_GetTick() - s_freq_last_tick >= FREQ_UPDATE_INTERVAL_MS) {
-        s_freq_last_tick = HAL_GetTick();
+    uint32_t agora = HAL_GetTick();
+    uint32_t dt_ms = agora - s_integracao.tick_anterior;
+    if (dt_ms < FREQ_SUBJANELA_MS) {
+        return;
+    }
+
+#if GRAVACAO_HABILITADA
+    uint32_t contagem = Gravacao_Reproduzindo() ? Gravacao_Get_Pulsos() : Frequency_Get_Pulse_Count();
+#else
+    uint32_t contagem = Frequency_Get_Pulse_Count();
+#endif
+    GRAVACAO_PULSOS(contagem);
+    float taxa_hz = (float)(contagem - s_integracao.contagem_anterior) * 1000.0f / (float)dt_ms;
+    s_integracao.tick_anterior = agora;
+    s_integracao.contagem_anterior = contagem;
+
+    s_integracao.subjanelas++;
+    float delta = taxa_hz - s_integracao.media_hz;
+    s_integracao.media_hz += delta / (float)s_integracao.subjanelas;
+    s_integracao.m2 += delta * (taxa_hz - s_integracao.media_hz);
+
+    if (s_integracao.subjanelas < FREQ_SUBJANELAS_MIN) {
+        return;
+    }
 
-        uint32_t pulsos = Frequency_Get_Pulse_Count();
-        Frequency_Reset();
+    uint32_t total_ms = agora - s_integracao.tick_inicio;
+    float frequencia_hz = (float)(contagem - s_integracao.contagem_inicio) * 1000.0f / (float)total_ms;
+    float escala_a = CalculateEscalaA(frequencia_hz);
 
-        s_dados_medicao_atuais.Frequencia = (float)pulsos;
-        s_dados_medicao_atuais.Escala_A = CalculateEscalaA(pulsos);
+    float gain = 1.0f;
+    float zero = 0.0f;
+    Gerenciador_Config_Get_Cal_A(&gain, &zero);
+    float n = (float)s_integracao.subjanelas;
+    float erro_padrao_hz = sqrtf(s_integracao.m2 / ((n - 1.0f) * n));
+    float erro_padrao_a = fabsf(COEF_FREQ_ESCALA_A * gain) * erro_padrao_hz;
+
+    if (s_integracao.subjanelas >= FREQ_SUBJANELAS_MAX || erro_padrao_a <= CalcularErroAlvoEscalaA(escala_a)) {
+        s_dados_medicao_atuais.Frequencia = frequencia_hz;
+        s_dados_medicao_atuais.Escala_A = escala_a;
+        s_tempo_integracao_ms = total_ms;
+        s_contador_frequencia++;
+        Eventos_Publicar(EVT_MEDICAO_PRONTA, (int32_t)total_ms, NULL, 0);
+        ReiniciarIntegracao(agora, contagem);
     }
 }
 
+static void ReiniciarIntegracao(uint32_t agora, uint32_t contagem) {
+    memset(&s_integracao, 0, sizeof(s_integracao));
+    s_integracao.tick_inicio = agora;
+    s_integracao.tick_anterior = agora;
+    s_integracao.contagem_inicio = contagem;
+    s_integracao.contagem_anterior = contagem;
+}
+
+/**
+ * @brief Erro padro mximo aceitvel para a Escala A.
+ * A curva do produto (polinmio cbico Fat_A..Fat_D em Escala A) d a
+ * sensibilidade dU/dA no ponto atual; o alvo  uma frao do ltimo dgito
+ * de umidade exibido (nr_decimals) convertida para unidades de Escala A.
+ */
+static float CalcularErroAlvoEscalaA(float escala_a) {
+    float resolucao = 1.0f;
+    uint16_t casas = Gerenciador_Config_Get_NR_Decimals();
+    for (uint16_t i = 0; i < casas && i < 4; i++) {
+        resolucao *= 0.1f;
+    }
+
+    float sensibilidade = SENSIBILIDADE_PADRAO;
+    uint8_t indice_grao = 0;
+    if (Gerenciador_Config_Get_Grao_Ativo(&indice_grao) && indice_grao < MAX_GRAOS) {
+        const struct Produtos_ROM* produto = &Produto[indice_grao];
+        float derivada = fabsf((3.0f * produto->Fat_A * escala_a + 2.0f * produto->Fat_B) * escala_a + produto->Fat_C);
+        if (derivada > 1e-6f) {
+            sensibilidade = derivada;
+        }
+    }
+
+    return (resolucao * FRACAO_RESOLUCAO_ALVO) / sensibilidade;
+}
+
 /**
  * @brief Lgica movida de app_manager.c (Calcular_Escala_A).
  * Calcula o valor da Escala A com base na frequncia e nos fatores de calibrao.
  */
-static float CalculateEscalaA(uint32_t frequencia_hz) {
-    float escala_a = (-0.00014955f * (float)frequencia_hz) + 396.85f;
+static float CalculateEscalaA(float frequencia_hz) {
+    float escala_a = (COEF_FREQ_ESCALA_A * frequencia_hz) + OFFSET_ESCALA_A;
 
     float gain = 1.0f;
     float zero = 0.0f;
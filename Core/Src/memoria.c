@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * @file        memoria.c
+ * @brief       Monitor de uso de RAM: pilha, pool do USBX e dados estticos.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Os limites vm do linker (armlink): __initial_sp  exportado
+ * pelo startup com MicroLIB e Image$$RW_IRAM1$$... delimitam a regio de
+ * RAM do scatter gerado pelo Keil, que tambm contm pilha e heap.
+ ******************************************************************************/
+
+#include "memoria.h"
+#include "main.h"
+#include "ux_api.h"
+
+//==============================================================================
+// Smbolos do Linker
+//==============================================================================
+
+extern uint32_t __initial_sp;
+extern uint32_t Image$$RW_IRAM1$$Base;
+extern uint32_t Image$$RW_IRAM1$$ZI$$Limit;
+
+//==============================================================================
+// Configuraes
+//==============================================================================
+
+static const uint32_t PADRAO_PILHA = 0xA5A5A5A5u;
+static const uint32_t MARGEM_SP = 64u;         // No pinta o quadro em uso abaixo do SP
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Memoria_Pintar_Pilha(void)
+{
+    uint32_t* p = (uint32_t*)((uint32_t)&__initial_sp - MEMORIA_PILHA_TAMANHO);
+    uint32_t* limite = (uint32_t*)(__get_MSP() - MARGEM_SP);
+
+    while (p < limite)
+    {
+        *p++ = PADRAO_PILHA;
+    }
+}
+
+void Memoria_Get_Uso(Memoria_Uso_t* uso_out)
+{
+    if (uso_out == NULL) return;
+
+    const uint32_t topo = (uint32_t)&__initial_sp;
+    const uint32_t* p = (const uint32_t*)(topo - MEMORIA_PILHA_TAMANHO);
+    while ((uint32_t)p < topo && *p == PADRAO_PILHA)
+    {
+        p++;
+    }
+    uso_out->pilha_usada = topo - (uint32_t)p;
+    uso_out->pilha_tamanho = MEMORIA_PILHA_TAMANHO;
+
+    // _ux_system s existe depois de ux_system_initialize(). Ao acordar do modo
+    // Stop o pool  reinicializado, ento o pico recomea a contar.
+    uso_out->pool_ativo = false;
+    uso_out->pool_em_uso = 0;
+    uso_out->pool_pico = 0;
+    uso_out->pool_tamanho = 0;
+    if (_ux_system != UX_NULL && _ux_system->ux_system_memory_byte_pool[UX_MEMORY_BYTE_POOL_REGULAR] != UX_NULL)
+    {
+        const UX_MEMORY_BYTE_POOL* pool = _ux_system->ux_system_memory_byte_pool[UX_MEMORY_BYTE_POOL_REGULAR];
+        uso_out->pool_ativo = true;
+        uso_out->pool_tamanho = pool->ux_byte_pool_size;
+        uso_out->pool_em_uso = pool->ux_byte_pool_size - pool->ux_byte_pool_available;
+#ifdef UX_ENABLE_MEMORY_STATISTICS
+        uso_out->pool_pico = pool->ux_byte_pool_size - (uint32_t)pool->ux_byte_pool_min_free;
+#else
+        uso_out->pool_pico = uso_out->pool_em_uso;
+#endif
+    }
+
+    const uint32_t ram_usada = (uint32_t)&Image$$RW_IRAM1$$ZI$$Limit - (uint32_t)&Image$$RW_IRAM1$$Base;
+    uso_out->estatica = ram_usada - MEMORIA_PILHA_TAMANHO - MEMORIA_HEAP_TAMANHO;
+    uso_out->ram_tamanho = MEMORIA_RAM_TAMANHO;
+}
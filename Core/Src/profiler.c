@@ -0,0 +1,241 @@
+/*******************************************************************************
+ * @file        profiler.c
+ * @brief       Profiler estatstico por amostragem do PC (TIM3).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O handler do TIM3  "naked": pega o SP da pilha ativa (MSP
+ * ou PSP, pelo EXC_RETURN) e salta para Profiler_Registrar_Amostra(), que
+ * l o PC no quadro empilhado pelo hardware (R0-R3, R12, LR, PC, xPSR).
+ * O TIM3 no  usado pelo CubeMX neste projeto, ento o handler  daqui.
+ * A prioridade 0 permite amostrar tambm dentro das outras ISRs; trechos
+ * com interrupes bloqueadas aparecem na instruo seguinte ao
+ * __enable_irq().
+ ******************************************************************************/
+
+#include "profiler.h"
+
+#if PROFILER_HABILITADO
+
+#include "main.h"
+#include "cli_driver.h"
+#include "temporizador.h"
+#include "secao_critica.h"
+#include <string.h>
+#include <stdio.h>
+
+//==============================================================================
+// Configuraes
+//==============================================================================
+
+static const uint32_t PRESCALER_1MHZ = 47;      // 48 MHz / 48 = 1 MHz
+static const uint32_t PERIODO_AMOSTRA_US = 1009; // Primo: no sincroniza com o SysTick
+static const uint32_t INTERVALO_DUMP_MS = 5;
+static const uint16_t ESPACO_MIN_LINHA = 24;    // Bytes livres no FIFO para uma linha
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static TIM_HandleTypeDef s_htim;
+static uint16_t s_baldes[PROFILER_NUM_BALDES];
+static volatile uint32_t s_amostras = 0;
+static volatile uint32_t s_fora_flash = 0;      // PC em RAM (ex.: rotina copiada) ou invlido
+static volatile bool s_saturado = false;
+static bool s_ativo = false;
+
+static Temporizador_Id_t s_timer_dump = TEMPORIZADOR_INVALIDO;
+static uint16_t s_proximo_balde_dump = 0;
+static bool s_cabecalho_pendente = false;
+
+//==============================================================================
+// Prottipos
+//==============================================================================
+
+// Chamada pelo handler em assembly; no pode ser static.
+void Profiler_Registrar_Amostra(const uint32_t* quadro);
+static void Continuar_Dump(void);
+
+//==============================================================================
+// Handler do TIM3
+//==============================================================================
+
+__attribute__((naked)) void TIM3_IRQHandler(void)
+{
+    __asm volatile (
+        "movs r0, #4                        \n"
+        "mov  r1, lr                        \n"
+        "tst  r0, r1                        \n"
+        "beq  1f                            \n"
+        "mrs  r0, psp                       \n"
+        "b    2f                            \n"
+        "1:                                 \n"
+        "mrs  r0, msp                       \n"
+        "2:                                 \n"
+        "ldr  r1, =Profiler_Registrar_Amostra \n"
+        "bx   r1                            \n"   // LR continua com EXC_RETURN
+    );
+}
+
+__attribute__((used)) void Profiler_Registrar_Amostra(const uint32_t* quadro)
+{
+    __HAL_TIM_CLEAR_IT(&s_htim, TIM_IT_UPDATE);
+
+    uint32_t pc = quadro[6];
+    s_amostras++;
+
+    uint32_t offset = pc - PROFILER_FLASH_INICIO;
+    if (offset >= PROFILER_FLASH_TAMANHO)
+    {
+        s_fora_flash++;
+        return;
+    }
+
+    uint16_t* balde = &s_baldes[offset >> PROFILER_BITS_BALDE];
+    if (*balde == UINT16_MAX)
+    {
+        s_saturado = true;
+        return;
+    }
+    (*balde)++;
+}
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Profiler_Init(void)
+{
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    s_htim.Instance = TIM3;
+    s_htim.Init.Prescaler = PRESCALER_1MHZ;
+    s_htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    s_htim.Init.Period = PERIODO_AMOSTRA_US - 1U;
+    s_htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    s_htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_Base_Init(&s_htim) != HAL_OK)
+    {
+        CLI_Printf("PROFILER: falha ao configurar o TIM3.\r\n");
+        return;
+    }
+
+    HAL_NVIC_SetPriority(TIM3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM3_IRQn);
+
+    s_timer_dump = Temporizador_Criar(Continuar_Dump, true);
+    Profiler_Zerar();
+}
+
+void Profiler_Iniciar(void)
+{
+    if (!s_ativo)
+    {
+        s_ativo = true;
+        HAL_TIM_Base_Start_IT(&s_htim);
+    }
+}
+
+void Profiler_Parar(void)
+{
+    if (s_ativo)
+    {
+        HAL_TIM_Base_Stop_IT(&s_htim);
+        s_ativo = false;
+    }
+}
+
+void Profiler_Zerar(void)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    memset(s_baldes, 0, sizeof(s_baldes));
+    s_amostras = 0;
+    s_fora_flash = 0;
+    s_saturado = false;
+    SECAO_CRITICA_SAIR(sc);
+}
+
+void Profiler_Dump(void)
+{
+    s_proximo_balde_dump = 0;
+    s_cabecalho_pendente = true;
+    Continuar_Dump();
+    Temporizador_Iniciar(s_timer_dump, INTERVALO_DUMP_MS);
+}
+
+void Profiler_Ajustar_Clock(uint32_t clock_timer_hz)
+{
+    if (s_htim.Instance == NULL || clock_timer_hz < 1000000U)
+    {
+        return;
+    }
+    // Como no TIM14: UG com URS carrega o PSC novo sem gerar amostra.
+    const uint32_t contagem = __HAL_TIM_GET_COUNTER(&s_htim);
+    const uint32_t cr1 = s_htim.Instance->CR1;
+    __HAL_TIM_SET_PRESCALER(&s_htim, (clock_timer_hz / 1000000U) - 1U);
+    s_htim.Instance->CR1 = cr1 | TIM_CR1_URS;
+    s_htim.Instance->EGR = TIM_EGR_UG;
+    s_htim.Instance->CR1 = cr1;
+    __HAL_TIM_SET_COUNTER(&s_htim, contagem);
+}
+
+bool Profiler_Ativo(void)
+{
+    return s_ativo;
+}
+
+uint32_t Profiler_Get_Amostras(void)
+{
+    return s_amostras;
+}
+
+uint32_t Profiler_Get_Fora_Flash(void)
+{
+    return s_fora_flash;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Escreve tantas linhas do dump quanto couberem no FIFO do CLI.
+ * Roda pelo temporizador at o ltimo balde. Se a amostragem continuar
+ * durante o dump, as contagens so as do momento em que cada linha sai.
+ */
+static void Continuar_Dump(void)
+{
+    if (!CLI_Is_USB_Connected())
+    {
+        Temporizador_Parar(s_timer_dump);
+        return;
+    }
+
+    if (s_cabecalho_pendente)
+    {
+        if (CLI_Get_TX_Livre() < 64u) return;
+        CLI_Printf("PROF INICIO amostras=%lu fora=%lu balde=%u saturado=%u\r\n",
+                   (unsigned long)s_amostras, (unsigned long)s_fora_flash,
+                   (unsigned)(1U << PROFILER_BITS_BALDE), (unsigned)s_saturado);
+        s_cabecalho_pendente = false;
+    }
+
+    while (s_proximo_balde_dump < PROFILER_NUM_BALDES && CLI_Get_TX_Livre() >= ESPACO_MIN_LINHA)
+    {
+        uint16_t contagem = s_baldes[s_proximo_balde_dump];
+        if (contagem > 0)
+        {
+            uint32_t endereco = PROFILER_FLASH_INICIO + ((uint32_t)s_proximo_balde_dump << PROFILER_BITS_BALDE);
+            CLI_Printf("%08lX %u\r\n", (unsigned long)endereco, (unsigned)contagem);
+        }
+        s_proximo_balde_dump++;
+    }
+
+    if (s_proximo_balde_dump >= PROFILER_NUM_BALDES && CLI_Get_TX_Livre() >= ESPACO_MIN_LINHA)
+    {
+        CLI_Puts("PROF FIM\r\n");
+        Temporizador_Parar(s_timer_dump);
+    }
+}
+
+#endif // PROFILER_HABILITADO
@@ -63,9 +63,35 @@ void PWM_Servo_SetAngle(Servo_t *servo, float angle)
     // Converte o ngulo desejado para o valor bruto do registrador CCR.
     uint32_t ccr_value = map_angle_to_ccr(servo, angle);
 
+    if (servo->divisor_clock > 1)
+    {
+        ccr_value /= servo->divisor_clock; // Clock reduzido pelo governador
+    }
+
     __HAL_TIM_SET_COMPARE(servo->htim, servo->channel, ccr_value); // move o servo para a posio desejada.
 }
 
+// Reescala ARR e CCR para o novo clock do timer.
+void PWM_Servo_Ajustar_Clock(Servo_t *servo, uint8_t divisor)
+{
+    if (servo == NULL || servo->htim == NULL || divisor == 0)
+    {
+        return;
+    }
+
+    const uint32_t antigo = (servo->divisor_clock > 1) ? servo->divisor_clock : 1;
+    if (divisor == antigo)
+    {
+        return;
+    }
+
+    const uint32_t arr = __HAL_TIM_GET_AUTORELOAD(servo->htim);
+    const uint32_t ccr = __HAL_TIM_GET_COMPARE(servo->htim, servo->channel);
+    __HAL_TIM_SET_AUTORELOAD(servo->htim, ((arr + 1U) * antigo) / divisor - 1U);
+    __HAL_TIM_SET_COMPARE(servo->htim, servo->channel, (ccr * antigo) / divisor);
+    servo->divisor_clock = divisor;
+}
+
 // Para a gerao de PWM para um servo especfico.
 HAL_StatusTypeDef PWM_Servo_DeInit(Servo_t *servo)
 {
@@ -4,6 +4,7 @@
 #include "rtc_driver.h"
 #include "dwin_driver.h"
 #include "cli_driver.h"
+#include "lote_handler.h"
 #include <stdio.h>
 
 
@@ -30,7 +31,7 @@ void Who_am_i(void)
     printf("Hardware = %21s\r\n", HARDWARE);
     printf("Serial   = %21s\r\n", serial);
     printf(Linha);
-    printf("Medidas  = %21d\n\r", 22);
+    printf("Medidas  = %21lu\n\r", (unsigned long)Lote_Get_Numero_Amostra());
     printf(Ejeta);
 }
 
@@ -85,8 +86,8 @@ void Relatorio_Printer (void)
     printf("Produto       = %16s\n\r",  dados_grao_ativo.nome);
   	printf("Versao Equacao= %10lu\n\r",   (unsigned long)dados_grao_ativo.id_curva);
   	printf("Validade Curva= %13s\n\r", dados_grao_ativo.validade);
-  	printf("Amostra Numero= %8i\n\r",      4);
-  	printf("Temp.Amostra .= %8.1f 'C\n\r", 22.0);
+  	printf("Amostra Numero= %8lu\n\r",     (unsigned long)Lote_Get_Numero_Amostra());
+  	printf("Temp.Amostra .= %8.1f 'C\n\r", medicao_snapshot.Temp_Amostra);
   	printf("Temp.Instru ..= %8.1f 'C\n\r", medicao_snapshot.Temp_Instru);
   	printf("Peso Amostra .= %8.1f g\n\r", medicao_snapshot.Peso);
   	printf("Densidade ....= %8.1f Kg/hL\n\r",  medicao_snapshot.Densidade);
@@ -118,13 +119,14 @@ void Relatorio_QRCode_WhoAmI(void)
     RTC_Driver_GetTime(&hh, &mm, &ss);
     RTC_Driver_GetDate(&dd, &mo, &yy, weekday_dummy);
 
-    int n = snprintf(qr_buffer, sizeof(qr_buffer),
+    snprintf(qr_buffer, sizeof(qr_buffer),
                      "G620_Teste_Gab\n"
                      "===================\n\r"
                      "Produto: %.*s\n"
 										 "Umidade: %.*f %%\n"
                      "Curva: %lu\n"
-                     "Amostra: %d\n"
+                     "Amostra: %lu\n"
+                     "Temp. amostra: %.1f C\n"
                      "Temp. instru: %.1f C\n"
                      "Peso: %.1f g\n"
                      "Densidade: %.1f Kg/hL\n"
@@ -135,7 +137,8 @@ void Relatorio_QRCode_WhoAmI(void)
                      MAX_NOME_GRAO_LEN, grao.nome,
 										 (int)nr_decimals, dados.Umidade,
                      (unsigned long)grao.id_curva,
-                     4,             
+                     (unsigned long)Lote_Get_Numero_Amostra(),
+                     dados.Temp_Amostra,
                      dados.Temp_Instru,
                      dados.Peso,
                      dados.Densidade,
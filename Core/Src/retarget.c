@@ -42,8 +42,8 @@ void Retarget_Init(UART_HandleTypeDef* debug_huart, UART_HandleTypeDef* dwin_hua
 
 static inline bool usb_cdc_ready(void)
 {
-    // Usa o ponteiro da classe CDC-ACM para saber se o host USB est conectado
-    return (cdc_acm != NULL);
+    // Classe CDC-ACM ativa e barramento no suspenso pelo host
+    return CLI_Is_USB_Connected();
 }
 
 /**
@@ -35,6 +35,7 @@ static RtcSetResult_t rtc_handle_set_time_logic(const uint8_t* dwin_data, uint16
 
 void RTC_Handle_Set_Time(const uint8_t* dwin_data, uint16_t len, uint16_t received_value)
 {
+				(void)received_value;
 				RtcData_t parsed_data;
 
 				// 1. Chama a NOVA funo de lgica que s mexe na hora
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * @file        secao_critica.c
+ * @brief       Sees crticas com medio do tempo de interrupes bloqueadas.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Tabela pequena de locais (funo + linha de sada). Um local
+ * novo com a tabela cheia substitui o de menor tempo mximo, se for pior.
+ ******************************************************************************/
+
+#include "secao_critica.h"
+
+#if SECAO_CRITICA_MEDIR
+
+#include <string.h>
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static SecaoCritica_Local_t s_locais[SECAO_CRITICA_MAX_LOCAIS];
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void SecaoCritica_Registrar(const char* funcao, uint16_t linha, uint32_t duracao_us)
+{
+    SecaoCritica_Local_t* local = NULL;
+    SecaoCritica_Local_t* menor = &s_locais[0];
+
+    for (uint8_t i = 0; i < SECAO_CRITICA_MAX_LOCAIS; i++)
+    {
+        SecaoCritica_Local_t* l = &s_locais[i];
+        if (l->funcao == funcao && l->linha == linha)
+        {
+            local = l;
+            break;
+        }
+        if (l->funcao == NULL || (menor->funcao != NULL && l->max_us < menor->max_us))
+        {
+            menor = l;
+        }
+    }
+
+    if (local == NULL)
+    {
+        if (menor->funcao != NULL && duracao_us <= menor->max_us)
+        {
+            return;
+        }
+        local = menor;
+        local->funcao = funcao;
+        local->linha = linha;
+        local->contagem = 0;
+        local->max_us = 0;
+        local->soma_us = 0;
+    }
+
+    local->contagem++;
+    local->soma_us += duracao_us;
+    if (duracao_us > local->max_us) local->max_us = duracao_us;
+}
+
+uint8_t SecaoCritica_Get_Piores(SecaoCritica_Local_t* locais_out, uint8_t max_locais)
+{
+    SecaoCritica_Local_t copia[SECAO_CRITICA_MAX_LOCAIS];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(copia, s_locais, sizeof(copia));
+    __set_PRIMASK(primask);
+
+    // Ordenao por seleo, do maior para o menor max_us.
+    uint8_t n = 0;
+    while (n < max_locais)
+    {
+        int8_t pior = -1;
+        for (uint8_t i = 0; i < SECAO_CRITICA_MAX_LOCAIS; i++)
+        {
+            if (copia[i].funcao != NULL && (pior < 0 || copia[i].max_us > copia[pior].max_us))
+            {
+                pior = (int8_t)i;
+            }
+        }
+        if (pior < 0) break;
+
+        locais_out[n++] = copia[pior];
+        copia[pior].funcao = NULL;
+    }
+    return n;
+}
+
+void SecaoCritica_Zerar(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(s_locais, 0, sizeof(s_locais));
+    __set_PRIMASK(primask);
+}
+
+#endif // SECAO_CRITICA_MEDIR
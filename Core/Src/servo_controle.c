@@ -1,13 +1,37 @@
 /*******************************************************************************
  * @file        servo_controle.c
  * @brief       Mdulo de alto nvel para controle da sequncia de servos.
- * @version     2.1 (Corrigido para usar TIM16 e TIM17)
+ * @version     3.0 (Malha fechada pelo peso da cmara)
+ * @details     O funil e o raspador no usam mais tempos fixos. O funil fecha
+ * quando a taxa de subida do peso indica cmara cheia, e a raspagem 
+ * confirmada pela queda de peso. Os limites vm do perfil do gro ativo
+ * (Peso_Pad da tabela Produto[] e classe do gro). Se a variao de peso
+ * esperada no acontece, a sequncia aborta com um cdigo de falha.
  ******************************************************************************/
 
 #include "servo_controle.h"
 #include "pwm_servo_driver.h"
+#include "medicao_handler.h"
+#include "gerenciador_configuracoes.h"
+#include "GXXX_Equacoes.h"
+#include "estimador_peso.h"
+#include "ads1232_driver.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Log CSV de cada amostra do estimador, para capturar enchimentos pela CDC
+// e reprocess-los fora da placa (defina como 1 para habilitar).
+#define DEBUG_ESTIMADOR 0
+
+#if DEBUG_ESTIMADOR
+#define ESTIMADOR_LOG(peso_mg) printf("EST;%u;%lu;%ld;%ld;%ld;%u\r\n", (unsigned)s_indice_estado_atual, \
+        (unsigned long)HAL_GetTick(), (long)(peso_mg), (long)EstimadorPeso_Get_Previsto_mg(&s_estimador), \
+        (long)EstimadorPeso_Get_Incerteza_mg(&s_estimador), (unsigned)EstimadorPeso_Convergiu(&s_estimador))
+#else
+#define ESTIMADOR_LOG(peso_mg) do {} while (0)
+#endif
 
 //================================================================================
 // Definies da Mquina de Estados
@@ -15,24 +39,138 @@
 
 #define ESTADO_OCIOSO 0xFF
 
+typedef enum {
+    PASSO_CONTINUA,
+    PASSO_CONCLUIDO,
+    PASSO_FALHOU
+} Resultado_Passo_t;
+
 typedef void (*Funcao_Acao_t)(void);
+typedef Resultado_Passo_t (*Funcao_Condicao_t)(uint32_t tempo_no_passo_ms);
 
 typedef struct
 {
     ServoStep_t id_passo;
-    Funcao_Acao_t acao;
-    uint32_t duracao_ms;
+    Funcao_Acao_t acao;             // Executada na entrada do passo
+    Funcao_Condicao_t condicao;     // Avaliada no loop; NULL = passo instantneo
     uint8_t indice_proximo_estado;
 } Passo_Processo_t;
 
+// Limites de um ciclo, resolvidos a partir do gro ativo no incio da sequncia.
+typedef struct
+{
+    float    peso_min_g;            // Peso mnimo para considerar a cmara cheia
+    float    peso_max_g;            // Acima disto: transbordo ou clula com defeito
+    float    queda_min_g;           // Queda mnima que confirma a raspagem
+    float    taxa_estavel_g_s;      // |dP/dt| abaixo disto = peso estabilizado
+    uint32_t timeout_fluxo_ms;      // Tempo mximo at detectar gro caindo
+    uint32_t timeout_enche_ms;      // Tempo mximo com o funil aberto
+    uint32_t acomodacao_ms;         // Espera aps fechar funil / recolher raspador
+    uint32_t curso_raspa_min_ms;    // Curso mecnico mnimo do raspador
+    uint32_t timeout_raspa_ms;      // Tempo mximo aguardando a queda de peso
+    int32_t  tolerancia_previsao_mg; // Incerteza aceita para antecipar o peso final
+} Perfil_Servo_t;
+
+//================================================================================
+// Configurao
+//================================================================================
+
+#define ANGULO_FECHADO      0.0f
+#define ANGULO_FUNIL_ABRE   75.0f
+#define ANGULO_SCRAP_ABRE   90.0f
+
+#define AMOSTRAGEM_PESO_MS      50      // Perodo de amostragem do peso para a derivada
+#define JANELA_TAXA_AMOSTRAS    4       // Amostras usadas no clculo de dP/dt
+#define AMOSTRAS_ESTAVEIS_MIN   3       // Amostras consecutivas estveis exigidas
+#define LIMIAR_FLUXO_G          3.0f    // Subida mnima que indica gro caindo
+#define TIMEOUT_SEM_LEITURA_MS  500     // Sem amostra nova da balana = falha
+
+// Fraes do Peso_Pad do produto usadas para derivar os limites do gro.
+#define FRACAO_PESO_MIN         0.60f
+#define FRACAO_PESO_MAX         3.00f
+#define FRACAO_QUEDA_MIN        0.02f
+#define QUEDA_MIN_ABSOLUTA_G    1.0f
+#define PESO_PAD_PADRAO_G       142
+
+// Tolerncia da previso do peso final: 0,5% do Peso_Pad (em mg por grama), com piso.
+#define TOLERANCIA_PREVISAO_MG_POR_G    5
+#define TOLERANCIA_PREVISAO_MIN_MG      200
+
+// Cmara simulada (ADS1232_SIMULATION_MODE): transbordo em relao ao Peso_Pad.
+#define FRACAO_SIM_CHEIO        1.10f
+
+// Classe de gros grados (milho, soja, feijo...): fluxo irregular, pior caso.
+static const Perfil_Servo_t s_perfil_graos =
+{
+    .taxa_estavel_g_s   = 8.0f,
+    .timeout_fluxo_ms   = 800,
+    .timeout_enche_ms   = 2500,
+    .acomodacao_ms      = 300,
+    .curso_raspa_min_ms = 600,
+    .timeout_raspa_ms   = 2500,
+};
+
+// Classe de sementes midas: escoam como fluido e assentam rpido.
+static const Perfil_Servo_t s_perfil_sementes_miudas =
+{
+    .taxa_estavel_g_s   = 5.0f,
+    .timeout_fluxo_ms   = 400,
+    .timeout_enche_ms   = 1200,
+    .acomodacao_ms      = 150,
+    .curso_raspa_min_ms = 400,
+    .timeout_raspa_ms   = 1200,
+};
+
+// Curvas (Nr_Equa) tratadas como sementes midas.
+static const uint32_t s_curvas_sementes_miudas[] =
+{
+    13853,                          // Amaranto
+    13805,                          // Chia
+    13844, 7879, 13806,             // Canola, Colza
+    13856, 13857, 13846, 1826,      // Gergelim
+    13809,                          // Linhaa
+    13825, 13830,                   // Milheto, Paino
+    13791,                          // Mostarda
+    13862, 13860, 13861,            // Quinoa
+    13828, 13815,                   // Alpiste, Nabo forrageiro
+    13864, 13866,                   // Azevm, Capim
+};
+#define NUM_CURVAS_SEMENTES_MIUDAS (sizeof(s_curvas_sementes_miudas) / sizeof(s_curvas_sementes_miudas[0]))
+
 //================================================================================
 // Variveis de Estado do Mdulo
 //================================================================================
 
-static volatile uint32_t s_timer_funil = 0;
-static volatile uint32_t s_timer_scrap = 0;
-static volatile uint8_t s_indice_estado_atual = ESTADO_OCIOSO;
-static volatile uint32_t s_timer_estado_ms = 0;
+static uint8_t  s_indice_estado_atual = ESTADO_OCIOSO;
+static uint32_t s_tick_entrada_estado = 0;
+static ServoStatus_t s_status = SERVO_STATUS_OCIOSO;
+static Perfil_Servo_t s_perfil;
+static Servo_Ciclo_Info_t s_ciclo;
+static uint32_t s_tick_inicio_ciclo = 0;
+
+// Amostragem de peso para o clculo da derivada
+static float    s_janela_peso[JANELA_TAXA_AMOSTRAS];
+static uint32_t s_janela_tick[JANELA_TAXA_AMOSTRAS];
+static uint8_t  s_janela_idx = 0;
+static uint8_t  s_janela_cont = 0;
+static uint32_t s_tick_ultima_amostra = 0;
+static uint32_t s_contador_peso_anterior = 0;
+static uint32_t s_tick_ultima_leitura_nova = 0;
+static uint8_t  s_amostras_estaveis = 0;
+static float    s_peso_atual = 0.0f;
+static float    s_peso_referencia = 0.0f;
+static bool     s_fluxo_detectado = false;
+
+#if ADS1232_SIMULATION_MODE
+static float    s_sim_camara_g = 0.0f;      // Somado  leitura fixa da balana
+static uint32_t s_sim_tick = 0;
+#endif
+
+// Previso do peso assinttico durante a raspagem
+static Estimador_Peso_t s_estimador;
+
+static float s_angulo_funil = ANGULO_FECHADO;
+static float s_angulo_scrap = ANGULO_FECHADO;
 
 // --- CORRIGIDO: Configurao dos Servos para TIM16 e TIM17 ---
 // O linker procura estas variveis, que so definidas em tim.c
@@ -43,71 +181,167 @@ extern TIM_HandleTypeDef htim17;
 static Servo_t s_servo_funil   = {.htim = &htim17, .channel = TIM_CHANNEL_1, .min_pulse_us = 700, .max_pulse_us = 2300};
 static Servo_t s_servo_scrap   = {.htim = &htim16, .channel = TIM_CHANNEL_1, .min_pulse_us = 650, .max_pulse_us = 2400};
 
-
-#define ANGULO_FECHADO      0.0f
-#define ANGULO_FUNIL_ABRE   75.0f
-#define ANGULO_SCRAP_ABRE   90.0f
-
 static void Acao_Abrir_Funil(void);
+static void Acao_Fechar_Funil(void);
 static void Acao_Varrer_Scrap(void);
+static void Acao_Recolher_Scrap(void);
 static void Acao_Finalizar(void);
 
+static Resultado_Passo_t Cond_Enchimento(uint32_t tempo_no_passo_ms);
+static Resultado_Passo_t Cond_Acomodacao_Funil(uint32_t tempo_no_passo_ms);
+static Resultado_Passo_t Cond_Raspagem(uint32_t tempo_no_passo_ms);
+static Resultado_Passo_t Cond_Acomodacao_Scrap(uint32_t tempo_no_passo_ms);
+
 static const Passo_Processo_t s_fluxo_processo[] =
 {
-    { SERVO_STEP_FUNNEL,   Acao_Abrir_Funil,  2000, 1 },
-    { SERVO_STEP_FUNNEL,   NULL,              500,  2 },
-    { SERVO_STEP_SCRAPER,  Acao_Varrer_Scrap, 2000, 3 },
-    { SERVO_STEP_SCRAPER,  NULL,              500,  4 },
-    { SERVO_STEP_FINISHED, Acao_Finalizar,    1,    ESTADO_OCIOSO },
+    { SERVO_STEP_FUNNEL,   Acao_Abrir_Funil,    Cond_Enchimento,        1 },
+    { SERVO_STEP_SETTLE,   Acao_Fechar_Funil,   Cond_Acomodacao_Funil,  2 },
+    { SERVO_STEP_SCRAPER,  Acao_Varrer_Scrap,   Cond_Raspagem,          3 },
+    { SERVO_STEP_SCRAPER,  Acao_Recolher_Scrap, Cond_Acomodacao_Scrap,  4 },
+    { SERVO_STEP_FINISHED, Acao_Finalizar,      NULL,                   ESTADO_OCIOSO },
 };
 #define NUM_PASSOS_PROCESSO (sizeof(s_fluxo_processo) / sizeof(s_fluxo_processo[0]))
 
 static void Entrar_No_Estado(uint8_t indice_estado);
+static void Abortar_Com_Falha(ServoStatus_t falha);
+static void Carregar_Perfil_Grao_Ativo(void);
+static bool Amostrar_Peso(void);
+static float Calcular_Taxa_Peso_g_s(void);
+static void Reiniciar_Janela_Peso(void);
+static void Aplicar_Angulos(void);
+#if ADS1232_SIMULATION_MODE
+static float Simular_Camara_g(uint32_t agora);
+#endif
 
 //================================================================================
 // Implementao
 //================================================================================
 
-void Servos_Tick_ms(void)
-{
-    if (s_timer_estado_ms > 0) s_timer_estado_ms--;
-    if (s_timer_funil > 0) s_timer_funil--;
-    if (s_timer_scrap > 0) s_timer_scrap--;
-}
-
 void Servos_Init(void)
 {
     PWM_Servo_Init(&s_servo_scrap);
     PWM_Servo_Init(&s_servo_funil);
     s_indice_estado_atual = ESTADO_OCIOSO;
+    s_status = SERVO_STATUS_OCIOSO;
+    s_angulo_funil = ANGULO_FECHADO;
+    s_angulo_scrap = ANGULO_FECHADO;
+    memset(&s_ciclo, 0, sizeof(s_ciclo));
+    Aplicar_Angulos();
 }
 
 void Servos_Process(void)
 {
-    uint32_t timer_snapshot;
+    if (s_indice_estado_atual != ESTADO_OCIOSO)
+    {
+        const Passo_Processo_t* passo = &s_fluxo_processo[s_indice_estado_atual];
+        Resultado_Passo_t resultado = PASSO_CONCLUIDO;
 
-    __disable_irq();
-    timer_snapshot = s_timer_estado_ms;
-    __enable_irq();
+        if (passo->condicao != NULL)
+        {
+            bool amostra_nova = Amostrar_Peso();
+            if (!amostra_nova && (HAL_GetTick() - s_tick_ultima_leitura_nova >= TIMEOUT_SEM_LEITURA_MS))
+            {
+                Abortar_Com_Falha(SERVO_FALHA_SEM_LEITURA_PESO);
+                resultado = PASSO_FALHOU;
+            }
+            else
+            {
+                resultado = passo->condicao(HAL_GetTick() - s_tick_entrada_estado);
+            }
+        }
 
-    if (s_indice_estado_atual != ESTADO_OCIOSO && timer_snapshot == 0)
-    {
-        uint8_t proximo_indice = s_fluxo_processo[s_indice_estado_atual].indice_proximo_estado;
-        Entrar_No_Estado(proximo_indice);
-    }
+        if (resultado == PASSO_CONCLUIDO)
+        {
+            Entrar_No_Estado(passo->indice_proximo_estado);
+        }
 
-    PWM_Servo_SetAngle(&s_servo_funil, (s_timer_funil > 0) ? ANGULO_FUNIL_ABRE : ANGULO_FECHADO);
-    PWM_Servo_SetAngle(&s_servo_scrap, (s_timer_scrap > 0) ? ANGULO_SCRAP_ABRE : ANGULO_FECHADO);
+        Aplicar_Angulos();
+    }
 }
 
 void Servos_Start_Sequence(void)
 {
     if (s_indice_estado_atual == ESTADO_OCIOSO)
     {
+        Carregar_Perfil_Grao_Ativo();
+        memset(&s_ciclo, 0, sizeof(s_ciclo));
+        s_tick_inicio_ciclo = HAL_GetTick();
+        s_status = SERVO_STATUS_EM_CURSO;
+        Medicao_Liberar_Peso();     // A malha do funil precisa da leitura viva
+#if ADS1232_SIMULATION_MODE
+        // Cmara vazia: a referncia do enchimento  a leitura fixa.
+        DadosMedicao_t dados;
+        Medicao_Get_UltimaMedicao(&dados);
+        s_peso_atual = dados.Peso;
+        s_sim_camara_g = 0.0f;
+        s_sim_tick = HAL_GetTick();
+#endif
         Entrar_No_Estado(0);
     }
 }
 
+void Servos_Abort(void)
+{
+    if (s_indice_estado_atual != ESTADO_OCIOSO)
+    {
+        Abortar_Com_Falha(SERVO_FALHA_ABORTADO);
+    }
+}
+
+void Servos_Ajustar_Clock(uint8_t divisor)
+{
+    PWM_Servo_Ajustar_Clock(&s_servo_scrap, divisor);
+    PWM_Servo_Ajustar_Clock(&s_servo_funil, divisor);
+}
+
+ServoStep_t Servos_Get_Step(void)
+{
+    if (s_indice_estado_atual == ESTADO_OCIOSO)
+    {
+        return (s_status == SERVO_STATUS_CONCLUIDO) ? SERVO_STEP_FINISHED : SERVO_STEP_IDLE;
+    }
+    return s_fluxo_processo[s_indice_estado_atual].id_passo;
+}
+
+ServoStatus_t Servos_Get_Status(void)
+{
+    return s_status;
+}
+
+bool Servos_Status_Is_Falha(ServoStatus_t status)
+{
+    return (status >= SERVO_FALHA_SEM_LEITURA_PESO);
+}
+
+const char* Servos_Get_Status_Str(ServoStatus_t status)
+{
+    switch (status)
+    {
+        case SERVO_STATUS_OCIOSO:              return "OCIOSO";
+        case SERVO_STATUS_EM_CURSO:            return "EM CURSO";
+        case SERVO_STATUS_CONCLUIDO:           return "CONCLUIDO";
+        case SERVO_FALHA_SEM_LEITURA_PESO:     return "Falha: balanca sem leitura";
+        case SERVO_FALHA_SEM_FLUXO:            return "Falha: funil sem fluxo";
+        case SERVO_FALHA_ENCHIMENTO_INCOMPLETO:return "Falha: camara incompleta";
+        case SERVO_FALHA_PESO_EXCESSIVO:       return "Falha: peso excessivo";
+        case SERVO_FALHA_RASPAGEM_SEM_QUEDA:   return "Falha: raspagem sem queda";
+        case SERVO_FALHA_ABORTADO:             return "Sequencia abortada";
+        default:                               return "Desconhecido";
+    }
+}
+
+void Servos_Get_Ultimo_Ciclo(Servo_Ciclo_Info_t* info_out)
+{
+    if (info_out != NULL)
+    {
+        memcpy(info_out, &s_ciclo, sizeof(Servo_Ciclo_Info_t));
+    }
+}
+
+//================================================================================
+// Mquina de Estados
+//================================================================================
+
 static void Entrar_No_Estado(uint8_t indice_estado)
 {
     if (indice_estado >= NUM_PASSOS_PROCESSO)
@@ -117,20 +351,336 @@ static void Entrar_No_Estado(uint8_t indice_estado)
     }
 
     s_indice_estado_atual = indice_estado;
+    s_tick_entrada_estado = HAL_GetTick();
+    s_amostras_estaveis = 0;
+
     const Passo_Processo_t* passo = &s_fluxo_processo[indice_estado];
 
     if (passo->acao != NULL)
     {
         passo->acao();
     }
+}
 
-    s_timer_estado_ms = passo->duracao_ms;
+static void Abortar_Com_Falha(ServoStatus_t falha)
+{
+    // Posio segura: funil fechado e raspador recolhido.
+    s_angulo_funil = ANGULO_FECHADO;
+    s_angulo_scrap = ANGULO_FECHADO;
+    s_ciclo.peso_final_g = s_peso_atual;
+    s_ciclo.tempo_total_ms = HAL_GetTick() - s_tick_inicio_ciclo;
+    s_status = falha;
+    s_indice_estado_atual = ESTADO_OCIOSO;
+    Aplicar_Angulos();     // Ocioso, o Process no roda mais
+    printf("SERVOS: %s (peso=%.1fg)\r\n", Servos_Get_Status_Str(falha), s_peso_atual);
+}
 
-    if (passo->id_passo == SERVO_STEP_FINISHED)
+static void Aplicar_Angulos(void)
+{
+    PWM_Servo_SetAngle(&s_servo_funil, s_angulo_funil);
+    PWM_Servo_SetAngle(&s_servo_scrap, s_angulo_scrap);
+}
+
+static void Acao_Abrir_Funil(void)
+{
+    Reiniciar_Janela_Peso();
+    s_peso_referencia = s_peso_atual;
+    s_ciclo.peso_inicial_g = s_peso_atual;
+    s_fluxo_detectado = false;
+    s_angulo_funil = ANGULO_FUNIL_ABRE;
+}
+
+static void Acao_Fechar_Funil(void)
+{
+    s_angulo_funil = ANGULO_FECHADO;
+    s_ciclo.tempo_enchimento_ms = HAL_GetTick() - s_tick_inicio_ciclo;
+}
+
+static void Acao_Varrer_Scrap(void)
+{
+    EstimadorPeso_Reiniciar(&s_estimador, s_perfil.tolerancia_previsao_mg);
+    s_peso_referencia = s_peso_atual;
+    s_ciclo.peso_enchimento_g = s_peso_atual;
+    s_angulo_scrap = ANGULO_SCRAP_ABRE;
+}
+
+static void Acao_Recolher_Scrap(void)
+{
+    s_angulo_scrap = ANGULO_FECHADO;
+}
+
+static void Acao_Finalizar(void)
+{
+    s_ciclo.peso_previsto = EstimadorPeso_Convergiu(&s_estimador);
+    s_ciclo.incerteza_final_g = (float)EstimadorPeso_Get_Incerteza_mg(&s_estimador) / 1000.0f;
+    s_ciclo.peso_final_g = s_ciclo.peso_previsto
+                           ? (float)EstimadorPeso_Get_Previsto_mg(&s_estimador) / 1000.0f
+                           : s_peso_atual;
+    if (s_ciclo.peso_previsto)
+    {
+        // A acomodao foi encurtada: a leitura viva ainda est no transitrio.
+        // Relatrio, lote, QR code e estado crtico leem o peso previsto.
+        Medicao_Fixar_Peso(s_ciclo.peso_final_g);
+    }
+    s_ciclo.tempo_total_ms = HAL_GetTick() - s_tick_inicio_ciclo;
+    s_status = SERVO_STATUS_CONCLUIDO;
+}
+
+/**
+ * @brief Funil aberto: conclui quando o peso passou do mnimo e a taxa de
+ * subida achatou (cmara cheia, excesso escorrendo pelas bordas).
+ */
+static Resultado_Passo_t Cond_Enchimento(uint32_t tempo_no_passo_ms)
+{
+    float subida = s_peso_atual - s_peso_referencia;
+
+    if (subida > s_perfil.peso_max_g)
+    {
+        Abortar_Com_Falha(SERVO_FALHA_PESO_EXCESSIVO);
+        return PASSO_FALHOU;
+    }
+
+    if (!s_fluxo_detectado)
+    {
+        if (subida >= LIMIAR_FLUXO_G)
+        {
+            s_fluxo_detectado = true;
+        }
+        else if (tempo_no_passo_ms >= s_perfil.timeout_fluxo_ms)
+        {
+            Abortar_Com_Falha(SERVO_FALHA_SEM_FLUXO);
+            return PASSO_FALHOU;
+        }
+        return PASSO_CONTINUA;
+    }
+
+    if (subida >= s_perfil.peso_min_g && s_amostras_estaveis >= AMOSTRAS_ESTAVEIS_MIN)
+    {
+        return PASSO_CONCLUIDO;
+    }
+
+    if (tempo_no_passo_ms >= s_perfil.timeout_enche_ms)
+    {
+        if (subida >= s_perfil.peso_min_g)
+        {
+            return PASSO_CONCLUIDO; // Cheio mas ainda oscilando: segue mesmo assim
+        }
+        Abortar_Com_Falha(SERVO_FALHA_ENCHIMENTO_INCOMPLETO);
+        return PASSO_FALHOU;
+    }
+
+    return PASSO_CONTINUA;
+}
+
+static Resultado_Passo_t Cond_Acomodacao_Funil(uint32_t tempo_no_passo_ms)
+{
+    return (tempo_no_passo_ms >= s_perfil.acomodacao_ms) ? PASSO_CONCLUIDO : PASSO_CONTINUA;
+}
+
+/**
+ * @brief Raspador em curso: conclui quando a queda de peso confirma a
+ * retirada do excesso e o peso voltou a estabilizar, ou quando o estimador
+ * j prev o peso final dentro da tolerncia.
+ */
+static Resultado_Passo_t Cond_Raspagem(uint32_t tempo_no_passo_ms)
+{
+    float queda = s_peso_referencia - s_peso_atual;
+
+    if (tempo_no_passo_ms >= s_perfil.curso_raspa_min_ms &&
+        queda >= s_perfil.queda_min_g &&
+        (s_amostras_estaveis >= AMOSTRAS_ESTAVEIS_MIN || EstimadorPeso_Convergiu(&s_estimador)))
+    {
+        // Registrado aqui: Entrar_No_Estado zera o tick antes da ao do prximo passo.
+        s_ciclo.tempo_raspagem_ms = tempo_no_passo_ms;
+        return PASSO_CONCLUIDO;
+    }
+
+    if (tempo_no_passo_ms >= s_perfil.timeout_raspa_ms)
     {
+        if (queda >= s_perfil.queda_min_g)
+        {
+            s_ciclo.tempo_raspagem_ms = tempo_no_passo_ms;
+            return PASSO_CONCLUIDO;
+        }
+        Abortar_Com_Falha(SERVO_FALHA_RASPAGEM_SEM_QUEDA);
+        return PASSO_FALHOU;
     }
+
+    return PASSO_CONTINUA;
 }
 
-static void Acao_Abrir_Funil(void) { s_timer_funil = 2000; }
-static void Acao_Varrer_Scrap(void) { s_timer_scrap = 2000; }
-static void Acao_Finalizar(void) {}
\ No newline at end of file
+/**
+ * @brief Raspador recolhendo: se a previso j convergiu, o peso final 
+ * aceito sem esperar a acomodao completa.
+ */
+static Resultado_Passo_t Cond_Acomodacao_Scrap(uint32_t tempo_no_passo_ms)
+{
+    if (EstimadorPeso_Convergiu(&s_estimador))
+    {
+        return PASSO_CONCLUIDO;
+    }
+    return (tempo_no_passo_ms >= s_perfil.acomodacao_ms) ? PASSO_CONCLUIDO : PASSO_CONTINUA;
+}
+
+//================================================================================
+// Perfil do Gro e Amostragem de Peso
+//================================================================================
+
+/**
+ * @brief Resolve os limites do ciclo para o gro ativo: a classe define os
+ * tempos e o Peso_Pad do produto define as faixas de peso.
+ */
+static void Carregar_Perfil_Grao_Ativo(void)
+{
+    uint8_t indice_grao = 0;
+    Gerenciador_Config_Get_Grao_Ativo(&indice_grao);
+
+    int32_t peso_pad = PESO_PAD_PADRAO_G;
+    bool semente_miuda = false;
+
+    if (indice_grao < MAX_GRAOS)
+    {
+        if (Produto[indice_grao].Peso_Pad > 0)
+        {
+            peso_pad = Produto[indice_grao].Peso_Pad;
+        }
+        for (uint8_t i = 0; i < NUM_CURVAS_SEMENTES_MIUDAS; i++)
+        {
+            if (Produto[indice_grao].Nr_Equa == s_curvas_sementes_miudas[i])
+            {
+                semente_miuda = true;
+                break;
+            }
+        }
+    }
+
+    s_perfil = semente_miuda ? s_perfil_sementes_miudas : s_perfil_graos;
+    s_perfil.peso_min_g  = (float)peso_pad * FRACAO_PESO_MIN;
+    s_perfil.peso_max_g  = (float)peso_pad * FRACAO_PESO_MAX;
+    s_perfil.queda_min_g = (float)peso_pad * FRACAO_QUEDA_MIN;
+    if (s_perfil.queda_min_g < QUEDA_MIN_ABSOLUTA_G)
+    {
+        s_perfil.queda_min_g = QUEDA_MIN_ABSOLUTA_G;
+    }
+    s_perfil.tolerancia_previsao_mg = peso_pad * TOLERANCIA_PREVISAO_MG_POR_G;
+    if (s_perfil.tolerancia_previsao_mg < TOLERANCIA_PREVISAO_MIN_MG)
+    {
+        s_perfil.tolerancia_previsao_mg = TOLERANCIA_PREVISAO_MIN_MG;
+    }
+    s_ciclo.semente_miuda = semente_miuda;
+}
+
+static void Reiniciar_Janela_Peso(void)
+{
+    s_janela_idx = 0;
+    s_janela_cont = 0;
+    s_amostras_estaveis = 0;
+    s_tick_ultima_amostra = HAL_GetTick();
+    s_tick_ultima_leitura_nova = HAL_GetTick();
+    s_contador_peso_anterior = Medicao_Get_Contador_Peso();
+
+    DadosMedicao_t dados;
+    Medicao_Get_UltimaMedicao(&dados);
+    s_peso_atual = dados.Peso;
+}
+
+/**
+ * @brief Amostra o peso a cada AMOSTRAGEM_PESO_MS e atualiza o contador de
+ * amostras estveis.
+ * @return true se a balana entregou uma leitura nova desde a ltima amostra.
+ */
+static bool Amostrar_Peso(void)
+{
+    uint32_t agora = HAL_GetTick();
+    if (agora - s_tick_ultima_amostra < AMOSTRAGEM_PESO_MS)
+    {
+        return true;
+    }
+    s_tick_ultima_amostra = agora;
+
+    uint32_t contador = Medicao_Get_Contador_Peso();
+    if (contador == s_contador_peso_anterior)
+    {
+        return false;
+    }
+    s_contador_peso_anterior = contador;
+    s_tick_ultima_leitura_nova = agora;
+
+    DadosMedicao_t dados;
+    Medicao_Get_UltimaMedicao(&dados);
+    s_peso_atual = dados.Peso;
+#if ADS1232_SIMULATION_MODE
+    s_peso_atual += Simular_Camara_g(agora);
+#endif
+
+    int32_t peso_mg = (int32_t)(s_peso_atual * 1000.0f);
+    EstimadorPeso_Adicionar(&s_estimador, peso_mg);
+    ESTIMADOR_LOG(peso_mg);
+
+    s_janela_peso[s_janela_idx] = s_peso_atual;
+    s_janela_tick[s_janela_idx] = agora;
+    s_janela_idx = (uint8_t)((s_janela_idx + 1) % JANELA_TAXA_AMOSTRAS);
+    if (s_janela_cont < JANELA_TAXA_AMOSTRAS)
+    {
+        s_janela_cont++;
+    }
+
+    float taxa = Calcular_Taxa_Peso_g_s();
+    if (s_janela_cont >= JANELA_TAXA_AMOSTRAS && taxa < s_perfil.taxa_estavel_g_s && taxa > -s_perfil.taxa_estavel_g_s)
+    {
+        if (s_amostras_estaveis < 0xFF) s_amostras_estaveis++;
+    }
+    else
+    {
+        s_amostras_estaveis = 0;
+    }
+    return true;
+}
+
+#if ADS1232_SIMULATION_MODE
+/**
+ * @brief Sem a clula de carga a leitura  fixa e todo enchimento acabaria em
+ * SEM_FLUXO. A cmara segue os ngulos: o funil aberto enche at
+ * FRACAO_SIM_CHEIO do Peso_Pad e o raspador aberto tira o excesso at o
+ * Peso_Pad, cada um na metade do tempo que o perfil do gro admite.
+ */
+static float Simular_Camara_g(uint32_t agora)
+{
+    const float dt_ms = (float)(agora - s_sim_tick);
+    s_sim_tick = agora;
+
+    const float pad = s_perfil.peso_min_g / FRACAO_PESO_MIN;
+    const float cheio = pad * FRACAO_SIM_CHEIO;
+    if (s_angulo_funil != ANGULO_FECHADO)
+    {
+        s_sim_camara_g += dt_ms * cheio / (float)(s_perfil.timeout_enche_ms / 2u);
+        if (s_sim_camara_g > cheio) s_sim_camara_g = cheio;
+    }
+    if (s_angulo_scrap != ANGULO_FECHADO && s_sim_camara_g > pad)
+    {
+        s_sim_camara_g -= dt_ms * (cheio - pad) / (float)(s_perfil.curso_raspa_min_ms / 2u);
+        if (s_sim_camara_g < pad) s_sim_camara_g = pad;
+    }
+    return s_sim_camara_g;
+}
+#endif
+
+/**
+ * @brief dP/dt entre a amostra mais antiga e a mais recente da janela.
+ */
+static float Calcular_Taxa_Peso_g_s(void)
+{
+    if (s_janela_cont < 2)
+    {
+        return 0.0f;
+    }
+    uint8_t idx_novo = (uint8_t)((s_janela_idx + JANELA_TAXA_AMOSTRAS - 1) % JANELA_TAXA_AMOSTRAS);
+    uint8_t idx_antigo = (s_janela_cont < JANELA_TAXA_AMOSTRAS) ? 0 : s_janela_idx;
+
+    uint32_t dt_ms = s_janela_tick[idx_novo] - s_janela_tick[idx_antigo];
+    if (dt_ms == 0)
+    {
+        return 0.0f;
+    }
+    return (s_janela_peso[idx_novo] - s_janela_peso[idx_antigo]) * 1000.0f / (float)dt_ms;
+}
@@ -0,0 +1,189 @@
+/*******************************************************************************
+ * @file        sono.c
+ * @brief       Acordadas peridicas de fundo durante o Stop.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O alarme do RTC no passa de 30 s (energia.c), ento um
+ * intervalo de minutos  feito de vrios Stops; o tempo dormido de cada um
+ *  somado at vencer o intervalo. As correntes do modelo so estimativas de
+ * bancada da placa inteira: em repouso o IBAT do BQ25622 fica dentro da zona
+ * morta e no mede nada til.
+ ******************************************************************************/
+
+#include "sono.h"
+#include "energia.h"
+#include "battery_handler.h"
+#include "bq_soc.h"
+#include "temporizador.h"
+#include "falha_energia.h"
+#include "main.h"
+#include <string.h>
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+static const uint32_t CORRENTE_STOP_UA     = 350;   // Placa em Stop, display desligado
+static const uint32_t CORRENTE_ACORDADO_UA = 2500;  // MCU a 12 MHz + I2C ativo
+static const float    CORRENTE_STOP_A      = (float)CORRENTE_STOP_UA / 1000000.0f;
+static const uint64_t UA_MS_POR_UAH        = 3600000u;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static volatile bool s_toque = false;
+static Sono_Relatorio_t s_relatorio;
+static uint64_t s_carga_ua_ms = 0;
+
+static Sono_Registro_t s_log[SONO_LOG_TAMANHO];
+static uint8_t s_log_proximo = 0;
+static uint8_t s_log_quantidade = 0;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint16_t Soc_Decimos(void);
+static bool Executar_Tarefas(uint32_t intervalo_ms, uint32_t instante_s, uint32_t inicio_us);
+static void Contabilizar(uint32_t dormido_ms, uint32_t acordado_us);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Sono_Dormir(void)
+{
+    s_toque = false;
+    s_relatorio.sonos++;
+    s_relatorio.soc_inicio_decimos = Soc_Decimos();
+
+    uint32_t desde_tarefas_ms = 0;     // Agenda das acordadas
+    uint32_t pendente_ms = 0;          // Dormido ainda no integrado no SoC
+    uint32_t instante_ms = 0;
+
+    for (;;)
+    {
+#if SONO_FUNDO_HABILITADO
+        const uint32_t prazo_ms = SONO_INTERVALO_MS - desde_tarefas_ms;
+#else
+        const uint32_t prazo_ms = ENERGIA_SEM_PRAZO;
+#endif
+        const uint32_t dormido_ms = Energia_Stop(prazo_ms, ENERGIA_CLOCK_REDUZIDO);
+        if (dormido_ms == ENERGIA_STOP_FALHOU)
+        {
+            // Sem RTC no h Stop: ficar no loop giraria no clock cheio at o toque.
+            break;
+        }
+        const uint32_t acordou_us = Temporizador_Get_us();
+        desde_tarefas_ms += dormido_ms;
+        pendente_ms += dormido_ms;
+        instante_ms += dormido_ms;
+
+        // Queda de energia (EXTI do POWER_GOOD ou bateria crtica) tambm no sono.
+        Falha_Energia_Process();
+
+        if (s_toque)
+        {
+            Contabilizar(dormido_ms, Temporizador_Get_us() - acordou_us);
+            break;
+        }
+
+        if (SONO_FUNDO_HABILITADO && desde_tarefas_ms >= SONO_INTERVALO_MS)
+        {
+            if (Executar_Tarefas(pendente_ms, instante_ms / 1000u, acordou_us)) pendente_ms = 0;
+            desde_tarefas_ms = 0;
+            s_relatorio.acordadas++;
+        }
+        else
+        {
+            s_relatorio.intermediarias++;
+        }
+        Contabilizar(dormido_ms, Temporizador_Get_us() - acordou_us);
+    }
+
+    // Toque (ou Stop indisponvel): volta ao clock cheio e fecha o SoC com o trecho desde a ltima acordada.
+    Energia_Set_Clock(ENERGIA_CLOCK_CHEIO);
+    Battery_Handler_Atualizar_Sono(pendente_ms, CORRENTE_STOP_A);
+    s_relatorio.soc_fim_decimos = Soc_Decimos();
+}
+
+void Sono_Sinalizar_Toque(void)
+{
+    s_toque = true;
+}
+
+void Sono_Get_Relatorio(Sono_Relatorio_t* relatorio_out)
+{
+    if (relatorio_out == NULL) return;
+
+    *relatorio_out = s_relatorio;
+    relatorio_out->carga_uAh = (uint32_t)(s_carga_ua_ms / UA_MS_POR_UAH);
+}
+
+uint8_t Sono_Get_Log(Sono_Registro_t* registros_out, uint8_t max)
+{
+    if (registros_out == NULL) return 0;
+
+    const uint8_t quantidade = (s_log_quantidade < max) ? s_log_quantidade : max;
+    const uint8_t primeiro = (uint8_t)((s_log_proximo + SONO_LOG_TAMANHO - s_log_quantidade) % SONO_LOG_TAMANHO);
+    for (uint8_t i = 0; i < quantidade; i++)
+    {
+        registros_out[i] = s_log[(primeiro + i) % SONO_LOG_TAMANHO];
+    }
+    return quantidade;
+}
+
+void Sono_Zerar(void)
+{
+    memset(&s_relatorio, 0, sizeof(s_relatorio));
+    s_carga_ua_ms = 0;
+    s_log_proximo = 0;
+    s_log_quantidade = 0;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static uint16_t Soc_Decimos(void)
+{
+    return (uint16_t)(bq_soc_get_percentage() * 10.0f);
+}
+
+/**
+ * @brief Tarefas de fundo: carregador e SoC pelo I2C (timing refeito para
+ * o clock reduzido) e o registro no log.
+ * O log fica em RAM: gravar na EEPROM custaria mais que a prpria acordada.
+ * @return false se o SoC no foi atualizado: o intervalo continua pendente.
+ */
+static bool Executar_Tarefas(uint32_t intervalo_ms, uint32_t instante_s, uint32_t inicio_us)
+{
+    if (!Battery_Handler_Atualizar_Sono(intervalo_ms, CORRENTE_STOP_A))
+    {
+        return false;
+    }
+
+    const uint32_t duracao_us = Temporizador_Get_us() - inicio_us;
+    Sono_Registro_t* registro = &s_log[s_log_proximo];
+    registro->instante_s  = instante_s;
+    registro->vbat_mv     = (uint16_t)(bq_soc_get_last_vbat() * 1000.0f);
+    registro->ibat_ma     = (int16_t)(bq_soc_get_last_ibat() * 1000.0f);
+    registro->soc_decimos = Soc_Decimos();
+    registro->acordada_us = (duracao_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)duracao_us;
+
+    s_log_proximo = (uint8_t)((s_log_proximo + 1u) % SONO_LOG_TAMANHO);
+    if (s_log_quantidade < SONO_LOG_TAMANHO) s_log_quantidade++;
+    return true;
+}
+
+/** @brief Soma tempos e a carga estimada de um ciclo Stop + acordada. */
+static void Contabilizar(uint32_t dormido_ms, uint32_t acordado_us)
+{
+    s_relatorio.dormido_ms  += dormido_ms;
+    s_relatorio.acordado_us += acordado_us;
+    if (acordado_us > s_relatorio.acordada_max_us) s_relatorio.acordada_max_us = acordado_us;
+
+    s_carga_ua_ms += (uint64_t)CORRENTE_STOP_UA * dormido_ms;
+    s_carga_ua_ms += ((uint64_t)CORRENTE_ACORDADO_UA * acordado_us) / 1000u;
+}
@@ -24,8 +24,12 @@
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
 #include "dwin_driver.h"
-#include "bq_soc.h"
 #include "ads1232_driver.h"
+#include "trace.h"
+#include "sono.h"
+#include "falha_energia.h"
+#include "escalonador.h"
+#include "app_manager.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -61,11 +65,13 @@
 /* External variables --------------------------------------------------------*/
 extern I2C_HandleTypeDef hi2c1;
 extern TIM_HandleTypeDef htim14;
+extern DMA_HandleTypeDef hdma_adc1;
 extern DMA_HandleTypeDef hdma_usart2_rx;
 extern DMA_HandleTypeDef hdma_usart2_tx;
 extern UART_HandleTypeDef huart2;
 extern PCD_HandleTypeDef hpcd_USB_DRD_FS;
 /* USER CODE BEGIN EV */
+extern RTC_HandleTypeDef hrtc;
 
 /* USER CODE END EV */
 
@@ -138,7 +144,6 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-	bq_soc_systick_callback();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -155,7 +160,7 @@ void SysTick_Handler(void)
 void EXTI4_15_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI4_15_IRQn 0 */
-
+  TRACE(TRC_ISR_EXTI, 0);
   /* USER CODE END EXTI4_15_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(SINAL_DISPLAY_Pin);
   /* USER CODE BEGIN EXTI4_15_IRQn 1 */
@@ -169,10 +174,12 @@ void EXTI4_15_IRQHandler(void)
 void USB_DRD_FS_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_DRD_FS_IRQn 0 */
-
+  TRACE(TRC_ISR_USB, 0);
   /* USER CODE END USB_DRD_FS_IRQn 0 */
   HAL_PCD_IRQHandler(&hpcd_USB_DRD_FS);
   /* USER CODE BEGIN USB_DRD_FS_IRQn 1 */
+  // Pacote recebido ou transferncia concluda: atende j, sem esperar o perodo da tarefa.
+  Escalonador_Sinalizar(TAREFA_CLI);
 
   /* USER CODE END USB_DRD_FS_IRQn 1 */
 }
@@ -183,7 +190,7 @@ void USB_DRD_FS_IRQHandler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
-
+  TRACE(TRC_ISR_DMA_UART_RX, 0);
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart2_rx);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
@@ -197,9 +204,10 @@ void DMA1_Channel1_IRQHandler(void)
 void DMA1_Channel2_3_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
-
+  TRACE(TRC_ISR_DMA_UART_TX_ADC, 0);
   /* USER CODE END DMA1_Channel2_3_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  HAL_DMA_IRQHandler(&hdma_adc1);
   /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
 
   /* USER CODE END DMA1_Channel2_3_IRQn 1 */
@@ -225,7 +233,7 @@ void TIM14_IRQHandler(void)
 void I2C1_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_IRQn 0 */
-
+  TRACE(TRC_ISR_I2C, 0);
   /* USER CODE END I2C1_IRQn 0 */
   if (hi2c1.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR))
   {
@@ -246,7 +254,7 @@ void I2C1_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  TRACE(TRC_ISR_UART, 0);
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
@@ -255,6 +263,24 @@ void USART2_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles RTC interrupt through EXTI line 19.
+  * Alarme A: acorda o Stop com prazo do gerenciador de energia.
+  */
+void RTC_IRQHandler(void)
+{
+  HAL_RTC_AlarmIRQHandler(&hrtc);
+}
+
+/**
+  * @brief This function handles EXTI line 2 and 3 interrupts.
+  * Linha 3: POWER_GOOD (armada por Falha_Energia_Init).
+  */
+void EXTI2_3_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(POWER_GOOD_Pin);
+}
+
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART2) // DWIN (UART2)
@@ -286,16 +312,22 @@ void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
     {
         Drv_ADS1232_DRDY_Callback(); // Chame a sua função de tratamento
     }
+    else if (GPIO_Pin == POWER_GOOD_Pin)
+    {
+        // Perda da entrada: a avaliação e a emergência rodam no loop principal.
+        Falha_Energia_Sinalizar();
+    }
 }
 
-// Callback genérico para outras interrupções (como a de Rising do toque)
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+// Borda de subida do toque. O HAL do C0 separa as bordas e não chama
+// HAL_GPIO_EXTI_Callback.
+void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin)
 {
     // Verifica se a interrupção veio do pino de wake-up do toque
     if (GPIO_Pin == SINAL_DISPLAY_Pin) // SINAL_DISPLAY_Pin é PC7
     {
-        // Apenas acordar o MCU é suficiente.
-        // A lógica de tratamento já está no loop principal após sair do STOP.
+        // Acorda o MCU e diferencia o toque das acordadas de fundo do Stop.
+        Sono_Sinalizar_Toque();
     }
 }
 /* USER CODE END 1 */
@@ -1,14 +1,22 @@
 /*******************************************************************************
  * @file        temp_sensor.c
- * @brief       Mdulo para leitura do sensor de temperatura interno do MCU.
- * @details     Esta implementao estvel utiliza o dado de calibrao de
- * fbrica de ponto nico (`TS_CAL1`) para fornecer uma leitura de
- * temperatura confivel e mais precisa do que os valores genricos
- * do datasheet. O resultado  a temperatura interna do chip.
+ * @brief       Aquisio de temperatura (amostra e MCU) via ADC1 + DMA.
+ * @version     2.0
+ * @author      Gabriel Agune
+ * @details     O ADC1 converte em sequncia fixa (ordem crescente de canal)
+ * o sensor interno do MCU, o VREFINT e o termistor da amostra no pino
+ * TEMP_CHIP (PB2). Cada canal usa oversampling de hardware 16x (shift 4),
+ * ento cada palavra entregue pelo DMA j  a mdia de 16 converses.
+ * A sequncia  disparada periodicamente por TempSensor_Process() e o
+ * resultado  convertido em ponto fixo (centsimos de C) fora da ISR.
+ * Nenhuma funo deste mdulo bloqueia esperando o ADC: as leituras
+ * pblicas sempre retornam o ltimo valor convertido.
  ******************************************************************************/
 
 #include "temp_sensor.h"
 #include "adc.h"
+#include "medicao_handler.h"
+#include <stdio.h>
 #include "stm32c0xx_ll_adc.h" // Inclui o header da ST que contm a definio para TEMPSENSOR_CAL1_ADDR
 
 extern ADC_HandleTypeDef hadc1;
@@ -17,63 +25,219 @@ extern ADC_HandleTypeDef hadc1;
 // Constantes de Calibrao (Especficas do Datasheet do STM32C0)
 //==============================================================================
 
-#define TEMP_CAL_P1_TEMP   15.0f // Temperatura de referncia para o ponto de calibrao 1 (em C).
+#define TEMP_CAL_P1_TEMP_C        15   // Temperatura de referncia para o ponto de calibrao 1 (em C).
+#define AVG_SLOPE_UV_POR_C        1610 // Slope da curva do sensor interno, em uV/C (1.61mV/C).
+#define VDDA_CALIBRATION_MV       3000 // Tenso de referncia usada durante a calibrao de fbrica.
+#define ADC_MAX_VALUE             4095 // Resoluo mxima de um ADC de 12 bits (2^12 - 1).
 
-#define AVG_SLOPE_TYP       0.00161f // Slope (inclinao) da curva do sensor, em Volts/C (1.61mV/C).
+//==============================================================================
+// Definies Privadas
+//==============================================================================
 
-#define VDDA_CALIBRATION_VOLTAGE 3.0f // Tenso de referncia usada durante a calibrao de fbrica.
+// Posies no buffer do DMA. Com ADC_SCAN_SEQ_FIXED a ordem  a do nmero do
+// canal: TEMPSENSOR (9), VREFINT (10), TEMP_CHIP (19).
+enum {
+    IDX_TEMP_MCU = 0,
+    IDX_VREFINT,
+    IDX_TEMP_AMOSTRA,
+    NUM_CANAIS_ADC
+};
+
+static const uint32_t PERIODO_AQUISICAO_MS = 200;
+
+/**
+ * @brief Tabela de linearizao do termistor da amostra.
+ * NTC 10k B3950 para o GND com pull-up de 10k em VDDA. Como o divisor 
+ * ratiomtrico, a contagem no depende de VDDA. Pontos a cada 5 C,
+ * contagens decrescentes com a temperatura.
+ */
+typedef struct {
+    uint16_t contagem;
+    int16_t  temp_centi_c;
+} Ponto_NTC_t;
+
+static const Ponto_NTC_t s_tabela_ntc[] = {
+    {3740, -2000}, {3629, -1500}, {3495, -1000}, {3337,  -500},
+    {3156,     0}, {2955,   500}, {2738,  1000}, {2510,  1500},
+    {2278,  2000}, {2048,  2500}, {1825,  3000}, {1614,  3500},
+    {1419,  4000}, {1241,  4500}, {1081,  5000}, { 940,  5500},
+    { 815,  6000}, { 707,  6500}, { 613,  7000}, { 532,  7500},
+    { 462,  8000},
+};
+#define NUM_PONTOS_NTC (sizeof(s_tabela_ntc) / sizeof(s_tabela_ntc[0]))
 
-#define ADC_MAX_VALUE       4095.0f // Resoluo mxima de um ADC de 12 bits (2^12 - 1).
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint16_t s_buffer_adc[NUM_CANAIS_ADC];
+static volatile bool s_conversao_pronta = false;
+static volatile bool s_conversao_em_curso = false;
+static uint32_t s_ultimo_disparo_tick = 0;
+
+static int32_t  s_temp_mcu_centi = -27300;
+static int32_t  s_temp_amostra_centi = -27300;
+static uint16_t s_vdda_mv = VDDA_CALIBRATION_MV;
+static bool     s_amostra_valida = false;
 
 //==============================================================================
-// Implementao da Funo Pblica
+// Prottipos Privados
 //==============================================================================
 
-//L a temperatura do sensor interno do MCU usando calibrao de fbrica.
-float TempSensor_GetTemperature(void)
+static void Disparar_Conversao(void);
+static void Processar_Conversao(void);
+static bool Linearizar_NTC(uint16_t contagem, int32_t* temp_centi_out);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void TempSensor_Init(void)
 {
-    uint32_t raw_temp_sensor = 0;
-
-    // Configura o ADC para ler o canal do sensor de temperatura
-    ADC_ChannelConfTypeDef sConfig = {0};
-    sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
-    sConfig.Rank = ADC_REGULAR_RANK_1;
-    sConfig.SamplingTime = ADC_SAMPLETIME_160CYCLES_5;
-		
-    if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+    if (HAL_ADCEx_Calibration_Start(&hadc1) != HAL_OK)
     {
-        return -273.0f;
+        printf("TEMP: Falha na calibracao do ADC.\r\n");
     }
+    Disparar_Conversao();
+}
 
-    if (HAL_ADC_Start(&hadc1) != HAL_OK)
+void TempSensor_Process(void)
+{
+    if (s_conversao_pronta)
     {
-        return -273.0f;
+        s_conversao_pronta = false;
+        Processar_Conversao();
     }
-    if (HAL_ADC_PollForConversion(&hadc1, 100) == HAL_OK)
+
+    if (!s_conversao_em_curso && (HAL_GetTick() - s_ultimo_disparo_tick >= PERIODO_AQUISICAO_MS))
+    {
+        Disparar_Conversao();
+    }
+}
+
+uint32_t TempSensor_Get_Proximo_ms(void)
+{
+    if (s_conversao_pronta)
+    {
+        return 0;
+    }
+    if (s_conversao_em_curso)
+    {
+        return 1;   // O ADC para no Stop: s Sleep at o fim do DMA
+    }
+    const uint32_t decorrido = HAL_GetTick() - s_ultimo_disparo_tick;
+    return (decorrido >= PERIODO_AQUISICAO_MS) ? 0 : (PERIODO_AQUISICAO_MS - decorrido);
+}
+
+float TempSensor_GetTemperature(void)
+{
+    return (float)s_temp_mcu_centi / 100.0f;
+}
+
+float TempSensor_Get_Temp_Amostra(void)
+{
+    return (float)s_temp_amostra_centi / 100.0f;
+}
+
+bool TempSensor_Temp_Amostra_Valida(void)
+{
+    return s_amostra_valida;
+}
+
+uint16_t TempSensor_Get_VDDA_mV(void)
+{
+    return s_vdda_mv;
+}
+
+//==============================================================================
+// Callbacks do HAL (contexto de interrupo)
+//==============================================================================
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    if (hadc->Instance == ADC1)
     {
-        raw_temp_sensor = HAL_ADC_GetValue(&hadc1);
+        s_conversao_em_curso = false;
+        s_conversao_pronta = true;
     }
-    HAL_ADC_Stop(&hadc1);
+}
 
-    if (raw_temp_sensor == 0)
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef* hadc)
+{
+    if (hadc->Instance == ADC1)
     {
-        return -273.0f;
+        // Descarta a sequncia; o prximo perodo dispara outra.
+        HAL_ADC_Stop_DMA(hadc);
+        s_conversao_em_curso = false;
     }
+}
 
-    // --- Incio do Clculo de Preciso Final ---
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
 
-    uint16_t temp_cal1_raw = *TEMPSENSOR_CAL1_ADDR;
+static void Disparar_Conversao(void)
+{
+    s_ultimo_disparo_tick = HAL_GetTick();
+    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t*)s_buffer_adc, NUM_CANAIS_ADC) == HAL_OK)
+    {
+        s_conversao_em_curso = true;
+    }
+}
 
-    // 2. Converte a contagem de calibrao para a tenso correspondente (V30)
-    //    usando a tenso de referncia da calibrao (3.0V).
-    float v30_calibrated = VDDA_CALIBRATION_VOLTAGE * (float)temp_cal1_raw / ADC_MAX_VALUE;
+/**
+ * @brief Converte o ltimo buffer do DMA para as grandezas fsicas.
+ * Todo o clculo  inteiro; a converso para float s ocorre nos getters.
+ */
+static void Processar_Conversao(void)
+{
+    uint32_t raw_vref = s_buffer_adc[IDX_VREFINT];
+    if (raw_vref != 0)
+    {
+        s_vdda_mv = (uint16_t)(((uint32_t)(*VREFINT_CAL_ADDR) * VREFINT_CAL_VREF) / raw_vref);
+    }
 
-    // 3. Converte a leitura atual do sensor para tenso (Vsense) usando a mesma
-    //    tenso de referncia para manter a consistncia.
-    float vsense_voltage = VDDA_CALIBRATION_VOLTAGE * (float)raw_temp_sensor / ADC_MAX_VALUE;
+    // Sensor interno: ponto nico TS_CAL1, compensado pela VDDA real.
+    uint32_t raw_mcu = s_buffer_adc[IDX_TEMP_MCU];
+    if (raw_mcu != 0)
+    {
+        int32_t vsense_uv = (int32_t)((raw_mcu * s_vdda_mv * 1000UL) / ADC_MAX_VALUE);
+        int32_t vcal_uv   = (int32_t)(((uint32_t)(*TEMPSENSOR_CAL1_ADDR) * VDDA_CALIBRATION_MV * 1000UL) / ADC_MAX_VALUE);
+        s_temp_mcu_centi  = ((vsense_uv - vcal_uv) * 100) / AVG_SLOPE_UV_POR_C + (TEMP_CAL_P1_TEMP_C * 100);
+    }
 
-    // 4. Aplica a frmula de ponto nico usando a tenso de calibrao REAL do chip.
-    float temperature_celsius = ((vsense_voltage - v30_calibrated) / AVG_SLOPE_TYP) + TEMP_CAL_P1_TEMP;
+    int32_t temp_amostra;
+    s_amostra_valida = Linearizar_NTC(s_buffer_adc[IDX_TEMP_AMOSTRA], &temp_amostra);
+    if (s_amostra_valida)
+    {
+        s_temp_amostra_centi = temp_amostra;
+        Medicao_Set_Temp_Amostra(TempSensor_Get_Temp_Amostra());
+    }
+}
 
-    return temperature_celsius;
-}
\ No newline at end of file
+/**
+ * @brief Interpolao linear na tabela do NTC.
+ * @return false se a contagem estiver fora da tabela (sensor aberto ou em curto).
+ */
+static bool Linearizar_NTC(uint16_t contagem, int32_t* temp_centi_out)
+{
+    if (contagem > s_tabela_ntc[0].contagem || contagem < s_tabela_ntc[NUM_PONTOS_NTC - 1].contagem)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 1; i < NUM_PONTOS_NTC; i++)
+    {
+        const Ponto_NTC_t* p_alto  = &s_tabela_ntc[i - 1];
+        const Ponto_NTC_t* p_baixo = &s_tabela_ntc[i];
+        if (contagem >= p_baixo->contagem)
+        {
+            int32_t delta_contagem = (int32_t)p_alto->contagem - (int32_t)p_baixo->contagem;
+            int32_t delta_temp     = (int32_t)p_baixo->temp_centi_c - (int32_t)p_alto->temp_centi_c;
+            *temp_centi_out = p_alto->temp_centi_c +
+                              (((int32_t)p_alto->contagem - (int32_t)contagem) * delta_temp) / delta_contagem;
+            return true;
+        }
+    }
+    return false;
+}
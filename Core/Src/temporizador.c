@@ -0,0 +1,367 @@
+/*******************************************************************************
+ * @file        temporizador.c
+ * @brief       Roda de temporizao (hashed timer wheel) acionada pelo TIM14.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A roda tem NUM_SLOTS posies; um temporizador com atraso d
+ * entra no slot (tick + d) % NUM_SLOTS com (d - 1) / NUM_SLOTS voltas
+ * restantes. Cada slot  uma lista duplamente encadeada de ndices, ento
+ * inserir e remover so O(1); a cada tick a ISR percorre apenas o slot
+ * corrente. Expirados so marcados num bitmask e despachados fora da ISR.
+ * Os peridicos so rearmados na prpria ISR, sem deriva acumulada.
+ ******************************************************************************/
+
+#include "temporizador.h"
+#include "secao_critica.h"
+#include <stddef.h>
+#include <stdio.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define BITS_SLOTS      5
+#define NUM_SLOTS       (1U << BITS_SLOTS)
+#define MASCARA_SLOTS   (NUM_SLOTS - 1U)
+#define NENHUM          0xFF
+
+typedef struct {
+    Temporizador_Callback_t callback;
+    uint32_t periodo_ms;
+    uint32_t voltas;
+    uint8_t  proximo;
+    uint8_t  anterior;
+    uint8_t  slot;
+    bool     alocado;
+    bool     periodico;
+    bool     na_roda;
+} Temporizador_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static TIM_HandleTypeDef* s_htim = NULL;
+static void (*s_ao_expirar)(void) = NULL;
+
+static Temporizador_t s_temporizadores[TEMPORIZADOR_MAX];
+static uint8_t s_slots[NUM_SLOTS];
+static volatile uint32_t s_tick_roda = 0;
+static volatile uint32_t s_expirados = 0;      // Bit n = temporizador n expirou
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Inserir_Na_Roda(uint8_t id, uint32_t atraso_ms);
+static void Remover_Da_Roda(uint8_t id);
+static uint32_t Restante_ms(uint8_t id);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Temporizador_Init(TIM_HandleTypeDef* htim, void (*ao_expirar)(void))
+{
+    s_htim = htim;
+    s_ao_expirar = ao_expirar;
+    s_tick_roda = 0;
+    s_expirados = 0;
+
+    for (uint8_t i = 0; i < NUM_SLOTS; i++)
+    {
+        s_slots[i] = NENHUM;
+    }
+    for (uint8_t i = 0; i < TEMPORIZADOR_MAX; i++)
+    {
+        s_temporizadores[i].alocado = false;
+        s_temporizadores[i].na_roda = false;
+    }
+
+    HAL_TIM_Base_Start_IT(s_htim);
+}
+
+Temporizador_Id_t Temporizador_Criar(Temporizador_Callback_t callback, bool periodico)
+{
+    if (callback == NULL)
+    {
+        return TEMPORIZADOR_INVALIDO;
+    }
+
+    for (uint8_t i = 0; i < TEMPORIZADOR_MAX; i++)
+    {
+        if (!s_temporizadores[i].alocado)
+        {
+            s_temporizadores[i].callback = callback;
+            s_temporizadores[i].periodico = periodico;
+            s_temporizadores[i].na_roda = false;
+            s_temporizadores[i].alocado = true;
+            return i;
+        }
+    }
+    printf("TEMPORIZADOR: Sem espaco para novo temporizador!\r\n");
+    return TEMPORIZADOR_INVALIDO;
+}
+
+bool Temporizador_Iniciar(Temporizador_Id_t id, uint32_t atraso_ms)
+{
+    if (id >= TEMPORIZADOR_MAX || !s_temporizadores[id].alocado || atraso_ms == 0)
+    {
+        return false;
+    }
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    Remover_Da_Roda(id);
+    s_expirados &= ~(1UL << id);
+    s_temporizadores[id].periodo_ms = atraso_ms;
+    Inserir_Na_Roda(id, atraso_ms);
+    SECAO_CRITICA_SAIR(sc);
+    return true;
+}
+
+void Temporizador_Parar(Temporizador_Id_t id)
+{
+    if (id >= TEMPORIZADOR_MAX)
+    {
+        return;
+    }
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    Remover_Da_Roda(id);
+    s_expirados &= ~(1UL << id);
+    SECAO_CRITICA_SAIR(sc);
+}
+
+void Temporizador_Process(void)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    uint32_t expirados = s_expirados;
+    s_expirados = 0;
+    SECAO_CRITICA_SAIR(sc);
+
+    for (uint8_t i = 0; expirados != 0; i++, expirados >>= 1)
+    {
+        if ((expirados & 1U) && s_temporizadores[i].alocado)
+        {
+            s_temporizadores[i].callback();
+        }
+    }
+}
+
+bool Temporizador_Ha_Pendentes(void)
+{
+    return (s_expirados != 0);
+}
+
+uint32_t Temporizador_Get_us(void)
+{
+    if (s_htim == NULL)
+    {
+        return HAL_GetTick() * 1000U;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t ms = s_tick_roda;
+    uint32_t contagem = __HAL_TIM_GET_COUNTER(s_htim);
+    if (__HAL_TIM_GET_FLAG(s_htim, TIM_FLAG_UPDATE))
+    {
+        // Estouro ainda no atendido pela ISR: o contador j voltou a zero.
+        contagem = __HAL_TIM_GET_COUNTER(s_htim);
+        ms++;
+    }
+    __set_PRIMASK(primask);
+
+    return ms * (__HAL_TIM_GET_AUTORELOAD(s_htim) + 1U) + contagem;
+}
+
+uint32_t Temporizador_Get_Proximo_ms(void)
+{
+    if (s_expirados != 0)
+    {
+        return 0;
+    }
+
+    uint32_t proximo = UINT32_MAX;
+    for (uint8_t i = 0; i < TEMPORIZADOR_MAX; i++)
+    {
+        if (s_temporizadores[i].na_roda)
+        {
+            uint32_t restante = Restante_ms(i);
+            if (restante < proximo) proximo = restante;
+        }
+    }
+    return proximo;
+}
+
+void Temporizador_Avancar(uint32_t ms)
+{
+    if (ms == 0)
+    {
+        return;
+    }
+
+    uint32_t restantes[TEMPORIZADOR_MAX];
+    bool expirou = false;
+
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    for (uint8_t i = 0; i < TEMPORIZADOR_MAX; i++)
+    {
+        restantes[i] = s_temporizadores[i].na_roda ? Restante_ms(i) : 0;
+        Remover_Da_Roda(i);
+    }
+    s_tick_roda += ms;
+
+    for (uint8_t i = 0; i < TEMPORIZADOR_MAX; i++)
+    {
+        Temporizador_t* t = &s_temporizadores[i];
+        if (restantes[i] == 0)
+        {
+            continue;
+        }
+        if (restantes[i] > ms)
+        {
+            Inserir_Na_Roda(i, restantes[i] - ms);
+            continue;
+        }
+
+        // Venceu durante o Stop: expira uma vez e o peridico mantm a fase.
+        s_expirados |= (1UL << i);
+        expirou = true;
+        if (t->periodico)
+        {
+            Inserir_Na_Roda(i, t->periodo_ms - ((ms - restantes[i]) % t->periodo_ms));
+        }
+    }
+    SECAO_CRITICA_SAIR(sc);
+
+    if (expirou && s_ao_expirar != NULL)
+    {
+        s_ao_expirar();
+    }
+}
+
+void Temporizador_Ajustar_Clock(uint32_t clock_timer_hz)
+{
+    if (s_htim == NULL || clock_timer_hz < 1000000U)
+    {
+        return;
+    }
+    // O PSC tem buffer: UG com URS carrega o valor novo sem pedir a ISR.
+    const uint32_t contagem = __HAL_TIM_GET_COUNTER(s_htim);
+    const uint32_t cr1 = s_htim->Instance->CR1;
+    __HAL_TIM_SET_PRESCALER(s_htim, (clock_timer_hz / 1000000U) - 1U);
+    s_htim->Instance->CR1 = cr1 | TIM_CR1_URS;
+    s_htim->Instance->EGR = TIM_EGR_UG;
+    s_htim->Instance->CR1 = cr1;
+    __HAL_TIM_SET_COUNTER(s_htim, contagem);
+}
+
+void Temporizador_Tick_ISR(void)
+{
+    uint32_t tick = ++s_tick_roda;
+    uint8_t id = s_slots[tick & MASCARA_SLOTS];
+    bool expirou = false;
+
+    while (id != NENHUM)
+    {
+        Temporizador_t* t = &s_temporizadores[id];
+        uint8_t proximo = t->proximo;   // Salvo antes: o rearme insere no incio da lista
+
+        if (t->voltas > 0)
+        {
+            t->voltas--;
+        }
+        else
+        {
+            Remover_Da_Roda(id);
+            s_expirados |= (1UL << id);
+            expirou = true;
+            if (t->periodico)
+            {
+                Inserir_Na_Roda(id, t->periodo_ms);
+            }
+        }
+        id = proximo;
+    }
+
+    if (expirou && s_ao_expirar != NULL)
+    {
+        s_ao_expirar();
+    }
+}
+
+//==============================================================================
+// Callback do HAL
+//==============================================================================
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim)
+{
+    if (s_htim != NULL && htim->Instance == s_htim->Instance)
+    {
+        Temporizador_Tick_ISR();
+    }
+}
+
+//==============================================================================
+// Implementao das Funes Privadas (chamar com interrupes bloqueadas)
+//==============================================================================
+
+static void Inserir_Na_Roda(uint8_t id, uint32_t atraso_ms)
+{
+    Temporizador_t* t = &s_temporizadores[id];
+    uint8_t slot = (uint8_t)((s_tick_roda + atraso_ms) & MASCARA_SLOTS);
+
+    t->voltas = (atraso_ms - 1U) >> BITS_SLOTS;
+    t->slot = slot;
+    t->anterior = NENHUM;
+    t->proximo = s_slots[slot];
+    if (t->proximo != NENHUM)
+    {
+        s_temporizadores[t->proximo].anterior = id;
+    }
+    s_slots[slot] = id;
+    t->na_roda = true;
+}
+
+static void Remover_Da_Roda(uint8_t id)
+{
+    Temporizador_t* t = &s_temporizadores[id];
+    if (!t->na_roda)
+    {
+        return;
+    }
+
+    if (t->anterior != NENHUM)
+    {
+        s_temporizadores[t->anterior].proximo = t->proximo;
+    }
+    else
+    {
+        s_slots[t->slot] = t->proximo;
+    }
+    if (t->proximo != NENHUM)
+    {
+        s_temporizadores[t->proximo].anterior = t->anterior;
+    }
+    t->na_roda = false;
+}
+
+/**
+ * @brief Ticks at o temporizador vencer: voltas completas mais a distncia
+ * at o slot (o slot corrente j foi visitado, ento distncia 0 = uma volta).
+ */
+static uint32_t Restante_ms(uint8_t id)
+{
+    const Temporizador_t* t = &s_temporizadores[id];
+    uint32_t distancia = (t->slot - s_tick_roda) & MASCARA_SLOTS;
+    if (distancia == 0)
+    {
+        distancia = NUM_SLOTS;
+    }
+    return (t->voltas << BITS_SLOTS) + distancia;
+}
@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * @file        trace.c
+ * @brief       Rastro binrio de eventos em RAM (ISRs e tarefas).
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O anel guarda os ltimos TRACE_NUM_REGISTROS registros. O
+ * dump sai em texto compacto, entre as linhas "TRACE INICIO" e "TRACE FIM":
+ * primeiro os nomes das tarefas ("TRC T <id> <nome>") e dos eventos
+ * ("TRC E <id> <nome>"), depois os registros, do mais antigo ao mais novo,
+ * em hexadecimal (tempo_us, id e arg com 8, 4 e 4 dgitos), vrios por
+ * linha. O Ferramentas/trace_para_chrome converte no PC para o JSON do
+ * Chrome/Perfetto.
+ ******************************************************************************/
+
+#include "trace.h"
+
+#if TRACE_HABILITADO
+
+#include "main.h"
+#include "temporizador.h"
+#include "escalonador.h"
+#include "eventos.h"
+#include "secao_critica.h"
+#include "cli_driver.h"
+
+//==============================================================================
+// Configuraes e Tipos
+//==============================================================================
+
+#define MASCARA_REGISTROS   (TRACE_NUM_REGISTROS - 1U)
+
+#define REGISTROS_POR_LINHA 8u
+#define DIGITOS_REGISTRO    16u
+
+static const uint32_t INTERVALO_DUMP_MS = 5;
+static const uint16_t ESPACO_MIN_LINHA = 160;   // Bytes livres no FIFO para uma linha
+
+typedef struct {
+    uint32_t tempo_us;
+    uint16_t id;
+    uint16_t arg;
+} Trace_Registro_t;
+
+typedef enum {
+    DUMP_INATIVO,
+    DUMP_CABECALHO,
+    DUMP_NOMES_TAREFAS,
+    DUMP_NOMES_EVENTOS,
+    DUMP_REGISTROS,
+    DUMP_FIM
+} Dump_Estado_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static Trace_Registro_t s_anel[TRACE_NUM_REGISTROS];
+static volatile uint32_t s_total = 0;           // Registros j gravados (ndice de escrita)
+static volatile bool s_congelado = false;
+
+static volatile bool s_gatilho_armado = false;
+static volatile uint16_t s_id_gatilho = 0;
+static volatile uint16_t s_pos_gatilho = 0;
+static volatile uint16_t s_restantes_gatilho = 0;
+
+static Temporizador_Id_t s_timer_dump = TEMPORIZADOR_INVALIDO;
+static Dump_Estado_t s_dump_estado = DUMP_INATIVO;
+static uint32_t s_dump_indice = 0;
+static uint32_t s_dump_fim = 0;
+static uint32_t s_dump_nome = 0;        // Prxima tarefa/evento a nomear
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Continuar_Dump(void);
+static void Imprimir_Linha_Registros(void);
+static char* Escrever_Hex(char* destino, uint32_t valor, uint8_t digitos);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Trace_Init(void)
+{
+    s_timer_dump = Temporizador_Criar(Continuar_Dump, true);
+}
+
+void Trace_Registrar(uint16_t id, uint16_t arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!s_congelado)
+    {
+        Trace_Registro_t* r = &s_anel[s_total & MASCARA_REGISTROS];
+        r->tempo_us = Temporizador_Get_us();
+        r->id = id;
+        r->arg = arg;
+        s_total++;
+
+        if (s_restantes_gatilho > 0)
+        {
+            if (--s_restantes_gatilho == 0) s_congelado = true;
+        }
+        else if (s_gatilho_armado && id == s_id_gatilho)
+        {
+            s_gatilho_armado = false;
+            if (s_pos_gatilho == 0) s_congelado = true;
+            else s_restantes_gatilho = s_pos_gatilho;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void Trace_Armar_Gatilho(Trace_Id_t id, uint16_t pos_gatilho)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    s_id_gatilho = (uint16_t)id;
+    s_pos_gatilho = pos_gatilho;
+    s_restantes_gatilho = 0;
+    s_gatilho_armado = true;
+    SECAO_CRITICA_SAIR(sc);
+}
+
+void Trace_Congelar(void)
+{
+    s_congelado = true;
+}
+
+void Trace_Liberar(void)
+{
+    SecaoCritica_t sc;
+    SECAO_CRITICA_ENTRAR(sc);
+    s_gatilho_armado = false;
+    s_restantes_gatilho = 0;
+    s_congelado = false;
+    SECAO_CRITICA_SAIR(sc);
+}
+
+bool Trace_Congelado(void)
+{
+    return s_congelado;
+}
+
+uint32_t Trace_Get_Total(void)
+{
+    return s_total;
+}
+
+void Trace_Dump(void)
+{
+    Trace_Congelar();
+
+    s_dump_fim = s_total;
+    s_dump_indice = (s_dump_fim > TRACE_NUM_REGISTROS) ? (s_dump_fim - TRACE_NUM_REGISTROS) : 0;
+    s_dump_nome = 0;
+    s_dump_estado = DUMP_CABECALHO;
+
+    Continuar_Dump();
+    Temporizador_Iniciar(s_timer_dump, INTERVALO_DUMP_MS);
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/**
+ * @brief Escreve o quanto couber no FIFO do CLI; roda pelo temporizador.
+ */
+static void Continuar_Dump(void)
+{
+    if (!CLI_Is_USB_Connected())
+    {
+        s_dump_estado = DUMP_INATIVO;
+    }
+
+    while (s_dump_estado != DUMP_INATIVO && CLI_Get_TX_Livre() >= ESPACO_MIN_LINHA)
+    {
+        switch (s_dump_estado)
+        {
+            case DUMP_CABECALHO:
+                CLI_Printf("TRACE INICIO registros=%lu\r\n", (unsigned long)(s_dump_fim - s_dump_indice));
+                s_dump_estado = DUMP_NOMES_TAREFAS;
+                break;
+
+            case DUMP_NOMES_TAREFAS:
+                if (s_dump_nome >= Escalonador_Get_Num_Tarefas())
+                {
+                    s_dump_nome = 0;
+                    s_dump_estado = DUMP_NOMES_EVENTOS;
+                    break;
+                }
+                CLI_Printf("TRC T %lu %s\r\n", (unsigned long)s_dump_nome, Escalonador_Get_Nome((uint8_t)s_dump_nome));
+                s_dump_nome++;
+                break;
+
+            case DUMP_NOMES_EVENTOS:
+                if (s_dump_nome >= NUM_TIPOS_EVENTO)
+                {
+                    s_dump_estado = DUMP_REGISTROS;
+                    break;
+                }
+                CLI_Printf("TRC E %lu %s\r\n", (unsigned long)s_dump_nome, Eventos_Get_Nome((Evento_Tipo_t)s_dump_nome));
+                s_dump_nome++;
+                break;
+
+            case DUMP_REGISTROS:
+                if (s_dump_indice >= s_dump_fim)
+                {
+                    s_dump_estado = DUMP_FIM;
+                    break;
+                }
+                Imprimir_Linha_Registros();
+                break;
+
+            case DUMP_FIM:
+            default:
+                CLI_Puts("TRACE FIM\r\n");
+                s_dump_estado = DUMP_INATIVO;
+                break;
+        }
+    }
+
+    if (s_dump_estado == DUMP_INATIVO)
+    {
+        Temporizador_Parar(s_timer_dump);
+    }
+}
+
+/**
+ * @brief At REGISTROS_POR_LINHA registros numa linha, 16 dgitos cada.
+ * Montada  mo: um vsnprintf por registro custaria dez vezes mais.
+ */
+static void Imprimir_Linha_Registros(void)
+{
+    char linha[REGISTROS_POR_LINHA * DIGITOS_REGISTRO + 3u];
+    char* p = linha;
+
+    for (uint32_t n = 0; n < REGISTROS_POR_LINHA && s_dump_indice < s_dump_fim; n++)
+    {
+        const Trace_Registro_t* r = &s_anel[s_dump_indice & MASCARA_REGISTROS];
+        p = Escrever_Hex(p, r->tempo_us, 8);
+        p = Escrever_Hex(p, r->id, 4);
+        p = Escrever_Hex(p, r->arg, 4);
+        s_dump_indice++;
+    }
+    *p++ = '\r';
+    *p++ = '\n';
+    *p = '\0';
+    CLI_Puts(linha);
+}
+
+static char* Escrever_Hex(char* destino, uint32_t valor, uint8_t digitos)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+    for (uint8_t i = digitos; i > 0u; i--)
+    {
+        destino[i - 1u] = HEX[valor & 0xFu];
+        valor >>= 4;
+    }
+    return destino + digitos;
+}
+
+#endif // TRACE_HABILITADO
@@ -60,7 +60,7 @@ void MX_USB_PCD_Init(void)
 	HAL_PCDEx_PMAConfig(&hpcd_USB_DRD_FS, 0x82, PCD_SNG_BUF, 0xE0); //EP2 IN
 	HAL_PCDEx_PMAConfig(&hpcd_USB_DRD_FS, 0x03, PCD_SNG_BUF, 0xF0); //EP3 OUT
 	
-	_ux_dcd_stm32_initialize((ULONG)NULL, (ULONG)&hpcd_USB_DRD_FS);
+	_ux_dcd_stm32_initialize(0, (ULONG)(uintptr_t)&hpcd_USB_DRD_FS); // ULONG tem 32 bits, como o ponteiro no alvo
 	HAL_PCD_Start(&hpcd_USB_DRD_FS);
   /* USER CODE END USB_Init 2 */
 
@@ -0,0 +1,248 @@
+/*******************************************************************************
+ * @file        replay_estimador.cpp
+ * @brief       Reprocessa enchimentos capturados pelo estimador do peso final.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     L o log da CDC com DEBUG_ESTIMADOR = 1 no servo_controle.c
+ * (linhas "EST;estado;tick;peso_mg;previsto;incerteza;convergiu"; as demais
+ * so ignoradas) e passa as amostras de cada enchimento pelo mesmo
+ * estimador_peso.c do firmware, com uma ou mais tolerncias. Para cada
+ * tolerncia informa em que amostra a previso convergiu, o erro contra o
+ * peso acomodado e quanto tempo a aceitao antecipada teria poupado.
+ *
+ * Um enchimento termina numa lacuna de mais de 2 s entre amostras ou quando
+ * o ndice de estado volta. O peso acomodado  a mdia das ltimas amostras,
+ * ento a captura deve seguir at o fim da acomodao (grave com a previso
+ * desligada, ou com tolerncia 0, para no encurtar o transiente).
+ *
+ * Uso: replay_estimador <captura> [--tolerancia mg[,mg...]] [--erro-max mg] [-v]
+ ******************************************************************************/
+
+extern "C" {
+#include "estimador_peso.h"
+}
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+namespace {
+
+const uint32_t LACUNA_NOVO_ENCHIMENTO_MS = 2000;
+const size_t   AMOSTRAS_REFERENCIA = 5;     // Mdia final = peso acomodado
+const size_t   AMOSTRAS_MINIMAS = 8;
+const int32_t  TOLERANCIA_PADRAO_MG = 200;  // TOLERANCIA_PREVISAO_MIN_MG
+
+struct Amostra {
+    uint32_t tick;
+    int32_t  peso_mg;
+};
+
+struct Enchimento {
+    unsigned linha;
+    std::vector<Amostra> amostras;
+};
+
+struct Resultado {
+    bool     convergiu = false;
+    size_t   amostra = 0;           // ndice (base 1) da amostra que convergiu
+    int32_t  previsto_mg = 0;
+    int32_t  incerteza_mg = 0;
+    int32_t  erro_mg = 0;
+    uint32_t poupado_ms = 0;
+};
+
+struct Resumo {
+    unsigned convergidos = 0;
+    unsigned fora_da_faixa = 0;     // |erro| maior que a incerteza informada
+    int64_t  soma_erro_abs = 0;
+    int32_t  erro_max_abs = 0;
+    uint64_t soma_poupado_ms = 0;
+};
+
+//==============================================================================
+// Leitura da captura
+//==============================================================================
+
+bool Ler_Captura(const char* arquivo, std::vector<Enchimento>& enchimentos)
+{
+    std::ifstream entrada(arquivo);
+    if (!entrada) return false;
+
+    std::string linha;
+    unsigned numero = 0;
+    long estado_anterior = -1;
+    uint32_t tick_anterior = 0;
+    while (std::getline(entrada, linha))
+    {
+        numero++;
+        const size_t inicio = linha.find("EST;");
+        if (inicio == std::string::npos) continue;
+
+        long estado = 0, peso = 0;
+        unsigned long tick = 0;
+        if (std::sscanf(linha.c_str() + inicio, "EST;%ld;%lu;%ld", &estado, &tick, &peso) != 3) continue;
+
+        const bool novo = enchimentos.empty() || estado < estado_anterior ||
+                          (uint32_t)tick - tick_anterior > LACUNA_NOVO_ENCHIMENTO_MS;
+        if (novo) enchimentos.push_back(Enchimento{numero, {}});
+        enchimentos.back().amostras.push_back(Amostra{(uint32_t)tick, (int32_t)peso});
+        estado_anterior = estado;
+        tick_anterior = (uint32_t)tick;
+    }
+    return true;
+}
+
+std::vector<int32_t> Ler_Tolerancias(const char* lista)
+{
+    std::vector<int32_t> tolerancias;
+    std::stringstream entrada(lista);
+    std::string item;
+    while (std::getline(entrada, item, ','))
+    {
+        if (!item.empty()) tolerancias.push_back((int32_t)std::strtol(item.c_str(), nullptr, 10));
+    }
+    return tolerancias;
+}
+
+//==============================================================================
+// Reprocessamento
+//==============================================================================
+
+int32_t Peso_Acomodado(const Enchimento& enchimento)
+{
+    const size_t n = enchimento.amostras.size();
+    const size_t k = (n < AMOSTRAS_REFERENCIA) ? n : AMOSTRAS_REFERENCIA;
+    int64_t soma = 0;
+    for (size_t i = n - k; i < n; i++) soma += enchimento.amostras[i].peso_mg;
+    return (int32_t)(soma / (int64_t)k);
+}
+
+/** @brief Como o servo_controle.c: aceita na primeira amostra convergida. */
+Resultado Reprocessar(const Enchimento& enchimento, int32_t tolerancia_mg, int32_t acomodado_mg)
+{
+    Resultado resultado;
+    Estimador_Peso_t estimador;
+    EstimadorPeso_Reiniciar(&estimador, tolerancia_mg);
+
+    for (size_t i = 0; i < enchimento.amostras.size(); i++)
+    {
+        EstimadorPeso_Adicionar(&estimador, enchimento.amostras[i].peso_mg);
+        if (EstimadorPeso_Convergiu(&estimador))
+        {
+            resultado.convergiu = true;
+            resultado.amostra = i + 1;
+            resultado.previsto_mg = EstimadorPeso_Get_Previsto_mg(&estimador);
+            resultado.incerteza_mg = EstimadorPeso_Get_Incerteza_mg(&estimador);
+            resultado.erro_mg = resultado.previsto_mg - acomodado_mg;
+            resultado.poupado_ms = enchimento.amostras.back().tick - enchimento.amostras[i].tick;
+            break;
+        }
+    }
+    return resultado;
+}
+
+void Somar(Resumo& resumo, const Resultado& resultado)
+{
+    if (!resultado.convergiu) return;
+    const int32_t erro_abs = std::abs(resultado.erro_mg);
+    resumo.convergidos++;
+    resumo.soma_erro_abs += erro_abs;
+    if (erro_abs > resumo.erro_max_abs) resumo.erro_max_abs = erro_abs;
+    if (erro_abs > resultado.incerteza_mg) resumo.fora_da_faixa++;
+    resumo.soma_poupado_ms += resultado.poupado_ms;
+}
+
+} // namespace
+
+//==============================================================================
+// Programa
+//==============================================================================
+
+int main(int argc, char* argv[])
+{
+    const char* arquivo = nullptr;
+    std::vector<int32_t> tolerancias{TOLERANCIA_PADRAO_MG};
+    int32_t erro_max_mg = -1;
+    bool verboso = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--tolerancia") == 0 && i + 1 < argc) tolerancias = Ler_Tolerancias(argv[++i]);
+        else if (std::strcmp(argv[i], "--erro-max") == 0 && i + 1 < argc) erro_max_mg = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-v") == 0) verboso = true;
+        else arquivo = argv[i];
+    }
+    if (arquivo == nullptr || tolerancias.empty())
+    {
+        std::fprintf(stderr, "uso: %s <captura> [--tolerancia mg[,mg...]] [--erro-max mg] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Enchimento> enchimentos;
+    if (!Ler_Captura(arquivo, enchimentos))
+    {
+        std::fprintf(stderr, "nao foi possivel abrir %s\n", arquivo);
+        return 2;
+    }
+
+    std::vector<const Enchimento*> validos;
+    for (const Enchimento& enchimento : enchimentos)
+    {
+        if (enchimento.amostras.size() >= AMOSTRAS_MINIMAS) validos.push_back(&enchimento);
+    }
+    std::printf("%zu enchimentos (%zu com menos de %zu amostras ignorados)\n",
+                validos.size(), enchimentos.size() - validos.size(), AMOSTRAS_MINIMAS);
+    if (validos.empty()) return 1;
+
+    bool falhou = false;
+    for (int32_t tolerancia : tolerancias)
+    {
+        Resumo resumo;
+        if (verboso)
+        {
+            std::printf("\ntolerancia %" PRId32 " mg\n", tolerancia);
+            std::printf(" linha amostras acomodado_mg conv_em previsto_mg  erro_mg incerteza_mg poupado_ms\n");
+        }
+        for (const Enchimento* enchimento : validos)
+        {
+            const int32_t acomodado = Peso_Acomodado(*enchimento);
+            const Resultado resultado = Reprocessar(*enchimento, tolerancia, acomodado);
+            Somar(resumo, resultado);
+            if (erro_max_mg >= 0 && resultado.convergiu && std::abs(resultado.erro_mg) > erro_max_mg) falhou = true;
+            if (!verboso) continue;
+            if (resultado.convergiu)
+            {
+                std::printf("%6u %8zu %12" PRId32 " %7zu %11" PRId32 " %8" PRId32 " %12" PRId32 " %10" PRIu32 "\n",
+                            enchimento->linha, enchimento->amostras.size(), acomodado, resultado.amostra,
+                            resultado.previsto_mg, resultado.erro_mg, resultado.incerteza_mg, resultado.poupado_ms);
+            }
+            else
+            {
+                std::printf("%6u %8zu %12" PRId32 "       -\n", enchimento->linha, enchimento->amostras.size(), acomodado);
+            }
+        }
+
+        const unsigned n = resumo.convergidos;
+        std::printf("tolerancia %6" PRId32 " mg: convergiu %u/%zu, erro medio %" PRId64 " mg, max %" PRId32
+                    " mg, %u fora da faixa, poupado %" PRIu64 " ms por enchimento\n",
+                    tolerancia, n, validos.size(), (n > 0) ? resumo.soma_erro_abs / n : 0, resumo.erro_max_abs,
+                    resumo.fora_da_faixa, (n > 0) ? resumo.soma_poupado_ms / n : 0);
+    }
+
+    if (falhou)
+    {
+        std::printf("FALHA: erro acima de %" PRId32 " mg\n", erro_max_mg);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*******************************************************************************
+ * @file        simbolizar_perfil.cpp
+ * @brief       Resolve o dump do profiler (PROF DUMP) em funes e categorias.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     L o log da CDC com o dump ("PROF INICIO ...", linhas
+ * "endereco contagem", "PROF FIM"; o resto do log  ignorado) e a tabela de
+ * smbolos do firmware: o .map do Keil (Image Symbol Table) ou o .axf (ELF).
+ * Cada balde cobre uma faixa de endereos que pode conter mais de uma
+ * funo; a contagem  repartida entre elas na proporo dos bytes de cada
+ * uma dentro da faixa. O resultado sai por funo e por categoria
+ * (soft-float, HAL, USBX, runtime da biblioteca e aplicao).
+ *
+ * Uso: simbolizar_perfil <dump> <firmware.map|firmware.axf> [--top N]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+namespace {
+
+const uint32_t BALDE_PADRAO = 256;      // PROFILER_BITS_BALDE = 8
+const size_t   TOP_PADRAO = 25;
+const char*    SEM_SIMBOLO = "(sem simbolo)";
+
+struct Simbolo {
+    std::string nome;
+    std::string objeto;
+    uint32_t    inicio;
+    uint32_t    tamanho;
+};
+
+struct Perfil {
+    uint32_t amostras = 0;
+    uint32_t fora_flash = 0;
+    uint32_t balde = BALDE_PADRAO;
+    std::vector<std::pair<uint32_t, uint32_t>> baldes;   // endereo, contagem
+};
+
+struct Acumulado {
+    std::string objeto;
+    double      amostras = 0.0;
+};
+
+bool Termina_Com(const std::string& texto, const char* sufixo)
+{
+    const size_t n = std::strlen(sufixo);
+    return texto.size() >= n && texto.compare(texto.size() - n, n, sufixo) == 0;
+}
+
+bool Comeca_Com(const std::string& texto, const char* prefixo)
+{
+    return texto.compare(0, std::strlen(prefixo), prefixo) == 0;
+}
+
+//==============================================================================
+// Dump do profiler
+//==============================================================================
+
+bool Ler_Dump(const char* arquivo, Perfil& perfil)
+{
+    std::ifstream entrada(arquivo);
+    if (!entrada) return false;
+
+    std::string linha;
+    while (std::getline(entrada, linha))
+    {
+        unsigned long a = 0, b = 0, c = 0;
+        const size_t inicio = linha.find("PROF INICIO");
+        if (inicio != std::string::npos)
+        {
+            if (std::sscanf(linha.c_str() + inicio, "PROF INICIO amostras=%lu fora=%lu balde=%lu", &a, &b, &c) == 3)
+            {
+                perfil.amostras = (uint32_t)a;
+                perfil.fora_flash = (uint32_t)b;
+                perfil.balde = (uint32_t)c;
+            }
+            perfil.baldes.clear();          // Vale o ltimo dump do log
+            continue;
+        }
+
+        char hex[9] = {0};
+        if (std::sscanf(linha.c_str(), "%8[0-9A-Fa-f] %lu", hex, &b) == 2 && std::strlen(hex) == 8)
+        {
+            perfil.baldes.emplace_back((uint32_t)std::strtoul(hex, nullptr, 16), (uint32_t)b);
+        }
+    }
+    return true;
+}
+
+//==============================================================================
+// Tabela de smbolos
+//==============================================================================
+
+/**
+ * @brief Image Symbol Table do armlink: "nome 0xendereco Thumb Code tamanho
+ * objeto(secao)", nas partes Local e Global. O bit 0 (Thumb)  descartado.
+ */
+bool Ler_Map(const char* arquivo, std::vector<Simbolo>& simbolos)
+{
+    std::ifstream entrada(arquivo);
+    if (!entrada) return false;
+
+    std::string linha;
+    bool na_tabela = false;
+    while (std::getline(entrada, linha))
+    {
+        if (linha.find("Image Symbol Table") != std::string::npos) { na_tabela = true; continue; }
+        if (linha.find("Memory Map of the image") != std::string::npos) break;
+        if (!na_tabela || linha.find("Thumb Code") == std::string::npos) continue;
+
+        std::istringstream campos(linha);
+        std::string nome, valor, thumb, code, objeto;
+        unsigned long tamanho = 0;
+        if (!(campos >> nome >> valor >> thumb >> code >> tamanho >> objeto)) continue;
+        if (tamanho == 0) continue;
+
+        const size_t parentese = objeto.find('(');
+        if (parentese != std::string::npos) objeto.erase(parentese);
+        const uint32_t inicio = (uint32_t)std::strtoul(valor.c_str(), nullptr, 16) & ~1u;
+        simbolos.push_back(Simbolo{nome, objeto, inicio, (uint32_t)tamanho});
+    }
+    return true;
+}
+
+template <typename T>
+T Ler_Le(const std::vector<uint8_t>& dados, size_t deslocamento)
+{
+    T valor = 0;
+    for (size_t i = 0; i < sizeof(T); i++) valor |= (T)((T)dados[deslocamento + i] << (8u * i));
+    return valor;
+}
+
+/** @brief Funes (STT_FUNC) da .symtab de um ELF32 little-endian. */
+bool Ler_Elf(const char* arquivo, std::vector<Simbolo>& simbolos)
+{
+    std::ifstream entrada(arquivo, std::ios::binary);
+    if (!entrada) return false;
+    const std::vector<uint8_t> dados((std::istreambuf_iterator<char>(entrada)), std::istreambuf_iterator<char>());
+    if (dados.size() < 52 || std::memcmp(dados.data(), "\x7F" "ELF", 4) != 0 || dados[4] != 1 || dados[5] != 1)
+    {
+        return false;
+    }
+
+    const uint32_t shoff = Ler_Le<uint32_t>(dados, 32);
+    const uint16_t shentsize = Ler_Le<uint16_t>(dados, 46);
+    const uint16_t shnum = Ler_Le<uint16_t>(dados, 48);
+    if ((uint64_t)shoff + (uint64_t)shnum * shentsize > dados.size()) return false;
+
+    for (uint16_t s = 0; s < shnum; s++)
+    {
+        const size_t sh = shoff + (size_t)s * shentsize;
+        if (Ler_Le<uint32_t>(dados, sh + 4) != 2u) continue;           // SHT_SYMTAB
+
+        const uint32_t offset = Ler_Le<uint32_t>(dados, sh + 16);
+        const uint32_t tamanho = Ler_Le<uint32_t>(dados, sh + 20);
+        const uint32_t link = Ler_Le<uint32_t>(dados, sh + 24);
+        const size_t shstr = shoff + (size_t)link * shentsize;
+        const uint32_t str_offset = Ler_Le<uint32_t>(dados, shstr + 16);
+        if ((uint64_t)offset + tamanho > dados.size()) return false;
+
+        for (uint32_t e = offset; e + 16 <= offset + tamanho; e += 16)
+        {
+            const uint32_t nome = Ler_Le<uint32_t>(dados, e);
+            const uint32_t valor = Ler_Le<uint32_t>(dados, e + 4);
+            const uint32_t tam = Ler_Le<uint32_t>(dados, e + 8);
+            if ((dados[e + 12] & 0x0Fu) != 2u || tam == 0) continue;   // STT_FUNC
+            if ((size_t)str_offset + nome >= dados.size()) continue;
+            const char* texto = reinterpret_cast<const char*>(&dados[str_offset + nome]);
+            simbolos.push_back(Simbolo{texto, "", valor & ~1u, tam});
+        }
+        return true;
+    }
+    return false;
+}
+
+//==============================================================================
+// Classificao
+//==============================================================================
+
+std::string Categoria(const Simbolo& simbolo)
+{
+    static const char* const PREFIXOS_FLOAT[] = {
+        "__aeabi_f", "__aeabi_d", "__aeabi_i2f", "__aeabi_ui2f", "__aeabi_i2d", "__aeabi_ui2d",
+        "__aeabi_l2f", "__aeabi_ul2f", "__aeabi_l2d", "__aeabi_ul2d", "__aeabi_cf", "__aeabi_cd",
+        "_fp", "__fp", "_float", "_double", "__ARM_scalbn", "__ARM_fpclassify", "__hardfp_", "__softfp_",
+    };
+    static const char* const FUNCOES_MATEMATICAS[] = {
+        "expf", "logf", "log10f", "powf", "sqrtf", "sinf", "cosf", "tanf", "atanf", "atan2f",
+        "floorf", "ceilf", "roundf", "fmodf", "frexp", "ldexp", "exp", "log", "pow", "sqrt",
+    };
+
+    const std::string& n = simbolo.nome;
+    const std::string& o = simbolo.objeto;
+    for (const char* prefixo : PREFIXOS_FLOAT) if (Comeca_Com(n, prefixo)) return "soft-float";
+    for (const char* funcao : FUNCOES_MATEMATICAS) if (n == funcao) return "soft-float";
+    if (Termina_Com(o, "epilogue.o")) return "soft-float";
+
+    if (Comeca_Com(n, "HAL_") || Comeca_Com(n, "LL_") || Comeca_Com(n, "USB_") ||
+        Comeca_Com(o, "stm32c0xx_hal") || Comeca_Com(o, "stm32c0xx_ll")) return "HAL";
+    if (Comeca_Com(n, "_ux") || Comeca_Com(n, "ux_") || Comeca_Com(o, "ux_")) return "USBX";
+    if (Comeca_Com(n, "__") || Comeca_Com(n, "_printf") || Comeca_Com(n, "_scanf") || Comeca_Com(n, "_sys") ||
+        Comeca_Com(n, "mem") || Comeca_Com(n, "str") || Comeca_Com(n, "ato") ||
+        n.find("printf") != std::string::npos || n == "fputc") return "runtime";
+    return "aplicacao";
+}
+
+//==============================================================================
+// Resoluo
+//==============================================================================
+
+/** @brief Reparte cada balde entre os smbolos que cruzam a sua faixa. */
+std::map<std::string, Acumulado> Resolver(const Perfil& perfil, const std::vector<Simbolo>& simbolos)
+{
+    std::map<std::string, Acumulado> funcoes;
+    for (const auto& balde : perfil.baldes)
+    {
+        const uint64_t inicio = balde.first;
+        const uint64_t fim = inicio + perfil.balde;
+        uint64_t coberto = 0;
+        std::vector<std::pair<const Simbolo*, uint64_t>> partes;
+
+        for (const Simbolo& simbolo : simbolos)
+        {
+            if (simbolo.inicio >= fim) break;
+            const uint64_t a = std::max<uint64_t>(inicio, simbolo.inicio);
+            const uint64_t b = std::min<uint64_t>(fim, (uint64_t)simbolo.inicio + simbolo.tamanho);
+            if (b <= a) continue;
+            partes.emplace_back(&simbolo, b - a);
+            coberto += b - a;
+        }
+
+        if (partes.empty())
+        {
+            funcoes[SEM_SIMBOLO].amostras += balde.second;
+            continue;
+        }
+        for (const auto& parte : partes)
+        {
+            Acumulado& acumulado = funcoes[parte.first->nome];
+            acumulado.objeto = parte.first->objeto;
+            acumulado.amostras += (double)balde.second * (double)parte.second / (double)coberto;
+        }
+    }
+    return funcoes;
+}
+
+} // namespace
+
+//==============================================================================
+// Programa
+//==============================================================================
+
+int main(int argc, char* argv[])
+{
+    const char* arquivos[2] = {nullptr, nullptr};
+    size_t top = TOP_PADRAO;
+    int posicional = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) top = (size_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (posicional < 2) arquivos[posicional++] = argv[i];
+    }
+    if (posicional != 2)
+    {
+        std::fprintf(stderr, "uso: %s <dump> <firmware.map|firmware.axf> [--top N]\n", argv[0]);
+        return 2;
+    }
+
+    Perfil perfil;
+    if (!Ler_Dump(arquivos[0], perfil) || perfil.baldes.empty())
+    {
+        std::fprintf(stderr, "nenhum balde do PROF DUMP em %s\n", arquivos[0]);
+        return 1;
+    }
+
+    std::vector<Simbolo> simbolos;
+    const std::string firmware = arquivos[1];
+    const bool elf = Termina_Com(firmware, ".axf") || Termina_Com(firmware, ".elf");
+    if (!(elf ? Ler_Elf(arquivos[1], simbolos) : Ler_Map(arquivos[1], simbolos)) || simbolos.empty())
+    {
+        std::fprintf(stderr, "nenhum simbolo de codigo em %s\n", arquivos[1]);
+        return 1;
+    }
+    // Ordenados por endereo; apelidos (mesmo incio e tamanho) ficam com o primeiro nome.
+    std::stable_sort(simbolos.begin(), simbolos.end(),
+                     [](const Simbolo& a, const Simbolo& b) { return a.inicio < b.inicio; });
+    simbolos.erase(std::unique(simbolos.begin(), simbolos.end(),
+                               [](const Simbolo& a, const Simbolo& b) {
+                                   return a.inicio == b.inicio && a.tamanho == b.tamanho;
+                               }),
+                   simbolos.end());
+
+    const std::map<std::string, Acumulado> funcoes = Resolver(perfil, simbolos);
+    double total = 0.0;
+    std::map<std::string, double> categorias;
+    for (const auto& funcao : funcoes)
+    {
+        total += funcao.second.amostras;
+        const std::string categoria = (funcao.first == SEM_SIMBOLO)
+                                    ? SEM_SIMBOLO : Categoria(Simbolo{funcao.first, funcao.second.objeto, 0, 0});
+        categorias[categoria] += funcao.second.amostras;
+    }
+
+    std::printf("%.0f amostras na flash, %" PRIu32 " fora, baldes de %" PRIu32 " bytes, %zu simbolos\n",
+                total, perfil.fora_flash, perfil.balde, simbolos.size());
+
+    std::vector<std::pair<std::string, double>> ordem(categorias.begin(), categorias.end());
+    std::sort(ordem.begin(), ordem.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    std::printf("\n%-16s %10s %7s\n", "categoria", "amostras", "%");
+    for (const auto& categoria : ordem)
+    {
+        std::printf("%-16s %10.1f %6.1f%%\n", categoria.first.c_str(), categoria.second, 100.0 * categoria.second / total);
+    }
+
+    std::vector<std::pair<std::string, const Acumulado*>> lista;
+    for (const auto& funcao : funcoes) lista.emplace_back(funcao.first, &funcao.second);
+    std::sort(lista.begin(), lista.end(),
+              [](const auto& a, const auto& b) { return a.second->amostras > b.second->amostras; });
+    std::printf("\n%-40s %-34s %10s %7s\n", "funcao", "objeto", "amostras", "%");
+    for (size_t i = 0; i < lista.size() && i < top; i++)
+    {
+        std::printf("%-40s %-34s %10.1f %6.1f%%\n", lista[i].first.c_str(), lista[i].second->objeto.c_str(),
+                    lista[i].second->amostras, 100.0 * lista[i].second->amostras / total);
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*******************************************************************************
+ * @file        trace_para_chrome.cpp
+ * @brief       Converte o dump do TRACE DUMP no JSON do Chrome/Perfetto.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     L uma captura da CDC (terminal salvo em arquivo, ou a sada
+ * do stm_vcom_sim com -v) e usa o ltimo bloco entre "TRACE INICIO" e
+ * "TRACE FIM" (formato no trace.c). Incio/fim de tarefa viram fatias na
+ * linha "Tarefas", ISRs viram marcas instantneas na linha "ISRs" e os
+ * eventos publicados/despachados, na linha "Eventos", com os nomes que o
+ * prprio dump informa. Os tempos so relativos ao registro mais antigo;
+ * a volta do contador de 32 bits em us  compensada.
+ *
+ * O JSON abre em chrome://tracing ou ui.perfetto.dev. Um resumo por tarefa
+ * (execues, tempo total e mximo) sai no terminal.
+ *
+ * Uso: trace_para_chrome <captura> [saida.json]   (sem sada: JSON no stdout)
+ ******************************************************************************/
+
+extern "C" {
+#include "trace.h"
+}
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+namespace {
+
+const size_t DIGITOS_REGISTRO = 16;     // tempo_us (8), id (4), arg (4)
+
+enum Linha_Tempo {
+    TID_TAREFAS = 1,
+    TID_ISRS = 2,
+    TID_EVENTOS = 3
+};
+
+struct Registro {
+    uint32_t tempo_us;
+    uint16_t id;
+    uint16_t arg;
+};
+
+struct Dump {
+    unsigned long anunciados = 0;
+    bool completo = false;
+    std::map<unsigned, std::string> tarefas;
+    std::map<unsigned, std::string> eventos;
+    std::vector<Registro> registros;
+};
+
+struct Uso_Tarefa {
+    unsigned execucoes = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+};
+
+const char* Nome_Id(uint16_t id)
+{
+    switch (id)
+    {
+        case TRC_ISR_EXTI:            return "ISR_EXTI";
+        case TRC_ISR_USB:             return "ISR_USB";
+        case TRC_ISR_DMA_UART_RX:     return "ISR_DMA_RX";
+        case TRC_ISR_DMA_UART_TX_ADC: return "ISR_DMA_TX_ADC";
+        case TRC_ISR_I2C:             return "ISR_I2C";
+        case TRC_ISR_UART:            return "ISR_UART";
+        case TRC_MARCA:               return "MARCA";
+        default:                      return "?";
+    }
+}
+
+std::string Nome(const std::map<unsigned, std::string>& nomes, unsigned id)
+{
+    const auto it = nomes.find(id);
+    return (it != nomes.end()) ? it->second : "#" + std::to_string(id);
+}
+
+//==============================================================================
+// Leitura da captura
+//==============================================================================
+
+bool Hex(const std::string& texto, size_t inicio, size_t digitos, uint32_t& valor)
+{
+    valor = 0;
+    for (size_t i = inicio; i < inicio + digitos; i++)
+    {
+        const char c = texto[i];
+        uint32_t nibble;
+        if (c >= '0' && c <= '9') nibble = (uint32_t)(c - '0');
+        else if (c >= 'A' && c <= 'F') nibble = (uint32_t)(c - 'A' + 10);
+        else if (c >= 'a' && c <= 'f') nibble = (uint32_t)(c - 'a' + 10);
+        else return false;
+        valor = (valor << 4) | nibble;
+    }
+    return true;
+}
+
+/** @brief Uma linha de registros: mltiplo de 16 dgitos, nada mais. */
+bool Ler_Registros(const std::string& linha, std::vector<Registro>& registros)
+{
+    if (linha.empty() || linha.size() % DIGITOS_REGISTRO != 0) return false;
+
+    std::vector<Registro> lidos;
+    for (size_t i = 0; i < linha.size(); i += DIGITOS_REGISTRO)
+    {
+        uint32_t tempo, id, arg;
+        if (!Hex(linha, i, 8, tempo) || !Hex(linha, i + 8, 4, id) || !Hex(linha, i + 12, 4, arg)) return false;
+        lidos.push_back(Registro{tempo, (uint16_t)id, (uint16_t)arg});
+    }
+    registros.insert(registros.end(), lidos.begin(), lidos.end());
+    return true;
+}
+
+/** @brief Guarda o ltimo bloco; um TRACE INICIO novo descarta o anterior. */
+bool Ler_Captura(const char* arquivo, Dump& dump)
+{
+    std::ifstream entrada(arquivo, std::ios::binary);
+    if (!entrada) return false;
+
+    bool dentro = false;
+    std::string linha;
+    while (std::getline(entrada, linha))
+    {
+        while (!linha.empty() && (linha.back() == '\r' || linha.back() == ' ')) linha.pop_back();
+        // O prompt da CLI pode cair no meio do dump, que segue pelo temporizador.
+        while (linha.compare(0, 2, "> ") == 0) linha.erase(0, 2);
+
+        const size_t inicio = linha.find("TRACE INICIO registros=");
+        if (inicio != std::string::npos)
+        {
+            dump = Dump();
+            dump.anunciados = std::strtoul(linha.c_str() + inicio + std::strlen("TRACE INICIO registros="), nullptr, 10);
+            dentro = true;
+            continue;
+        }
+        if (!dentro) continue;
+
+        unsigned id = 0;
+        char nome[64];
+        if (linha == "TRACE FIM")
+        {
+            dump.completo = true;
+            dentro = false;
+        }
+        else if (std::sscanf(linha.c_str(), "TRC T %u %63s", &id, nome) == 2) dump.tarefas[id] = nome;
+        else if (std::sscanf(linha.c_str(), "TRC E %u %63s", &id, nome) == 2) dump.eventos[id] = nome;
+        else (void)Ler_Registros(linha, dump.registros);
+    }
+    return true;
+}
+
+//==============================================================================
+// Converso
+//==============================================================================
+
+void Escrever_Evento(FILE* saida, bool& primeiro, const std::string& nome, const char* fase,
+                     uint64_t ts, int tid, const char* extra)
+{
+    std::fprintf(saida, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%d%s}",
+                 primeiro ? "" : ",\n", nome.c_str(), fase, ts, tid, extra);
+    primeiro = false;
+}
+
+void Escrever_Json(FILE* saida, const Dump& dump, std::map<unsigned, Uso_Tarefa>& uso)
+{
+    bool primeiro = true;
+    std::fprintf(saida, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const std::pair<int, const char*> linhas[] = {
+        {TID_TAREFAS, "Tarefas"}, {TID_ISRS, "ISRs"}, {TID_EVENTOS, "Eventos"}};
+    for (const auto& l : linhas)
+    {
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), ",\"args\":{\"name\":\"%s\"}", l.second);
+        Escrever_Evento(saida, primeiro, "thread_name", "M", 0, l.first, extra);
+    }
+
+    uint64_t ts = 0;
+    bool tarefa_aberta = false;
+    unsigned tarefa = 0;
+    uint64_t tarefa_inicio = 0;
+    for (size_t i = 0; i < dump.registros.size(); i++)
+    {
+        const Registro& r = dump.registros[i];
+        if (i > 0) ts += (uint32_t)(r.tempo_us - dump.registros[i - 1].tempo_us);
+
+        char extra[64];
+        switch (r.id)
+        {
+            case TRC_TAREFA_INICIO:
+                // Sem preempo entre tarefas: um incio sem fim  um registro perdido.
+                if (tarefa_aberta) Escrever_Evento(saida, primeiro, Nome(dump.tarefas, tarefa), "E", ts, TID_TAREFAS, "");
+                Escrever_Evento(saida, primeiro, Nome(dump.tarefas, r.arg), "B", ts, TID_TAREFAS, "");
+                tarefa_aberta = true;
+                tarefa = r.arg;
+                tarefa_inicio = ts;
+                break;
+
+            case TRC_TAREFA_FIM:
+                // O anel pode comear no meio de uma tarefa: o fim sem incio fica de fora.
+                if (!tarefa_aberta || tarefa != r.arg) break;
+                Escrever_Evento(saida, primeiro, Nome(dump.tarefas, r.arg), "E", ts, TID_TAREFAS, "");
+                tarefa_aberta = false;
+                {
+                    Uso_Tarefa& u = uso[r.arg];
+                    const uint64_t duracao = ts - tarefa_inicio;
+                    u.execucoes++;
+                    u.total_us += duracao;
+                    if (duracao > u.max_us) u.max_us = duracao;
+                }
+                break;
+
+            case TRC_EVENTO_PUBLICADO:
+            case TRC_EVENTO_DESPACHADO:
+                std::snprintf(extra, sizeof(extra), ",\"s\":\"t\",\"args\":{\"fase\":\"%s\"}",
+                              (r.id == TRC_EVENTO_PUBLICADO) ? "publicado" : "despachado");
+                Escrever_Evento(saida, primeiro, Nome(dump.eventos, r.arg), "i", ts, TID_EVENTOS, extra);
+                break;
+
+            default:
+                std::snprintf(extra, sizeof(extra), ",\"s\":\"t\",\"args\":{\"arg\":%u}", (unsigned)r.arg);
+                Escrever_Evento(saida, primeiro, Nome_Id(r.id), "i", ts,
+                                (r.id >= TRC_ISR_EXTI && r.id <= TRC_ISR_UART) ? TID_ISRS : TID_TAREFAS, extra);
+                break;
+        }
+    }
+    if (tarefa_aberta) Escrever_Evento(saida, primeiro, Nome(dump.tarefas, tarefa), "E", ts, TID_TAREFAS, "");
+    std::fprintf(saida, "\n]}\n");
+}
+
+} // namespace
+
+//==============================================================================
+// Programa
+//==============================================================================
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "uso: %s <captura> [saida.json]\n", argv[0]);
+        return 2;
+    }
+
+    Dump dump;
+    if (!Ler_Captura(argv[1], dump))
+    {
+        std::fprintf(stderr, "nao foi possivel abrir %s\n", argv[1]);
+        return 2;
+    }
+    if (dump.registros.empty())
+    {
+        std::fprintf(stderr, "nenhum dump do TRACE em %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* saida = stdout;
+    if (argc == 3 && (saida = std::fopen(argv[2], "w")) == nullptr)
+    {
+        std::fprintf(stderr, "nao foi possivel criar %s\n", argv[2]);
+        return 2;
+    }
+    std::map<unsigned, Uso_Tarefa> uso;
+    Escrever_Json(saida, dump, uso);
+    if (saida != stdout) std::fclose(saida);
+
+    // Com o JSON no stdout, o resumo vai para o stderr.
+    FILE* resumo = (saida == stdout) ? stderr : stdout;
+    const uint64_t janela_us = (uint32_t)(dump.registros.back().tempo_us - dump.registros.front().tempo_us);
+    std::fprintf(resumo, "%zu registros em %.3f ms, %zu tarefas, %zu eventos nomeados\n",
+                 dump.registros.size(), janela_us / 1000.0, dump.tarefas.size(), dump.eventos.size());
+    std::fprintf(resumo, "tarefa        execucoes   total_us   max_us\n");
+    for (const auto& u : uso)
+    {
+        std::fprintf(resumo, "%-12s %10u %10" PRIu64 " %8" PRIu64 "\n", Nome(dump.tarefas, u.first).c_str(),
+                     u.second.execucoes, u.second.total_us, u.second.max_us);
+    }
+
+    if (!dump.completo || dump.registros.size() != dump.anunciados)
+    {
+        std::fprintf(resumo, "FALHA: dump incompleto (%zu de %lu registros%s)\n", dump.registros.size(),
+                     dump.anunciados, dump.completo ? "" : ", sem TRACE FIM");
+        return 1;
+    }
+    return 0;
+}
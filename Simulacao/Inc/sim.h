@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * @file        sim.h
+ * @brief       Ncleo da simulao no PC: tempo virtual, interrupes e as
+ *              entradas e sadas dos modelos de hardware.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O tempo s anda quando o firmware chama o HAL (cada chamada
+ * custa SIM_CICLOS_CHAMADA ciclos no clock atual), quando espera em WFI ou
+ * Stop (salta at o prximo evento) ou quando um modelo conta a durao de
+ * uma transferncia bloqueante. As interrupes so entregues nesses pontos,
+ * respeitando o PRIMASK; uma ISR no  interrompida por outra.
+ *
+ * Os modelos (UART/display, I2C/EEPROM/carregador, USB CDC, GPIO/EXTI, TIM,
+ * RTC, ADC) agendam eventos numa agenda com uma posio por fonte.
+ ******************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stm32c0xx_hal.h"
+
+//==============================================================================
+// Tempo virtual e ncleo (sim_nucleo.c)
+//==============================================================================
+
+#define SIM_CICLOS_CHAMADA      48u         // CPU gasta por chamada ao HAL simulado
+#define SIM_NUNCA               UINT64_MAX
+
+typedef enum {
+    SIM_FONTE_UART_TX,
+    SIM_FONTE_UART_RX,
+    SIM_FONTE_I2C,
+    SIM_FONTE_ADC,
+    SIM_FONTE_RTC,
+    SIM_FONTE_USB,
+    SIM_FONTE_USB_RX,
+    SIM_FONTE_ROTEIRO,
+    SIM_FONTE_FIM,
+    NUM_SIM_FONTES
+} Sim_Fonte_t;
+
+typedef struct {
+    uint64_t ativo_ns;
+    uint64_t sleep_ns;
+    uint64_t stop_ns;
+    uint32_t entradas_sleep;
+    uint32_t entradas_stop;
+    uint32_t systicks;
+    uint32_t irqs[32];
+} Sim_Estatisticas_t;
+
+void     Sim_Reiniciar(void);
+uint64_t Sim_Agora_ns(void);
+uint32_t Sim_Agora_ms(void);
+
+/** @brief CPU ocupada por 'ns'; interrupes pendentes so atendidas depois. */
+void Sim_Consumir_ns(uint64_t ns);
+
+/** @brief CPU ocupada por 'ciclos' do HCLK atual (o custo cai com o clock). */
+void Sim_Consumir_Ciclos(uint32_t ciclos);
+
+/** @brief Custo fixo de uma chamada ao HAL simulado. */
+#define SIM_CHAMADA()           Sim_Consumir_Ciclos(SIM_CICLOS_CHAMADA)
+
+/** @brief Agenda 'ao_vencer' para o instante dado (substitui o anterior da fonte). */
+void Sim_Agendar(Sim_Fonte_t fonte, uint64_t instante_ns, void (*ao_vencer)(void));
+void Sim_Cancelar(Sim_Fonte_t fonte);
+bool Sim_Agendado(Sim_Fonte_t fonte);
+
+/** @brief Marca a IRQ como pendente (entregue quando habilitada e fora do PRIMASK). */
+void Sim_Pendurar_Irq(IRQn_Type irq);
+void Sim_Habilitar_Irq(IRQn_Type irq, bool habilitar);
+void Sim_Prioridade_Irq(IRQn_Type irq, uint32_t prioridade);
+
+/** @brief Stop: contadores e SysTick parados at uma IRQ de EXTI, RTC ou USB. */
+void Sim_Stop(void);
+bool Sim_Em_Stop(void);
+
+/** @brief Clocks do AHB e do APB a partir dos registradores do RCC simulado. */
+uint32_t Sim_Hclk_Hz(void);
+uint32_t Sim_Pclk_Hz(void);
+
+/** @brief Pulsos por segundo na entrada do TIM2 (sensor capacitivo). */
+void Sim_Set_Frequencia_Pulsos(uint32_t hz);
+
+/** @brief SysTick: configurado pelo HAL_InitTick, parado pelo HAL_SuspendTick. */
+void Sim_Systick_Configurar(void);
+
+void Sim_Get_Estatisticas(Sim_Estatisticas_t* estatisticas_out);
+
+/** @brief Chamado quando no h mais nada que possa acordar o ncleo. */
+extern void (*Sim_Ao_Travar)(const char* motivo);
+
+/** @brief IRQ do canal de DMA e marcao de eventos (DMA_ISR_xxIF1) no ISR. */
+IRQn_Type Sim_Dma_Irq(const DMA_HandleTypeDef* hdma);
+void      Sim_Dma_Sinalizar(DMA_HandleTypeDef* hdma, uint32_t flags);
+
+//==============================================================================
+// Display DWIN na USART2 (sim_uart.c)
+//==============================================================================
+
+#define SIM_DWIN_NUM_VPS    0x10000u
+
+typedef struct {
+    uint32_t quadros_tx;
+    uint32_t bytes_tx;
+    uint32_t quadros_rx;
+    uint32_t rx_perdidos;               // Chegaram sem recepo armada ou em Stop
+    uint64_t ocupado_tx_ns;             // Tempo com a linha de TX ocupada
+} Sim_Dwin_Estatisticas_t;
+
+void     Sim_Dwin_Reiniciar(void);
+/** @brief Alimentao do display (DISPLAY_PWR_CTRL); ao ligar, ele refaz o boot. */
+void     Sim_Dwin_Alimentacao(bool ligado);
+/** @brief O display envia um quadro (toque, leitura de VP) pela linha de RX. */
+void     Sim_Dwin_Enviar(const uint8_t* quadro, uint16_t tamanho);
+/** @brief Toque num boto: quadro 0x83 com VP e valor, como o display envia. */
+void     Sim_Dwin_Tocar(uint16_t vp, uint16_t valor);
+uint16_t Sim_Dwin_Get_Tela(void);
+uint16_t Sim_Dwin_Get_Vp(uint16_t vp);
+const char* Sim_Dwin_Get_Texto(uint16_t vp);
+uint32_t Sim_Dwin_Get_Trocas_Tela(void);
+void     Sim_Dwin_Get_Estatisticas(Sim_Dwin_Estatisticas_t* estatisticas_out);
+/** @brief Chamado a cada quadro completo recebido pelo display (tempo da concluso). */
+extern void (*Sim_Dwin_Ao_Receber)(const uint8_t* quadro, uint16_t tamanho);
+
+//==============================================================================
+// I2C1: EEPROM AT24C512 e carregador BQ25622 (sim_i2c.c)
+//==============================================================================
+
+#define SIM_EEPROM_TAMANHO  65536u
+
+typedef struct {
+    uint32_t escritas;                  // Pginas (ou trechos) gravadas
+    uint32_t bytes_escritos;
+    uint32_t leituras;
+    uint32_t bytes_lidos;
+    uint32_t nacks_ocupada;             // Acessos durante o tWR
+    uint64_t escrita_max_ns;            // Incio da transferncia ao fim do tWR
+    uint64_t escrita_soma_ns;
+} Sim_Eeprom_Estatisticas_t;
+
+void     Sim_I2c_Reiniciar(void);
+uint8_t* Sim_Eeprom_Memoria(void);
+/** @brief Tempo de gravao interna (tWR); o padro  o tpico, 4 ms. */
+void     Sim_Eeprom_Definir_Twr_us(uint32_t twr_us);
+void     Sim_Eeprom_Get_Estatisticas(Sim_Eeprom_Estatisticas_t* estatisticas_out);
+/** @brief Bateria vista pelo ADC do carregador. Corrente > 0 = carga. */
+void     Sim_Bateria_Definir(float tensao_v, float corrente_a, float vbus_v);
+
+//==============================================================================
+// USB CDC (sim_usbx.c)
+//==============================================================================
+
+void     Sim_Usb_Reiniciar(void);
+void     Sim_Usb_Conectar(bool conectado);
+/** @brief O host suspende ou retoma o barramento (o cabo continua conectado). */
+void     Sim_Usb_Suspender(bool suspenso);
+/** @brief O host envia bytes pela porta serial virtual. */
+void     Sim_Usb_Enviar(const char* texto, size_t tamanho);
+/** @brief Chamado com cada bloco que o firmware escreve na porta. */
+extern void (*Sim_Usb_Ao_Receber)(const uint8_t* dados, size_t tamanho);
+
+//==============================================================================
+// GPIO/EXTI e ADC (sim_gpio.c, sim_adc.c)
+//==============================================================================
+
+void     Sim_Gpio_Reiniciar(void);
+/** @brief Nvel de um pino de entrada; bordas geram EXTI se configuradas. */
+void     Sim_Gpio_Definir(GPIO_TypeDef* porta, uint16_t pino, bool nivel);
+bool     Sim_Gpio_Ler_Saida(GPIO_TypeDef* porta, uint16_t pino);
+
+void     Sim_Adc_Reiniciar(void);
+/** @brief Temperatura do chip e do termistor da amostra (C). */
+void     Sim_Adc_Definir(float temp_chip_c, float temp_amostra_c);
+
+//==============================================================================
+// RTC (sim_rtc.c)
+//==============================================================================
+
+void     Sim_Rtc_Reiniciar(void);
+
+#endif // SIM_H
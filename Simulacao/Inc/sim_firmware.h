@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * @file        sim_firmware.h
+ * @brief       Includo  fora (-include) em cada fonte do firmware no build
+ *              de simulao.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Substitui o cmsis_compiler.h do GCC/ARM por intrnsecos que
+ * chamam o ncleo simulado (PRIMASK, WFI) e redireciona as instncias dos
+ * perifricos (TIMx, RCC, GPIOx, SysTick...) para estruturas em RAM. O
+ * resto dos cabealhos do CMSIS e do HAL  o mesmo do alvo; s as funes
+ * do HAL usadas pelo firmware so reimplementadas (sim_*.c).
+ ******************************************************************************/
+
+#ifndef SIM_FIRMWARE_H
+#define SIM_FIRMWARE_H
+
+#include <stdint.h>
+
+//==============================================================================
+// Compilador (no lugar do cmsis_compiler.h / cmsis_gcc.h)
+//==============================================================================
+
+#define __CMSIS_COMPILER_H
+
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT             struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION              union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+#define __COMPILER_BARRIER()        __asm volatile("" ::: "memory")
+
+#define __UNALIGNED_UINT16_READ(addr)        (*((const volatile uint16_t*)(addr)))
+#define __UNALIGNED_UINT16_WRITE(addr, val)  ((void)(*((volatile uint16_t*)(addr)) = (val)))
+#define __UNALIGNED_UINT32_READ(addr)        (*((const volatile uint32_t*)(addr)))
+#define __UNALIGNED_UINT32_WRITE(addr, val)  ((void)(*((volatile uint32_t*)(addr)) = (val)))
+#define __UNALIGNED_UINT32(x)                (*((volatile uint32_t*)(x)))
+
+//==============================================================================
+// Intrnsecos do ncleo (sim_nucleo.c)
+//==============================================================================
+
+uint32_t Sim_Get_Primask(void);
+void     Sim_Set_Primask(uint32_t primask);
+void     Sim_Wfi(void);
+
+static inline void     __enable_irq(void)             { Sim_Set_Primask(0U); }
+static inline void     __disable_irq(void)            { Sim_Set_Primask(1U); }
+static inline uint32_t __get_PRIMASK(void)            { return Sim_Get_Primask(); }
+static inline void     __set_PRIMASK(uint32_t primask) { Sim_Set_Primask(primask); }
+static inline void     __WFI(void)                    { Sim_Wfi(); }
+static inline void     __WFE(void)                    { Sim_Wfi(); }
+static inline void     __SEV(void)                    { }
+static inline void     __NOP(void)                    { }
+static inline void     __ISB(void)                    { __COMPILER_BARRIER(); }
+static inline void     __DSB(void)                    { __COMPILER_BARRIER(); }
+static inline void     __DMB(void)                    { __COMPILER_BARRIER(); }
+static inline uint32_t __get_IPSR(void)               { return 0U; }
+static inline uint32_t __get_CONTROL(void)            { return 0U; }
+static inline uint32_t __REV(uint32_t v)              { return __builtin_bswap32(v); }
+static inline uint32_t __REV16(uint32_t v)            { return ((v & 0xFF00FF00U) >> 8) | ((v & 0x00FF00FFU) << 8); }
+static inline int16_t  __REVSH(int16_t v)             { return (int16_t)__builtin_bswap16((uint16_t)v); }
+static inline uint32_t __ROR(uint32_t v, uint32_t n)  { n %= 32U; return (n == 0U) ? v : ((v >> n) | (v << (32U - n))); }
+#define __BKPT(value)               ((void)(value))
+
+//==============================================================================
+// Dispositivo: o cabealho do alvo, sem puxar o HAL antes dos redirecionamentos
+//==============================================================================
+
+#pragma push_macro("USE_HAL_DRIVER")
+#undef USE_HAL_DRIVER
+#include "stm32c0xx.h"
+#pragma pop_macro("USE_HAL_DRIVER")
+
+// Perifricos em RAM (sim_nucleo.c). Os registradores so lidos e escritos
+// diretamente pelo firmware; os modelos os atualizam conforme o tempo virtual.
+extern TIM_TypeDef     Sim_TIM1, Sim_TIM2, Sim_TIM3, Sim_TIM14, Sim_TIM16, Sim_TIM17;
+extern RTC_TypeDef     Sim_RTC;
+extern USART_TypeDef   Sim_USART1, Sim_USART2;
+extern I2C_TypeDef     Sim_I2C1, Sim_I2C2;
+extern PWR_TypeDef     Sim_PWR;
+extern RCC_TypeDef     Sim_RCC;
+extern EXTI_TypeDef    Sim_EXTI;
+extern SYSCFG_TypeDef  Sim_SYSCFG;
+extern DMA_TypeDef     Sim_DMA1;
+extern DMA_Channel_TypeDef Sim_DMA1_Channel[5];
+extern FLASH_TypeDef   Sim_FLASH;
+extern CRC_TypeDef     Sim_CRC;
+extern CRS_TypeDef     Sim_CRS;
+extern GPIO_TypeDef    Sim_GPIOA, Sim_GPIOB, Sim_GPIOC, Sim_GPIOD, Sim_GPIOF;
+extern ADC_TypeDef     Sim_ADC1;
+extern ADC_Common_TypeDef Sim_ADC1_COMMON;
+extern DBG_TypeDef     Sim_DBG;
+extern USB_DRD_TypeDef Sim_USB_DRD_FS;
+extern SCB_Type        Sim_SCB;
+extern SysTick_Type    Sim_SysTick;
+extern NVIC_Type       Sim_NVIC;
+extern uint16_t        Sim_Calibracao_Adc[2];   // [0] = TS_CAL1, [1] = VREFINT_CAL
+
+#undef TIM1
+#undef TIM2
+#undef TIM3
+#undef TIM14
+#undef TIM16
+#undef TIM17
+#undef RTC
+#undef USART1
+#undef USART2
+#undef I2C1
+#undef I2C2
+#undef PWR
+#undef RCC
+#undef EXTI
+#undef SYSCFG
+#undef DMA1
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef FLASH
+#undef CRC
+#undef CRS
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOF
+#undef ADC1
+#undef ADC1_COMMON
+#undef ADC
+#undef DBG
+#undef USB_DRD_FS
+#undef SCB
+#undef SysTick
+#undef NVIC
+
+#define TIM1            (&Sim_TIM1)
+#define TIM2            (&Sim_TIM2)
+#define TIM3            (&Sim_TIM3)
+#define TIM14           (&Sim_TIM14)
+#define TIM16           (&Sim_TIM16)
+#define TIM17           (&Sim_TIM17)
+#define RTC             (&Sim_RTC)
+#define USART1          (&Sim_USART1)
+#define USART2          (&Sim_USART2)
+#define I2C1            (&Sim_I2C1)
+#define I2C2            (&Sim_I2C2)
+#define PWR             (&Sim_PWR)
+#define RCC             (&Sim_RCC)
+#define EXTI            (&Sim_EXTI)
+#define SYSCFG          (&Sim_SYSCFG)
+#define DMA1            (&Sim_DMA1)
+#define DMA1_Channel1   (&Sim_DMA1_Channel[0])
+#define DMA1_Channel2   (&Sim_DMA1_Channel[1])
+#define DMA1_Channel3   (&Sim_DMA1_Channel[2])
+#define DMA1_Channel4   (&Sim_DMA1_Channel[3])
+#define DMA1_Channel5   (&Sim_DMA1_Channel[4])
+#define FLASH           (&Sim_FLASH)
+#define CRC             (&Sim_CRC)
+#define CRS             (&Sim_CRS)
+#define GPIOA           (&Sim_GPIOA)
+#define GPIOB           (&Sim_GPIOB)
+#define GPIOC           (&Sim_GPIOC)
+#define GPIOD           (&Sim_GPIOD)
+#define GPIOF           (&Sim_GPIOF)
+#define ADC1            (&Sim_ADC1)
+#define ADC1_COMMON     (&Sim_ADC1_COMMON)
+#define ADC             ADC1_COMMON
+#define DBG             (&Sim_DBG)
+#define USB_DRD_FS      (&Sim_USB_DRD_FS)
+#define SCB             (&Sim_SCB)
+#define SysTick         (&Sim_SysTick)
+#define NVIC            (&Sim_NVIC)
+
+//==============================================================================
+// USBX: tipos base com as larguras do alvo (no lugar dos do ux_port.h)
+//==============================================================================
+
+// O ux_port.h genrico usa long, que tem 64 bits no PC. O firmware passa
+// uint32_t* onde a API pede ULONG* (o mesmo tipo no Cortex-M0+), e o
+// simulador escreveria 8 bytes num contador de 4.
+#define VOID                        void
+typedef char                        CHAR;
+typedef unsigned char               UCHAR;
+typedef int                         INT;
+typedef unsigned int                UINT;
+typedef int32_t                     LONG;
+typedef uint32_t                    ULONG;
+typedef short                       SHORT;
+typedef unsigned short              USHORT;
+
+//==============================================================================
+// HAL, j com os perifricos redirecionados
+//==============================================================================
+
+#ifdef USE_HAL_DRIVER
+#include "stm32c0xx_hal.h"
+#endif
+
+// Valores de calibrao de fbrica (lidos da flash de sistema no alvo).
+#undef TEMPSENSOR_CAL1_ADDR
+#undef VREFINT_CAL_ADDR
+#define TEMPSENSOR_CAL1_ADDR    (&Sim_Calibracao_Adc[0])
+#define VREFINT_CAL_ADDR        (&Sim_Calibracao_Adc[1])
+
+#endif // SIM_FIRMWARE_H
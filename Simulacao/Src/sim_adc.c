@@ -0,0 +1,268 @@
+/*******************************************************************************
+ * @file        sim_adc.c
+ * @brief       ADC1 com DMA: sensor interno, VREFINT e o termistor da amostra.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Uma sequncia (canais em ordem crescente, como no SEQ_FIXED)
+ * dura (amostragem + 12,5) ciclos x sobreamostragem x canais no clock do ADC;
+ * no fim o DMA grava as meias-palavras e pendura a IRQ do canal. As contagens
+ * vm de modelos fsicos, no da tabela do firmware: o sensor interno segue o
+ * TS_CAL1 e a inclinao do datasheet, e o termistor  um NTC 10k B3950 com
+ * pull-up de 10k, ratiomtrico.
+ ******************************************************************************/
+
+#include "sim.h"
+#include <math.h>
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define CANAL_TEMPSENSOR        9u
+#define CANAL_VREFINT           10u
+#define CANAL_TERMISTOR         19u
+#define NUM_CANAIS              23u
+#define ADC_FUNDO_ESCALA        4095.0f
+#define TS_CAL1                 1035u       // Contagem a 15 C e 3,0 V
+#define TS_CAL1_TEMP_C          15.0f
+#define TS_INCLINACAO_V_POR_C   0.00161f
+#define VREFINT_CAL             1655u       // Contagem a 3,0 V
+#define VDDA_CAL_V              3.0f
+#define VDDA_V                  3.3f
+#define NTC_R25_OHMS            10000.0f
+#define NTC_BETA                3950.0f
+#define NTC_PULLUP_OHMS         10000.0f
+#define KELVIN_25C              298.15f
+#define KELVIN_0C               273.15f
+#define CICLOS_AMOSTRAGEM_X2    321u        // 160,5 ciclos
+#define CICLOS_CONVERSAO_X2     25u         // 12,5 ciclos
+#define CICLOS_CALIBRACAO       82u
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static float s_temp_chip_c = 25.0f;
+static float s_temp_amostra_c = 25.0f;
+static ADC_HandleTypeDef* s_hadc = NULL;
+static uint16_t* s_destino = NULL;
+static uint32_t  s_tamanho = 0;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint32_t Adc_Clock_Hz(const ADC_HandleTypeDef* hadc);
+static uint32_t Sobreamostragem(const ADC_HandleTypeDef* hadc);
+static uint16_t Contagem_Do_Canal(uint32_t canal);
+static void     Sequencia_Concluir(void);
+static void     Dma_Cplt(DMA_HandleTypeDef* hdma);
+static void     Dma_Meio(DMA_HandleTypeDef* hdma);
+
+//==============================================================================
+// Callbacks padro
+//==============================================================================
+
+__weak void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc) { (void)hadc; }
+__weak void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) { (void)hadc; }
+__weak void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) { (void)hadc; }
+__weak void HAL_ADC_ErrorCallback(ADC_HandleTypeDef* hadc) { (void)hadc; }
+
+//==============================================================================
+// HAL
+//==============================================================================
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef* hadc)
+{
+    SIM_CHAMADA();
+    if (hadc == NULL) return HAL_ERROR;
+
+    if (hadc->State == HAL_ADC_STATE_RESET)
+    {
+        hadc->ErrorCode = HAL_ADC_ERROR_NONE;
+        hadc->Lock = HAL_UNLOCKED;
+        HAL_ADC_MspInit(hadc);
+    }
+    s_hadc = hadc;
+    hadc->Instance->CFGR2 = hadc->Init.ClockPrescaler & ADC_CFGR2_CKMODE;
+    if (hadc->Init.OversamplingMode == ENABLE)
+    {
+        hadc->Instance->CFGR2 |= ADC_CFGR2_OVSE | hadc->Init.Oversampling.Ratio |
+                                 hadc->Init.Oversampling.RightBitShift;
+    }
+    hadc->Instance->CHSELR = 0U;
+    hadc->State = HAL_ADC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef* hadc, const ADC_ChannelConfTypeDef* sConfig)
+{
+    SIM_CHAMADA();
+    if (hadc->Instance->CR & ADC_CR_ADSTART) return HAL_ERROR;
+
+    const uint32_t canal = __LL_ADC_CHANNEL_TO_DECIMAL_NB(sConfig->Channel);
+    if (canal >= NUM_CANAIS) return HAL_ERROR;
+    hadc->Instance->CHSELR |= 1UL << canal;
+    if (canal == CANAL_TEMPSENSOR) ADC1_COMMON->CCR |= ADC_CCR_TSEN;
+    if (canal == CANAL_VREFINT)    ADC1_COMMON->CCR |= ADC_CCR_VREFEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef* hadc)
+{
+    SIM_CHAMADA();
+    if (hadc->Instance->CR & ADC_CR_ADSTART) return HAL_BUSY;
+    Sim_Consumir_ns(((uint64_t)CICLOS_CALIBRACAO * 1000000000ull) / Adc_Clock_Hz(hadc));
+    hadc->Instance->CALFACT = 0x40U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* pData, uint32_t Length)
+{
+    SIM_CHAMADA();
+    if (hadc->Instance->CR & ADC_CR_ADSTART) return HAL_BUSY;
+    if (pData == NULL || Length == 0U) return HAL_ERROR;
+
+    hadc->State = (hadc->State & ~(HAL_ADC_STATE_READY | HAL_ADC_STATE_REG_EOC | HAL_ADC_STATE_REG_OVR |
+                                   HAL_ADC_STATE_REG_EOSMP)) | HAL_ADC_STATE_REG_BUSY;
+    hadc->ErrorCode = HAL_ADC_ERROR_NONE;
+
+    DMA_HandleTypeDef* dma = hadc->DMA_Handle;
+    dma->XferCpltCallback = Dma_Cplt;
+    dma->XferHalfCpltCallback = Dma_Meio;
+    dma->XferErrorCallback = NULL;
+    dma->Instance->CNDTR = Length;
+    dma->Instance->CCR |= DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN;
+    dma->State = HAL_DMA_STATE_BUSY;
+
+    s_hadc = hadc;
+    s_destino = (uint16_t*)pData;           // DMA em meia-palavra
+    s_tamanho = Length;
+    hadc->Instance->CFGR1 |= ADC_CFGR1_DMAEN;
+    hadc->Instance->CR |= ADC_CR_ADSTART;
+
+    uint32_t canais = 0;
+    for (uint32_t canal = 0; canal < NUM_CANAIS; canal++)
+    {
+        if (hadc->Instance->CHSELR & (1UL << canal)) canais++;
+    }
+    const uint64_t ciclos_x2 = (uint64_t)(CICLOS_AMOSTRAGEM_X2 + CICLOS_CONVERSAO_X2) * Sobreamostragem(hadc) * canais;
+    const uint64_t duracao_ns = (ciclos_x2 * 1000000000ull) / (2u * (uint64_t)Adc_Clock_Hz(hadc));
+    Sim_Agendar(SIM_FONTE_ADC, Sim_Agora_ns() + duracao_ns, Sequencia_Concluir);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef* hadc)
+{
+    SIM_CHAMADA();
+    Sim_Cancelar(SIM_FONTE_ADC);
+    hadc->Instance->CR &= ~ADC_CR_ADSTART;
+    hadc->Instance->CFGR1 &= ~ADC_CFGR1_DMAEN;
+    hadc->DMA_Handle->Instance->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN);
+    hadc->DMA_Handle->State = HAL_DMA_STATE_READY;
+    hadc->State = (hadc->State & ~HAL_ADC_STATE_REG_BUSY) | HAL_ADC_STATE_READY;
+    return HAL_OK;
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_Adc_Reiniciar(void)
+{
+    memset(&Sim_ADC1, 0, sizeof(Sim_ADC1));
+    memset(&Sim_ADC1_COMMON, 0, sizeof(Sim_ADC1_COMMON));
+    Sim_Calibracao_Adc[0] = TS_CAL1;
+    Sim_Calibracao_Adc[1] = VREFINT_CAL;
+    s_temp_chip_c = 25.0f;
+    s_temp_amostra_c = 25.0f;
+    s_hadc = NULL;
+    s_destino = NULL;
+    s_tamanho = 0;
+}
+
+void Sim_Adc_Definir(float temp_chip_c, float temp_amostra_c)
+{
+    s_temp_chip_c = temp_chip_c;
+    s_temp_amostra_c = temp_amostra_c;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/** @brief Modo sncrono: PCLK dividido pelo CKMODE; assncrono: SYSCLK. */
+static uint32_t Adc_Clock_Hz(const ADC_HandleTypeDef* hadc)
+{
+    switch (hadc->Init.ClockPrescaler)
+    {
+        case ADC_CLOCK_SYNC_PCLK_DIV1: return Sim_Pclk_Hz();
+        case ADC_CLOCK_SYNC_PCLK_DIV2: return Sim_Pclk_Hz() / 2u;
+        case ADC_CLOCK_SYNC_PCLK_DIV4: return Sim_Pclk_Hz() / 4u;
+        default:                       return Sim_Hclk_Hz();
+    }
+}
+
+static uint32_t Sobreamostragem(const ADC_HandleTypeDef* hadc)
+{
+    if ((hadc->Instance->CFGR2 & ADC_CFGR2_OVSE) == 0U) return 1u;
+    return 2u << ((hadc->Instance->CFGR2 & ADC_CFGR2_OVSR) >> ADC_CFGR2_OVSR_Pos);
+}
+
+static uint16_t Contagem_Do_Canal(uint32_t canal)
+{
+    float tensao;
+    switch (canal)
+    {
+        case CANAL_TEMPSENSOR:
+            tensao = (TS_CAL1 * VDDA_CAL_V) / ADC_FUNDO_ESCALA +
+                     (s_temp_chip_c - TS_CAL1_TEMP_C) * TS_INCLINACAO_V_POR_C;
+            break;
+        case CANAL_VREFINT:
+            tensao = (VREFINT_CAL * VDDA_CAL_V) / ADC_FUNDO_ESCALA;
+            break;
+        case CANAL_TERMISTOR:
+        {
+            const float kelvin = s_temp_amostra_c + KELVIN_0C;
+            const float r_ntc = NTC_R25_OHMS * expf(NTC_BETA * (1.0f / kelvin - 1.0f / KELVIN_25C));
+            tensao = VDDA_V * r_ntc / (r_ntc + NTC_PULLUP_OHMS);
+            break;
+        }
+        default:
+            return 0u;
+    }
+    const float contagem = tensao * ADC_FUNDO_ESCALA / VDDA_V + 0.5f;
+    if (contagem <= 0.0f) return 0u;
+    return (contagem >= ADC_FUNDO_ESCALA) ? (uint16_t)ADC_FUNDO_ESCALA : (uint16_t)contagem;
+}
+
+/** @brief Fim da sequncia: o DMA grava um resultado por canal habilitado. */
+static void Sequencia_Concluir(void)
+{
+    if (s_hadc == NULL || s_destino == NULL) return;
+
+    DMA_HandleTypeDef* dma = s_hadc->DMA_Handle;
+    uint32_t gravados = 0;
+    for (uint32_t canal = 0; canal < NUM_CANAIS && gravados < s_tamanho; canal++)
+    {
+        if ((s_hadc->Instance->CHSELR & (1UL << canal)) == 0U) continue;
+        s_destino[gravados++] = Contagem_Do_Canal(canal);
+    }
+    dma->Instance->CNDTR = s_tamanho - gravados;
+    s_hadc->Instance->CR &= ~ADC_CR_ADSTART;
+    s_hadc->Instance->ISR |= ADC_ISR_EOC | ADC_ISR_EOS;
+    Sim_Dma_Sinalizar(dma, DMA_ISR_HTIF1 | ((dma->Instance->CNDTR == 0U) ? DMA_ISR_TCIF1 : 0U));
+}
+
+static void Dma_Cplt(DMA_HandleTypeDef* hdma)
+{
+    ADC_HandleTypeDef* hadc = (ADC_HandleTypeDef*)hdma->Parent;
+    hadc->State = (hadc->State & ~HAL_ADC_STATE_REG_BUSY) | HAL_ADC_STATE_REG_EOC | HAL_ADC_STATE_READY;
+    HAL_ADC_ConvCpltCallback(hadc);
+}
+
+static void Dma_Meio(DMA_HandleTypeDef* hdma)
+{
+    HAL_ADC_ConvHalfCpltCallback((ADC_HandleTypeDef*)hdma->Parent);
+}
@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * @file        sim_gpio.c
+ * @brief       GPIO e EXTI simulados.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O IDR de cada porta junta o ODR (pinos em sada) com os nveis
+ * externos definidos pelo roteiro. Uma mudana de nvel numa linha da EXTI
+ * com a borda configurada marca RPR1/FPR1 e pendura a IRQ do grupo, tambm
+ * em Stop, como no alvo. A placa sobe com o POWER_GOOD em nvel alto.
+ ******************************************************************************/
+
+#include "sim.h"
+#include "main.h"
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas (mesma codificao do Mode no HAL)
+//==============================================================================
+
+#define MODO_PINO           0x00000003u
+#define MODO_EXTI           0x10000000u
+#define MODO_IT             0x00010000u
+#define MODO_EVT            0x00020000u
+#define BORDA_SUBIDA        0x00100000u
+#define BORDA_DESCIDA       0x00200000u
+#define TIPO_SAIDA_OD       0x00000010u
+#define NUM_PORTAS          6u
+#define NUM_PINOS           16u
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static GPIO_TypeDef* const s_portas[NUM_PORTAS] = {GPIOA, GPIOB, GPIOC, GPIOD, NULL, GPIOF};
+static uint16_t s_niveis_externos[NUM_PORTAS];
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint32_t Indice_Porta(const GPIO_TypeDef* porta);
+static void     Atualizar_Idr(GPIO_TypeDef* porta);
+static IRQn_Type Irq_Da_Linha(uint32_t linha);
+static void     Notificar_Saidas(const GPIO_TypeDef* porta);
+
+//==============================================================================
+// Callbacks padro
+//==============================================================================
+
+__weak void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin) { (void)GPIO_Pin; }
+__weak void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin) { (void)GPIO_Pin; }
+
+//==============================================================================
+// HAL
+//==============================================================================
+
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, const GPIO_InitTypeDef* pGPIO_Init)
+{
+    SIM_CHAMADA();
+    const uint32_t modo = pGPIO_Init->Mode;
+    for (uint32_t pino = 0; pino < NUM_PINOS; pino++)
+    {
+        const uint32_t bit = 1u << pino;
+        if ((pGPIO_Init->Pin & bit) == 0u) continue;
+
+        MODIFY_REG(GPIOx->MODER, GPIO_MODER_MODE0 << (pino * 2u), (modo & MODO_PINO) << (pino * 2u));
+        MODIFY_REG(GPIOx->OTYPER, bit, ((modo & TIPO_SAIDA_OD) != 0u) ? bit : 0u);
+        MODIFY_REG(GPIOx->PUPDR, GPIO_PUPDR_PUPD0 << (pino * 2u), pGPIO_Init->Pull << (pino * 2u));
+        if (modo == GPIO_MODE_AF_PP || modo == GPIO_MODE_AF_OD)
+        {
+            MODIFY_REG(GPIOx->AFR[pino >> 3], 0xFu << ((pino & 7u) * 4u),
+                       (pGPIO_Init->Alternate & 0xFu) << ((pino & 7u) * 4u));
+        }
+
+        if ((modo & MODO_EXTI) == MODO_EXTI)
+        {
+            MODIFY_REG(EXTI->EXTICR[pino >> 2], 0xFFu << ((pino & 3u) * 8u),
+                       Indice_Porta(GPIOx) << ((pino & 3u) * 8u));
+            MODIFY_REG(EXTI->IMR1,  bit, (modo & MODO_IT) ? bit : 0u);
+            MODIFY_REG(EXTI->EMR1,  bit, (modo & MODO_EVT) ? bit : 0u);
+            MODIFY_REG(EXTI->RTSR1, bit, (modo & BORDA_SUBIDA) ? bit : 0u);
+            MODIFY_REG(EXTI->FTSR1, bit, (modo & BORDA_DESCIDA) ? bit : 0u);
+        }
+    }
+    Atualizar_Idr(GPIOx);
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef* GPIOx, uint32_t GPIO_Pin)
+{
+    SIM_CHAMADA();
+    for (uint32_t pino = 0; pino < NUM_PINOS; pino++)
+    {
+        const uint32_t bit = 1u << pino;
+        if ((GPIO_Pin & bit) == 0u) continue;
+
+        const uint32_t fonte = (EXTI->EXTICR[pino >> 2] >> ((pino & 3u) * 8u)) & 0xFFu;
+        if (fonte == Indice_Porta(GPIOx))
+        {
+            CLEAR_BIT(EXTI->EXTICR[pino >> 2], 0xFFu << ((pino & 3u) * 8u));
+            CLEAR_BIT(EXTI->IMR1, bit);
+            CLEAR_BIT(EXTI->EMR1, bit);
+            CLEAR_BIT(EXTI->RTSR1, bit);
+            CLEAR_BIT(EXTI->FTSR1, bit);
+        }
+        SET_BIT(GPIOx->MODER, GPIO_MODER_MODE0 << (pino * 2u));     // Analgico
+        CLEAR_BIT(GPIOx->PUPDR, GPIO_PUPDR_PUPD0 << (pino * 2u));
+    }
+    Atualizar_Idr(GPIOx);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(const GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    SIM_CHAMADA();
+    return ((GPIOx->IDR & GPIO_Pin) != 0u) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    SIM_CHAMADA();
+    if (PinState != GPIO_PIN_RESET) GPIOx->ODR |= GPIO_Pin;
+    else                            GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    Atualizar_Idr(GPIOx);
+    Notificar_Saidas(GPIOx);
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    SIM_CHAMADA();
+    GPIOx->ODR ^= GPIO_Pin;
+    Atualizar_Idr(GPIOx);
+    Notificar_Saidas(GPIOx);
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+    if (EXTI->RPR1 & GPIO_Pin)
+    {
+        EXTI->RPR1 &= ~(uint32_t)GPIO_Pin;
+        HAL_GPIO_EXTI_Rising_Callback(GPIO_Pin);
+    }
+    if (EXTI->FPR1 & GPIO_Pin)
+    {
+        EXTI->FPR1 &= ~(uint32_t)GPIO_Pin;
+        HAL_GPIO_EXTI_Falling_Callback(GPIO_Pin);
+    }
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_Gpio_Reiniciar(void)
+{
+    for (uint32_t i = 0; i < NUM_PORTAS; i++)
+    {
+        if (s_portas[i] == NULL) continue;
+        memset(s_portas[i], 0, sizeof(GPIO_TypeDef));
+        s_portas[i]->MODER = 0xFFFFFFFFu;       // Reset: tudo analgico
+        s_niveis_externos[i] = 0;
+    }
+    memset(&Sim_EXTI, 0, sizeof(Sim_EXTI));
+    s_niveis_externos[Indice_Porta(POWER_GOOD_GPIO_Port)] |= POWER_GOOD_Pin;
+    for (uint32_t i = 0; i < NUM_PORTAS; i++)
+    {
+        if (s_portas[i] != NULL) Atualizar_Idr(s_portas[i]);
+    }
+}
+
+void Sim_Gpio_Definir(GPIO_TypeDef* porta, uint16_t pino, bool nivel)
+{
+    const uint32_t indice = Indice_Porta(porta);
+    if (indice >= NUM_PORTAS) return;
+
+    const uint16_t antes = s_niveis_externos[indice];
+    if (nivel) s_niveis_externos[indice] |= pino;
+    else       s_niveis_externos[indice] &= (uint16_t)~pino;
+    const uint16_t mudou = antes ^ s_niveis_externos[indice];
+    Atualizar_Idr(porta);
+
+    for (uint32_t linha = 0; linha < NUM_PINOS; linha++)
+    {
+        const uint32_t bit = 1u << linha;
+        if ((mudou & bit) == 0u || (EXTI->IMR1 & bit) == 0u) continue;
+        if (((EXTI->EXTICR[linha >> 2] >> ((linha & 3u) * 8u)) & 0xFFu) != indice) continue;
+
+        const bool subiu = (s_niveis_externos[indice] & bit) != 0u;
+        if (subiu && (EXTI->RTSR1 & bit))        EXTI->RPR1 |= bit;
+        else if (!subiu && (EXTI->FTSR1 & bit))  EXTI->FPR1 |= bit;
+        else continue;
+        Sim_Pendurar_Irq(Irq_Da_Linha(linha));
+    }
+}
+
+bool Sim_Gpio_Ler_Saida(GPIO_TypeDef* porta, uint16_t pino)
+{
+    return (porta->ODR & pino) != 0u;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static uint32_t Indice_Porta(const GPIO_TypeDef* porta)
+{
+    for (uint32_t i = 0; i < NUM_PORTAS; i++)
+    {
+        if (s_portas[i] == porta) return i;
+    }
+    return NUM_PORTAS;
+}
+
+/** @brief Pinos em sada leem o prprio ODR; os demais, o nvel externo. */
+static void Atualizar_Idr(GPIO_TypeDef* porta)
+{
+    const uint32_t indice = Indice_Porta(porta);
+    if (indice >= NUM_PORTAS) return;
+
+    uint32_t idr = 0;
+    for (uint32_t pino = 0; pino < NUM_PINOS; pino++)
+    {
+        const uint32_t modo = (porta->MODER >> (pino * 2u)) & MODO_PINO;
+        const uint32_t fonte = (modo == GPIO_MODE_OUTPUT_PP) ? porta->ODR : s_niveis_externos[indice];
+        idr |= fonte & (1u << pino);
+    }
+    porta->IDR = idr;
+}
+
+static IRQn_Type Irq_Da_Linha(uint32_t linha)
+{
+    if (linha < 2u) return EXTI0_1_IRQn;
+    if (linha < 4u) return EXTI2_3_IRQn;
+    return EXTI4_15_IRQn;
+}
+
+/** @brief Sadas que alimentam outros modelos (display ligado com o pino em baixo). */
+static void Notificar_Saidas(const GPIO_TypeDef* porta)
+{
+    if (porta == DISPLAY_PWR_CTRL_GPIO_Port)
+    {
+        Sim_Dwin_Alimentacao((porta->ODR & DISPLAY_PWR_CTRL_Pin) == 0u);
+    }
+}
@@ -0,0 +1,498 @@
+/*******************************************************************************
+ * @file        sim_hal.c
+ * @brief       HAL simulado: tick, NVIC, RCC, PWR, CRC, DMA e TIM.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada funo faz nos registradores em RAM o mesmo que o HAL do
+ * alvo faz no hardware, e o ncleo deriva da os clocks e os contadores. No
+ * h espera ativa por flags de prontido: o oscilador fica pronto no prximo
+ * avano do tempo.
+ ******************************************************************************/
+
+#include "sim.h"
+#include <string.h>
+
+//==============================================================================
+// Variveis do HAL
+//==============================================================================
+
+__IO uint32_t       uwTick;
+uint32_t            uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define CRC_POLINOMIO_PADRAO    0x04C11DB7u
+#define CRC_VALOR_INICIAL       0xFFFFFFFFu
+#define CICLOS_CRC_POR_BYTE     1u          // Uma palavra a cada 4 ciclos do AHB
+#define NUM_CANAIS_DMA          5u
+#define BITS_POR_CANAL_DMA      4u
+
+//==============================================================================
+// MSP e callbacks padro (o firmware substitui os que usa)
+//==============================================================================
+
+__weak void HAL_MspInit(void) { }
+__weak void HAL_MspDeInit(void) { }
+__weak void HAL_CRC_MspInit(CRC_HandleTypeDef* hcrc) { (void)hcrc; }
+__weak void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim) { (void)htim; }
+__weak void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef* htim) { (void)htim; }
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) { (void)htim; }
+
+//==============================================================================
+// Tick e ncleo
+//==============================================================================
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    Sim_Prioridade_Irq(SysTick_IRQn, TICK_INT_PRIORITY);
+    if (HAL_InitTick(TICK_INT_PRIORITY) != HAL_OK) return HAL_ERROR;
+    HAL_MspInit();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    SIM_CHAMADA();
+    if ((uint32_t)uwTickFreq == 0U || TickPriority >= (1UL << __NVIC_PRIO_BITS)) return HAL_ERROR;
+
+    // SysTick_Config() do CMSIS foi definida antes do redirecionamento e
+    // escreveria no endereo do alvo; os mesmos passos, no SysTick simulado.
+    const uint32_t carga = SystemCoreClock / (1000U / (uint32_t)uwTickFreq);
+    if ((carga - 1UL) > SysTick_LOAD_RELOAD_Msk) return HAL_ERROR;
+    SysTick->LOAD = carga - 1UL;
+    SysTick->VAL = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    Sim_Systick_Configurar();
+    HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+    uwTickPrio = TickPriority;
+    return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+    uwTick += (uint32_t)uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    SIM_CHAMADA();
+    return uwTick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    const uint32_t inicio = HAL_GetTick();
+    uint32_t espera = Delay;
+    if (espera < HAL_MAX_DELAY) espera += (uint32_t)uwTickFreq;
+    while ((HAL_GetTick() - inicio) < espera) { }
+}
+
+void HAL_SuspendTick(void)
+{
+    CLEAR_BIT(SysTick->CTRL, SysTick_CTRL_TICKINT_Msk);
+}
+
+void HAL_ResumeTick(void)
+{
+    SET_BIT(SysTick->CTRL, SysTick_CTRL_TICKINT_Msk);
+}
+
+//==============================================================================
+// NVIC
+//==============================================================================
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)SubPriority;
+    Sim_Prioridade_Irq(IRQn, PreemptPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    Sim_Habilitar_Irq(IRQn, true);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    Sim_Habilitar_Irq(IRQn, false);
+}
+
+//==============================================================================
+// RCC e PWR
+//==============================================================================
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(const RCC_OscInitTypeDef* RCC_OscInitStruct)
+{
+    SIM_CHAMADA();
+    if (RCC_OscInitStruct == NULL) return HAL_ERROR;
+
+    const uint32_t tipo = RCC_OscInitStruct->OscillatorType;
+    if (tipo & RCC_OSCILLATORTYPE_HSI)
+    {
+        MODIFY_REG(RCC->CR, RCC_CR_HSION | RCC_CR_HSIDIV,
+                   RCC_OscInitStruct->HSIState | RCC_OscInitStruct->HSIDiv);
+        SystemCoreClockUpdate();
+    }
+    if (tipo & RCC_OSCILLATORTYPE_LSI)
+    {
+        MODIFY_REG(RCC->CSR2, RCC_CSR2_LSION, RCC_OscInitStruct->LSIState);
+    }
+    if (tipo & RCC_OSCILLATORTYPE_HSI48)
+    {
+        MODIFY_REG(RCC->CR, RCC_CR_HSIUSB48ON, RCC_OscInitStruct->HSI48State);
+    }
+    SIM_CHAMADA();                          // Osciladores estabilizam
+    return HAL_InitTick(uwTickPrio);
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(const RCC_ClkInitTypeDef* RCC_ClkInitStruct, uint32_t FLatency)
+{
+    SIM_CHAMADA();
+    if (RCC_ClkInitStruct == NULL) return HAL_ERROR;
+
+    MODIFY_REG(FLASH->ACR, FLASH_ACR_LATENCY, FLatency);
+    const uint32_t tipo = RCC_ClkInitStruct->ClockType;
+    if (tipo & RCC_CLOCKTYPE_SYSCLK)
+    {
+        MODIFY_REG(RCC->CR, RCC_CR_SYSDIV, RCC_ClkInitStruct->SYSCLKDivider);
+        MODIFY_REG(RCC->CFGR, RCC_CFGR_SW | RCC_CFGR_SWS,
+                   RCC_ClkInitStruct->SYSCLKSource | (RCC_ClkInitStruct->SYSCLKSource << RCC_CFGR_SWS_Pos));
+    }
+    if (tipo & RCC_CLOCKTYPE_HCLK)  MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, RCC_ClkInitStruct->AHBCLKDivider);
+    if (tipo & RCC_CLOCKTYPE_PCLK1) MODIFY_REG(RCC->CFGR, RCC_CFGR_PPRE, RCC_ClkInitStruct->APB1CLKDivider);
+
+    SystemCoreClock = Sim_Hclk_Hz();
+    return HAL_InitTick(uwTickPrio);
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    SystemCoreClock = Sim_Hclk_Hz();
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    SIM_CHAMADA();
+    SystemCoreClock = Sim_Hclk_Hz();
+    return Sim_Pclk_Hz();
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(const RCC_PeriphCLKInitTypeDef* PeriphClkInit)
+{
+    SIM_CHAMADA();
+    return (PeriphClkInit != NULL) ? HAL_OK : HAL_ERROR;
+}
+
+void HAL_RCCEx_CRSConfig(RCC_CRSInitTypeDef* pInit)
+{
+    SIM_CHAMADA();
+    WRITE_REG(CRS->CFGR, pInit->Prescaler | pInit->Source | pInit->Polarity |
+                         pInit->ReloadValue | (pInit->ErrorLimitValue << CRS_CFGR_FELIM_Pos));
+    SET_BIT(CRS->CR, CRS_CR_AUTOTRIMEN | CRS_CR_CEN);
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+    (void)Regulator;
+    (void)STOPEntry;
+    SET_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+    Sim_Stop();
+    CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+}
+
+//==============================================================================
+// CRC (polinmio e valor inicial padro, sem inverses)
+//==============================================================================
+
+static void Crc_Byte(uint8_t byte)
+{
+    uint32_t crc = CRC->DR ^ ((uint32_t)byte << 24);
+    for (int bit = 0; bit < 8; bit++)
+    {
+        crc = (crc & 0x80000000u) ? ((crc << 1) ^ CRC_POLINOMIO_PADRAO) : (crc << 1);
+    }
+    CRC->DR = crc;
+}
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef* hcrc)
+{
+    if (hcrc == NULL) return HAL_ERROR;
+    if (hcrc->State == HAL_CRC_STATE_RESET)
+    {
+        hcrc->Lock = HAL_UNLOCKED;
+        HAL_CRC_MspInit(hcrc);
+    }
+    CRC->DR = CRC_VALOR_INICIAL;
+    hcrc->State = HAL_CRC_STATE_READY;
+    return HAL_OK;
+}
+
+/**
+ * @brief Comprimento em unidades do formato de entrada, como no HAL: bytes,
+ * meias-palavras ou palavras (estas entram pelo byte mais significativo).
+ */
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef* hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    uint32_t bytes;
+    switch (hcrc->InputDataFormat)
+    {
+        case CRC_INPUTDATA_FORMAT_BYTES:
+        {
+            const uint8_t* dados = (const uint8_t*)pBuffer;
+            for (uint32_t i = 0; i < BufferLength; i++) Crc_Byte(dados[i]);
+            bytes = BufferLength;
+            break;
+        }
+        case CRC_INPUTDATA_FORMAT_HALFWORDS:
+        {
+            const uint16_t* dados = (const uint16_t*)(void*)pBuffer;
+            for (uint32_t i = 0; i < BufferLength; i++)
+            {
+                Crc_Byte((uint8_t)(dados[i] >> 8));
+                Crc_Byte((uint8_t)dados[i]);
+            }
+            bytes = BufferLength * 2u;
+            break;
+        }
+        default:
+            for (uint32_t i = 0; i < BufferLength; i++)
+            {
+                for (int desloc = 24; desloc >= 0; desloc -= 8) Crc_Byte((uint8_t)(pBuffer[i] >> desloc));
+            }
+            bytes = BufferLength * 4u;
+            break;
+    }
+    SIM_CHAMADA();
+    Sim_Consumir_Ciclos(bytes * CICLOS_CRC_POR_BYTE);
+    return CRC->DR;
+}
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef* hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    CRC->DR = CRC_VALOR_INICIAL;
+    return HAL_CRC_Accumulate(hcrc, pBuffer, BufferLength);
+}
+
+//==============================================================================
+// DMA: os modelos marcam o ISR com Sim_Dma_Sinalizar e a IRQ chama os callbacks
+//==============================================================================
+
+static uint32_t Canal_Dma(const DMA_HandleTypeDef* hdma)
+{
+    return (uint32_t)(hdma->Instance - &Sim_DMA1_Channel[0]);
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma)
+{
+    if (hdma == NULL || Canal_Dma(hdma) >= NUM_CANAIS_DMA) return HAL_ERROR;
+
+    hdma->ChannelIndex = Canal_Dma(hdma) * BITS_POR_CANAL_DMA;
+    hdma->Instance->CCR = hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+                          hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment |
+                          hdma->Init.Mode | hdma->Init.Priority;
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef* hdma)
+{
+    if (hdma == NULL) return HAL_ERROR;
+    hdma->Instance->CCR = 0U;
+    hdma->Instance->CNDTR = 0U;
+    DMA1->ISR &= ~(0xFu << hdma->ChannelIndex);
+    hdma->XferCpltCallback = NULL;
+    hdma->XferHalfCpltCallback = NULL;
+    hdma->XferErrorCallback = NULL;
+    hdma->XferAbortCallback = NULL;
+    hdma->State = HAL_DMA_STATE_RESET;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef* hdma)
+{
+    const uint32_t flags = DMA1->ISR >> hdma->ChannelIndex;
+    const uint32_t ccr = hdma->Instance->CCR;
+
+    if ((flags & DMA_ISR_HTIF1) && (ccr & DMA_CCR_HTIE))
+    {
+        DMA1->ISR &= ~(DMA_ISR_HTIF1 << hdma->ChannelIndex);
+        if (hdma->XferHalfCpltCallback != NULL) hdma->XferHalfCpltCallback(hdma);
+    }
+    else if ((flags & DMA_ISR_TCIF1) && (ccr & DMA_CCR_TCIE))
+    {
+        DMA1->ISR &= ~((DMA_ISR_TCIF1 | DMA_ISR_HTIF1) << hdma->ChannelIndex);
+        if ((ccr & DMA_CCR_CIRC) == 0U)
+        {
+            hdma->Instance->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN);
+            hdma->State = HAL_DMA_STATE_READY;
+        }
+        if (hdma->XferCpltCallback != NULL) hdma->XferCpltCallback(hdma);
+    }
+    else if ((flags & DMA_ISR_TEIF1) && (ccr & DMA_CCR_TEIE))
+    {
+        DMA1->ISR &= ~(0xFu << hdma->ChannelIndex);
+        hdma->Instance->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN);
+        hdma->ErrorCode = HAL_DMA_ERROR_TE;
+        hdma->State = HAL_DMA_STATE_READY;
+        if (hdma->XferErrorCallback != NULL) hdma->XferErrorCallback(hdma);
+    }
+    if ((DMA1->ISR >> hdma->ChannelIndex) & (DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1))
+    {
+        Sim_Pendurar_Irq(Sim_Dma_Irq(hdma));    // Outro evento do canal ainda pendente
+    }
+}
+
+IRQn_Type Sim_Dma_Irq(const DMA_HandleTypeDef* hdma)
+{
+    return (Canal_Dma(hdma) == 0U) ? DMA1_Channel1_IRQn : DMA1_Channel2_3_IRQn;
+}
+
+void Sim_Dma_Sinalizar(DMA_HandleTypeDef* hdma, uint32_t flags)
+{
+    DMA1->ISR |= (flags | DMA_ISR_GIF1) << hdma->ChannelIndex;
+    if (hdma->Instance->CCR & (DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE))
+    {
+        Sim_Pendurar_Irq(Sim_Dma_Irq(hdma));
+    }
+}
+
+//==============================================================================
+// TIM
+//==============================================================================
+
+static void Tim_Configurar_Base(TIM_HandleTypeDef* htim)
+{
+    TIM_TypeDef* tim = htim->Instance;
+    MODIFY_REG(tim->CR1, TIM_CR1_DIR | TIM_CR1_CMS | TIM_CR1_CKD | TIM_CR1_ARPE,
+               htim->Init.CounterMode | htim->Init.ClockDivision | htim->Init.AutoReloadPreload);
+    tim->ARR = htim->Init.Period;
+    tim->PSC = htim->Init.Prescaler;
+    tim->RCR = htim->Init.RepetitionCounter;
+    tim->EGR = TIM_EGR_UG;                  // Carrega o PSC; o UIF no fica marcado
+    htim->State = HAL_TIM_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim)
+{
+    SIM_CHAMADA();
+    if (htim == NULL) return HAL_ERROR;
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        htim->Lock = HAL_UNLOCKED;
+        HAL_TIM_Base_MspInit(htim);
+    }
+    Tim_Configurar_Base(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef* htim)
+{
+    SIM_CHAMADA();
+    if (htim == NULL) return HAL_ERROR;
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        htim->Lock = HAL_UNLOCKED;
+        HAL_TIM_PWM_MspInit(htim);
+    }
+    Tim_Configurar_Base(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim)
+{
+    SIM_CHAMADA();
+    htim->State = HAL_TIM_STATE_BUSY;
+    SET_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim)
+{
+    SIM_CHAMADA();
+    htim->State = HAL_TIM_STATE_BUSY;
+    SET_BIT(htim->Instance->DIER, TIM_DIER_UIE);
+    SET_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim)
+{
+    SIM_CHAMADA();
+    CLEAR_BIT(htim->Instance->DIER, TIM_DIER_UIE);
+    CLEAR_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_SlaveConfigSynchro(TIM_HandleTypeDef* htim, const TIM_SlaveConfigTypeDef* sSlaveConfig)
+{
+    SIM_CHAMADA();
+    MODIFY_REG(htim->Instance->SMCR, TIM_SMCR_SMS | TIM_SMCR_TS,
+               sSlaveConfig->SlaveMode | sSlaveConfig->InputTrigger);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef* htim,
+                                                        const TIM_MasterConfigTypeDef* sMasterConfig)
+{
+    SIM_CHAMADA();
+    MODIFY_REG(htim->Instance->CR2, TIM_CR2_MMS, sMasterConfig->MasterOutputTrigger);
+    MODIFY_REG(htim->Instance->SMCR, TIM_SMCR_MSM, sMasterConfig->MasterSlaveMode);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_ConfigBreakDeadTime(TIM_HandleTypeDef* htim,
+                                                const TIM_BreakDeadTimeConfigTypeDef* sBreakDeadTimeConfig)
+{
+    SIM_CHAMADA();
+    htim->Instance->BDTR = sBreakDeadTimeConfig->DeadTime | sBreakDeadTimeConfig->LockLevel |
+                           sBreakDeadTimeConfig->OffStateIDLEMode | sBreakDeadTimeConfig->OffStateRunMode |
+                           sBreakDeadTimeConfig->BreakState | sBreakDeadTimeConfig->BreakPolarity |
+                           sBreakDeadTimeConfig->AutomaticOutput;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef* htim, const TIM_OC_InitTypeDef* sConfig,
+                                            uint32_t Channel)
+{
+    SIM_CHAMADA();
+    __HAL_TIM_SET_COMPARE(htim, Channel, sConfig->Pulse);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t Channel)
+{
+    SIM_CHAMADA();
+    SET_BIT(htim->Instance->CCER, TIM_CCER_CC1E << (Channel & 0x1FU));
+    SET_BIT(htim->Instance->BDTR, TIM_BDTR_MOE);
+    SET_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t Channel)
+{
+    SIM_CHAMADA();
+    CLEAR_BIT(htim->Instance->CCER, TIM_CCER_CC1E << (Channel & 0x1FU));
+    if ((htim->Instance->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) == 0U)
+    {
+        CLEAR_BIT(htim->Instance->BDTR, TIM_BDTR_MOE);
+        CLEAR_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+    }
+    return HAL_OK;
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim)
+{
+    if (READ_BIT(htim->Instance->SR, TIM_SR_UIF) && READ_BIT(htim->Instance->DIER, TIM_DIER_UIE))
+    {
+        CLEAR_BIT(htim->Instance->SR, TIM_SR_UIF);
+        HAL_TIM_PeriodElapsedCallback(htim);
+    }
+}
@@ -0,0 +1,440 @@
+/*******************************************************************************
+ * @file        sim_i2c.c
+ * @brief       I2C1 com a EEPROM AT24C512 e o carregador BQ25622.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A durao de cada transao sai do TIMINGR e do PCLK atuais
+ * (9 bits por byte, mais START/STOP). As chamadas bloqueantes ocupam a CPU por
+ * esse tempo; a Mem_Write_IT agenda o fim e entrega pela IRQ do I2C1, como o
+ * HAL do alvo.
+ *
+ * A EEPROM grava em pginas de 128 bytes (o endereo d a volta dentro da
+ * pgina) e no responde (NACK) durante o tWR. O carregador expe os
+ * registradores do ADC a partir de Sim_Bateria_Definir.
+ ******************************************************************************/
+
+#include "sim.h"
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define EEPROM_ENDERECO         0xA0u
+#define EEPROM_PAGINA           128u
+#define EEPROM_TWR_PADRAO_NS    4000000ull  // Tpico; o mximo do datasheet  5 ms
+#define BQ_ENDERECO             0xD6u
+#define BQ_NUM_REGISTRADORES    0x40u
+#define BQ_REG_CHG_STATUS_1     0x1Eu
+#define BQ_REG_IBAT_ADC         0x2Au
+#define BQ_REG_VBUS_ADC         0x2Cu
+#define BQ_REG_VBAT_ADC         0x30u
+#define BQ_REG_TDIE_ADC         0x36u
+#define BQ_REG_PART_INFO        0x38u
+#define BQ_PART_INFO            0x0Au
+#define BQ_VBAT_LSB_V           0.00199f
+#define BQ_IBAT_LSB_A           0.004f
+#define BQ_VBUS_LSB_V           0.00397f
+#define BQ_TDIE_LSB_C           0.5f
+#define BQ_TDIE_C               30.0f
+#define BITS_POR_BYTE           9u          // 8 de dados + ACK
+#define BITS_START_STOP         2u
+#define CICLOS_SINCRONIA        4u          // Sincronizao do SCL, em ciclos do kernel
+
+typedef enum {
+    RESPOSTA_ACK,
+    RESPOSTA_NACK
+} Resposta_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint8_t  s_eeprom[SIM_EEPROM_TAMANHO];
+static uint64_t s_eeprom_ocupada_ate_ns = 0;
+static uint64_t s_eeprom_twr_ns = EEPROM_TWR_PADRAO_NS;
+static Sim_Eeprom_Estatisticas_t s_estatisticas;
+static uint8_t  s_bq[BQ_NUM_REGISTRADORES];
+
+// Transferncia por interrupo em andamento
+static I2C_HandleTypeDef* s_it_handle = NULL;
+static const uint8_t* s_it_dados = NULL;
+static uint16_t   s_it_dispositivo = 0;
+static uint16_t   s_it_endereco = 0;
+static uint16_t   s_it_tamanho = 0;
+static uint64_t   s_it_inicio_ns = 0;
+static Resposta_t s_it_resposta = RESPOSTA_ACK;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint64_t   Ns_Por_Bit(void);
+static uint64_t   Ns_Transacao(uint32_t bytes);
+static bool       Barramento_Ativo(void);
+static Resposta_t Enderecar(uint16_t dispositivo);
+static void       Escrever(uint16_t dispositivo, uint16_t endereco, const uint8_t* dados, uint16_t tamanho,
+                           uint64_t inicio_ns);
+static void       Ler(uint16_t dispositivo, uint16_t endereco, uint8_t* dados, uint16_t tamanho);
+static void       Escrita_It_Concluir(void);
+static void       Bq_Escrever_16(uint8_t registrador, uint16_t valor);
+
+//==============================================================================
+// Callbacks padro
+//==============================================================================
+
+__weak void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c) { (void)hi2c; }
+__weak void HAL_I2C_MspDeInit(I2C_HandleTypeDef* hi2c) { (void)hi2c; }
+__weak void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c) { (void)hi2c; }
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) { (void)hi2c; }
+
+//==============================================================================
+// HAL
+//==============================================================================
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c)
+{
+    SIM_CHAMADA();
+    if (hi2c == NULL) return HAL_ERROR;
+
+    if (hi2c->State == HAL_I2C_STATE_RESET)
+    {
+        hi2c->Lock = HAL_UNLOCKED;
+        HAL_I2C_MspInit(hi2c);
+    }
+    hi2c->Instance->CR1 &= ~I2C_CR1_PE;
+    hi2c->Instance->TIMINGR = hi2c->Init.Timing & 0xF0FFFFFFu;
+    hi2c->Instance->OAR1 = hi2c->Init.OwnAddress1;
+    hi2c->Instance->CR1 |= hi2c->Init.GeneralCallMode | hi2c->Init.NoStretchMode | I2C_CR1_PE;
+
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->PreviousState = 0U;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c)
+{
+    SIM_CHAMADA();
+    if (hi2c == NULL) return HAL_ERROR;
+
+    hi2c->State = HAL_I2C_STATE_BUSY;
+    hi2c->Instance->CR1 &= ~I2C_CR1_PE;
+    HAL_I2C_MspDeInit(hi2c);
+    if (s_it_handle == hi2c)
+    {
+        Sim_Cancelar(SIM_FONTE_I2C);
+        s_it_handle = NULL;
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->State = HAL_I2C_STATE_RESET;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef* hi2c, uint32_t AnalogFilter)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    MODIFY_REG(hi2c->Instance->CR1, I2C_CR1_ANFOFF, AnalogFilter);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef* hi2c, uint32_t DigitalFilter)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    MODIFY_REG(hi2c->Instance->CR1, I2C_CR1_DNF, DigitalFilter << I2C_CR1_DNF_Pos);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint32_t Trials,
+                                        uint32_t Timeout)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    if (!Barramento_Ativo())
+    {
+        Sim_Consumir_ns((uint64_t)Timeout * 1000000ull);
+        hi2c->ErrorCode |= HAL_I2C_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+
+    hi2c->State = HAL_I2C_STATE_BUSY;
+    for (uint32_t tentativa = 0; tentativa < Trials; tentativa++)
+    {
+        Sim_Consumir_ns(Ns_Transacao(1u));
+        if (Enderecar(DevAddress) == RESPOSTA_ACK)
+        {
+            hi2c->State = HAL_I2C_STATE_READY;
+            return HAL_OK;
+        }
+    }
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode |= HAL_I2C_ERROR_TIMEOUT;
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t* pData, uint16_t Size, uint32_t Timeout)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    if (pData == NULL || Size == 0U) return HAL_ERROR;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!Barramento_Ativo())
+    {
+        Sim_Consumir_ns((uint64_t)Timeout * 1000000ull);
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+
+    const uint64_t inicio = Sim_Agora_ns();
+    if (Enderecar(DevAddress) == RESPOSTA_NACK)
+    {
+        Sim_Consumir_ns(Ns_Transacao(1u));
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+    Sim_Consumir_ns(Ns_Transacao(1u + MemAddSize + Size));
+    Escrever(DevAddress, MemAddress, pData, Size, inicio);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t* pData, uint16_t Size, uint32_t Timeout)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    if (pData == NULL || Size == 0U) return HAL_ERROR;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!Barramento_Ativo())
+    {
+        Sim_Consumir_ns((uint64_t)Timeout * 1000000ull);
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+
+    if (Enderecar(DevAddress) == RESPOSTA_NACK)
+    {
+        Sim_Consumir_ns(Ns_Transacao(1u));
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+    // Endereo + endereo de memria, START repetido, endereo + dados
+    Sim_Consumir_ns(Ns_Transacao(2u + MemAddSize + Size) + Ns_Por_Bit());
+    Ler(DevAddress, MemAddress, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                       uint16_t MemAddSize, uint8_t* pData, uint16_t Size)
+{
+    SIM_CHAMADA();
+    if (hi2c->State != HAL_I2C_STATE_READY) return HAL_BUSY;
+    if (pData == NULL || Size == 0U) return HAL_ERROR;
+
+    hi2c->State = HAL_I2C_STATE_BUSY_TX;
+    hi2c->Mode = HAL_I2C_MODE_MEM;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+
+    s_it_handle = hi2c;
+    s_it_dados = pData;
+    s_it_dispositivo = DevAddress;
+    s_it_endereco = MemAddress;
+    s_it_tamanho = Size;
+    s_it_inicio_ns = Sim_Agora_ns();
+
+    // Um barramento desligado no gera evento: a FSM fica esperando, como no alvo
+    if (!Barramento_Ativo()) return HAL_OK;
+
+    s_it_resposta = Enderecar(DevAddress);
+    const uint32_t bytes = (s_it_resposta == RESPOSTA_ACK) ? (1u + MemAddSize + Size) : 1u;
+    Sim_Agendar(SIM_FONTE_I2C, s_it_inicio_ns + Ns_Transacao(bytes), Escrita_It_Concluir);
+    return HAL_OK;
+}
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* hi2c)
+{
+    const uint32_t isr = hi2c->Instance->ISR;
+    if ((isr & I2C_ISR_STOPF) == 0U) return;
+
+    hi2c->Instance->ISR &= ~(I2C_ISR_STOPF | I2C_ISR_NACKF);
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    if (isr & I2C_ISR_NACKF)
+    {
+        hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+        HAL_I2C_ErrorCallback(hi2c);
+        return;
+    }
+    HAL_I2C_MemTxCpltCallback(hi2c);
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* hi2c)
+{
+    const uint32_t isr = hi2c->Instance->ISR;
+    if (isr & I2C_ISR_BERR) hi2c->ErrorCode |= HAL_I2C_ERROR_BERR;
+    if (isr & I2C_ISR_ARLO) hi2c->ErrorCode |= HAL_I2C_ERROR_ARLO;
+    if (isr & I2C_ISR_OVR)  hi2c->ErrorCode |= HAL_I2C_ERROR_OVR;
+    hi2c->Instance->ISR &= ~(I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR);
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    HAL_I2C_ErrorCallback(hi2c);
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_I2c_Reiniciar(void)
+{
+    memset(&Sim_I2C1, 0, sizeof(Sim_I2C1));
+    memset(s_eeprom, 0xFF, sizeof(s_eeprom));   // EEPROM virgem
+    s_eeprom_ocupada_ate_ns = 0;
+    s_eeprom_twr_ns = EEPROM_TWR_PADRAO_NS;
+    memset(&s_estatisticas, 0, sizeof(s_estatisticas));
+    s_it_handle = NULL;
+
+    memset(s_bq, 0, sizeof(s_bq));
+    s_bq[BQ_REG_PART_INFO] = BQ_PART_INFO;
+    Sim_Bateria_Definir(3.9f, 0.0f, 0.0f);
+}
+
+uint8_t* Sim_Eeprom_Memoria(void)
+{
+    return s_eeprom;
+}
+
+void Sim_Eeprom_Definir_Twr_us(uint32_t twr_us)
+{
+    s_eeprom_twr_ns = (uint64_t)twr_us * 1000u;
+}
+
+void Sim_Eeprom_Get_Estatisticas(Sim_Eeprom_Estatisticas_t* estatisticas_out)
+{
+    *estatisticas_out = s_estatisticas;
+}
+
+void Sim_Bateria_Definir(float tensao_v, float corrente_a, float vbus_v)
+{
+    const int32_t ibat = (int32_t)(corrente_a / BQ_IBAT_LSB_A);
+    Bq_Escrever_16(BQ_REG_VBAT_ADC, (uint16_t)(((uint32_t)(tensao_v / BQ_VBAT_LSB_V) << 1) & 0x1FFEu));
+    Bq_Escrever_16(BQ_REG_IBAT_ADC, (uint16_t)((uint32_t)ibat << 2));
+    Bq_Escrever_16(BQ_REG_VBUS_ADC, (uint16_t)(((uint32_t)(vbus_v / BQ_VBUS_LSB_V) << 2) & 0x7FFCu));
+    Bq_Escrever_16(BQ_REG_TDIE_ADC, (uint16_t)((int32_t)(BQ_TDIE_C / BQ_TDIE_LSB_C) & 0x0FFF));
+
+    // CHG_STAT (bits 4:3): 01 = carga em corrente constante
+    const bool carregando = (vbus_v > 4.0f) && (corrente_a > 0.01f);
+    s_bq[BQ_REG_CHG_STATUS_1] = carregando ? (uint8_t)(1u << 3) : 0u;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+/** @brief Perodo do SCL pelo TIMINGR (PRESC, SCLH, SCLL) no clock do kernel (PCLK). */
+static uint64_t Ns_Por_Bit(void)
+{
+    const uint32_t timingr = I2C1->TIMINGR;
+    const uint64_t presc = ((timingr >> I2C_TIMINGR_PRESC_Pos) & 0xFu) + 1u;
+    const uint64_t scll = ((timingr >> I2C_TIMINGR_SCLL_Pos) & 0xFFu) + 1u;
+    const uint64_t sclh = ((timingr >> I2C_TIMINGR_SCLH_Pos) & 0xFFu) + 1u;
+    const uint64_t ciclos = (scll + sclh) * presc + CICLOS_SINCRONIA;
+    return (ciclos * 1000000000ull) / Sim_Pclk_Hz();
+}
+
+static uint64_t Ns_Transacao(uint32_t bytes)
+{
+    return (bytes * BITS_POR_BYTE + BITS_START_STOP) * Ns_Por_Bit();
+}
+
+static bool Barramento_Ativo(void)
+{
+    return (I2C1->CR1 & I2C_CR1_PE) != 0U;
+}
+
+static Resposta_t Enderecar(uint16_t dispositivo)
+{
+    if ((dispositivo & 0xFEu) == BQ_ENDERECO) return RESPOSTA_ACK;
+    if ((dispositivo & 0xFEu) != EEPROM_ENDERECO) return RESPOSTA_NACK;
+
+    if (Sim_Agora_ns() < s_eeprom_ocupada_ate_ns)
+    {
+        s_estatisticas.nacks_ocupada++;
+        return RESPOSTA_NACK;
+    }
+    return RESPOSTA_ACK;
+}
+
+static void Escrever(uint16_t dispositivo, uint16_t endereco, const uint8_t* dados, uint16_t tamanho,
+                     uint64_t inicio_ns)
+{
+    if ((dispositivo & 0xFEu) == BQ_ENDERECO)
+    {
+        for (uint16_t i = 0; i < tamanho; i++)
+        {
+            const uint32_t registrador = (uint32_t)(endereco + i) % BQ_NUM_REGISTRADORES;
+            if (registrador < BQ_REG_CHG_STATUS_1) s_bq[registrador] = dados[i];   // S os de controle
+        }
+        return;
+    }
+
+    // Dentro da pgina o endereo d a volta, como no AT24C512
+    const uint16_t base = (uint16_t)(endereco & ~(EEPROM_PAGINA - 1u));
+    for (uint16_t i = 0; i < tamanho; i++)
+    {
+        s_eeprom[base + ((endereco + i) & (EEPROM_PAGINA - 1u))] = dados[i];
+    }
+    s_eeprom_ocupada_ate_ns = Sim_Agora_ns() + s_eeprom_twr_ns;
+
+    const uint64_t duracao = s_eeprom_ocupada_ate_ns - inicio_ns;
+    s_estatisticas.escritas++;
+    s_estatisticas.bytes_escritos += tamanho;
+    s_estatisticas.escrita_soma_ns += duracao;
+    if (duracao > s_estatisticas.escrita_max_ns) s_estatisticas.escrita_max_ns = duracao;
+}
+
+static void Ler(uint16_t dispositivo, uint16_t endereco, uint8_t* dados, uint16_t tamanho)
+{
+    if ((dispositivo & 0xFEu) == BQ_ENDERECO)
+    {
+        for (uint16_t i = 0; i < tamanho; i++)
+        {
+            dados[i] = s_bq[(uint32_t)(endereco + i) % BQ_NUM_REGISTRADORES];
+        }
+        return;
+    }
+
+    for (uint16_t i = 0; i < tamanho; i++)
+    {
+        dados[i] = s_eeprom[(uint16_t)(endereco + i)];
+    }
+    s_estatisticas.leituras++;
+    s_estatisticas.bytes_lidos += tamanho;
+}
+
+/** @brief STOP da escrita por interrupo: grava (ou NACK) e pendura a IRQ. */
+static void Escrita_It_Concluir(void)
+{
+    if (s_it_handle == NULL) return;
+
+    if (s_it_resposta == RESPOSTA_ACK)
+    {
+        Escrever(s_it_dispositivo, s_it_endereco, s_it_dados, s_it_tamanho, s_it_inicio_ns);
+    }
+    else
+    {
+        I2C1->ISR |= I2C_ISR_NACKF;
+    }
+    I2C1->ISR |= I2C_ISR_STOPF;
+    s_it_handle = NULL;
+    Sim_Pendurar_Irq(I2C1_IRQn);
+}
+
+static void Bq_Escrever_16(uint8_t registrador, uint16_t valor)
+{
+    s_bq[registrador] = (uint8_t)valor;             // Little-endian
+    s_bq[registrador + 1u] = (uint8_t)(valor >> 8);
+}
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * @file        sim_libc.c
+ * @brief       printf do firmware e o monitor de memria no PC.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O printf do firmware vira Sim_Printf (definio na linha de
+ * compilao) e sai, caractere a caractere, pelo fputc do retarget.c, como
+ * na microlib do Keil; da segue pelo FIFO do CLI at a porta USB simulada.
+ * O memoria.c mede a pilha e o pool do USBX do alvo e no tem equivalente
+ * aqui: as funes informam o tamanho da RAM e o pool inativo.
+ ******************************************************************************/
+
+#include "sim.h"
+#include "memoria.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define PRINTF_BUFFER           512u
+#define CICLOS_POR_CARACTERE    24u         // Formatao na microlib, estimada
+
+//==============================================================================
+// Funes do firmware renomeadas na compilao
+//==============================================================================
+
+int Sim_Firmware_fputc(int ch, FILE* f);
+
+//==============================================================================
+// printf
+//==============================================================================
+
+int Sim_Printf(const char* formato, ...)
+{
+    char buffer[PRINTF_BUFFER];
+    va_list args;
+
+    SIM_CHAMADA();
+    va_start(args, formato);
+    int n = vsnprintf(buffer, sizeof(buffer), formato, args);
+    va_end(args);
+    if (n < 0) return n;
+    if ((size_t)n >= sizeof(buffer)) n = (int)sizeof(buffer) - 1;
+
+    Sim_Consumir_Ciclos(CICLOS_POR_CARACTERE * (uint32_t)n);
+    for (int i = 0; i < n; i++)
+    {
+        Sim_Firmware_fputc((unsigned char)buffer[i], stdout);
+    }
+    return n;
+}
+
+//==============================================================================
+// Monitor de memria
+//==============================================================================
+
+void Memoria_Pintar_Pilha(void)
+{
+}
+
+void Memoria_Get_Uso(Memoria_Uso_t* uso_out)
+{
+    memset(uso_out, 0, sizeof(*uso_out));
+    uso_out->pilha_tamanho = MEMORIA_PILHA_TAMANHO;
+    uso_out->pool_ativo = false;
+    uso_out->ram_tamanho = MEMORIA_RAM_TAMANHO;
+}
@@ -0,0 +1,659 @@
+/*******************************************************************************
+ * @file        sim_nucleo.c
+ * @brief       Tempo virtual, NVIC, PRIMASK/WFI, Stop, SysTick e timers.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Os contadores (SysTick, TIMx) so recalculados a cada avano
+ * do tempo a partir dos registradores que o firmware escreveu: o clock vem
+ * do RCC, o perodo do LOAD/ARR e o divisor do PSC. Um estouro com a
+ * interrupo habilitada  um evento da agenda, ento o tempo para exatamente
+ * nele. No Stop os contadores ficam parados e s EXTI, RTC e USB acordam.
+ ******************************************************************************/
+
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==============================================================================
+// Perifricos em RAM
+//==============================================================================
+
+TIM_TypeDef     Sim_TIM1, Sim_TIM2, Sim_TIM3, Sim_TIM14, Sim_TIM16, Sim_TIM17;
+RTC_TypeDef     Sim_RTC;
+USART_TypeDef   Sim_USART1, Sim_USART2;
+I2C_TypeDef     Sim_I2C1, Sim_I2C2;
+PWR_TypeDef     Sim_PWR;
+RCC_TypeDef     Sim_RCC;
+EXTI_TypeDef    Sim_EXTI;
+SYSCFG_TypeDef  Sim_SYSCFG;
+DMA_TypeDef     Sim_DMA1;
+DMA_Channel_TypeDef Sim_DMA1_Channel[5];
+FLASH_TypeDef   Sim_FLASH;
+CRC_TypeDef     Sim_CRC;
+CRS_TypeDef     Sim_CRS;
+GPIO_TypeDef    Sim_GPIOA, Sim_GPIOB, Sim_GPIOC, Sim_GPIOD, Sim_GPIOF;
+ADC_TypeDef     Sim_ADC1;
+ADC_Common_TypeDef Sim_ADC1_COMMON;
+DBG_TypeDef     Sim_DBG;
+USB_DRD_TypeDef Sim_USB_DRD_FS;
+SCB_Type        Sim_SCB;
+SysTick_Type    Sim_SysTick;
+NVIC_Type       Sim_NVIC;
+uint16_t        Sim_Calibracao_Adc[2];
+
+//==============================================================================
+// Definies e Tipos Privados
+//==============================================================================
+
+#define NS_POR_S            1000000000ull
+#define PASSO_MAX_NS        NS_POR_S        // Limita dt * f a 64 bits
+#define CICLOS_ENTRADA_ISR  32u             // Empilhamento + retorno no M0+
+#define NUM_IRQS            32
+
+typedef struct {
+    uint64_t instante_ns;
+    void (*ao_vencer)(void);
+} Sim_Agendamento_t;
+
+typedef struct {
+    TIM_TypeDef* tim;
+    IRQn_Type    irq;
+    uint32_t     psc;               // Divisor ativo (o PSC tem buffer)
+    uint32_t     cnt_escrito;       // ltimo valor posto em CNT pelo simulador
+    uint64_t     resto;             // Frao de tick, em ns * Hz
+} Sim_Timer_t;
+
+typedef void (*Sim_Handler_t)(void);
+
+//==============================================================================
+// Rotinas de interrupo (as do firmware substituem estas)
+//==============================================================================
+
+#define HANDLER_PADRAO(nome)    void __attribute__((weak)) nome(void) { }
+
+HANDLER_PADRAO(SysTick_Handler)
+HANDLER_PADRAO(RTC_IRQHandler)
+HANDLER_PADRAO(EXTI0_1_IRQHandler)
+HANDLER_PADRAO(EXTI2_3_IRQHandler)
+HANDLER_PADRAO(EXTI4_15_IRQHandler)
+HANDLER_PADRAO(USB_DRD_FS_IRQHandler)
+HANDLER_PADRAO(DMA1_Channel1_IRQHandler)
+HANDLER_PADRAO(DMA1_Channel2_3_IRQHandler)
+HANDLER_PADRAO(ADC1_IRQHandler)
+HANDLER_PADRAO(TIM2_IRQHandler)
+HANDLER_PADRAO(TIM3_IRQHandler)
+HANDLER_PADRAO(TIM14_IRQHandler)
+HANDLER_PADRAO(TIM16_IRQHandler)
+HANDLER_PADRAO(TIM17_IRQHandler)
+HANDLER_PADRAO(I2C1_IRQHandler)
+HANDLER_PADRAO(USART2_IRQHandler)
+
+static const Sim_Handler_t s_handlers[NUM_IRQS] = {
+    [RTC_IRQn]             = RTC_IRQHandler,
+    [EXTI0_1_IRQn]         = EXTI0_1_IRQHandler,
+    [EXTI2_3_IRQn]         = EXTI2_3_IRQHandler,
+    [EXTI4_15_IRQn]        = EXTI4_15_IRQHandler,
+    [USB_DRD_FS_IRQn]      = USB_DRD_FS_IRQHandler,
+    [DMA1_Channel1_IRQn]   = DMA1_Channel1_IRQHandler,
+    [DMA1_Channel2_3_IRQn] = DMA1_Channel2_3_IRQHandler,
+    [ADC1_IRQn]            = ADC1_IRQHandler,
+    [TIM2_IRQn]            = TIM2_IRQHandler,
+    [TIM3_IRQn]            = TIM3_IRQHandler,
+    [TIM14_IRQn]           = TIM14_IRQHandler,
+    [TIM16_IRQn]           = TIM16_IRQHandler,
+    [TIM17_IRQn]           = TIM17_IRQHandler,
+    [I2C1_IRQn]            = I2C1_IRQHandler,
+    [USART2_IRQn]          = USART2_IRQHandler,
+};
+
+// Fontes que tiram o ncleo do Stop: linhas da EXTI, alarme do RTC e wakeup da USB.
+static const uint32_t IRQS_ACORDAM_STOP = (1u << EXTI0_1_IRQn) | (1u << EXTI2_3_IRQn) |
+                                          (1u << EXTI4_15_IRQn) | (1u << RTC_IRQn) |
+                                          (1u << USB_DRD_FS_IRQn);
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint64_t s_agora_ns = 0;
+static uint32_t s_primask = 0;
+static bool     s_em_isr = false;
+static bool     s_em_stop = false;
+
+static uint32_t s_pendentes = 0;
+static uint32_t s_habilitadas = 0;
+static uint8_t  s_prioridades[NUM_IRQS];
+static bool     s_systick_pendente = false;
+static uint8_t  s_prioridade_systick = 3;
+
+static Sim_Agendamento_t s_agenda[NUM_SIM_FONTES];
+
+static uint32_t s_systick_val_escrito = 0;
+static uint64_t s_systick_resto = 0;
+
+static Sim_Timer_t s_timers[] = {
+    {&Sim_TIM2,  TIM2_IRQn,  0, 0, 0},
+    {&Sim_TIM3,  TIM3_IRQn,  0, 0, 0},
+    {&Sim_TIM14, TIM14_IRQn, 0, 0, 0},
+    {&Sim_TIM16, TIM16_IRQn, 0, 0, 0},
+    {&Sim_TIM17, TIM17_IRQn, 0, 0, 0},
+};
+#define NUM_TIMERS  (sizeof(s_timers) / sizeof(s_timers[0]))
+
+static uint32_t s_pulsos_hz = 0;
+static Sim_Estatisticas_t s_estatisticas;
+
+static void Travar_Padrao(const char* motivo);
+void (*Sim_Ao_Travar)(const char* motivo) = Travar_Padrao;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void     Avancar_Ate(uint64_t alvo_ns);
+static uint64_t Proximo_Evento(void);
+static void     Atualizar_Relogios(uint64_t dt_ns);
+static void     Atualizar_Rcc(void);
+static void     Atualizar_Systick(uint64_t dt_ns);
+static uint64_t Proximo_Systick(void);
+static void     Atualizar_Timer(Sim_Timer_t* t, uint64_t dt_ns);
+static uint64_t Proximo_Timer(const Sim_Timer_t* t);
+static uint32_t Entrada_Timer(const Sim_Timer_t* t);
+static bool     Ha_Irq_Para_Acordar(uint32_t mascara);
+static void     Atender_Irqs(void);
+static uint64_t Ns_Ate_Ticks(uint64_t ticks, uint64_t divisor_hz, uint64_t resto, uint32_t f_hz);
+
+//==============================================================================
+// Implementao das Funes Pblicas
+//==============================================================================
+
+void Sim_Reiniciar(void)
+{
+    s_agora_ns = 0;
+    s_primask = 0;
+    s_em_isr = false;
+    s_em_stop = false;
+    s_pendentes = 0;
+    s_habilitadas = 0;
+    s_systick_pendente = false;
+    s_prioridade_systick = 3;
+    s_systick_val_escrito = 0;
+    s_systick_resto = 0;
+    s_pulsos_hz = 0;
+    memset(s_prioridades, 0, sizeof(s_prioridades));
+    memset(s_agenda, 0, sizeof(s_agenda));
+    memset(&s_estatisticas, 0, sizeof(s_estatisticas));
+
+    memset(&Sim_TIM2, 0, sizeof(TIM_TypeDef));
+    memset(&Sim_TIM3, 0, sizeof(TIM_TypeDef));
+    memset(&Sim_TIM14, 0, sizeof(TIM_TypeDef));
+    memset(&Sim_TIM16, 0, sizeof(TIM_TypeDef));
+    memset(&Sim_TIM17, 0, sizeof(TIM_TypeDef));
+    for (size_t i = 0; i < NUM_TIMERS; i++)
+    {
+        s_timers[i].tim->ARR = 0xFFFFu;
+        s_timers[i].psc = 0;
+        s_timers[i].cnt_escrito = 0;
+        s_timers[i].resto = 0;
+    }
+    Sim_TIM2.ARR = 0xFFFFFFFFu;
+
+    memset(&Sim_SysTick, 0, sizeof(Sim_SysTick));
+    memset(&Sim_SCB, 0, sizeof(Sim_SCB));
+    memset(&Sim_NVIC, 0, sizeof(Sim_NVIC));
+    memset(&Sim_PWR, 0, sizeof(Sim_PWR));
+    memset(&Sim_EXTI, 0, sizeof(Sim_EXTI));
+    memset(&Sim_FLASH, 0, sizeof(Sim_FLASH));
+    memset(&Sim_DMA1, 0, sizeof(Sim_DMA1));
+    memset(Sim_DMA1_Channel, 0, sizeof(Sim_DMA1_Channel));
+
+    // Reset do RCC: HSISYS = HSI48 / 4.
+    memset(&Sim_RCC, 0, sizeof(Sim_RCC));
+    Sim_RCC.CR = RCC_CR_HSION | RCC_CR_HSIRDY | (2u << RCC_CR_HSIDIV_Pos);
+}
+
+uint64_t Sim_Agora_ns(void) { return s_agora_ns; }
+
+uint32_t Sim_Agora_ms(void) { return (uint32_t)(s_agora_ns / 1000000u); }
+
+void Sim_Consumir_ns(uint64_t ns)
+{
+    // Como no alvo, as interrupes entram no meio de um trecho longo de CPU
+    // (uma escrita bloqueante na EEPROM no junta vrios SysTicks em um).
+    const uint64_t alvo = s_agora_ns + ns;
+    for (;;)
+    {
+        const uint64_t proximo = Proximo_Evento();
+        Avancar_Ate((proximo > s_agora_ns && proximo < alvo) ? proximo : alvo);
+        Atender_Irqs();
+        if (s_agora_ns >= alvo) return;
+    }
+}
+
+void Sim_Consumir_Ciclos(uint32_t ciclos)
+{
+    const uint32_t hclk = Sim_Hclk_Hz();
+    Sim_Consumir_ns(((uint64_t)ciclos * NS_POR_S + hclk - 1u) / hclk);
+}
+
+void Sim_Agendar(Sim_Fonte_t fonte, uint64_t instante_ns, void (*ao_vencer)(void))
+{
+    if (fonte >= NUM_SIM_FONTES) return;
+    s_agenda[fonte].instante_ns = (instante_ns < s_agora_ns) ? s_agora_ns : instante_ns;
+    s_agenda[fonte].ao_vencer = ao_vencer;
+}
+
+void Sim_Cancelar(Sim_Fonte_t fonte)
+{
+    if (fonte < NUM_SIM_FONTES) s_agenda[fonte].ao_vencer = NULL;
+}
+
+bool Sim_Agendado(Sim_Fonte_t fonte)
+{
+    return (fonte < NUM_SIM_FONTES) && (s_agenda[fonte].ao_vencer != NULL);
+}
+
+void Sim_Pendurar_Irq(IRQn_Type irq)
+{
+    if (irq == SysTick_IRQn) s_systick_pendente = true;
+    else if (irq >= 0 && irq < NUM_IRQS) s_pendentes |= (1u << irq);
+}
+
+void Sim_Habilitar_Irq(IRQn_Type irq, bool habilitar)
+{
+    if (irq < 0 || irq >= NUM_IRQS) return;
+    if (habilitar)
+    {
+        s_habilitadas |= (1u << irq);
+        Atender_Irqs();                     // J pendente: entra na hora
+    }
+    else
+    {
+        s_habilitadas &= ~(1u << irq);
+    }
+}
+
+void Sim_Prioridade_Irq(IRQn_Type irq, uint32_t prioridade)
+{
+    // O M0+ implementa 2 bits de prioridade.
+    if (prioridade > 3u) prioridade = 3u;
+    if (irq == SysTick_IRQn) s_prioridade_systick = (uint8_t)prioridade;
+    else if (irq >= 0 && irq < NUM_IRQS) s_prioridades[irq] = (uint8_t)prioridade;
+}
+
+uint32_t Sim_Get_Primask(void) { return s_primask; }
+
+void Sim_Set_Primask(uint32_t primask)
+{
+    s_primask = primask & 1u;
+    Atender_Irqs();
+}
+
+void Sim_Wfi(void)
+{
+    SIM_CHAMADA();
+    if (Ha_Irq_Para_Acordar(UINT32_MAX)) return;
+
+    const uint64_t inicio_ns = s_agora_ns;
+    s_estatisticas.entradas_sleep++;
+    while (!Ha_Irq_Para_Acordar(UINT32_MAX))
+    {
+        const uint64_t proximo = Proximo_Evento();
+        if (proximo == SIM_NUNCA)
+        {
+            Sim_Ao_Travar("WFI sem nenhum evento futuro");
+            return;
+        }
+        Avancar_Ate(proximo);
+    }
+    s_estatisticas.sleep_ns += s_agora_ns - inicio_ns;
+    Atender_Irqs();
+}
+
+void Sim_Stop(void)
+{
+    SIM_CHAMADA();
+    if (Ha_Irq_Para_Acordar(IRQS_ACORDAM_STOP)) return;
+
+    const uint64_t inicio_ns = s_agora_ns;
+    s_estatisticas.entradas_stop++;
+    s_em_stop = true;
+    while (!Ha_Irq_Para_Acordar(IRQS_ACORDAM_STOP))
+    {
+        const uint64_t proximo = Proximo_Evento();
+        if (proximo == SIM_NUNCA)
+        {
+            s_em_stop = false;
+            Sim_Ao_Travar("Stop sem nenhuma fonte de despertar");
+            return;
+        }
+        Avancar_Ate(proximo);
+    }
+    s_em_stop = false;
+
+    // Ao acordar o HSISYS volta com o divisor de reset e o HSI48 desligado.
+    Sim_RCC.CR &= ~(RCC_CR_HSIDIV | RCC_CR_HSIUSB48ON | RCC_CR_HSIUSB48RDY);
+    Sim_RCC.CR |= RCC_CR_HSION | RCC_CR_HSIRDY | (2u << RCC_CR_HSIDIV_Pos);
+    Sim_RCC.CFGR &= ~(RCC_CFGR_SW | RCC_CFGR_SWS);
+    s_estatisticas.stop_ns += s_agora_ns - inicio_ns;
+    Atender_Irqs();
+}
+
+bool Sim_Em_Stop(void) { return s_em_stop; }
+
+uint32_t Sim_Hclk_Hz(void)
+{
+    const uint32_t sysdiv = ((Sim_RCC.CR & RCC_CR_SYSDIV) >> RCC_CR_SYSDIV_Pos) + 1u;
+    uint32_t sysclk;
+    switch (Sim_RCC.CFGR & RCC_CFGR_SW)
+    {
+        case RCC_CFGR_SW_1:                     sysclk = HSI48_VALUE; break;
+        case (RCC_CFGR_SW_1 | RCC_CFGR_SW_0):   sysclk = LSI_VALUE; break;
+        default:
+            sysclk = HSI_VALUE >> ((Sim_RCC.CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos);
+            break;
+    }
+    return (sysclk / sysdiv) >> AHBPrescTable[(Sim_RCC.CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+}
+
+uint32_t Sim_Pclk_Hz(void)
+{
+    return Sim_Hclk_Hz() >> APBPrescTable[(Sim_RCC.CFGR & RCC_CFGR_PPRE) >> RCC_CFGR_PPRE_Pos];
+}
+
+void Sim_Set_Frequencia_Pulsos(uint32_t hz)
+{
+    Atualizar_Relogios(0);
+    s_pulsos_hz = hz;
+}
+
+void Sim_Systick_Configurar(void)
+{
+    s_systick_resto = 0;
+    Sim_SysTick.VAL = 0;
+    s_systick_val_escrito = 0;
+}
+
+void Sim_Get_Estatisticas(Sim_Estatisticas_t* estatisticas_out)
+{
+    if (estatisticas_out == NULL) return;
+    *estatisticas_out = s_estatisticas;
+    estatisticas_out->ativo_ns = s_agora_ns - s_estatisticas.sleep_ns - s_estatisticas.stop_ns;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static void Travar_Padrao(const char* motivo)
+{
+    fprintf(stderr, "SIM: travado em %.3f ms: %s\n", (double)s_agora_ns / 1e6, motivo);
+    exit(3);
+}
+
+/**
+ * @brief Avana at 'alvo_ns' parando em cada evento: estouros de contador
+ * marcam as IRQs e os agendamentos vencidos so chamados na ordem das fontes.
+ */
+static void Avancar_Ate(uint64_t alvo_ns)
+{
+    for (;;)
+    {
+        const uint64_t proximo = Proximo_Evento();
+        uint64_t ate = (proximo < alvo_ns) ? proximo : alvo_ns;
+        if (ate < s_agora_ns) ate = s_agora_ns;
+        if (ate - s_agora_ns > PASSO_MAX_NS) ate = s_agora_ns + PASSO_MAX_NS;
+
+        Atualizar_Relogios(ate - s_agora_ns);
+        s_agora_ns = ate;
+
+        for (int i = 0; i < NUM_SIM_FONTES; i++)
+        {
+            if (s_agenda[i].ao_vencer != NULL && s_agenda[i].instante_ns <= s_agora_ns)
+            {
+                void (*ao_vencer)(void) = s_agenda[i].ao_vencer;
+                s_agenda[i].ao_vencer = NULL;   // O callback pode reagendar a fonte
+                ao_vencer();
+            }
+        }
+
+        if (s_agora_ns >= alvo_ns) return;
+    }
+}
+
+static uint64_t Proximo_Evento(void)
+{
+    uint64_t proximo = SIM_NUNCA;
+    for (int i = 0; i < NUM_SIM_FONTES; i++)
+    {
+        if (s_agenda[i].ao_vencer != NULL && s_agenda[i].instante_ns < proximo)
+        {
+            proximo = s_agenda[i].instante_ns;
+        }
+    }
+    if (s_em_stop) return proximo;
+
+    const uint64_t systick = Proximo_Systick();
+    if (systick < proximo) proximo = systick;
+    for (size_t i = 0; i < NUM_TIMERS; i++)
+    {
+        const uint64_t timer = Proximo_Timer(&s_timers[i]);
+        if (timer < proximo) proximo = timer;
+    }
+    return proximo;
+}
+
+static void Atualizar_Relogios(uint64_t dt_ns)
+{
+    Atualizar_Rcc();
+    if (s_em_stop) dt_ns = 0;      // Clocks parados: s os registradores escritos valem
+    Atualizar_Systick(dt_ns);
+    for (size_t i = 0; i < NUM_TIMERS; i++)
+    {
+        Atualizar_Timer(&s_timers[i], dt_ns);
+    }
+}
+
+/** @brief Osciladores ficam prontos assim que ligados; SWS segue o SW. */
+static void Atualizar_Rcc(void)
+{
+    uint32_t cr = Sim_RCC.CR & ~(RCC_CR_HSIRDY | RCC_CR_HSIUSB48RDY);
+    if (cr & RCC_CR_HSION)      cr |= RCC_CR_HSIRDY;
+    if (cr & RCC_CR_HSIUSB48ON) cr |= RCC_CR_HSIUSB48RDY;
+    Sim_RCC.CR = cr;
+
+    if (Sim_RCC.CSR2 & RCC_CSR2_LSION) Sim_RCC.CSR2 |= RCC_CSR2_LSIRDY;
+    else                               Sim_RCC.CSR2 &= ~RCC_CSR2_LSIRDY;
+
+    const uint32_t sw = Sim_RCC.CFGR & RCC_CFGR_SW;
+    Sim_RCC.CFGR = (Sim_RCC.CFGR & ~RCC_CFGR_SWS) | (sw << RCC_CFGR_SWS_Pos);
+}
+
+static uint32_t Clock_Systick(void)
+{
+    const uint32_t hclk = Sim_Hclk_Hz();
+    return (Sim_SysTick.CTRL & SysTick_CTRL_CLKSOURCE_Msk) ? hclk : hclk / 8u;
+}
+
+/**
+ * @brief Contagem regressiva do SysTick. Uma escrita no VAL zera o contador;
+ * o prximo tick recarrega o LOAD e a interrupo vem na passagem de 1 a 0.
+ */
+static void Atualizar_Systick(uint64_t dt_ns)
+{
+    if (Sim_SysTick.VAL != s_systick_val_escrito)
+    {
+        Sim_SysTick.VAL = 0;
+        s_systick_resto = 0;
+    }
+    if ((Sim_SysTick.CTRL & SysTick_CTRL_ENABLE_Msk) == 0 || dt_ns == 0)
+    {
+        s_systick_val_escrito = Sim_SysTick.VAL;
+        return;
+    }
+
+    const uint64_t total = dt_ns * Clock_Systick() + s_systick_resto;
+    uint64_t ticks = total / NS_POR_S;
+    s_systick_resto = total % NS_POR_S;
+
+    const uint64_t periodo = (uint64_t)(Sim_SysTick.LOAD & SysTick_LOAD_RELOAD_Msk) + 1u;
+    const uint64_t ate_zero = (Sim_SysTick.VAL == 0) ? periodo : Sim_SysTick.VAL;
+    if (ticks >= ate_zero)
+    {
+        ticks -= ate_zero;
+        const uint64_t resto = ticks % periodo;
+        Sim_SysTick.VAL = (resto == 0) ? 0u : (uint32_t)(periodo - resto);
+        Sim_SysTick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if (Sim_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk) s_systick_pendente = true;
+    }
+    else
+    {
+        Sim_SysTick.VAL = (uint32_t)(ate_zero - ticks);
+    }
+    s_systick_val_escrito = Sim_SysTick.VAL;
+}
+
+static uint64_t Proximo_Systick(void)
+{
+    if ((Sim_SysTick.CTRL & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk)) !=
+        (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk))
+    {
+        return SIM_NUNCA;
+    }
+    const uint64_t periodo = (uint64_t)(Sim_SysTick.LOAD & SysTick_LOAD_RELOAD_Msk) + 1u;
+    const uint64_t ate_zero = (Sim_SysTick.VAL == 0 || Sim_SysTick.VAL != s_systick_val_escrito) ?
+                              periodo : Sim_SysTick.VAL;
+    return s_agora_ns + Ns_Ate_Ticks(ate_zero, 1u, s_systick_resto, Clock_Systick());
+}
+
+/** @brief Frequncia de entrada do prescaler: clock do APB ou pulsos externos. */
+static uint32_t Entrada_Timer(const Sim_Timer_t* t)
+{
+    if ((t->tim->SMCR & TIM_SMCR_SMS) == (TIM_SMCR_SMS_0 | TIM_SMCR_SMS_1 | TIM_SMCR_SMS_2))
+    {
+        return (t->tim == &Sim_TIM2) ? s_pulsos_hz : 0u;
+    }
+    // Com o APB dividido, os timers recebem o dobro do PCLK.
+    const bool apb_dividido = (Sim_RCC.CFGR & RCC_CFGR_PPRE) >= (4u << RCC_CFGR_PPRE_Pos);
+    return apb_dividido ? Sim_Pclk_Hz() * 2u : Sim_Pclk_Hz();
+}
+
+/**
+ * @brief Conta os ticks do intervalo. O UG s recarrega o PSC: o firmware
+ * liga o URS em volta dele (ou limpa o UIF em seguida) e sempre regrava o
+ * CNT, mas o simulador s v o estado final dos registradores.
+ */
+static void Atualizar_Timer(Sim_Timer_t* t, uint64_t dt_ns)
+{
+    TIM_TypeDef* tim = t->tim;
+    if (tim->CNT != t->cnt_escrito) t->resto = 0;      // O firmware escreveu no CNT
+    if (tim->EGR & TIM_EGR_UG)
+    {
+        tim->EGR = 0;
+        t->psc = tim->PSC;
+        t->resto = 0;
+    }
+
+    const uint32_t f_hz = Entrada_Timer(t);
+    if ((tim->CR1 & TIM_CR1_CEN) == 0 || dt_ns == 0 || f_hz == 0)
+    {
+        t->cnt_escrito = tim->CNT;
+        return;
+    }
+
+    const uint64_t divisor = ((uint64_t)t->psc + 1u) * NS_POR_S;
+    const uint64_t total = dt_ns * f_hz + t->resto;
+    const uint64_t ticks = total / divisor;
+    t->resto = total % divisor;
+
+    const uint64_t periodo = (uint64_t)tim->ARR + 1u;
+    const uint64_t contagem = (uint64_t)tim->CNT + ticks;
+    if (contagem >= periodo)
+    {
+        t->psc = tim->PSC;                              // Evento de update carrega o PSC
+        tim->SR |= TIM_SR_UIF;
+        if (tim->DIER & TIM_DIER_UIE) Sim_Pendurar_Irq(t->irq);
+    }
+    tim->CNT = (uint32_t)(contagem % periodo);
+    t->cnt_escrito = tim->CNT;
+}
+
+static uint64_t Proximo_Timer(const Sim_Timer_t* t)
+{
+    const TIM_TypeDef* tim = t->tim;
+    if ((tim->CR1 & TIM_CR1_CEN) == 0 || (tim->DIER & TIM_DIER_UIE) == 0) return SIM_NUNCA;
+
+    const uint32_t f_hz = Entrada_Timer(t);
+    if (f_hz == 0) return SIM_NUNCA;
+
+    const uint64_t periodo = (uint64_t)tim->ARR + 1u;
+    const uint64_t cnt = (tim->CNT < periodo) ? tim->CNT : 0u;
+    const uint64_t resto = (tim->CNT == t->cnt_escrito) ? t->resto : 0u;
+    return s_agora_ns + Ns_Ate_Ticks(periodo - cnt, (uint64_t)t->psc + 1u, resto, f_hz);
+}
+
+/** @brief Tempo at completar 'ticks' contando a frao j acumulada. */
+static uint64_t Ns_Ate_Ticks(uint64_t ticks, uint64_t divisor, uint64_t resto, uint32_t f_hz)
+{
+    const unsigned __int128 necessario = (unsigned __int128)ticks * divisor * NS_POR_S;
+    if (necessario <= resto) return 0;
+    const unsigned __int128 falta = necessario - resto;
+    return (uint64_t)((falta + f_hz - 1u) / f_hz);
+}
+
+/** @brief Alguma IRQ habilitada e pendente entre as da mscara (ou o SysTick). */
+static bool Ha_Irq_Para_Acordar(uint32_t mascara)
+{
+    if (s_pendentes & s_habilitadas & mascara) return true;
+    return (mascara == UINT32_MAX) && s_systick_pendente &&
+           (Sim_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk);
+}
+
+/**
+ * @brief Atende as pendentes por prioridade (empate: menor nmero, SysTick
+ * primeiro). Sem aninhamento: a prxima s entra quando a atual retorna.
+ */
+static void Atender_Irqs(void)
+{
+    while (!s_em_isr && s_primask == 0)
+    {
+        int escolhida = NUM_IRQS;
+        uint8_t melhor = UINT8_MAX;
+        if (s_systick_pendente && (Sim_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk))
+        {
+            escolhida = SysTick_IRQn;
+            melhor = s_prioridade_systick;
+        }
+        const uint32_t prontas = s_pendentes & s_habilitadas;
+        for (int irq = 0; irq < NUM_IRQS; irq++)
+        {
+            if ((prontas & (1u << irq)) && s_prioridades[irq] < melhor)
+            {
+                escolhida = irq;
+                melhor = s_prioridades[irq];
+            }
+        }
+        if (escolhida == NUM_IRQS) return;
+
+        Sim_Handler_t handler;
+        if (escolhida == SysTick_IRQn)
+        {
+            s_systick_pendente = false;
+            Sim_SysTick.CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+            handler = SysTick_Handler;
+            s_estatisticas.systicks++;
+        }
+        else
+        {
+            s_pendentes &= ~(1u << escolhida);
+            handler = s_handlers[escolhida];
+            s_estatisticas.irqs[escolhida]++;
+        }
+
+        s_em_isr = true;
+        Sim_Consumir_Ciclos(CICLOS_ENTRADA_ISR);
+        if (handler != NULL) handler();
+        s_em_isr = false;
+    }
+}
@@ -0,0 +1,541 @@
+/*******************************************************************************
+ * @file        sim_principal.c
+ * @brief       Roda o firmware no tempo virtual com um roteiro de entradas e
+ *              confere ou mede o resultado.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     Cada execuo  um cenrio: o firmware parte do reset (main()
+ * renomeado para firmware_main), o roteiro injeta toques, comandos de CLI e
+ * mudanas de cabo nos instantes marcados, e no fim do tempo virtual o
+ * cenrio verifica o estado (tela, transcrio da CLI, EEPROM) e imprime as
+ * medies. Como as variveis estticas do firmware no voltam ao valor
+ * inicial, h um cenrio por processo; a imagem da EEPROM pode ser levada de
+ * uma execuo  prxima com --eeprom.
+ *
+ * Uso: stm_vcom_sim <cenario> [--eeprom arquivo] [-v]
+ ******************************************************************************/
+
+#include "sim.h"
+#include "dwin_driver.h"
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define TEMPO_REAL_MAX_S        120u        // Guarda contra lao sem chamadas ao HAL
+#define TRANSCRICAO_TAMANHO     65536u
+#define CLI_SILENCIO_NS         50000000ull // Fim de uma resposta da CLI
+#define MAX_AMOSTRAS            64u
+#define MAX_TELAS               32u
+#define TOLERANCIA_TELA_NS      10000000ull // Troca de tela reproduzida vs. roteiro
+#define NS_POR_MS               1000000ull
+
+enum {
+    SAIDA_OK = 0,
+    SAIDA_FALHOU = 1,
+    SAIDA_USO = 2,
+    SAIDA_TRAVOU = 3
+};
+
+typedef struct {
+    uint32_t instante_ms;
+    void (*acao)(void);
+} Passo_t;
+
+typedef struct {
+    const char*    nome;
+    const char*    descricao;
+    uint32_t       duracao_ms;
+    const Passo_t* passos;
+    size_t         num_passos;
+    bool (*verificar)(void);
+} Cenario_t;
+
+typedef struct {
+    uint32_t n;
+    uint64_t soma_ns;
+    uint64_t max_ns;
+} Amostras_t;
+
+typedef struct {
+    uint16_t tela;
+    uint64_t instante_ns;
+} Troca_Tela_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+int firmware_main(void);
+
+static jmp_buf s_fim;
+static int     s_codigo_fim = SAIDA_OK;
+static bool    s_verboso = false;
+static const Cenario_t* s_cenario = NULL;
+static size_t  s_proximo_passo = 0;
+
+// Display
+static uint64_t s_boot_ns = 0;
+static uint16_t s_tela_esperada = 0xFFFFu;
+static uint64_t s_toque_ns = 0;
+static uint32_t s_toques = 0;
+static Amostras_t s_latencia_toque;
+static Troca_Tela_t s_telas[MAX_TELAS];
+static uint32_t s_num_telas = 0;
+static uint64_t s_marco_ns = 0;         // Incio da gravao ou da reproduo
+
+// CLI
+static char     s_transcricao[TRANSCRICAO_TAMANHO];
+static size_t   s_transcricao_len = 0;
+static uint64_t s_comando_ns = 0;
+static uint64_t s_resposta_primeiro_ns = 0;
+static uint64_t s_resposta_ultimo_ns = 0;
+static size_t   s_resposta_bytes = 0;
+static Amostras_t s_latencia_cli;
+static uint64_t s_vazao_bytes = 0;
+static uint64_t s_vazao_ns = 0;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static void Reiniciar_Placa(void);
+static void Roteiro_Avancar(void);
+static void Encerrar(void);
+static void Ao_Travar(const char* motivo);
+static void Ao_Alarme(int sinal);
+static void Ao_Receber_Dwin(const uint8_t* quadro, uint16_t tamanho);
+static void Ao_Receber_Usb(const uint8_t* dados, size_t tamanho);
+static void Enviar_Comando(const char* linha);
+static void Fechar_Resposta(void);
+static void Tocar(uint16_t vp, uint16_t tela_esperada);
+static void Registrar(Amostras_t* amostras, uint64_t ns);
+static double Media_ms(const Amostras_t* amostras);
+static const char* Transcricao(void);
+static bool Carregar_Eeprom(const char* arquivo);
+static bool Salvar_Eeprom(const char* arquivo);
+static void Imprimir_Relatorio(double tempo_real_s);
+
+//==============================================================================
+// Cenrios
+//==============================================================================
+
+static void Passo_Who_Am_I(void)    { Enviar_Comando("WHO_AM_I"); }
+static void Passo_Help(void)        { Enviar_Comando("HELP"); }
+static void Passo_Stats(void)       { Enviar_Comando("STATS"); }
+static void Passo_Trace_Dump(void)  { Enviar_Comando("TRACE DUMP"); }
+static void Passo_Gravar(void)      { s_marco_ns = Sim_Agora_ns(); Enviar_Comando("GRAVAR INICIAR"); }
+static void Passo_Gravar_Parar(void){ Enviar_Comando("GRAVAR PARAR"); }
+static void Passo_Reproduzir(void)  { s_marco_ns = Sim_Agora_ns(); Enviar_Comando("REPRODUZIR"); }
+static void Passo_Fechar(void)      { Fechar_Resposta(); }
+static void Passo_Monitor(void)     { Tocar(MONITOR, TELA_MONITOR_SYSTEM); }
+static void Passo_Bateria(void)     { Tocar(BATTERY_INFORMATION, TELA_BATERIA); }
+static void Passo_Escape(void)      { Tocar(ESCAPE, PRINCIPAL); }
+
+static const Passo_t PASSOS_BOOT[] = {
+    {2500, Passo_Who_Am_I},
+    {2900, Passo_Fechar},
+};
+
+static bool Verificar_Boot(void)
+{
+    bool ok = true;
+    if (Sim_Dwin_Get_Tela() != PRINCIPAL)
+    {
+        printf("FALHA: tela %u no fim do boot, esperada %u\n", Sim_Dwin_Get_Tela(), (unsigned)PRINCIPAL);
+        ok = false;
+    }
+    if (s_latencia_cli.n == 0u)
+    {
+        printf("FALHA: a CLI nao respondeu ao WHO_AM_I pela USB\n");
+        ok = false;
+    }
+    return ok;
+}
+
+static const Passo_t PASSOS_BENCH[] = {
+    {2500, Passo_Who_Am_I}, {2700, Passo_Fechar},
+    {2800, Passo_Stats},    {3300, Passo_Fechar},
+    {3400, Passo_Help},     {4400, Passo_Fechar},
+    {4500, Passo_Monitor},  {4800, Passo_Escape},
+    {5100, Passo_Bateria},  {5400, Passo_Escape},
+    {5700, Passo_Monitor},  {6000, Passo_Escape},
+    {6300, Passo_Bateria},  {6600, Passo_Escape},
+    {6900, Passo_Monitor},  {7200, Passo_Escape},
+};
+
+static bool Verificar_Bench(void)
+{
+    if (s_latencia_toque.n != s_toques)
+    {
+        printf("FALHA: %u de %u toques sem a troca de tela esperada\n",
+               (unsigned)(s_toques - s_latencia_toque.n), (unsigned)s_toques);
+        return false;
+    }
+    return Verificar_Boot();
+}
+
+static const Passo_t PASSOS_TRACE[] = {
+    {2500, Passo_Monitor},  {2800, Passo_Escape},
+    {3100, Passo_Bateria},  {3400, Passo_Escape},
+    {3500, Passo_Trace_Dump},
+};
+
+/** @brief O dump chega inteiro: um registro (16 dgitos) para cada um anunciado. */
+static bool Verificar_Trace(void)
+{
+    const char* inicio = strstr(Transcricao(), "TRACE INICIO registros=");
+    const char* fim = (inicio != NULL) ? strstr(inicio, "TRACE FIM") : NULL;
+    if (fim == NULL)
+    {
+        printf("FALHA: dump do trace incompleto\n");
+        return false;
+    }
+
+    const unsigned long anunciados = strtoul(inicio + strlen("TRACE INICIO registros="), NULL, 10);
+    unsigned long digitos = 0;
+    for (const char* linha = strchr(inicio, '\n'); linha != NULL && linha < fim; linha = strchr(linha, '\n'))
+    {
+        linha++;
+        if (strncmp(linha, "> ", 2) == 0) linha += 2;     // Prompt da CLI no meio do dump
+        const size_t n = strspn(linha, "0123456789ABCDEF");
+        if (linha[n] == '\r') digitos += n;
+    }
+    if (anunciados == 0u || digitos != anunciados * 16u)
+    {
+        printf("FALHA: %lu registros anunciados, %lu digitos recebidos\n", anunciados, digitos);
+        return false;
+    }
+    return Verificar_Bench();
+}
+
+/*
+ * Gravao e reproduo: o cenrio "gravar" toca o display e manda um
+ * comando com a gravao ligada e guarda a EEPROM (--eeprom); o
+ * "reproduzir" parte dessa EEPROM, sem toque nenhum, e deve repetir as
+ * mesmas trocas de tela nos mesmos instantes, contados do comando.
+ */
+static const Troca_Tela_t TELAS_GRAVADAS[] = {
+    {TELA_MONITOR_SYSTEM, 200u * NS_POR_MS}, {PRINCIPAL, 500u * NS_POR_MS},
+    {TELA_BATERIA,        800u * NS_POR_MS}, {PRINCIPAL, 1100u * NS_POR_MS},
+};
+#define NUM_TELAS_GRAVADAS (sizeof(TELAS_GRAVADAS) / sizeof(TELAS_GRAVADAS[0]))
+
+static const Passo_t PASSOS_GRAVAR[] = {
+    {2500, Passo_Gravar},
+    {2700, Passo_Monitor},  {3000, Passo_Escape},
+    {3300, Passo_Bateria},  {3600, Passo_Escape},
+    {3800, Passo_Who_Am_I}, {4000, Passo_Gravar_Parar},
+};
+
+static const Passo_t PASSOS_REPRODUZIR[] = {
+    {2500, Passo_Reproduzir},
+};
+
+/** @brief As trocas de tela depois do marco seguem TELAS_GRAVADAS. */
+static bool Verificar_Telas(void)
+{
+    uint32_t i = 0;
+    while (i < s_num_telas && s_telas[i].instante_ns < s_marco_ns) i++;
+
+    bool ok = (s_num_telas - i == NUM_TELAS_GRAVADAS);
+    for (uint32_t n = 0; ok && n < NUM_TELAS_GRAVADAS; n++, i++)
+    {
+        const uint64_t relativo = s_telas[i].instante_ns - s_marco_ns;
+        if (s_verboso) printf("tela %3u em +%.2f ms\n", s_telas[i].tela, relativo / 1e6);
+        ok = s_telas[i].tela == TELAS_GRAVADAS[n].tela &&
+             relativo >= TELAS_GRAVADAS[n].instante_ns &&
+             relativo <= TELAS_GRAVADAS[n].instante_ns + TOLERANCIA_TELA_NS;
+    }
+    if (!ok) printf("FALHA: trocas de tela diferentes do roteiro gravado\n");
+    return ok;
+}
+
+static bool Transcricao_Contem(const char* texto)
+{
+    if (strstr(Transcricao(), texto) != NULL) return true;
+    printf("FALHA: \"%s\" ausente na CLI\n", texto);
+    return false;
+}
+
+static bool Verificar_Gravar(void)
+{
+    return Transcricao_Contem(" 0 descartados.") && Verificar_Telas() && Verificar_Bench();
+}
+
+static bool Verificar_Reproduzir(void)
+{
+    // O WHO_AM_I gravado tambm volta, pela CLI.
+    return Transcricao_Contem("REPRODUCAO: concluida.") && Verificar_Telas() && Verificar_Boot();
+}
+
+static const Cenario_t CENARIOS[] = {
+    {"boot",  "Boot ate a tela principal e resposta da CLI pela USB",
+     3000, PASSOS_BOOT, sizeof(PASSOS_BOOT) / sizeof(PASSOS_BOOT[0]), Verificar_Boot},
+    {"bench", "Latencia e vazao do display, da CLI e da EEPROM",
+     7500, PASSOS_BENCH, sizeof(PASSOS_BENCH) / sizeof(PASSOS_BENCH[0]), Verificar_Bench},
+    {"trace", "Toques e TRACE DUMP (a saida com -v alimenta o trace_para_chrome)",
+     4000, PASSOS_TRACE, sizeof(PASSOS_TRACE) / sizeof(PASSOS_TRACE[0]), Verificar_Trace},
+    {"gravar", "Grava toques e um comando na EEPROM (use com --eeprom)",
+     5000, PASSOS_GRAVAR, sizeof(PASSOS_GRAVAR) / sizeof(PASSOS_GRAVAR[0]), Verificar_Gravar},
+    {"reproduzir", "Reproduz a gravacao do cenario gravar e confere as telas",
+     4500, PASSOS_REPRODUZIR, sizeof(PASSOS_REPRODUZIR) / sizeof(PASSOS_REPRODUZIR[0]), Verificar_Reproduzir},
+};
+#define NUM_CENARIOS (sizeof(CENARIOS) / sizeof(CENARIOS[0]))
+
+//==============================================================================
+// Programa
+//==============================================================================
+
+int main(int argc, char* argv[])
+{
+    const char* arquivo_eeprom = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc) arquivo_eeprom = argv[++i];
+        else if (strcmp(argv[i], "-v") == 0) s_verboso = true;
+        else
+        {
+            for (size_t c = 0; c < NUM_CENARIOS; c++)
+            {
+                if (strcmp(argv[i], CENARIOS[c].nome) == 0) s_cenario = &CENARIOS[c];
+            }
+        }
+    }
+    if (s_cenario == NULL)
+    {
+        fprintf(stderr, "uso: %s <cenario> [--eeprom arquivo] [-v]\n", argv[0]);
+        for (size_t c = 0; c < NUM_CENARIOS; c++)
+        {
+            fprintf(stderr, "  %-8s %s\n", CENARIOS[c].nome, CENARIOS[c].descricao);
+        }
+        return SAIDA_USO;
+    }
+
+    Reiniciar_Placa();
+    if (arquivo_eeprom != NULL) (void)Carregar_Eeprom(arquivo_eeprom);
+
+    signal(SIGALRM, Ao_Alarme);
+    alarm(TEMPO_REAL_MAX_S);
+    const clock_t inicio = clock();
+
+    if (setjmp(s_fim) == 0)
+    {
+        if (s_cenario->num_passos > 0u)
+        {
+            Sim_Agendar(SIM_FONTE_ROTEIRO, (uint64_t)s_cenario->passos[0].instante_ms * NS_POR_MS,
+                        Roteiro_Avancar);
+        }
+        Sim_Agendar(SIM_FONTE_FIM, (uint64_t)s_cenario->duracao_ms * NS_POR_MS, Encerrar);
+        (void)firmware_main();
+        printf("FALHA: main() do firmware retornou\n");
+        return SAIDA_FALHOU;
+    }
+    alarm(0);
+
+    const double tempo_real_s = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    if (arquivo_eeprom != NULL && !Salvar_Eeprom(arquivo_eeprom))
+    {
+        printf("FALHA: nao foi possivel gravar %s\n", arquivo_eeprom);
+        return SAIDA_FALHOU;
+    }
+    if (s_verboso) printf("---- CLI ----\n%.*s\n-------------\n", (int)s_transcricao_len, s_transcricao);
+    Imprimir_Relatorio(tempo_real_s);
+
+    if (s_codigo_fim != SAIDA_OK) return s_codigo_fim;
+    if (!s_cenario->verificar()) return SAIDA_FALHOU;
+    printf("OK: %s\n", s_cenario->nome);
+    return SAIDA_OK;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static void Reiniciar_Placa(void)
+{
+    Sim_Reiniciar();
+    Sim_Gpio_Reiniciar();
+    Sim_Rtc_Reiniciar();
+    Sim_Adc_Reiniciar();
+    Sim_I2c_Reiniciar();
+    Sim_Dwin_Reiniciar();
+    Sim_Usb_Reiniciar();
+    Sim_Ao_Travar = Ao_Travar;
+    Sim_Dwin_Ao_Receber = Ao_Receber_Dwin;
+    Sim_Usb_Ao_Receber = Ao_Receber_Usb;
+}
+
+static void Roteiro_Avancar(void)
+{
+    const uint32_t agora_ms = Sim_Agora_ms();
+    while (s_proximo_passo < s_cenario->num_passos &&
+           s_cenario->passos[s_proximo_passo].instante_ms <= agora_ms)
+    {
+        s_cenario->passos[s_proximo_passo++].acao();
+    }
+    if (s_proximo_passo < s_cenario->num_passos)
+    {
+        Sim_Agendar(SIM_FONTE_ROTEIRO, (uint64_t)s_cenario->passos[s_proximo_passo].instante_ms * NS_POR_MS,
+                    Roteiro_Avancar);
+    }
+}
+
+static void Encerrar(void)
+{
+    longjmp(s_fim, 1);
+}
+
+static void Ao_Travar(const char* motivo)
+{
+    printf("FALHA: travado em %.3f ms: %s\n", (double)Sim_Agora_ns() / 1e6, motivo);
+    s_codigo_fim = SAIDA_TRAVOU;
+    longjmp(s_fim, 1);
+}
+
+static void Ao_Alarme(int sinal)
+{
+    (void)sinal;
+    static const char msg[] = "FALHA: tempo real esgotado (laco sem chamadas ao HAL?)\n";
+    (void)write(STDOUT_FILENO, msg, sizeof(msg) - 1u);
+    _exit(SAIDA_TRAVOU);
+}
+
+/** @brief Trocas de tela: tempo de boot e latncia desde o ltimo toque. */
+static void Ao_Receber_Dwin(const uint8_t* quadro, uint16_t tamanho)
+{
+    if (tamanho < 10u || quadro[3] != 0x82u || quadro[4] != 0x00u || quadro[5] != 0x84u) return;
+
+    const uint16_t tela = (uint16_t)((quadro[8] << 8) | quadro[9]);
+    if (s_num_telas < MAX_TELAS) s_telas[s_num_telas++] = (Troca_Tela_t){tela, Sim_Agora_ns()};
+    if (tela == PRINCIPAL && s_boot_ns == 0u) s_boot_ns = Sim_Agora_ns();
+    if (tela == s_tela_esperada)
+    {
+        Registrar(&s_latencia_toque, Sim_Agora_ns() - s_toque_ns);
+        s_tela_esperada = 0xFFFFu;
+    }
+}
+
+static void Ao_Receber_Usb(const uint8_t* dados, size_t tamanho)
+{
+    const uint64_t agora = Sim_Agora_ns();
+    if (s_comando_ns != 0u && s_resposta_bytes == 0u)
+    {
+        s_resposta_primeiro_ns = agora;
+        Registrar(&s_latencia_cli, agora - s_comando_ns);
+    }
+    s_resposta_bytes += tamanho;
+    s_resposta_ultimo_ns = agora;
+
+    const size_t livre = TRANSCRICAO_TAMANHO - s_transcricao_len;
+    const size_t n = (tamanho < livre) ? tamanho : livre;
+    memcpy(&s_transcricao[s_transcricao_len], dados, n);
+    s_transcricao_len += n;
+}
+
+static void Enviar_Comando(const char* linha)
+{
+    char buffer[64];
+    const int n = snprintf(buffer, sizeof(buffer), "%s\r\n", linha);
+    s_comando_ns = Sim_Agora_ns();
+    s_resposta_bytes = 0;
+    Sim_Usb_Enviar(buffer, (size_t)n);
+}
+
+/** @brief Soma a resposta do ltimo comando  vazo (o tempo ocupado pela sada). */
+static void Fechar_Resposta(void)
+{
+    if (s_resposta_bytes > 0u && s_resposta_ultimo_ns + CLI_SILENCIO_NS <= Sim_Agora_ns())
+    {
+        s_vazao_bytes += s_resposta_bytes;
+        s_vazao_ns += s_resposta_ultimo_ns - s_resposta_primeiro_ns;
+    }
+    s_comando_ns = 0;
+    s_resposta_bytes = 0;
+}
+
+static void Tocar(uint16_t vp, uint16_t tela_esperada)
+{
+    s_toques++;
+    s_toque_ns = Sim_Agora_ns();
+    s_tela_esperada = tela_esperada;
+    Sim_Dwin_Tocar(vp, 1u);
+}
+
+static void Registrar(Amostras_t* amostras, uint64_t ns)
+{
+    amostras->n++;
+    amostras->soma_ns += ns;
+    if (ns > amostras->max_ns) amostras->max_ns = ns;
+}
+
+static double Media_ms(const Amostras_t* amostras)
+{
+    return (amostras->n == 0u) ? 0.0 : (double)amostras->soma_ns / amostras->n / 1e6;
+}
+
+/** @brief A transcrio da CLI como string (cheia, perde o ltimo byte). */
+static const char* Transcricao(void)
+{
+    s_transcricao[(s_transcricao_len < TRANSCRICAO_TAMANHO) ? s_transcricao_len : TRANSCRICAO_TAMANHO - 1u] = '\0';
+    return s_transcricao;
+}
+
+static bool Carregar_Eeprom(const char* arquivo)
+{
+    FILE* f = fopen(arquivo, "rb");
+    if (f == NULL) return false;
+    const size_t lidos = fread(Sim_Eeprom_Memoria(), 1, SIM_EEPROM_TAMANHO, f);
+    fclose(f);
+    return lidos == SIM_EEPROM_TAMANHO;
+}
+
+static bool Salvar_Eeprom(const char* arquivo)
+{
+    FILE* f = fopen(arquivo, "wb");
+    if (f == NULL) return false;
+    const size_t gravados = fwrite(Sim_Eeprom_Memoria(), 1, SIM_EEPROM_TAMANHO, f);
+    fclose(f);
+    return gravados == SIM_EEPROM_TAMANHO;
+}
+
+static void Imprimir_Relatorio(double tempo_real_s)
+{
+    Sim_Estatisticas_t nucleo;
+    Sim_Dwin_Estatisticas_t dwin;
+    Sim_Eeprom_Estatisticas_t eeprom;
+    Sim_Get_Estatisticas(&nucleo);
+    Sim_Dwin_Get_Estatisticas(&dwin);
+    Sim_Eeprom_Get_Estatisticas(&eeprom);
+
+    const double virtual_s = (double)Sim_Agora_ns() / 1e9;
+    printf("cenario          %s\n", s_cenario->nome);
+    printf("tempo virtual    %.3f s (%.1fx o tempo real)\n", virtual_s,
+           (tempo_real_s > 0.0) ? virtual_s / tempo_real_s : 0.0);
+    printf("cpu              ativa %.1f ms, sleep %.1f ms (%u), stop %.1f ms (%u), systicks %u\n",
+           nucleo.ativo_ns / 1e6, nucleo.sleep_ns / 1e6, (unsigned)nucleo.entradas_sleep,
+           nucleo.stop_ns / 1e6, (unsigned)nucleo.entradas_stop, (unsigned)nucleo.systicks);
+    printf("boot             tela principal em %.1f ms\n", s_boot_ns / 1e6);
+    printf("display tx       %u quadros, %u bytes, linha ocupada %.1f ms\n",
+           (unsigned)dwin.quadros_tx, (unsigned)dwin.bytes_tx, dwin.ocupado_tx_ns / 1e6);
+    printf("display rx       %u quadros, %u bytes perdidos, %u trocas de tela\n",
+           (unsigned)dwin.quadros_rx, (unsigned)dwin.rx_perdidos, (unsigned)Sim_Dwin_Get_Trocas_Tela());
+    printf("toque -> tela    %u amostras, media %.2f ms, max %.2f ms\n",
+           (unsigned)s_latencia_toque.n, Media_ms(&s_latencia_toque), s_latencia_toque.max_ns / 1e6);
+    printf("cli latencia     %u amostras, media %.2f ms, max %.2f ms\n",
+           (unsigned)s_latencia_cli.n, Media_ms(&s_latencia_cli), s_latencia_cli.max_ns / 1e6);
+    printf("cli vazao        %llu bytes em %.1f ms (%.1f kB/s)\n", (unsigned long long)s_vazao_bytes,
+           s_vazao_ns / 1e6, (s_vazao_ns > 0u) ? (double)s_vazao_bytes / (s_vazao_ns / 1e9) / 1000.0 : 0.0);
+    printf("eeprom escrita   %u trechos, %u bytes, media %.2f ms, max %.2f ms, %u NACKs em tWR\n",
+           (unsigned)eeprom.escritas, (unsigned)eeprom.bytes_escritos,
+           (eeprom.escritas > 0u) ? eeprom.escrita_soma_ns / 1e6 / eeprom.escritas : 0.0,
+           eeprom.escrita_max_ns / 1e6, (unsigned)eeprom.nacks_ocupada);
+    printf("eeprom leitura   %u leituras, %u bytes\n", (unsigned)eeprom.leituras, (unsigned)eeprom.bytes_lidos);
+}
@@ -0,0 +1,347 @@
+/*******************************************************************************
+ * @file        sim_rtc.c
+ * @brief       RTC simulado: calendrio e alarme A a partir do tempo virtual.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O calendrio conta subsegundos no clock do prescaler sncrono,
+ * LSI / (PREDIV_A + 1), e continua contando no Stop. Com o LSI de 32 kHz e os
+ * divisores do CubeMX (127/255) o subsegundo dura 4 ms, no 1/256 s: o
+ * "segundo" do RTC leva 1,024 s, como no alvo.
+ *
+ * O alarme compara segundos e subsegundos (com minutos, horas e data
+ * mascarados) ou tambm minutos e horas; sempre ignora a data.
+ ******************************************************************************/
+
+#include "sim.h"
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define NS_POR_S            1000000000ull
+#define SEGUNDOS_POR_DIA    86400u
+#define RTC_SYNCH_REPOUSO_NS 61000u        // Dois ciclos do RTCCLK at o RSF
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint64_t s_base_ns;                  // Instante do ltimo SetTime/SetDate
+static uint64_t s_base_subsegundos;         // Subsegundos desde 01/01/00 00:00:00 nesse instante
+static uint8_t  s_dia_semana_base;          // Dia da semana em 01/01/00 (o firmware escolhe)
+static RTC_HandleTypeDef* s_hrtc_alarme;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint32_t Por_Segundo(void);
+static uint32_t Subsegundos_Hz(void);
+static uint64_t Subsegundos_Agora(void);
+static void     Rebasear(uint64_t subsegundos);
+static uint8_t  Bcd_Para_Byte(uint8_t valor);
+static uint8_t  Byte_Para_Bcd(uint8_t valor);
+static uint8_t  Dias_No_Mes(uint8_t ano, uint8_t mes);
+static void     Dias_Para_Data(uint32_t dias, uint8_t* ano, uint8_t* mes, uint8_t* dia);
+static uint32_t Data_Para_Dias(uint8_t ano, uint8_t mes, uint8_t dia);
+static void     Agendar_Alarme(void);
+static void     Alarme_Vencer(void);
+
+//==============================================================================
+// MSP e callbacks padro
+//==============================================================================
+
+__weak void HAL_RTC_MspInit(RTC_HandleTypeDef* hrtc) { (void)hrtc; }
+__weak void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef* hrtc) { (void)hrtc; }
+
+//==============================================================================
+// HAL
+//==============================================================================
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef* hrtc)
+{
+    SIM_CHAMADA();
+    if (hrtc == NULL) return HAL_ERROR;
+    if (hrtc->State == HAL_RTC_STATE_RESET)
+    {
+        hrtc->Lock = HAL_UNLOCKED;
+        HAL_RTC_MspInit(hrtc);
+    }
+    const uint64_t agora = Subsegundos_Agora();
+    hrtc->Instance->PRER = (hrtc->Init.AsynchPrediv << RTC_PRER_PREDIV_A_Pos) | hrtc->Init.SynchPrediv;
+    MODIFY_REG(hrtc->Instance->CR, RTC_CR_FMT, hrtc->Init.HourFormat);
+    Rebasear(agora);
+    hrtc->State = HAL_RTC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime, uint32_t Format)
+{
+    SIM_CHAMADA();
+    uint8_t horas = sTime->Hours, minutos = sTime->Minutes, segundos = sTime->Seconds;
+    if (Format == RTC_FORMAT_BCD)
+    {
+        horas = Bcd_Para_Byte(horas);
+        minutos = Bcd_Para_Byte(minutos);
+        segundos = Bcd_Para_Byte(segundos);
+    }
+    if (horas > 23u || minutos > 59u || segundos > 59u) return HAL_ERROR;
+
+    // A inicializao zera os prescalers: o novo segundo comea agora.
+    const uint64_t dia = (Subsegundos_Agora() / Por_Segundo()) / SEGUNDOS_POR_DIA;
+    const uint64_t segundos_total = dia * SEGUNDOS_POR_DIA + horas * 3600u + minutos * 60u + segundos;
+    Rebasear(segundos_total * Por_Segundo());
+    Agendar_Alarme();
+    (void)hrtc;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime, uint32_t Format)
+{
+    SIM_CHAMADA();
+    const uint32_t por_segundo = Por_Segundo();
+    const uint64_t agora = Subsegundos_Agora();
+    const uint32_t no_dia = (uint32_t)((agora / por_segundo) % SEGUNDOS_POR_DIA);
+
+    sTime->Hours = (uint8_t)(no_dia / 3600u);
+    sTime->Minutes = (uint8_t)((no_dia / 60u) % 60u);
+    sTime->Seconds = (uint8_t)(no_dia % 60u);
+    sTime->TimeFormat = RTC_HOURFORMAT12_AM;
+    sTime->SecondFraction = por_segundo - 1u;
+    sTime->SubSeconds = (por_segundo - 1u) - (uint32_t)(agora % por_segundo);    // SSR conta para baixo
+    if (Format == RTC_FORMAT_BCD)
+    {
+        sTime->Hours = Byte_Para_Bcd(sTime->Hours);
+        sTime->Minutes = Byte_Para_Bcd(sTime->Minutes);
+        sTime->Seconds = Byte_Para_Bcd(sTime->Seconds);
+    }
+    (void)hrtc;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate, uint32_t Format)
+{
+    SIM_CHAMADA();
+    uint8_t ano = sDate->Year, mes = sDate->Month, dia = sDate->Date;
+    if (Format == RTC_FORMAT_BCD)
+    {
+        ano = Bcd_Para_Byte(ano);
+        mes = Bcd_Para_Byte(mes);
+        dia = Bcd_Para_Byte(dia);
+    }
+    if (ano > 99u || mes < 1u || mes > 12u || dia < 1u || dia > 31u) return HAL_ERROR;
+
+    const uint32_t por_segundo = Por_Segundo();
+    const uint64_t agora = Subsegundos_Agora();
+    const uint64_t no_dia = agora % ((uint64_t)SEGUNDOS_POR_DIA * por_segundo);
+    const uint32_t dias = Data_Para_Dias(ano, mes, dia);
+    Rebasear((uint64_t)dias * SEGUNDOS_POR_DIA * por_segundo + no_dia);
+    s_dia_semana_base = (uint8_t)((sDate->WeekDay + 6u - (dias % 7u)) % 7u + 1u);
+
+    // INITS: o ano do calendrio deixou de ser 0.
+    if (ano != 0u) SET_BIT(hrtc->Instance->ICSR, RTC_ICSR_INITS);
+    else           CLEAR_BIT(hrtc->Instance->ICSR, RTC_ICSR_INITS);
+    Agendar_Alarme();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(const RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate, uint32_t Format)
+{
+    SIM_CHAMADA();
+    const uint32_t dias = (uint32_t)((Subsegundos_Agora() / Por_Segundo()) / SEGUNDOS_POR_DIA);
+    Dias_Para_Data(dias, &sDate->Year, &sDate->Month, &sDate->Date);
+    sDate->WeekDay = (uint8_t)((s_dia_semana_base - 1u + dias) % 7u + 1u);
+    if (Format == RTC_FORMAT_BCD)
+    {
+        sDate->Year = Byte_Para_Bcd(sDate->Year);
+        sDate->Month = Byte_Para_Bcd(sDate->Month);
+        sDate->Date = Byte_Para_Bcd(sDate->Date);
+    }
+    (void)hrtc;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetAlarm_IT(RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* sAlarm, uint32_t Format)
+{
+    SIM_CHAMADA();
+    if (sAlarm->Alarm != RTC_ALARM_A) return HAL_ERROR;
+
+    uint8_t horas = sAlarm->AlarmTime.Hours, minutos = sAlarm->AlarmTime.Minutes;
+    uint8_t segundos = sAlarm->AlarmTime.Seconds;
+    if (Format == RTC_FORMAT_BCD)
+    {
+        horas = Bcd_Para_Byte(horas);
+        minutos = Bcd_Para_Byte(minutos);
+        segundos = Bcd_Para_Byte(segundos);
+    }
+
+    CLEAR_BIT(hrtc->Instance->CR, RTC_CR_ALRAE | RTC_CR_ALRAIE);
+    hrtc->Instance->ALRMAR = sAlarm->AlarmMask |
+                             ((uint32_t)Byte_Para_Bcd(horas) << RTC_ALRMAR_HU_Pos) |
+                             ((uint32_t)Byte_Para_Bcd(minutos) << RTC_ALRMAR_MNU_Pos) |
+                             ((uint32_t)Byte_Para_Bcd(segundos) << RTC_ALRMAR_SU_Pos);
+    hrtc->Instance->ALRMASSR = sAlarm->AlarmSubSecondMask | sAlarm->AlarmTime.SubSeconds;
+    CLEAR_BIT(hrtc->Instance->SR, RTC_SR_ALRAF);
+    SET_BIT(hrtc->Instance->CR, RTC_CR_ALRAE | RTC_CR_ALRAIE);
+
+    s_hrtc_alarme = hrtc;
+    Agendar_Alarme();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_DeactivateAlarm(RTC_HandleTypeDef* hrtc, uint32_t Alarm)
+{
+    SIM_CHAMADA();
+    if (Alarm != RTC_ALARM_A) return HAL_ERROR;
+    CLEAR_BIT(hrtc->Instance->CR, RTC_CR_ALRAE | RTC_CR_ALRAIE);
+    Sim_Cancelar(SIM_FONTE_RTC);
+    return HAL_OK;
+}
+
+void HAL_RTC_AlarmIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+    if (READ_BIT(hrtc->Instance->SR, RTC_SR_ALRAF) && READ_BIT(hrtc->Instance->CR, RTC_CR_ALRAIE))
+    {
+        CLEAR_BIT(hrtc->Instance->SR, RTC_SR_ALRAF);
+        HAL_RTC_AlarmAEventCallback(hrtc);
+    }
+    hrtc->State = HAL_RTC_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_RTC_WaitForSynchro(RTC_HandleTypeDef* hrtc)
+{
+    SIM_CHAMADA();
+    Sim_Consumir_ns(RTC_SYNCH_REPOUSO_NS);
+    SET_BIT(hrtc->Instance->ICSR, RTC_ICSR_RSF);
+    return HAL_OK;
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_Rtc_Reiniciar(void)
+{
+    memset(&Sim_RTC, 0, sizeof(Sim_RTC));
+    Sim_RTC.PRER = (127u << RTC_PRER_PREDIV_A_Pos) | 255u;     // Valores de reset
+    s_base_ns = Sim_Agora_ns();
+    s_base_subsegundos = 0;
+    s_dia_semana_base = RTC_WEEKDAY_MONDAY;
+    s_hrtc_alarme = NULL;
+    Sim_Cancelar(SIM_FONTE_RTC);
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static uint32_t Por_Segundo(void)
+{
+    return (Sim_RTC.PRER & RTC_PRER_PREDIV_S) + 1u;
+}
+
+/** @brief Frequncia do subsegundo: LSI / (PREDIV_A + 1). */
+static uint32_t Subsegundos_Hz(void)
+{
+    return LSI_VALUE / (((Sim_RTC.PRER & RTC_PRER_PREDIV_A) >> RTC_PRER_PREDIV_A_Pos) + 1u);
+}
+
+static uint64_t Subsegundos_Agora(void)
+{
+    return s_base_subsegundos + ((Sim_Agora_ns() - s_base_ns) * Subsegundos_Hz()) / NS_POR_S;
+}
+
+static void Rebasear(uint64_t subsegundos)
+{
+    s_base_ns = Sim_Agora_ns();
+    s_base_subsegundos = subsegundos;
+}
+
+static uint8_t Bcd_Para_Byte(uint8_t valor)
+{
+    return (uint8_t)((valor >> 4) * 10u + (valor & 0x0Fu));
+}
+
+static uint8_t Byte_Para_Bcd(uint8_t valor)
+{
+    return (uint8_t)(((valor / 10u) << 4) | (valor % 10u));
+}
+
+static uint8_t Dias_No_Mes(uint8_t ano, uint8_t mes)
+{
+    static const uint8_t DIAS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (uint8_t)(DIAS[mes - 1u] + ((mes == 2u && (ano % 4u) == 0u) ? 1u : 0u));
+}
+
+static uint32_t Data_Para_Dias(uint8_t ano, uint8_t mes, uint8_t dia)
+{
+    uint32_t dias = 0;
+    for (uint8_t a = 0; a < ano; a++) dias += ((a % 4u) == 0u) ? 366u : 365u;
+    for (uint8_t m = 1; m < mes; m++) dias += Dias_No_Mes(ano, m);
+    return dias + dia - 1u;
+}
+
+static void Dias_Para_Data(uint32_t dias, uint8_t* ano, uint8_t* mes, uint8_t* dia)
+{
+    uint8_t a = 0;
+    while (dias >= (((a % 4u) == 0u) ? 366u : 365u))
+    {
+        dias -= ((a % 4u) == 0u) ? 366u : 365u;
+        a = (uint8_t)((a + 1u) % 100u);
+    }
+    uint8_t m = 1;
+    while (dias >= Dias_No_Mes(a, m))
+    {
+        dias -= Dias_No_Mes(a, m);
+        m++;
+    }
+    *ano = a;
+    *mes = m;
+    *dia = (uint8_t)(dias + 1u);
+}
+
+/**
+ * @brief Prximo instante em que o calendrio casa com o ALRMAR/ALRMASSR. O
+ * ciclo de repetio  dado pelo campo mais alto que no est mascarado.
+ */
+static void Agendar_Alarme(void)
+{
+    Sim_Cancelar(SIM_FONTE_RTC);
+    if (s_hrtc_alarme == NULL || !READ_BIT(Sim_RTC.CR, RTC_CR_ALRAE)) return;
+
+    const uint32_t alrmar = Sim_RTC.ALRMAR;
+    const uint32_t por_segundo = Por_Segundo();
+    const uint32_t horas = Bcd_Para_Byte((uint8_t)((alrmar & (RTC_ALRMAR_HT | RTC_ALRMAR_HU)) >> RTC_ALRMAR_HU_Pos));
+    const uint32_t minutos = Bcd_Para_Byte((uint8_t)((alrmar & (RTC_ALRMAR_MNT | RTC_ALRMAR_MNU)) >> RTC_ALRMAR_MNU_Pos));
+    const uint32_t segundos = Bcd_Para_Byte((uint8_t)((alrmar & (RTC_ALRMAR_ST | RTC_ALRMAR_SU)) >> RTC_ALRMAR_SU_Pos));
+    const bool compara_ss = (Sim_RTC.ALRMASSR & RTC_ALRMASSR_MASKSS) != 0u;
+    const uint32_t ss = Sim_RTC.ALRMASSR & RTC_ALRMASSR_SS;
+
+    uint64_t ciclo_s;
+    uint64_t alvo_s;
+    if ((alrmar & RTC_ALRMAR_MSK1) != 0u)      { ciclo_s = 1u;     alvo_s = 0u; }
+    else if ((alrmar & RTC_ALRMAR_MSK2) != 0u) { ciclo_s = 60u;    alvo_s = segundos; }
+    else if ((alrmar & RTC_ALRMAR_MSK3) != 0u) { ciclo_s = 3600u;  alvo_s = minutos * 60u + segundos; }
+    else                                       { ciclo_s = SEGUNDOS_POR_DIA; alvo_s = horas * 3600u + minutos * 60u + segundos; }
+
+    // Sem comparar o SS, o alarme vem no incio do segundo (SSR = PREDIV_S).
+    const uint64_t ciclo = ciclo_s * por_segundo;
+    const uint64_t alvo = alvo_s * por_segundo + (compara_ss ? ((por_segundo - 1u) - (ss % por_segundo)) : 0u);
+    const uint64_t agora = Subsegundos_Agora();
+    uint64_t proximo = agora - (agora % ciclo) + alvo;
+    if (proximo <= agora) proximo += ciclo;
+
+    const uint64_t f = Subsegundos_Hz();
+    const uint64_t delta_ns = ((proximo - s_base_subsegundos) * NS_POR_S + f - 1u) / f;
+    Sim_Agendar(SIM_FONTE_RTC, s_base_ns + delta_ns, Alarme_Vencer);
+}
+
+static void Alarme_Vencer(void)
+{
+    if (s_hrtc_alarme == NULL || !READ_BIT(Sim_RTC.CR, RTC_CR_ALRAE)) return;
+
+    SET_BIT(Sim_RTC.SR, RTC_SR_ALRAF);
+    if (READ_BIT(Sim_RTC.CR, RTC_CR_ALRAIE)) Sim_Pendurar_Irq(RTC_IRQn);
+    Agendar_Alarme();
+}
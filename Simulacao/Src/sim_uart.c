@@ -0,0 +1,691 @@
+/*******************************************************************************
+ * @file        sim_uart.c
+ * @brief       USART2 com DMA e o display DWIN ligado a ela.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     A USART reproduz o HAL do alvo byte a byte: o DMA de TX move um
+ * byte a cada tempo de caractere (HT/TC no DMA, TC da USART no fim do ltimo
+ * stop bit) e a recepo "at IDLE" em modo NORMAL grava no buffer, gera HT na
+ * metade, TC no fim do buffer e IDLE um caractere depois do ltimo byte. Bytes
+ * que chegam sem recepo armada ficam no RDR (o segundo d overrun) e o
+ * AbortReceive descarta o RDR, como no hardware.
+ *
+ * O display interpreta os quadros 5A A5 de escrita (0x82) e leitura (0x83) de
+ * VPs, troca de tela pelo VP 0x0084 e responde s leituras depois de
+ * DWIN_RESPOSTA_NS. S escuta com a alimentao ligada (DISPLAY_PWR_CTRL em
+ * nvel baixo) e depois do boot; fora dos 115200 bps 3% nenhum lado entende
+ * o outro e a USART marca erro de quadro.
+ ******************************************************************************/
+
+#include "sim.h"
+#include "main.h"
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define DWIN_BAUD               115200u
+#define DWIN_TOLERANCIA_PCT     3u
+#define DWIN_BITS_POR_BYTE      10u         // 8N1
+#define DWIN_BOOT_NS            350000000ull
+#define DWIN_RESPOSTA_NS        1000000ull
+#define DWIN_CAB_1              0x5Au
+#define DWIN_CAB_2              0xA5u
+#define DWIN_CMD_ESCRITA        0x82u
+#define DWIN_CMD_LEITURA        0x83u
+#define DWIN_VP_TROCA_TELA      0x0084u
+#define DWIN_VP_PIC_NOW         0x0014u
+#define DWIN_QUADRO_MAX         (3u + 255u)
+#define DWIN_TEXTO_MAX          128u
+#define FILA_RX_QUADROS         16u
+
+#define USART_ERROS             (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE | USART_ISR_ORE)
+
+typedef struct {
+    uint64_t inicio_ns;                 // Instante em que o display comea a enviar
+    uint16_t tamanho;
+    uint8_t  dados[DWIN_QUADRO_MAX];
+} Quadro_Rx_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+// Lado do microcontrolador
+static UART_HandleTypeDef* s_huart = NULL;
+static uint16_t s_tx_pos = 0;
+static uint64_t s_tx_inicio_ns = 0;
+static bool     s_rdr_cheio = false;
+static uint8_t  s_rdr = 0;
+static bool     s_rx_desde_idle = false;
+
+// Display
+static uint16_t s_vps[SIM_DWIN_NUM_VPS];
+static bool     s_dwin_ligado = true;
+static uint64_t s_dwin_pronto_ns = DWIN_BOOT_NS;
+static uint8_t  s_quadro[DWIN_QUADRO_MAX];
+static uint16_t s_quadro_pos = 0;
+static uint32_t s_trocas_tela = 0;
+static Sim_Dwin_Estatisticas_t s_estatisticas;
+static char     s_texto[DWIN_TEXTO_MAX + 1u];
+
+// Linha display -> microcontrolador
+static Quadro_Rx_t s_fila_rx[FILA_RX_QUADROS];
+static uint32_t s_fila_inicio = 0;
+static uint32_t s_fila_qtd = 0;
+static uint16_t s_rx_pos = 0;
+
+void (*Sim_Dwin_Ao_Receber)(const uint8_t* quadro, uint16_t tamanho) = NULL;
+
+const uint16_t UARTPrescTable[12] = {1U, 2U, 4U, 6U, 8U, 10U, 12U, 16U, 32U, 64U, 128U, 256U};
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static uint64_t Ns_Por_Byte_Mcu(void);
+static uint64_t Ns_Por_Byte_Dwin(void);
+static bool     Baud_Confere(void);
+static bool     Dwin_Ativo(void);
+static void     Aplicar_Icr(void);
+static void     Avaliar_Irq(void);
+static void     Encerrar_Recepcao(UART_HandleTypeDef* huart);
+static void     Tx_Dma_Mover(UART_HandleTypeDef* huart);
+static void     Tx_Byte_Enviado(void);
+static void     Rx_Byte_Chegou(void);
+static void     Rx_Linha_Ociosa(void);
+static void     Rx_Entregar(uint8_t byte);
+static void     Rx_Agendar_Proximo(void);
+static void     Dma_Tx_Cplt(DMA_HandleTypeDef* hdma);
+static void     Dma_Tx_Meio(DMA_HandleTypeDef* hdma);
+static void     Dma_Rx_Cplt(DMA_HandleTypeDef* hdma);
+static void     Dma_Rx_Meio(DMA_HandleTypeDef* hdma);
+static void     Dwin_Receber_Byte(uint8_t byte);
+static void     Dwin_Processar_Quadro(void);
+static void     Dwin_Enfileirar(const uint8_t* quadro, uint16_t tamanho, uint64_t atraso_ns);
+
+//==============================================================================
+// Callbacks padro
+//==============================================================================
+
+__weak void HAL_UART_MspInit(UART_HandleTypeDef* huart) { (void)huart; }
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) { (void)huart; }
+__weak void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef* huart) { (void)huart; }
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) { (void)huart; }
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t Size) { (void)huart; (void)Size; }
+
+//==============================================================================
+// HAL
+//==============================================================================
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart)
+{
+    SIM_CHAMADA();
+    if (huart == NULL || huart->Instance != USART2) return HAL_ERROR;
+
+    if (huart->gState == HAL_UART_STATE_RESET)
+    {
+        huart->Lock = HAL_UNLOCKED;
+        HAL_UART_MspInit(huart);
+    }
+    s_huart = huart;
+    USART2->CR1 = 0U;
+    USART2->PRESC = huart->Init.ClockPrescaler;
+    USART2->BRR = (uint16_t)UART_DIV_SAMPLING16(Sim_Pclk_Hz(), huart->Init.BaudRate, huart->Init.ClockPrescaler);
+    USART2->ISR = USART_ISR_TXE_TXFNF | USART_ISR_TC;
+    USART2->CR1 = huart->Init.Mode | USART_CR1_UE;
+    s_rdr_cheio = false;
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->RxEventType = HAL_UART_RXEVENT_TC;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetTxFifoThreshold(UART_HandleTypeDef* huart, uint32_t TxFifoThreshold)
+{
+    SIM_CHAMADA();
+    (void)huart;
+    (void)TxFifoThreshold;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetRxFifoThreshold(UART_HandleTypeDef* huart, uint32_t RxFifoThreshold)
+{
+    SIM_CHAMADA();
+    (void)huart;
+    (void)RxFifoThreshold;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_DisableFifoMode(UART_HandleTypeDef* huart)
+{
+    SIM_CHAMADA();
+    huart->FifoMode = UART_FIFOMODE_DISABLE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size)
+{
+    SIM_CHAMADA();
+    if (huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (pData == NULL || Size == 0U) return HAL_ERROR;
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    DMA_HandleTypeDef* dma = huart->hdmatx;
+    dma->XferCpltCallback = Dma_Tx_Cplt;
+    dma->XferHalfCpltCallback = Dma_Tx_Meio;
+    dma->XferErrorCallback = NULL;
+    dma->Instance->CNDTR = Size;
+    dma->Instance->CCR |= DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN;
+    dma->State = HAL_DMA_STATE_BUSY;
+
+    USART2->ISR &= ~USART_ISR_TC;
+    USART2->CR3 |= USART_CR3_DMAT;
+
+    // O primeiro byte vai direto para o registrador de deslocamento e o
+    // segundo para o TDR: o DMA j moveu at dois bytes
+    Tx_Dma_Mover(huart);
+    if (Size > 1U) Tx_Dma_Mover(huart);
+
+    s_tx_pos = 0;
+    s_tx_inicio_ns = Sim_Agora_ns();
+    Sim_Agendar(SIM_FONTE_UART_TX, s_tx_inicio_ns + Ns_Por_Byte_Mcu(), Tx_Byte_Enviado);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size)
+{
+    SIM_CHAMADA();
+    if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (pData == NULL || Size == 0U) return HAL_ERROR;
+
+    Aplicar_Icr();
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    huart->RxEventType = HAL_UART_RXEVENT_TC;
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    DMA_HandleTypeDef* dma = huart->hdmarx;
+    dma->XferCpltCallback = Dma_Rx_Cplt;
+    dma->XferHalfCpltCallback = Dma_Rx_Meio;
+    dma->XferErrorCallback = NULL;
+    dma->Instance->CNDTR = Size;
+    dma->Instance->CCR |= DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN;
+    dma->State = HAL_DMA_STATE_BUSY;
+
+    USART2->ISR &= ~USART_ISR_IDLE;
+    USART2->CR3 |= USART_CR3_EIE | USART_CR3_DMAR;
+    USART2->CR1 |= USART_CR1_IDLEIE;
+
+    // Um byte esperando no RDR  o primeiro que o DMA transfere
+    if (s_rdr_cheio)
+    {
+        s_rdr_cheio = false;
+        Rx_Entregar(s_rdr);
+    }
+    Avaliar_Irq();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart)
+{
+    SIM_CHAMADA();
+    Encerrar_Recepcao(huart);
+    DMA1->ISR &= ~(0xFu << huart->hdmarx->ChannelIndex);
+    USART2->ISR &= ~(USART_ERROS | USART_ISR_IDLE);
+    if (s_rdr_cheio)
+    {
+        s_rdr_cheio = false;                // Pedido de descarte do RDR
+        s_estatisticas.rx_perdidos++;
+    }
+    huart->RxXferCount = 0U;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart)
+{
+    Aplicar_Icr();
+    const uint32_t isr = USART2->ISR;
+    const uint32_t cr1 = USART2->CR1;
+    const uint32_t cr3 = USART2->CR3;
+
+    // Com a recepo por DMA, qualquer erro encerra a transferncia
+    if ((isr & USART_ERROS) && (cr3 & USART_CR3_EIE))
+    {
+        if (isr & USART_ISR_PE)  huart->ErrorCode |= HAL_UART_ERROR_PE;
+        if (isr & USART_ISR_FE)  huart->ErrorCode |= HAL_UART_ERROR_FE;
+        if (isr & USART_ISR_NE)  huart->ErrorCode |= HAL_UART_ERROR_NE;
+        if (isr & USART_ISR_ORE) huart->ErrorCode |= HAL_UART_ERROR_ORE;
+        USART2->ISR &= ~USART_ERROS;
+        Encerrar_Recepcao(huart);
+        HAL_UART_ErrorCallback(huart);
+        return;
+    }
+
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE && (isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE))
+    {
+        USART2->ISR &= ~USART_ISR_IDLE;
+        const uint16_t restante = (uint16_t)huart->hdmarx->Instance->CNDTR;
+        if (restante > 0U && restante < huart->RxXferSize)
+        {
+            huart->RxXferCount = restante;
+            Encerrar_Recepcao(huart);
+            huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+            HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - restante));
+        }
+        return;
+    }
+
+    if ((isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE))
+    {
+        USART2->CR1 &= ~USART_CR1_TCIE;
+        huart->gState = HAL_UART_STATE_READY;
+        HAL_UART_TxCpltCallback(huart);
+    }
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_Dwin_Reiniciar(void)
+{
+    s_huart = NULL;
+    s_tx_pos = 0;
+    s_rdr_cheio = false;
+    s_rx_desde_idle = false;
+    memset(&Sim_USART2, 0, sizeof(Sim_USART2));
+
+    memset(s_vps, 0, sizeof(s_vps));
+    s_dwin_ligado = true;
+    s_dwin_pronto_ns = Sim_Agora_ns() + DWIN_BOOT_NS;
+    s_quadro_pos = 0;
+    s_trocas_tela = 0;
+    memset(&s_estatisticas, 0, sizeof(s_estatisticas));
+
+    s_fila_inicio = 0;
+    s_fila_qtd = 0;
+    s_rx_pos = 0;
+    Sim_Dwin_Ao_Receber = NULL;
+}
+
+void Sim_Dwin_Alimentacao(bool ligado)
+{
+    if (ligado == s_dwin_ligado) return;
+    s_dwin_ligado = ligado;
+    if (ligado)
+    {
+        s_dwin_pronto_ns = Sim_Agora_ns() + DWIN_BOOT_NS;
+        return;
+    }
+    // Sem alimentao o display perde a RAM de VPs e para de transmitir
+    memset(s_vps, 0, sizeof(s_vps));
+    s_quadro_pos = 0;
+    s_fila_qtd = 0;
+    s_rx_pos = 0;
+}
+
+void Sim_Dwin_Enviar(const uint8_t* quadro, uint16_t tamanho)
+{
+    Dwin_Enfileirar(quadro, tamanho, 0u);
+}
+
+void Sim_Dwin_Tocar(uint16_t vp, uint16_t valor)
+{
+    if (!Dwin_Ativo()) return;
+
+    // A linha SINAL_DISPLAY pulsa no toque (acorda o ncleo do Stop)
+    Sim_Gpio_Definir(SINAL_DISPLAY_GPIO_Port, SINAL_DISPLAY_Pin, true);
+    Sim_Gpio_Definir(SINAL_DISPLAY_GPIO_Port, SINAL_DISPLAY_Pin, false);
+
+    const uint8_t quadro[] = {DWIN_CAB_1, DWIN_CAB_2, 0x06, DWIN_CMD_LEITURA,
+                              (uint8_t)(vp >> 8), (uint8_t)vp, 0x01,
+                              (uint8_t)(valor >> 8), (uint8_t)valor};
+    Dwin_Enfileirar(quadro, sizeof(quadro), DWIN_RESPOSTA_NS);
+}
+
+uint16_t Sim_Dwin_Get_Tela(void)
+{
+    return s_vps[DWIN_VP_PIC_NOW];
+}
+
+uint16_t Sim_Dwin_Get_Vp(uint16_t vp)
+{
+    return s_vps[vp];
+}
+
+const char* Sim_Dwin_Get_Texto(uint16_t vp)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; n < DWIN_TEXTO_MAX; i++)
+    {
+        const uint16_t palavra = s_vps[(uint16_t)(vp + i)];
+        const uint8_t alto = (uint8_t)(palavra >> 8);
+        const uint8_t baixo = (uint8_t)palavra;
+        if (alto == 0x00u || alto == 0xFFu) break;
+        s_texto[n++] = (char)alto;
+        if (baixo == 0x00u || baixo == 0xFFu || n >= DWIN_TEXTO_MAX) break;
+        s_texto[n++] = (char)baixo;
+    }
+    s_texto[n] = '\0';
+    return s_texto;
+}
+
+uint32_t Sim_Dwin_Get_Trocas_Tela(void)
+{
+    return s_trocas_tela;
+}
+
+void Sim_Dwin_Get_Estatisticas(Sim_Dwin_Estatisticas_t* estatisticas_out)
+{
+    *estatisticas_out = s_estatisticas;
+}
+
+//==============================================================================
+// Implementao das Funes Privadas: USART
+//==============================================================================
+
+static uint64_t Ns_Por_Byte_Mcu(void)
+{
+    const uint64_t brr = (USART2->BRR != 0U) ? USART2->BRR : 1u;
+    const uint64_t pclk = UARTPrescTable[USART2->PRESC & 0xFu] != 0U ?
+                          Sim_Pclk_Hz() / UARTPrescTable[USART2->PRESC & 0xFu] : Sim_Pclk_Hz();
+    return (DWIN_BITS_POR_BYTE * 1000000000ull * brr) / pclk;
+}
+
+static uint64_t Ns_Por_Byte_Dwin(void)
+{
+    return (DWIN_BITS_POR_BYTE * 1000000000ull) / DWIN_BAUD;
+}
+
+/** @brief A taxa real da USART (clock atual / BRR) est dentro da tolerncia do display? */
+static bool Baud_Confere(void)
+{
+    const uint64_t ns_mcu = Ns_Por_Byte_Mcu();
+    const uint64_t ns_dwin = Ns_Por_Byte_Dwin();
+    const uint64_t diferenca = (ns_mcu > ns_dwin) ? (ns_mcu - ns_dwin) : (ns_dwin - ns_mcu);
+    return (diferenca * 100u) <= (ns_dwin * DWIN_TOLERANCIA_PCT);
+}
+
+static bool Dwin_Ativo(void)
+{
+    return s_dwin_ligado && Sim_Agora_ns() >= s_dwin_pronto_ns;
+}
+
+/** @brief Escritas no ICR limpam os flags correspondentes do ISR. */
+static void Aplicar_Icr(void)
+{
+    USART2->ISR &= ~USART2->ICR;
+    USART2->ICR = 0U;
+}
+
+static void Avaliar_Irq(void)
+{
+    const uint32_t isr = USART2->ISR;
+    const uint32_t cr1 = USART2->CR1;
+    const bool idle = (isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE);
+    const bool tc = (isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE);
+    const bool erro = (isr & USART_ERROS) && (USART2->CR3 & USART_CR3_EIE);
+    if (idle || tc || erro) Sim_Pendurar_Irq(USART2_IRQn);
+}
+
+/** @brief Fim da recepo em modo NORMAL: DMA parado, IDLE e erros desabilitados. */
+static void Encerrar_Recepcao(UART_HandleTypeDef* huart)
+{
+    USART2->CR1 &= ~(USART_CR1_IDLEIE | USART_CR1_PEIE | USART_CR1_RXNEIE_RXFNEIE);
+    USART2->CR3 &= ~(USART_CR3_EIE | USART_CR3_DMAR);
+    huart->hdmarx->Instance->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE | DMA_CCR_EN);
+    huart->hdmarx->State = HAL_DMA_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+}
+
+/** @brief O DMA de TX copia mais um byte para o TDR. */
+static void Tx_Dma_Mover(UART_HandleTypeDef* huart)
+{
+    DMA_Channel_TypeDef* canal = huart->hdmatx->Instance;
+    if (canal->CNDTR == 0U) return;
+
+    canal->CNDTR--;
+    if (canal->CNDTR == huart->TxXferSize / 2U) Sim_Dma_Sinalizar(huart->hdmatx, DMA_ISR_HTIF1);
+    if (canal->CNDTR == 0U)                     Sim_Dma_Sinalizar(huart->hdmatx, DMA_ISR_TCIF1);
+}
+
+/** @brief Fim do stop bit de um byte: o display o recebe e o DMA repe o TDR. */
+static void Tx_Byte_Enviado(void)
+{
+    if (s_huart == NULL) return;
+
+    const uint8_t byte = s_huart->pTxBuffPtr[s_tx_pos++];
+    s_estatisticas.bytes_tx++;
+    if (Dwin_Ativo() && Baud_Confere()) Dwin_Receber_Byte(byte);
+
+    Tx_Dma_Mover(s_huart);
+    if (s_tx_pos < s_huart->TxXferSize)
+    {
+        Sim_Agendar(SIM_FONTE_UART_TX, Sim_Agora_ns() + Ns_Por_Byte_Mcu(), Tx_Byte_Enviado);
+        return;
+    }
+    s_estatisticas.ocupado_tx_ns += Sim_Agora_ns() - s_tx_inicio_ns;
+    USART2->ISR |= USART_ISR_TC;
+    Avaliar_Irq();
+}
+
+/** @brief Um byte do display chega ao RDR (ou direto ao buffer pelo DMA). */
+static void Rx_Entregar(uint8_t byte)
+{
+    const bool habilitada = (USART2->CR1 & (USART_CR1_UE | USART_CR1_RE)) == (USART_CR1_UE | USART_CR1_RE);
+    if (s_huart == NULL || !habilitada || Sim_Em_Stop())
+    {
+        s_estatisticas.rx_perdidos++;
+        return;
+    }
+    s_rx_desde_idle = true;
+    if (!Baud_Confere())
+    {
+        USART2->ISR |= USART_ISR_FE;
+        s_estatisticas.rx_perdidos++;
+        Avaliar_Irq();
+        return;
+    }
+
+    DMA_HandleTypeDef* dma = s_huart->hdmarx;
+    DMA_Channel_TypeDef* canal = dma->Instance;
+    if ((USART2->CR3 & USART_CR3_DMAR) && (canal->CCR & DMA_CCR_EN) && canal->CNDTR > 0U)
+    {
+        s_huart->pRxBuffPtr[s_huart->RxXferSize - canal->CNDTR] = byte;
+        canal->CNDTR--;
+        if (canal->CNDTR == s_huart->RxXferSize / 2U) Sim_Dma_Sinalizar(dma, DMA_ISR_HTIF1);
+        if (canal->CNDTR == 0U)                       Sim_Dma_Sinalizar(dma, DMA_ISR_TCIF1);
+        return;
+    }
+
+    if (s_rdr_cheio)
+    {
+        USART2->ISR |= USART_ISR_ORE;
+        s_estatisticas.rx_perdidos++;
+        Avaliar_Irq();
+        return;
+    }
+    s_rdr = byte;
+    s_rdr_cheio = true;
+}
+
+static void Rx_Byte_Chegou(void)
+{
+    if (s_fila_qtd == 0u) return;
+
+    Quadro_Rx_t* quadro = &s_fila_rx[s_fila_inicio];
+    Rx_Entregar(quadro->dados[s_rx_pos++]);
+    if (s_rx_pos >= quadro->tamanho)
+    {
+        s_estatisticas.quadros_rx++;
+        s_rx_pos = 0;
+        s_fila_inicio = (s_fila_inicio + 1u) % FILA_RX_QUADROS;
+        s_fila_qtd--;
+    }
+
+    // Bytes em sequncia no deixam a linha ociosa; um intervalo gera IDLE
+    const uint64_t agora = Sim_Agora_ns();
+    if (s_fila_qtd > 0u && (s_rx_pos > 0u || s_fila_rx[s_fila_inicio].inicio_ns <= agora))
+    {
+        Sim_Agendar(SIM_FONTE_UART_RX, agora + Ns_Por_Byte_Dwin(), Rx_Byte_Chegou);
+    }
+    else
+    {
+        Sim_Agendar(SIM_FONTE_UART_RX, agora + Ns_Por_Byte_Dwin(), Rx_Linha_Ociosa);
+    }
+}
+
+static void Rx_Linha_Ociosa(void)
+{
+    if (s_rx_desde_idle && (USART2->CR1 & USART_CR1_UE))
+    {
+        s_rx_desde_idle = false;
+        USART2->ISR |= USART_ISR_IDLE;
+        Avaliar_Irq();
+    }
+    Rx_Agendar_Proximo();
+}
+
+static void Rx_Agendar_Proximo(void)
+{
+    if (s_fila_qtd == 0u || Sim_Agendado(SIM_FONTE_UART_RX)) return;
+
+    const uint64_t agora = Sim_Agora_ns();
+    const uint64_t inicio = s_fila_rx[s_fila_inicio].inicio_ns;
+    Sim_Agendar(SIM_FONTE_UART_RX, ((inicio > agora) ? inicio : agora) + Ns_Por_Byte_Dwin(), Rx_Byte_Chegou);
+}
+
+//==============================================================================
+// Implementao das Funes Privadas: callbacks do DMA (como no HAL)
+//==============================================================================
+
+static void Dma_Tx_Cplt(DMA_HandleTypeDef* hdma)
+{
+    UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+    huart->TxXferCount = 0U;
+    USART2->CR3 &= ~USART_CR3_DMAT;
+    USART2->CR1 |= USART_CR1_TCIE;          // TxCplt s no fim do ltimo stop bit
+    Avaliar_Irq();
+}
+
+static void Dma_Tx_Meio(DMA_HandleTypeDef* hdma)
+{
+    HAL_UART_TxHalfCpltCallback((UART_HandleTypeDef*)hdma->Parent);
+}
+
+static void Dma_Rx_Cplt(DMA_HandleTypeDef* hdma)
+{
+    UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+    const bool ate_idle = (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE);
+    huart->RxXferCount = 0U;
+    Encerrar_Recepcao(huart);
+    huart->RxEventType = HAL_UART_RXEVENT_TC;
+    if (ate_idle) HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+}
+
+static void Dma_Rx_Meio(DMA_HandleTypeDef* hdma)
+{
+    UART_HandleTypeDef* huart = (UART_HandleTypeDef*)hdma->Parent;
+    huart->RxEventType = HAL_UART_RXEVENT_HT;
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize / 2U));
+    }
+}
+
+//==============================================================================
+// Implementao das Funes Privadas: display
+//==============================================================================
+
+static void Dwin_Receber_Byte(uint8_t byte)
+{
+    if (s_quadro_pos == 0u && byte != DWIN_CAB_1) return;
+    if (s_quadro_pos == 1u && byte != DWIN_CAB_2)
+    {
+        s_quadro_pos = (byte == DWIN_CAB_1) ? 1u : 0u;
+        return;
+    }
+    s_quadro[s_quadro_pos++] = byte;
+    if (s_quadro_pos >= 3u && s_quadro_pos == 3u + s_quadro[2])
+    {
+        Dwin_Processar_Quadro();
+        s_quadro_pos = 0;
+    }
+}
+
+static void Dwin_Processar_Quadro(void)
+{
+    const uint16_t tamanho = s_quadro_pos;
+    s_estatisticas.quadros_tx++;
+    if (Sim_Dwin_Ao_Receber != NULL) Sim_Dwin_Ao_Receber(s_quadro, tamanho);
+    if (tamanho < 6u) return;
+
+    const uint8_t comando = s_quadro[3];
+    const uint16_t vp = (uint16_t)((s_quadro[4] << 8) | s_quadro[5]);
+    const uint8_t* dados = &s_quadro[6];
+    const uint16_t n = (uint16_t)(tamanho - 6u);
+
+    if (comando == DWIN_CMD_ESCRITA)
+    {
+        if (vp == DWIN_VP_TROCA_TELA && n >= 4u && dados[0] == 0x5Au && dados[1] == 0x01u)
+        {
+            const uint16_t tela = (uint16_t)((dados[2] << 8) | dados[3]);
+            if (tela != s_vps[DWIN_VP_PIC_NOW]) s_trocas_tela++;
+            s_vps[DWIN_VP_PIC_NOW] = tela;
+            return;
+        }
+        for (uint16_t i = 0; i < n; i += 2u)
+        {
+            const uint8_t baixo = (i + 1u < n) ? dados[i + 1u] : (uint8_t)s_vps[(uint16_t)(vp + i / 2u)];
+            s_vps[(uint16_t)(vp + i / 2u)] = (uint16_t)((dados[i] << 8) | baixo);
+        }
+    }
+    else if (comando == DWIN_CMD_LEITURA && n >= 1u)
+    {
+        uint8_t resposta[DWIN_QUADRO_MAX];
+        uint8_t palavras = dados[0];
+        if (palavras > 125u) palavras = 125u;
+
+        resposta[0] = DWIN_CAB_1;
+        resposta[1] = DWIN_CAB_2;
+        resposta[2] = (uint8_t)(4u + 2u * palavras);
+        resposta[3] = DWIN_CMD_LEITURA;
+        resposta[4] = s_quadro[4];
+        resposta[5] = s_quadro[5];
+        resposta[6] = palavras;
+        for (uint16_t i = 0; i < palavras; i++)
+        {
+            const uint16_t valor = s_vps[(uint16_t)(vp + i)];
+            resposta[7u + 2u * i] = (uint8_t)(valor >> 8);
+            resposta[8u + 2u * i] = (uint8_t)valor;
+        }
+        Dwin_Enfileirar(resposta, (uint16_t)(3u + resposta[2]), DWIN_RESPOSTA_NS);
+    }
+}
+
+static void Dwin_Enfileirar(const uint8_t* quadro, uint16_t tamanho, uint64_t atraso_ns)
+{
+    if (!Dwin_Ativo() || tamanho == 0u || tamanho > DWIN_QUADRO_MAX) return;
+    if (s_fila_qtd >= FILA_RX_QUADROS) return;
+
+    Quadro_Rx_t* novo = &s_fila_rx[(s_fila_inicio + s_fila_qtd) % FILA_RX_QUADROS];
+    novo->inicio_ns = Sim_Agora_ns() + atraso_ns;
+    novo->tamanho = tamanho;
+    memcpy(novo->dados, quadro, tamanho);
+    s_fila_qtd++;
+    Rx_Agendar_Proximo();
+}
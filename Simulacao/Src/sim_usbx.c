@@ -0,0 +1,379 @@
+/*******************************************************************************
+ * @file        sim_usbx.c
+ * @brief       PCD e a parte do USBX que o firmware usa, com um host CDC.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     No h pilha USB: o host simulado enumera o dispositivo
+ * USB_ENUMERACAO_NS depois do pull-up (HAL_PCD_Start) com o cabo conectado e
+ * o HSI48 ligado. Enumerao, desconexo e suspenso chegam pela IRQ da USB e
+ * chamam os mesmos callbacks que o DCD do alvo (change function e
+ * activate/deactivate da classe CDC ACM).
+ *
+ * O write_run/read_run seguem o modo standalone: a escrita fica em
+ * UX_STATE_WAIT pelo tempo dos pacotes de 64 bytes e ento devolve
+ * UX_STATE_NEXT; a leitura entrega no mximo um pacote por chamada. Os dados
+ * do host chegam com a IRQ da USB, como o OUT concludo no alvo.
+ ******************************************************************************/
+
+#include "sim.h"
+#include "ux_api.h"
+#include "ux_device_class_cdc_acm.h"
+#include "ux_dcd_stm32.h"
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define USB_ENUMERACAO_NS       150000000ull
+#define USB_REPETIR_NS          10000000ull     // Nova tentativa sem HSI48
+#define USB_NS_POR_PACOTE       60000ull        // Bulk FS de 64 bytes, com o host
+#define USB_PACOTE              64u
+#define USB_FILA_RX             4096u
+
+#define EVENTO_CONFIGURAR       (1u << 0)
+#define EVENTO_DESCONECTAR      (1u << 1)
+#define EVENTO_SUSPENDER        (1u << 2)
+#define EVENTO_RETOMAR          (1u << 3)
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+UCHAR _ux_system_slave_class_cdc_acm_name[] = "ux_slave_class_cdc_acm";
+
+static UINT (*s_mudanca)(ULONG estado) = NULL;
+static UX_SLAVE_CLASS_CDC_ACM_PARAMETER* s_parametros = NULL;
+static UX_SLAVE_CLASS_CDC_ACM s_instancia;
+
+static bool     s_conectado = true;
+static bool     s_pullup = false;
+static bool     s_configurado = false;
+static uint32_t s_eventos = 0;
+
+static bool     s_tx_em_curso = false;
+static uint64_t s_tx_fim_ns = 0;
+
+static uint8_t  s_fila_rx[USB_FILA_RX];
+static uint32_t s_rx_inicio = 0;
+static uint32_t s_rx_qtd = 0;
+static uint64_t s_rx_disponivel_ns = 0;
+
+void (*Sim_Usb_Ao_Receber)(const uint8_t* dados, size_t tamanho) = NULL;
+
+//==============================================================================
+// Prottipos Privados
+//==============================================================================
+
+static bool Hsi48_Ligado(void);
+static void Agendar_Enumeracao(void);
+static void Enumeracao_Concluir(void);
+static void Recepcao_Concluir(void);
+static void Sinalizar(uint32_t evento);
+static void Mudar_Estado(ULONG estado);
+static void Desconectar_Stack(void);
+static uint64_t Ns_Transferencia(ULONG tamanho);
+
+//==============================================================================
+// Callbacks padro
+//==============================================================================
+
+__weak void HAL_PCD_MspInit(PCD_HandleTypeDef* hpcd) { (void)hpcd; }
+
+//==============================================================================
+// HAL PCD
+//==============================================================================
+
+HAL_StatusTypeDef HAL_PCD_Init(PCD_HandleTypeDef* hpcd)
+{
+    SIM_CHAMADA();
+    if (hpcd == NULL) return HAL_ERROR;
+
+    if (hpcd->State == HAL_PCD_STATE_RESET)
+    {
+        hpcd->Lock = HAL_UNLOCKED;
+        HAL_PCD_MspInit(hpcd);
+    }
+    hpcd->USB_Address = 0U;
+    hpcd->State = HAL_PCD_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_PCDEx_PMAConfig(PCD_HandleTypeDef* hpcd, uint16_t ep_addr, uint16_t ep_kind,
+                                      uint32_t pmaadress)
+{
+    SIM_CHAMADA();
+    (void)hpcd;
+    (void)ep_addr;
+    (void)ep_kind;
+    (void)pmaadress;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_PCD_Start(PCD_HandleTypeDef* hpcd)
+{
+    SIM_CHAMADA();
+    (void)hpcd;
+    s_pullup = true;
+    Agendar_Enumeracao();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_PCD_Stop(PCD_HandleTypeDef* hpcd)
+{
+    SIM_CHAMADA();
+    (void)hpcd;
+    s_pullup = false;
+    Sim_Cancelar(SIM_FONTE_USB);
+    return HAL_OK;
+}
+
+void HAL_PCD_IRQHandler(PCD_HandleTypeDef* hpcd)
+{
+    (void)hpcd;
+    const uint32_t eventos = s_eventos;
+    s_eventos = 0;
+
+    if (eventos & EVENTO_DESCONECTAR) Desconectar_Stack();
+    if (eventos & EVENTO_CONFIGURAR)
+    {
+        Mudar_Estado(UX_DEVICE_ATTACHED);
+        s_configurado = true;
+        if (s_parametros != NULL && s_parametros->ux_slave_class_cdc_acm_instance_activate != NULL)
+        {
+            s_parametros->ux_slave_class_cdc_acm_instance_activate(&s_instancia);
+        }
+    }
+    if (eventos & EVENTO_SUSPENDER) Mudar_Estado(UX_DCD_STM32_DEVICE_SUSPENDED);
+    if (eventos & EVENTO_RETOMAR)   Mudar_Estado(UX_DCD_STM32_DEVICE_RESUMED);
+}
+
+//==============================================================================
+// USBX
+//==============================================================================
+
+UINT _uxe_system_initialize(VOID* regular_memory_pool_start, ULONG regular_memory_size,
+                            VOID* cache_safe_memory_pool_start, ULONG cache_safe_memory_size)
+{
+    SIM_CHAMADA();
+    (void)regular_memory_pool_start;
+    (void)regular_memory_size;
+    (void)cache_safe_memory_pool_start;
+    (void)cache_safe_memory_size;
+    return UX_SUCCESS;
+}
+
+UINT _ux_dcd_stm32_initialize(ULONG dcd_io, ULONG parameter)
+{
+    SIM_CHAMADA();
+    (void)dcd_io;
+    (void)parameter;
+    return UX_SUCCESS;
+}
+
+UINT _ux_device_stack_initialize(UCHAR* device_framework_high_speed, ULONG device_framework_length_high_speed,
+                                 UCHAR* device_framework_full_speed, ULONG device_framework_length_full_speed,
+                                 UCHAR* string_framework, ULONG string_framework_length,
+                                 UCHAR* language_id_framework, ULONG language_id_framework_length,
+                                 UINT (*ux_system_slave_change_function)(ULONG))
+{
+    SIM_CHAMADA();
+    (void)device_framework_high_speed;
+    (void)device_framework_length_high_speed;
+    (void)device_framework_full_speed;
+    (void)device_framework_length_full_speed;
+    (void)string_framework;
+    (void)string_framework_length;
+    (void)language_id_framework;
+    (void)language_id_framework_length;
+    s_mudanca = ux_system_slave_change_function;
+    return UX_SUCCESS;
+}
+
+UINT _ux_device_stack_class_register(UCHAR* class_name,
+                                     UINT (*class_entry_function)(struct UX_SLAVE_CLASS_COMMAND_STRUCT*),
+                                     ULONG configuration_number, ULONG interface_number, VOID* parameter)
+{
+    SIM_CHAMADA();
+    (void)class_name;
+    (void)class_entry_function;
+    (void)configuration_number;
+    (void)interface_number;
+    s_parametros = (UX_SLAVE_CLASS_CDC_ACM_PARAMETER*)parameter;
+    return UX_SUCCESS;
+}
+
+UINT _ux_device_class_cdc_acm_entry(UX_SLAVE_CLASS_COMMAND* command)
+{
+    (void)command;
+    return UX_SUCCESS;
+}
+
+UINT _ux_device_stack_disconnect(VOID)
+{
+    SIM_CHAMADA();
+    Desconectar_Stack();
+    return UX_SUCCESS;
+}
+
+UINT _ux_device_stack_tasks_run(VOID)
+{
+    SIM_CHAMADA();
+    return UX_STATE_IDLE;
+}
+
+UINT _ux_device_class_cdc_acm_write_run(UX_SLAVE_CLASS_CDC_ACM* cdc_acm, UCHAR* buffer,
+                                        ULONG requested_length, ULONG* actual_length)
+{
+    SIM_CHAMADA();
+    (void)cdc_acm;
+    if (!s_configurado || !s_pullup) return UX_STATE_ERROR;
+    if (!Hsi48_Ligado()) return UX_STATE_WAIT;
+
+    if (!s_tx_em_curso)
+    {
+        s_tx_em_curso = true;
+        s_tx_fim_ns = Sim_Agora_ns() + Ns_Transferencia(requested_length);
+        return UX_STATE_WAIT;
+    }
+    if (Sim_Agora_ns() < s_tx_fim_ns) return UX_STATE_WAIT;
+
+    s_tx_em_curso = false;
+    if (Sim_Usb_Ao_Receber != NULL) Sim_Usb_Ao_Receber(buffer, requested_length);
+    *actual_length = requested_length;
+    return UX_STATE_NEXT;
+}
+
+UINT _ux_device_class_cdc_acm_read_run(UX_SLAVE_CLASS_CDC_ACM* cdc_acm, UCHAR* buffer,
+                                       ULONG requested_length, ULONG* actual_length)
+{
+    SIM_CHAMADA();
+    (void)cdc_acm;
+    *actual_length = 0;
+    if (!s_configurado || !s_pullup) return UX_STATE_ERROR;
+    if (!Hsi48_Ligado() || s_rx_qtd == 0u || Sim_Agora_ns() < s_rx_disponivel_ns) return UX_STATE_WAIT;
+
+    ULONG n = (requested_length < USB_PACOTE) ? requested_length : USB_PACOTE;
+    if (n > s_rx_qtd) n = s_rx_qtd;
+    for (ULONG i = 0; i < n; i++)
+    {
+        buffer[i] = s_fila_rx[s_rx_inicio];
+        s_rx_inicio = (s_rx_inicio + 1u) % USB_FILA_RX;
+    }
+    s_rx_qtd -= n;
+    *actual_length = n;
+    return UX_STATE_NEXT;
+}
+
+//==============================================================================
+// Interface com o roteiro
+//==============================================================================
+
+void Sim_Usb_Reiniciar(void)
+{
+    s_mudanca = NULL;
+    s_parametros = NULL;
+    memset(&s_instancia, 0, sizeof(s_instancia));
+    s_conectado = true;
+    s_pullup = false;
+    s_configurado = false;
+    s_eventos = 0;
+    s_tx_em_curso = false;
+    s_rx_inicio = 0;
+    s_rx_qtd = 0;
+    s_rx_disponivel_ns = 0;
+    Sim_Usb_Ao_Receber = NULL;
+}
+
+void Sim_Usb_Conectar(bool conectado)
+{
+    if (conectado == s_conectado) return;
+    s_conectado = conectado;
+    if (conectado)
+    {
+        Agendar_Enumeracao();
+        return;
+    }
+    Sim_Cancelar(SIM_FONTE_USB);
+    if (s_configurado) Sinalizar(EVENTO_DESCONECTAR);
+}
+
+void Sim_Usb_Suspender(bool suspenso)
+{
+    if (s_configurado) Sinalizar(suspenso ? EVENTO_SUSPENDER : EVENTO_RETOMAR);
+}
+
+void Sim_Usb_Enviar(const char* texto, size_t tamanho)
+{
+    for (size_t i = 0; i < tamanho && s_rx_qtd < USB_FILA_RX; i++)
+    {
+        s_fila_rx[(s_rx_inicio + s_rx_qtd) % USB_FILA_RX] = (uint8_t)texto[i];
+        s_rx_qtd++;
+    }
+    s_rx_disponivel_ns = Sim_Agora_ns() + Ns_Transferencia((ULONG)tamanho);
+    Sim_Agendar(SIM_FONTE_USB_RX, s_rx_disponivel_ns, Recepcao_Concluir);
+}
+
+//==============================================================================
+// Implementao das Funes Privadas
+//==============================================================================
+
+static bool Hsi48_Ligado(void)
+{
+    return (RCC->CR & RCC_CR_HSIUSB48ON) != 0U;
+}
+
+static void Agendar_Enumeracao(void)
+{
+    if (s_conectado && s_pullup && !s_configurado)
+    {
+        Sim_Agendar(SIM_FONTE_USB, Sim_Agora_ns() + USB_ENUMERACAO_NS, Enumeracao_Concluir);
+    }
+}
+
+static void Enumeracao_Concluir(void)
+{
+    if (!s_conectado || !s_pullup || s_configurado) return;
+    if (!Hsi48_Ligado())
+    {
+        Sim_Agendar(SIM_FONTE_USB, Sim_Agora_ns() + USB_REPETIR_NS, Enumeracao_Concluir);
+        return;
+    }
+    Sinalizar(EVENTO_CONFIGURAR);
+}
+
+static void Recepcao_Concluir(void)
+{
+    if (s_configurado && s_pullup) Sim_Pendurar_Irq(USB_DRD_FS_IRQn);
+}
+
+static void Sinalizar(uint32_t evento)
+{
+    s_eventos |= evento;
+    Sim_Pendurar_Irq(USB_DRD_FS_IRQn);
+}
+
+static void Mudar_Estado(ULONG estado)
+{
+    if (s_mudanca != NULL) (void)s_mudanca(estado);
+}
+
+/** @brief Como o _ux_device_stack_disconnect: desativa a classe e avisa a aplicao. */
+static void Desconectar_Stack(void)
+{
+    if (!s_configurado) return;
+    s_configurado = false;
+    s_tx_em_curso = false;
+    if (s_parametros != NULL && s_parametros->ux_slave_class_cdc_acm_instance_deactivate != NULL)
+    {
+        s_parametros->ux_slave_class_cdc_acm_instance_deactivate(&s_instancia);
+    }
+    Mudar_Estado(UX_DEVICE_REMOVED);
+}
+
+/** @brief Pacotes de 64 bytes, mais o pacote vazio quando o ltimo vai cheio. */
+static uint64_t Ns_Transferencia(ULONG tamanho)
+{
+    const uint64_t pacotes = (tamanho / USB_PACOTE) + 1u;
+    return pacotes * USB_NS_POR_PACOTE;
+}
@@ -0,0 +1,326 @@
+/*******************************************************************************
+ * @file        teste_escalonador.c
+ * @brief       Ordem de execuo e prazos do escalonador no tempo virtual.
+ * @version     1.0
+ * @author      Gabriel Agune
+ * @details     O escalonador.c do firmware roda sobre o SysTick e o WFI do
+ * HAL simulado, com o mesmo lao do estado ativo do app_manager.c
+ * (Escalonador_Executar e, sem trabalho, Energia_Ocioso com a previso do
+ * escalonador). Sem Energia_Init no h RTC para o Stop: o ocioso  sempre
+ * o WFI, e o SysTick segue contando. As tarefas de
+ * teste anotam o tick e o instante virtual de cada execuo; a interrupo
+ * que sinaliza uma tarefa  a do TIM17, que o firmware no usa.
+ ******************************************************************************/
+
+#include "sim.h"
+#include "escalonador.h"
+#include "energia.h"
+#include <stdio.h>
+#include <string.h>
+
+//==============================================================================
+// Definies Privadas
+//==============================================================================
+
+#define MAX_REGISTROS   512u
+#define NS_POR_MS       1000000ull
+
+#define VERIFICAR(condicao)                                                     \
+    do {                                                                        \
+        if (!(condicao)) {                                                      \
+            printf("FALHA %s:%d: %s\n", __FILE__, __LINE__, #condicao);         \
+            s_falhas++;                                                         \
+        }                                                                       \
+    } while (0)
+
+typedef struct {
+    uint8_t  id;
+    uint32_t tick;
+    uint64_t instante_ns;
+} Registro_t;
+
+//==============================================================================
+// Variveis Estticas
+//==============================================================================
+
+static uint32_t   s_falhas = 0;
+static Registro_t s_registros[MAX_REGISTROS];
+static uint32_t   s_num_registros = 0;
+static uint8_t    s_id_a_sinalizar = 0;
+static uint64_t   s_sinalizada_ns = 0;
+
+//==============================================================================
+// Tarefas de teste
+//==============================================================================
+
+static void Registrar(uint8_t id)
+{
+    if (s_num_registros < MAX_REGISTROS)
+    {
+        s_registros[s_num_registros++] = (Registro_t){id, HAL_GetTick(), Sim_Agora_ns()};
+    }
+}
+
+static void Tarefa_0(void) { Registrar(0); }
+static void Tarefa_1(void) { Registrar(1); }
+static void Tarefa_2(void) { Registrar(2); }
+static void Tarefa_3(void) { Registrar(3); }
+
+/** @brief Tarefa longa: ocupa a CPU por 3 ms. */
+static void Tarefa_Lenta(void)
+{
+    Registrar(1);
+    Sim_Consumir_ns(3u * NS_POR_MS);
+}
+
+/** @brief Sinaliza a si mesma a cada execuo (evento que nunca se esgota). */
+static void Tarefa_Insistente(void)
+{
+    Registrar(0);
+    Escalonador_Sinalizar(0);
+}
+
+/** @brief Previso de teste: trabalho s com s_trabalho_ms == 0. */
+static uint32_t s_trabalho_ms = UINT32_MAX;
+static uint32_t Previsao_Teste(void) { return s_trabalho_ms; }
+
+/** @brief Evento agendado no simulador: dispara a IRQ do TIM17 (livre no firmware). */
+static void Disparar_Interrupcao(void)
+{
+    s_sinalizada_ns = Sim_Agora_ns();
+    Sim_Pendurar_Irq(TIM17_IRQn);
+}
+
+/** @brief ISR que sinaliza uma tarefa, como a expirao do TIM14 no firmware. */
+void TIM17_IRQHandler(void)
+{
+    Escalonador_Sinalizar(s_id_a_sinalizar);
+}
+
+//==============================================================================
+// Auxiliares
+//==============================================================================
+
+static void Iniciar(const Tarefa_t* tabela, uint8_t num_tarefas)
+{
+    s_num_registros = 0;
+    Escalonador_Init(tabela, num_tarefas);
+}
+
+/** @brief O lao do estado ativo, at o tick 'fim'. */
+static void Rodar_Ate(uint32_t fim)
+{
+    while (HAL_GetTick() < fim)
+    {
+        if (!Escalonador_Executar())
+        {
+            Energia_Ocioso(ENERGIA_STOP, Escalonador_Get_Ocioso_ms);
+        }
+    }
+}
+
+static uint32_t Contar(uint8_t id)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < s_num_registros; i++)
+    {
+        if (s_registros[i].id == id) n++;
+    }
+    return n;
+}
+
+//==============================================================================
+// Casos
+//==============================================================================
+
+/** @brief Tarefas vencidas no mesmo tick saem por prioridade; empate pela tabela. */
+static void Teste_Ordem_Por_Prioridade(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"BAIXA",  Tarefa_0, 10, 2, NULL},
+        {"ALTA",   Tarefa_1, 10, 0, NULL},
+        {"MEDIA1", Tarefa_2, 10, 1, NULL},
+        {"MEDIA2", Tarefa_3, 10, 1, NULL},
+    };
+    Iniciar(tabela, 4);
+    const uint32_t inicio = HAL_GetTick();
+    Rodar_Ate(inicio + 15u);
+
+    VERIFICAR(s_num_registros == 4u);
+    VERIFICAR(s_registros[0].id == 1u);
+    VERIFICAR(s_registros[1].id == 2u);
+    VERIFICAR(s_registros[2].id == 3u);
+    VERIFICAR(s_registros[3].id == 0u);
+    for (uint32_t i = 0; i < s_num_registros; i++)
+    {
+        VERIFICAR(s_registros[i].tick == inicio + 10u);
+    }
+}
+
+/** @brief Tarefa sem perodo roda s quando sinalizada, e o WFI acorda para ela. */
+static void Teste_Sinalizacao_Acorda_Ocioso(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"PERIODICA", Tarefa_0, 20, 1, NULL},
+        {"EVENTO",    Tarefa_1,  0, 0, NULL},
+    };
+    Iniciar(tabela, 2);
+    const uint32_t inicio = HAL_GetTick();
+    s_id_a_sinalizar = 1;
+    Sim_Habilitar_Irq(TIM17_IRQn, true);
+    Sim_Agendar(SIM_FONTE_ROTEIRO, Sim_Agora_ns() + 25300000ull, Disparar_Interrupcao);
+    Rodar_Ate(inicio + 50u);
+
+    VERIFICAR(Contar(1) == 1u);
+    VERIFICAR(Contar(0) == 2u);
+    for (uint32_t i = 0; i < s_num_registros; i++)
+    {
+        // Atendida na sada do WFI, sem esperar o prximo SysTick.
+        if (s_registros[i].id == 1u) VERIFICAR(s_registros[i].instante_ns - s_sinalizada_ns < 100000ull);
+    }
+}
+
+/**
+ * @brief Sem preempo, o atraso de uma tarefa curta fica limitado pela
+ * tarefa mais longa; a cadncia no deriva ao longo de um segundo.
+ */
+static void Teste_Prazos(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"RAPIDA", Tarefa_0,  5, 0, NULL},
+        {"LENTA",  Tarefa_Lenta, 20, 1, NULL},
+    };
+    Iniciar(tabela, 2);
+    const uint32_t inicio = HAL_GetTick();
+    Rodar_Ate(inicio + 1000u);
+
+    VERIFICAR(Contar(0) >= 199u && Contar(0) <= 200u);
+    VERIFICAR(Contar(1) >= 49u && Contar(1) <= 50u);
+    VERIFICAR(Escalonador_Get_Atraso_Max_ms(0) <= 3u);
+    VERIFICAR(Escalonador_Get_Atraso_Max_ms(1) <= 1u);
+
+    // Cada execuo da rpida cai no seu vencimento, ou at 3 ms depois dele.
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < s_num_registros; i++)
+    {
+        if (s_registros[i].id != 0u) continue;
+        n++;
+        const uint32_t vencimento = inicio + 5u * n;
+        VERIFICAR(s_registros[i].tick >= vencimento && s_registros[i].tick <= vencimento + 3u);
+    }
+}
+
+/** @brief Depois de um bloqueio de vrios perodos, uma execuo s e realinha. */
+static void Teste_Realinhamento(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"PERIODICA", Tarefa_0, 10, 0, NULL},
+    };
+    Iniciar(tabela, 1);
+    const uint32_t inicio = HAL_GetTick();
+    Sim_Consumir_ns(35u * NS_POR_MS);           // Loop preso fora do escalonador
+    const uint32_t retomada = HAL_GetTick();
+    Rodar_Ate(retomada + 15u);
+
+    VERIFICAR(Contar(0) == 2u);
+    VERIFICAR(s_registros[0].tick == retomada);
+    VERIFICAR(s_registros[1].tick == retomada + 10u);
+    VERIFICAR(Escalonador_Get_Atraso_Max_ms(0) >= (retomada - inicio) - 10u);
+}
+
+/** @brief Um evento sinalizado sem parar no prende a passada. */
+static void Teste_Limite_Por_Passada(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"INSISTENTE", Tarefa_Insistente, 0, 0, NULL},
+        {"OUTRA1",     Tarefa_1,          0, 1, NULL},
+        {"OUTRA2",     Tarefa_2,          0, 1, NULL},
+    };
+    Iniciar(tabela, 3);
+    Escalonador_Sinalizar(0);
+
+    VERIFICAR(Escalonador_Executar());
+    VERIFICAR(Contar(0) == 3u);
+
+    // A sinalizao pendente no passa para a prxima tabela.
+    static const Tarefa_t outra[] = {{"OUTRA", Tarefa_1, 0, 0, NULL}};
+    Iniciar(outra, 1);
+    VERIFICAR(!Escalonador_Executar());
+    VERIFICAR(Contar(1) == 0u);
+}
+
+/** @brief Tempo ocioso informado ao gerenciador de energia. */
+static void Teste_Ocioso_ms(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"P10", Tarefa_0, 10, 0, NULL},
+        {"P25", Tarefa_1, 25, 0, NULL},
+        {"EVT", Tarefa_2,  0, 0, NULL},
+    };
+    Iniciar(tabela, 3);
+    Sim_Consumir_ns(3u * NS_POR_MS);
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == 7u);
+
+    Escalonador_Sinalizar(2);
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == 0u);
+    VERIFICAR(Escalonador_Executar());
+    VERIFICAR(Contar(2) == 1u);
+
+    static const Tarefa_t so_eventos[] = {{"EVT", Tarefa_2, 0, 0, NULL}};
+    Iniciar(so_eventos, 1);
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == UINT32_MAX);
+}
+
+/** @brief Tarefa peridica com previso: parada no roda nem limita o ocioso. */
+static void Teste_Previsao(void)
+{
+    static const Tarefa_t tabela[] = {
+        {"POLL", Tarefa_0, 1,   0, Previsao_Teste},
+        {"P50",  Tarefa_1, 50,  1, NULL},
+    };
+    s_trabalho_ms = UINT32_MAX;
+    Iniciar(tabela, 2);
+    const uint32_t inicio = HAL_GetTick();
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == 50u);
+    Rodar_Ate(inicio + 20u);
+    VERIFICAR(Contar(0) == 0u);
+
+    // Trabalho daqui a 5 ms:  esse o prazo, no o perodo de 1 ms.
+    s_trabalho_ms = 5u;
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == 5u);
+
+    s_trabalho_ms = 0u;
+    VERIFICAR(Escalonador_Get_Ocioso_ms() == 0u);
+    Rodar_Ate(inicio + 25u);
+    VERIFICAR(Contar(0) >= 4u);
+
+    // O tempo parado no conta como atraso.
+    VERIFICAR(Escalonador_Get_Atraso_Max_ms(0) <= 1u);
+    s_trabalho_ms = UINT32_MAX;
+}
+
+//==============================================================================
+// Programa
+//==============================================================================
+
+int main(void)
+{
+    Sim_Reiniciar();
+    HAL_Init();
+
+    Teste_Ordem_Por_Prioridade();
+    Teste_Sinalizacao_Acorda_Ocioso();
+    Teste_Prazos();
+    Teste_Realinhamento();
+    Teste_Limite_Por_Passada();
+    Teste_Ocioso_ms();
+    Teste_Previsao();
+
+    if (s_falhas != 0u)
+    {
+        printf("%u falha(s)\n", (unsigned)s_falhas);
+        return 1;
+    }
+    printf("OK: escalonador\n");
+    return 0;
+}
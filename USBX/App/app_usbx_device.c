@@ -23,7 +23,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "energia.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -237,6 +237,7 @@ static UINT USBD_ChangeFunction(ULONG Device_State)
     case UX_DEVICE_REMOVED:
 
       /* USER CODE BEGIN UX_DEVICE_REMOVED */
+      Energia_USB_Suspenso(false);
 
       /* USER CODE END UX_DEVICE_REMOVED */
 
@@ -253,6 +254,7 @@ static UINT USBD_ChangeFunction(ULONG Device_State)
     case UX_DCD_STM32_DEVICE_DISCONNECTED:
 
       /* USER CODE BEGIN UX_DCD_STM32_DEVICE_DISCONNECTED */
+      Energia_USB_Suspenso(false);
 
       /* USER CODE END UX_DCD_STM32_DEVICE_DISCONNECTED */
 
@@ -261,6 +263,7 @@ static UINT USBD_ChangeFunction(ULONG Device_State)
     case UX_DCD_STM32_DEVICE_SUSPENDED:
 
       /* USER CODE BEGIN UX_DCD_STM32_DEVICE_SUSPENDED */
+      Energia_USB_Suspenso(true);
 
       /* USER CODE END UX_DCD_STM32_DEVICE_SUSPENDED */
 
@@ -269,6 +272,7 @@ static UINT USBD_ChangeFunction(ULONG Device_State)
     case UX_DCD_STM32_DEVICE_RESUMED:
 
       /* USER CODE BEGIN UX_DCD_STM32_DEVICE_RESUMED */
+      Energia_USB_Suspenso(false);
 
       /* USER CODE END UX_DCD_STM32_DEVICE_RESUMED */
 
@@ -619,6 +619,9 @@
 
 /* USER CODE BEGIN 2 */
 
+/* Pico de uso do byte pool, lido pelo comando MEM do CLI (memoria.c). */
+#define UX_ENABLE_MEMORY_STATISTICS
+
 /* USER CODE END 2 */
 
 #endif